@@ -14,6 +14,11 @@ typedef struct mc_fhl_struct
 {
     mc_config_t *config;
     GPtrArray *filters;
+    /* extension -> index of the first filter with it and with color plus 1 */
+    GHashTable *extensions;
+    GHashTable *extensions_nocase;      /* casefolded extensions */
+    /* unique id of filters to know colors cached in file entries, never 0 */
+    guint stamp;
 } mc_fhl_t;
 
 /*** global variables defined in .c file *********************************************************/
@@ -38,6 +38,8 @@
 
 /*** file scope variables ************************************************************************/
 
+static guint mc_fhl_last_stamp = 0;
+
 /*** file scope functions ************************************************************************/
 
 static void
@@ -61,6 +63,34 @@ mc_fhl_array_free (mc_fhl_t * fhl)
         g_ptr_array_foreach (fhl->filters, (GFunc) mc_fhl_filter_free, nullptr);
         fhl->filters = (GPtrArray *) g_ptr_array_free (fhl->filters, true);
     }
+
+    if (fhl->extensions != nullptr)
+    {
+        g_hash_table_destroy (fhl->extensions);
+        fhl->extensions = nullptr;
+    }
+
+    if (fhl->extensions_nocase != nullptr)
+    {
+        g_hash_table_destroy (fhl->extensions_nocase);
+        fhl->extensions_nocase = nullptr;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Give new stamp to filters: colors cached in file entries with other stamps are found again.
+ */
+
+void
+mc_fhl_new_stamp (mc_fhl_t * fhl)
+{
+    mc_fhl_last_stamp++;
+    /* 0 is stamp of file entries without color */
+    if (mc_fhl_last_stamp == 0)
+        mc_fhl_last_stamp++;
+
+    fhl->stamp = mc_fhl_last_stamp;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -76,6 +106,8 @@ mc_fhl_new (bool need_auto_fill)
     if (fhl == nullptr)
         return nullptr;
 
+    mc_fhl_new_stamp (fhl);
+
     if (!need_auto_fill)
         return fhl;
 
@@ -247,18 +247,61 @@ mc_fhl_get_color_regexp (mc_fhl_filter_t * mc_filter, mc_fhl_t * fhl, file_entry
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+mc_fhl_lookup_extensions (GHashTable * extensions, const char *fname, guint * index)
+{
+    const char *dot;
+
+    for (dot = strchr (fname, '.'); dot != nullptr; dot = strchr (dot + 1, '.'))
+    {
+        guint i;
+
+        i = GPOINTER_TO_UINT (g_hash_table_lookup (extensions, dot + 1));
+        if (i != 0 && i - 1 < *index)
+            *index = i - 1;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
-/*** public functions ****************************************************************************/
+/**
+ * Find the first extension filter matching file name, the same as regexp ".*\.(ext1|ext2)$"
+ * of every filter would do.
+ *
+ * @return index of filter, G_MAXUINT if there are no such filters
+ */
+
+static guint
+mc_fhl_get_extension_filter (mc_fhl_t * fhl, const char *fname)
+{
+    guint index = G_MAXUINT;
+
+    if (strchr (fname, '.') == nullptr)
+        return index;
+
+    if (fhl->extensions != nullptr)
+        mc_fhl_lookup_extensions (fhl->extensions, fname, &index);
+
+    if (fhl->extensions_nocase != nullptr)
+    {
+        char *folded;
+
+        folded = g_utf8_casefold (fname, -1);
+        mc_fhl_lookup_extensions (fhl->extensions_nocase, folded, &index);
+        g_free (folded);
+    }
+
+    return index;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
-int
-mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
+static int
+mc_fhl_find_color (mc_fhl_t * fhl, file_entry_t * fe)
 {
-    guint i;
+    guint i, ext_filter;
     int ret;
 
-    if (fhl == nullptr)
-        return NORMAL_COLOR;
+    ext_filter = mc_fhl_get_extension_filter (fhl, fe->fname);
 
     for (i = 0; i < fhl->filters->len; i++)
     {
@@ -273,6 +316,9 @@ mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
                 return -ret;
             break;
         case MC_FLHGH_T_EXT:
+            if (i == ext_filter && mc_filter->color_pair_index > 0)
+                return -mc_filter->color_pair_index;
+            break;
         case MC_FLHGH_T_FREGEXP:
             ret = mc_fhl_get_color_regexp (mc_filter, fhl, fe);
             if (ret > 0)
@@ -286,3 +332,31 @@ mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get color of file. The color is found once and kept in file entry until filters are changed:
+ * panel is repainted without running of filters.
+ *
+ * @param fhl file highlight filters
+ * @param fe file entry, its color_stamp should be 0 when entry is created or changed
+ *
+ * @return color pair index
+ */
+
+int
+mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
+{
+    if (fhl == nullptr)
+        return NORMAL_COLOR;
+
+    if (fe->color_stamp != fhl->stamp)
+    {
+        fe->color = mc_fhl_find_color (fhl, fe);
+        fe->color_stamp = fhl->stamp;
+    }
+
+    return fe->color;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -29,7 +29,6 @@
 
 #include "lib/global.h"
 #include "lib/fileloc.h"
-#include "lib/strescape.h"
 #include "lib/skin.h"
 #include "lib/util.h"           /* exist_file() */
 #include "lib/filehighlight.h"
@@ -130,7 +129,8 @@ mc_fhl_parse_get_extensions (mc_fhl_t * fhl, const gchar * group_name)
 {
     mc_fhl_filter_t *mc_filter;
     gchar **exts, **exts_orig;
-    GString *buf;
+    GHashTable *hash;
+    gpointer index;
 
     exts_orig = mc_config_get_string_list (fhl->config, group_name, "extensions", nullptr);
     if (exts_orig == nullptr || exts_orig[0] == nullptr)
@@ -139,33 +139,48 @@ mc_fhl_parse_get_extensions (mc_fhl_t * fhl, const gchar * group_name)
         return false;
     }
 
-    buf = g_string_sized_new (64);
+    mc_filter = g_new0 (mc_fhl_filter_t, 1);
+    mc_filter->type = MC_FLHGH_T_EXT;
+    mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
+    g_ptr_array_add (fhl->filters, (gpointer) mc_filter);
 
-    for (exts = exts_orig; *exts != nullptr; exts++)
+    /* filter without color never matches: the next filters with the same extensions should */
+    if (mc_filter->color_pair_index <= 0)
     {
-        char *esc_ext;
+        g_strfreev (exts_orig);
+        return true;
+    }
 
-        esc_ext = strutils_regex_escape (*exts);
-        if (buf->len != 0)
-            g_string_append_c (buf, '|');
-        g_string_append (buf, esc_ext);
-        g_free (esc_ext);
+    /* extensions of all filters are found by one lookup of every suffix of file name */
+    if (mc_config_get_bool (fhl->config, group_name, "extensions_case", false))
+    {
+        if (fhl->extensions == nullptr)
+            fhl->extensions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, nullptr);
+        hash = fhl->extensions;
+    }
+    else
+    {
+        if (fhl->extensions_nocase == nullptr)
+            fhl->extensions_nocase =
+                g_hash_table_new_full (g_str_hash, g_str_equal, g_free, nullptr);
+        hash = fhl->extensions_nocase;
     }
-    g_strfreev (exts_orig);
 
-    g_string_prepend (buf, ".*\\.(");
-    g_string_append (buf, ")$");
+    index = GUINT_TO_POINTER (fhl->filters->len);
 
-    mc_filter = g_new0 (mc_fhl_filter_t, 1);
-    mc_filter->type = MC_FLHGH_T_FREGEXP;
-    mc_filter->search_condition = mc_search_new_len (buf->str, buf->len, DEFAULT_CHARSET);
-    mc_filter->search_condition->is_case_sensitive =
-        mc_config_get_bool (fhl->config, group_name, "extensions_case", false);
-    mc_filter->search_condition->search_type = MC_SEARCH_T_REGEX;
+    for (exts = exts_orig; *exts != nullptr; exts++)
+    {
+        char *ext;
+
+        ext = hash == fhl->extensions ? g_strdup (*exts) : g_utf8_casefold (*exts, -1);
+        /* the first filter wins */
+        if (g_hash_table_lookup (hash, ext) == nullptr)
+            g_hash_table_insert (hash, ext, index);
+        else
+            g_free (ext);
+    }
+    g_strfreev (exts_orig);
 
-    mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
-    g_ptr_array_add (fhl->filters, (gpointer) mc_filter);
-    g_string_free (buf, true);
     return true;
 }
 
@@ -225,6 +240,7 @@ mc_fhl_parse_ini_file (mc_fhl_t * fhl)
 
     mc_fhl_array_free (fhl);
     fhl->filters = g_ptr_array_new ();
+    mc_fhl_new_stamp (fhl);
 
     orig_group_names = mc_config_get_groups (fhl->config, nullptr);
     ok = (*orig_group_names != nullptr);
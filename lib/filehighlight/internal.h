@@ -52,6 +52,7 @@ typedef struct mc_fhl_filter_struct
 /*** declarations of public functions ************************************************************/
 
 void mc_fhl_array_free (mc_fhl_t *);
+void mc_fhl_new_stamp (mc_fhl_t *);
 
 bool mc_fhl_init_from_standard_files (mc_fhl_t *);
 
@@ -64,6 +64,12 @@
 
 #define MC_SKINS_DIR            "skins"
 
+/* cached indexes of archives */
+#define MC_ARCHIVE_INDEX_DIR    "archives"
+
+/* cached listings of directories of network file systems */
+#define MC_DIRCACHE_DIR         "listings"
+
 /* editor home directory */
 #define EDIT_HOME_DIR           "mcedit"
 
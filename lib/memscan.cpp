@@ -0,0 +1,460 @@
+/*
+   Byte scanning in memory blocks.
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  \brief Source: byte scanning in memory blocks
+ *
+ *  Counting of bytes and search of one of two bytes forward and backward. These are used to
+ *  find line boundaries in editor, viewer and file search, where the libc functions are either
+ *  missing (memrchr() is a GNU extension, there is nothing to count bytes) or are not enough
+ *  (a line ends at one of two bytes). mc_memmem() wraps memmem() that is a GNU extension too.
+ *
+ *  On x86 the SSE2 and AVX2 versions are built; the best one supported by CPU is chosen
+ *  at the first call.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "lib/global.h"
+#include "lib/memscan.h"
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define MEMSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#ifdef MEMSCAN_X86
+#define MEMSCAN_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#endif
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    const char *name;
+    size_t (*count) (const unsigned char *s, unsigned char c, size_t n);
+    void *(*chr2) (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n);
+    void *(*rchr2) (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n);
+} memscan_ops_t;
+
+/*** file scope variables ************************************************************************/
+
+static const memscan_ops_t *memscan_ops = nullptr;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static size_t
+memcount_scalar (const unsigned char *s, unsigned char c, size_t n)
+{
+    size_t ret = 0;
+
+    for (; n != 0; n--)
+        if (*s++ == c)
+            ret++;
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void *
+memchr2_scalar (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n)
+{
+    if (c1 == c2)
+        return (void *) memchr (s, c1, n);
+
+    for (; n != 0; n--, s++)
+        if (*s == c1 || *s == c2)
+            return (void *) s;
+
+    return nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void *
+memrchr2_scalar (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n)
+{
+    while (n-- != 0)
+        if (s[n] == c1 || s[n] == c2)
+            return (void *) (s + n);
+
+    return nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef MEMSCAN_X86
+
+static size_t
+memcount_sse2 (const unsigned char *s, unsigned char c, size_t n)
+{
+    const __m128i vc = _mm_set1_epi8 ((char) c);
+    const __m128i zero = _mm_setzero_si128 ();
+    size_t ret = 0;
+
+    while (n >= 16)
+    {
+        __m128i acc = zero;
+        size_t k;
+
+        /* byte counters are incremented by matches (-1) and overflow after 255 rounds */
+        k = MIN (n / 16, 255);
+        n -= k * 16;
+
+        for (; k != 0; k--, s += 16)
+        {
+            const __m128i v = _mm_loadu_si128 ((const __m128i *) s);
+
+            acc = _mm_sub_epi8 (acc, _mm_cmpeq_epi8 (v, vc));
+        }
+
+        acc = _mm_sad_epu8 (acc, zero);
+        ret += (size_t) _mm_cvtsi128_si32 (acc) + (size_t) _mm_extract_epi16 (acc, 4);
+    }
+
+    return ret + memcount_scalar (s, c, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void *
+memchr2_sse2 (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n)
+{
+    const __m128i v1 = _mm_set1_epi8 ((char) c1);
+    const __m128i v2 = _mm_set1_epi8 ((char) c2);
+
+    for (; n >= 16; n -= 16, s += 16)
+    {
+        const __m128i v = _mm_loadu_si128 ((const __m128i *) s);
+        unsigned int m;
+
+        m = (unsigned int) _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (v, v1),
+                                                            _mm_cmpeq_epi8 (v, v2)));
+        if (m != 0)
+            return (void *) (s + __builtin_ctz (m));
+    }
+
+    return memchr2_scalar (s, c1, c2, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void *
+memrchr2_sse2 (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n)
+{
+    const __m128i v1 = _mm_set1_epi8 ((char) c1);
+    const __m128i v2 = _mm_set1_epi8 ((char) c2);
+
+    while (n >= 16)
+    {
+        __m128i v;
+        unsigned int m;
+
+        n -= 16;
+        v = _mm_loadu_si128 ((const __m128i *) (s + n));
+        m = (unsigned int) _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (v, v1),
+                                                            _mm_cmpeq_epi8 (v, v2)));
+        if (m != 0)
+            return (void *) (s + n + 31 - __builtin_clz (m));
+    }
+
+    return memrchr2_scalar (s, c1, c2, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+MEMSCAN_TARGET_AVX2 static size_t
+memcount_avx2 (const unsigned char *s, unsigned char c, size_t n)
+{
+    const __m256i vc = _mm256_set1_epi8 ((char) c);
+    const __m256i zero = _mm256_setzero_si256 ();
+    size_t ret = 0;
+
+    while (n >= 32)
+    {
+        __m256i acc = zero;
+        guint64 sum[4];
+        size_t k;
+
+        /* byte counters are incremented by matches (-1) and overflow after 255 rounds */
+        k = MIN (n / 32, 255);
+        n -= k * 32;
+
+        for (; k != 0; k--, s += 32)
+        {
+            const __m256i v = _mm256_loadu_si256 ((const __m256i *) s);
+
+            acc = _mm256_sub_epi8 (acc, _mm256_cmpeq_epi8 (v, vc));
+        }
+
+        _mm256_storeu_si256 ((__m256i *) sum, _mm256_sad_epu8 (acc, zero));
+        ret += (size_t) (sum[0] + sum[1] + sum[2] + sum[3]);
+    }
+
+    return ret + memcount_sse2 (s, c, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+MEMSCAN_TARGET_AVX2 static void *
+memchr2_avx2 (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n)
+{
+    const __m256i v1 = _mm256_set1_epi8 ((char) c1);
+    const __m256i v2 = _mm256_set1_epi8 ((char) c2);
+
+    for (; n >= 32; n -= 32, s += 32)
+    {
+        const __m256i v = _mm256_loadu_si256 ((const __m256i *) s);
+        unsigned int m;
+
+        m = (unsigned int) _mm256_movemask_epi8 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, v1),
+                                                                  _mm256_cmpeq_epi8 (v, v2)));
+        if (m != 0)
+            return (void *) (s + __builtin_ctz (m));
+    }
+
+    return memchr2_sse2 (s, c1, c2, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+MEMSCAN_TARGET_AVX2 static void *
+memrchr2_avx2 (const unsigned char *s, unsigned char c1, unsigned char c2, size_t n)
+{
+    const __m256i v1 = _mm256_set1_epi8 ((char) c1);
+    const __m256i v2 = _mm256_set1_epi8 ((char) c2);
+
+    while (n >= 32)
+    {
+        __m256i v;
+        unsigned int m;
+
+        n -= 32;
+        v = _mm256_loadu_si256 ((const __m256i *) (s + n));
+        m = (unsigned int) _mm256_movemask_epi8 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, v1),
+                                                                  _mm256_cmpeq_epi8 (v, v2)));
+        if (m != 0)
+            return (void *) (s + n + 31 - __builtin_clz (m));
+    }
+
+    return memrchr2_sse2 (s, c1, c2, n);
+}
+
+#endif /* MEMSCAN_X86 */
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const memscan_ops_t memscan_scalar = {
+    "scalar", memcount_scalar, memchr2_scalar, memrchr2_scalar
+};
+
+#ifdef MEMSCAN_X86
+static const memscan_ops_t memscan_sse2 = {
+    "sse2", memcount_sse2, memchr2_sse2, memrchr2_sse2
+};
+
+static const memscan_ops_t memscan_avx2 = {
+    "avx2", memcount_avx2, memchr2_avx2, memrchr2_avx2
+};
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const memscan_ops_t *
+memscan_get_ops (void)
+{
+    const memscan_ops_t *ops;
+
+    ops = (const memscan_ops_t *) g_atomic_pointer_get (&memscan_ops);
+    if (ops == nullptr)
+    {
+        mc_memscan_set_impl (MEMSCAN_AUTO);
+        ops = (const memscan_ops_t *) g_atomic_pointer_get (&memscan_ops);
+    }
+
+    return ops;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count occurrences of byte in memory block.
+ *
+ * @param s memory block
+ * @param c byte to count
+ * @param n size of memory block
+ *
+ * @return number of bytes equal to @c in @s
+ */
+
+size_t
+mc_memcount (const void *s, int c, size_t n)
+{
+    return memscan_get_ops ()->count ((const unsigned char *) s, (unsigned char) c, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find first occurrence of any of two bytes in memory block.
+ *
+ * @param s memory block
+ * @param c1 byte to find
+ * @param c2 another byte to find
+ * @param n size of memory block
+ *
+ * @return pointer to the first byte equal to @c1 or @c2, NULL if there is no such byte
+ */
+
+void *
+mc_memchr2 (const void *s, int c1, int c2, size_t n)
+{
+    return memscan_get_ops ()->chr2 ((const unsigned char *) s, (unsigned char) c1,
+                                     (unsigned char) c2, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find last occurrence of any of two bytes in memory block.
+ *
+ * @param s memory block
+ * @param c1 byte to find
+ * @param c2 another byte to find
+ * @param n size of memory block
+ *
+ * @return pointer to the last byte equal to @c1 or @c2, NULL if there is no such byte
+ */
+
+void *
+mc_memrchr2 (const void *s, int c1, int c2, size_t n)
+{
+    return memscan_get_ops ()->rchr2 ((const unsigned char *) s, (unsigned char) c1,
+                                      (unsigned char) c2, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find first occurrence of byte string in memory block.
+ *
+ * @param haystack memory block
+ * @param haystack_len size of memory block
+ * @param needle byte string to find
+ * @param needle_len length of @needle
+ *
+ * @return pointer to the first occurrence of @needle, NULL if there is no one
+ */
+
+void *
+mc_memmem (const void *haystack, size_t haystack_len, const void *needle, size_t needle_len)
+{
+#ifdef HAVE_MEMMEM
+    return memmem (haystack, haystack_len, needle, needle_len);
+#else
+    const unsigned char *h = (const unsigned char *) haystack;
+    const unsigned char *n = (const unsigned char *) needle;
+    const unsigned char *last;
+
+    if (needle_len == 0)
+        return (void *) haystack;
+    if (haystack_len < needle_len)
+        return nullptr;
+
+    /* byte after the last possible start of needle */
+    last = h + haystack_len - needle_len + 1;
+
+    for (; (h = (const unsigned char *) memchr (h, n[0], last - h)) != nullptr; h++)
+        if (memcmp (h + 1, n + 1, needle_len - 1) == 0)
+            return (void *) h;
+
+    return nullptr;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Choose implementation of memory scanning functions. Intended for tests and benchmarks.
+ *
+ * @param impl implementation; MEMSCAN_AUTO chooses the best one supported by CPU
+ *
+ * @return false if @impl is not supported, true otherwise
+ */
+
+bool
+mc_memscan_set_impl (memscan_impl_t impl)
+{
+    const memscan_ops_t *ops = nullptr;
+
+    switch (impl)
+    {
+    case MEMSCAN_AUTO:
+#ifdef MEMSCAN_X86
+        ops = __builtin_cpu_supports ("avx2") ? &memscan_avx2 : &memscan_sse2;
+#else
+        ops = &memscan_scalar;
+#endif
+        break;
+    case MEMSCAN_SCALAR:
+        ops = &memscan_scalar;
+        break;
+#ifdef MEMSCAN_X86
+    case MEMSCAN_SSE2:
+        ops = &memscan_sse2;
+        break;
+    case MEMSCAN_AVX2:
+        if (__builtin_cpu_supports ("avx2"))
+            ops = &memscan_avx2;
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if (ops == nullptr)
+        return false;
+
+    g_atomic_pointer_set (&memscan_ops, ops);
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get name of implementation of memory scanning functions in use.
+ *
+ * @return "scalar", "sse2" or "avx2"
+ */
+
+const char *
+mc_memscan_get_impl_name (void)
+{
+    return memscan_get_ops ()->name;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,45 @@
+/** \file memscan.h
+ *  \brief Header: byte scanning in memory blocks
+ */
+
+#ifndef MC_MEMSCAN_H
+#define MC_MEMSCAN_H
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+typedef enum
+{
+    MEMSCAN_AUTO = 0,           /* the best one supported by CPU */
+    MEMSCAN_SCALAR,
+    MEMSCAN_SSE2,
+    MEMSCAN_AVX2
+} memscan_impl_t;
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+size_t mc_memcount (const void *s, int c, size_t n);
+void *mc_memchr2 (const void *s, int c1, int c2, size_t n);
+void *mc_memrchr2 (const void *s, int c1, int c2, size_t n);
+void *mc_memmem (const void *haystack, size_t haystack_len, const void *needle,
+                 size_t needle_len);
+
+bool mc_memscan_set_impl (memscan_impl_t impl);
+const char *mc_memscan_get_impl_name (void);
+
+/*** inline functions ****************************************************************************/
+
+static inline void *
+mc_memrchr (const void *s, int c, size_t n)
+{
+    return mc_memrchr2 (s, c, c, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#endif /* MC_MEMSCAN_H */
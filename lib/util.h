@@ -105,6 +105,9 @@ typedef struct
     char *sort_key;
     /* key used for comparing extensions */
     char *second_sort_key;
+    /* color found by file highlight filters with stamp color_stamp, see mc_fhl_get_color() */
+    int color;
+    unsigned int color_stamp;   /* 0 if color isn't found yet */
 
     /* Flags */
     struct
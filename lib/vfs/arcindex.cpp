@@ -0,0 +1,543 @@
+/*
+   Virtual File System: cache of indexes of archives
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: cache of indexes of archives
+ *
+ * Archive file systems read all headers of archive to build the tree of inodes. For large or
+ * compressed archives it takes a lot of time, and it is done again each time the archive is
+ * entered after the superblock was freed by VFS garbage collector. The tree of inodes with
+ * offsets of data is saved in the cache directory of mc and is loaded instead of reading
+ * of archive while size and modification time of archive are the same.
+ *
+ * The index is a private cache of one machine, so records are stored in the native byte order.
+ *
+ * File system can save its own data with the tree, e.g. tarfs saves checkpoints of decompressor
+ * of gzipped archive to not decompress the archive from the beginning to read a file from it.
+ *
+ * Indexes of archives that were removed or are not opened anymore are never read again. So once
+ * per session, before the first index is saved, indexes older than a month are removed, and
+ * then the oldest ones while the cache is too large.
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/fileloc.h"
+#include "lib/mcconfig.h"       /* mc_config_get_cache_path() */
+
+#include "vfs.h"
+#include "utilvfs.h"            /* vfs_prune_cache_dir() */
+#include "xdirentry.h"
+
+#include "arcindex.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define VFS_S_INDEX_SIGNATURE "MC archive index 2\n"
+
+/* indexes of small archives are not saved: such archives are read fast enough */
+#define VFS_S_INDEX_MIN_SIZE (1024 * 1024)
+
+/* saved indexes older than this, in seconds, are removed */
+#define VFS_S_INDEX_MAX_AGE (30 * 24 * 60 * 60)
+
+/* if saved indexes take more, the oldest ones are removed */
+#define VFS_S_INDEX_MAX_SIZE (256 * 1024 * 1024)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    guint64 size;               /* size of archive */
+    gint64 mtime;               /* modification time of archive */
+    guint64 data;               /* length of data of file system */
+    guint32 inodes;             /* number of inodes including the root one */
+    guint32 entries;            /* number of entries */
+    guint32 key;                /* length of key */
+    guint32 pad;
+} vfs_s_index_header_t;
+
+typedef struct
+{
+    guint64 size;
+    guint64 rdev;
+    guint64 blocks;
+    gint64 data_offset;
+    gint64 atime;
+    gint64 mtime;
+    gint64 ctime;
+    guint32 mode;
+    guint32 uid;
+    guint32 gid;
+    guint32 blksize;
+    guint32 linkname;           /* length of link name plus 1, 0 if there is no link name */
+    guint32 pad;
+} vfs_s_index_inode_t;
+
+typedef struct
+{
+    guint32 dir;                /* index of directory inode */
+    guint32 ino;                /* index of inode */
+    guint32 name;               /* length of name */
+} vfs_s_index_entry_t;
+
+/* inodes and entries in the order of save */
+typedef struct
+{
+    GHashTable *indexes;        /* inode -> index plus 1 */
+    GPtrArray *inodes;
+    GPtrArray *entries;
+} vfs_s_index_walk_t;
+
+/*** file scope variables ************************************************************************/
+
+static bool vfs_s_index_pruned = false;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_index_key (const struct vfs_s_super *super, const char *fs_name)
+{
+    if (fs_name == nullptr)
+        fs_name = super->me->name;
+
+    return g_strconcat (fs_name, ":", super->name, (char *) nullptr);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_index_file_name (const char *key)
+{
+    char *digest, *name;
+
+    digest = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+    name = g_build_filename (mc_config_get_cache_path (), MC_ARCHIVE_INDEX_DIR, digest,
+                             (char *) nullptr);
+    g_free (digest);
+
+    return name;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint32
+vfs_s_index_add_inode (vfs_s_index_walk_t * walk, struct vfs_s_inode *ino)
+{
+    g_ptr_array_add (walk->inodes, ino);
+    g_hash_table_insert (walk->indexes, ino, GUINT_TO_POINTER (walk->inodes->len));
+
+    return walk->inodes->len - 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Collect entries of directory and its subdirectories in the order of directory lists.
+ * An inode linked several times is collected once.
+ */
+
+static void
+vfs_s_index_collect (vfs_s_index_walk_t * walk, struct vfs_s_inode *dir)
+{
+    GList *iter;
+
+    for (iter = g_queue_peek_head_link (dir->subdir); iter != nullptr; iter = g_list_next (iter))
+    {
+        struct vfs_s_entry *ent = VFS_ENTRY (iter->data);
+
+        g_ptr_array_add (walk->entries, ent);
+
+        if (g_hash_table_lookup (walk->indexes, ent->ino) == nullptr)
+        {
+            vfs_s_index_add_inode (walk, ent->ino);
+            vfs_s_index_collect (walk, ent->ino);
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint32
+vfs_s_index_of (const vfs_s_index_walk_t * walk, struct vfs_s_inode *ino)
+{
+    return GPOINTER_TO_UINT (g_hash_table_lookup (walk->indexes, ino)) - 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+vfs_s_index_write (struct vfs_s_super *super, const struct stat *st, const char *key,
+                   const GString * data, const char *file_name)
+{
+    vfs_s_index_walk_t walk;
+    vfs_s_index_header_t header;
+    GString *buf;
+    guint i;
+    bool ret;
+
+    walk.indexes = g_hash_table_new (g_direct_hash, g_direct_equal);
+    walk.inodes = g_ptr_array_new ();
+    walk.entries = g_ptr_array_new ();
+
+    vfs_s_index_add_inode (&walk, super->root);
+    vfs_s_index_collect (&walk, super->root);
+
+    memset (&header, 0, sizeof (header));
+    header.size = (guint64) st->st_size;
+    header.mtime = (gint64) st->st_mtime;
+    header.inodes = walk.inodes->len;
+    header.entries = walk.entries->len;
+    header.key = strlen (key);
+    header.data = data == nullptr ? 0 : data->len;
+
+    buf = g_string_sized_new (sizeof (header) + header.data + walk.entries->len * 64);
+    g_string_append (buf, VFS_S_INDEX_SIGNATURE);
+    g_string_append_len (buf, (const char *) &header, sizeof (header));
+    g_string_append_len (buf, key, header.key);
+    if (data != nullptr)
+        g_string_append_len (buf, data->str, data->len);
+
+    /* root inode is made by the file system itself */
+    for (i = 1; i < walk.inodes->len; i++)
+    {
+        const struct vfs_s_inode *ino =
+            (const struct vfs_s_inode *) g_ptr_array_index (walk.inodes, i);
+        vfs_s_index_inode_t rec;
+
+        memset (&rec, 0, sizeof (rec));
+        rec.size = (guint64) ino->st.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+        rec.rdev = (guint64) ino->st.st_rdev;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLOCKS
+        rec.blocks = (guint64) ino->st.st_blocks;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+        rec.blksize = (guint32) ino->st.st_blksize;
+#endif
+        rec.data_offset = (gint64) ino->data_offset;
+        rec.atime = (gint64) ino->st.st_atime;
+        rec.mtime = (gint64) ino->st.st_mtime;
+        rec.ctime = (gint64) ino->st.st_ctime;
+        rec.mode = (guint32) ino->st.st_mode;
+        rec.uid = (guint32) ino->st.st_uid;
+        rec.gid = (guint32) ino->st.st_gid;
+        rec.linkname = ino->linkname == nullptr ? 0 : strlen (ino->linkname) + 1;
+
+        g_string_append_len (buf, (const char *) &rec, sizeof (rec));
+        if (ino->linkname != nullptr)
+            g_string_append_len (buf, ino->linkname, rec.linkname - 1);
+    }
+
+    for (i = 0; i < walk.entries->len; i++)
+    {
+        const struct vfs_s_entry *ent =
+            (const struct vfs_s_entry *) g_ptr_array_index (walk.entries, i);
+        vfs_s_index_entry_t rec;
+
+        rec.dir = vfs_s_index_of (&walk, ent->dir);
+        rec.ino = vfs_s_index_of (&walk, ent->ino);
+        rec.name = strlen (ent->name);
+
+        g_string_append_len (buf, (const char *) &rec, sizeof (rec));
+        g_string_append_len (buf, ent->name, rec.name);
+    }
+
+    ret = g_file_set_contents (file_name, buf->str, buf->len, nullptr);
+
+    g_string_free (buf, TRUE);
+    g_ptr_array_free (walk.entries, TRUE);
+    g_ptr_array_free (walk.inodes, TRUE);
+    g_hash_table_destroy (walk.indexes);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take the record of @size bytes and @extra bytes after it from the buffer.
+ *
+ * @return pointer to the record, nullptr if buffer is too short
+ */
+
+static const char *
+vfs_s_index_take (const char **p, const char *end, size_t size, size_t extra)
+{
+    const char *rec = *p;
+
+    if ((size_t) (end - rec) < size || (size_t) (end - rec) - size < extra)
+        return nullptr;
+
+    *p = rec + size + extra;
+    return rec;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check all records before the tree is built to not leave a half of tree if the index is
+ * corrupted.
+ */
+
+static bool
+vfs_s_index_validate (const vfs_s_index_header_t * header, const char *p, const char *end)
+{
+    bool *linked;
+    guint32 i;
+    bool ret = true;
+
+    for (i = 1; i < header->inodes; i++)
+    {
+        vfs_s_index_inode_t rec;
+        const char *r;
+
+        r = vfs_s_index_take (&p, end, sizeof (rec), 0);
+        if (r == nullptr)
+            return false;
+
+        memcpy (&rec, r, sizeof (rec));
+        if (vfs_s_index_take (&p, end, 0, rec.linkname == 0 ? 0 : rec.linkname - 1) == nullptr)
+            return false;
+    }
+
+    /* each inode except root must be linked */
+    linked = g_new0 (bool, header->inodes);
+
+    for (i = 0; ret && i < header->entries; i++)
+    {
+        vfs_s_index_entry_t rec;
+        const char *r;
+
+        r = vfs_s_index_take (&p, end, sizeof (rec), 0);
+        if (r != nullptr)
+            memcpy (&rec, r, sizeof (rec));
+
+        ret = r != nullptr && rec.dir < header->inodes && rec.ino != 0
+            && rec.ino < header->inodes && rec.name != 0
+            && vfs_s_index_take (&p, end, 0, rec.name) != nullptr;
+        if (ret)
+            linked[rec.ino] = true;
+    }
+
+    for (i = 1; ret && i < header->inodes; i++)
+        ret = linked[i];
+
+    g_free (linked);
+
+    return ret && p == end;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+vfs_s_index_read (struct vfs_s_super *super, const struct stat *st, const char *key,
+                  GString ** data, const char *file_name)
+{
+    struct vfs_class *me = super->me;
+    char *contents;
+    gsize len;
+    const char *p, *end, *r, *d;
+    vfs_s_index_header_t header;
+    struct vfs_s_inode **inodes;
+    guint32 i;
+
+    if (!g_file_get_contents (file_name, &contents, &len, nullptr))
+        return false;
+
+    p = contents;
+    end = contents + len;
+
+    r = vfs_s_index_take (&p, end, strlen (VFS_S_INDEX_SIGNATURE), sizeof (header));
+    if (r == nullptr || strncmp (r, VFS_S_INDEX_SIGNATURE, strlen (VFS_S_INDEX_SIGNATURE)) != 0)
+    {
+        g_free (contents);
+        return false;
+    }
+
+    memcpy (&header, r + strlen (VFS_S_INDEX_SIGNATURE), sizeof (header));
+
+    /* the same archive, not changed since the index was saved */
+    if (header.size != (guint64) st->st_size || header.mtime != (gint64) st->st_mtime
+        || header.key != strlen (key) || header.inodes == 0
+        || (r = vfs_s_index_take (&p, end, header.key, 0)) == nullptr
+        || strncmp (r, key, header.key) != 0 || header.data > (guint64) len
+        || (d = vfs_s_index_take (&p, end, (size_t) header.data, 0)) == nullptr
+        || !vfs_s_index_validate (&header, p, end))
+    {
+        g_free (contents);
+        return false;
+    }
+
+    inodes = g_new (struct vfs_s_inode *, header.inodes);
+    inodes[0] = super->root;
+
+    for (i = 1; i < header.inodes; i++)
+    {
+        vfs_s_index_inode_t rec;
+        struct stat ist;
+
+        memcpy (&rec, vfs_s_index_take (&p, end, sizeof (rec), 0), sizeof (rec));
+
+        memset (&ist, 0, sizeof (ist));
+        ist.st_size = (off_t) rec.size;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+        ist.st_rdev = (dev_t) rec.rdev;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLOCKS
+        ist.st_blocks = (blkcnt_t) rec.blocks;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+        ist.st_blksize = (blksize_t) rec.blksize;
+#endif
+        ist.st_atime = (time_t) rec.atime;
+        ist.st_mtime = (time_t) rec.mtime;
+        ist.st_ctime = (time_t) rec.ctime;
+        ist.st_mode = (mode_t) rec.mode;
+        ist.st_uid = (uid_t) rec.uid;
+        ist.st_gid = (gid_t) rec.gid;
+
+        inodes[i] = vfs_s_new_inode (me, super, &ist);
+        inodes[i]->data_offset = (off_t) rec.data_offset;
+        if (rec.linkname != 0)
+            inodes[i]->linkname =
+                g_strndup (vfs_s_index_take (&p, end, rec.linkname - 1, 0), rec.linkname - 1);
+    }
+
+    for (i = 0; i < header.entries; i++)
+    {
+        vfs_s_index_entry_t rec;
+        char *name;
+        struct vfs_s_entry *ent;
+
+        memcpy (&rec, vfs_s_index_take (&p, end, sizeof (rec), 0), sizeof (rec));
+        name = g_strndup (vfs_s_index_take (&p, end, rec.name, 0), rec.name);
+        ent = vfs_s_new_entry (me, name, inodes[rec.ino]);
+        vfs_s_insert_entry (me, inodes[rec.dir], ent);
+        g_free (name);
+    }
+
+    if (data != nullptr)
+        *data = header.data == 0 ? nullptr : g_string_new_len (d, (gssize) header.data);
+
+    g_free (inodes);
+    g_free (contents);
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Build the tree of archive from the cached index.
+ *
+ * @param super superblock of archive with the name and the empty root inode
+ * @param fs_name name of file system in the key of index, nullptr for the name of VFS class
+ * @param st stat of archive file
+ * @param data pointer to store data of file system saved with the tree (nullptr if there are
+ *        none), nullptr if they aren't needed
+ *
+ * @return true if the tree is built, false if there is no valid index for this archive
+ */
+
+bool
+vfs_s_index_load (struct vfs_s_super *super, const char *fs_name, const struct stat *st,
+                  GString ** data)
+{
+    char *key, *file_name;
+    bool ret;
+
+    key = vfs_s_index_key (super, fs_name);
+    file_name = vfs_s_index_file_name (key);
+    ret = vfs_s_index_read (super, st, key, data, file_name);
+    g_free (file_name);
+    g_free (key);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save the tree of archive into the cache of indexes. Errors are ignored.
+ *
+ * @param super superblock of archive those tree is read completely
+ * @param fs_name name of file system in the key of index, nullptr for the name of VFS class
+ * @param st stat of archive file
+ * @param data data of file system to save with the tree, nullptr if there are none
+ */
+
+void
+vfs_s_index_save (struct vfs_s_super *super, const char *fs_name, const struct stat *st,
+                  const GString * data)
+{
+    char *key, *file_name, *dir;
+
+    if (st->st_size < VFS_S_INDEX_MIN_SIZE)
+        return;
+
+    key = vfs_s_index_key (super, fs_name);
+    file_name = vfs_s_index_file_name (key);
+
+    dir = g_path_get_dirname (file_name);
+    if (!vfs_s_index_pruned)
+    {
+        vfs_s_index_pruned = true;
+        vfs_prune_cache_dir (dir, VFS_S_INDEX_MAX_AGE, VFS_S_INDEX_MAX_SIZE);
+    }
+    if (g_mkdir_with_parents (dir, 0700) == 0)
+        vfs_s_index_write (super, st, key, data, file_name);
+    g_free (dir);
+
+    g_free (file_name);
+    g_free (key);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove the index of archive from the cache. Used when archive is changed by mc itself:
+ * size and modification time may be not enough to notice the change.
+ *
+ * @param super superblock of archive
+ * @param fs_name name of file system in the key of index, nullptr for the name of VFS class
+ */
+
+void
+vfs_s_index_forget (const struct vfs_s_super *super, const char *fs_name)
+{
+    char *key, *file_name;
+
+    key = vfs_s_index_key (super, fs_name);
+    file_name = vfs_s_index_file_name (key);
+    unlink (file_name);
+    g_free (file_name);
+    g_free (key);
+}
+
+/* --------------------------------------------------------------------------------------------- */
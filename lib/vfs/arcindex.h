@@ -0,0 +1,30 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: cache of indexes of archives
+ */
+
+#ifndef MC__VFS_ARCINDEX_H
+#define MC__VFS_ARCINDEX_H
+
+#include <sys/stat.h>
+
+#include "xdirentry.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+bool vfs_s_index_load (struct vfs_s_super *super, const char *fs_name, const struct stat *st,
+                       GString ** data);
+void vfs_s_index_save (struct vfs_s_super *super, const char *fs_name, const struct stat *st,
+                       const GString * data);
+void vfs_s_index_forget (const struct vfs_s_super *super, const char *fs_name);
+
+/*** inline functions ****************************************************************************/
+#endif /* MC__VFS_ARCINDEX_H */
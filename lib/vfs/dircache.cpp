@@ -0,0 +1,471 @@
+/*
+   Virtual File System: persistent cache of directory listings
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: persistent cache of directory listings
+ *
+ * Network file systems keep listings of directories in memory only, and they are lost when the
+ * superblock is freed by VFS garbage collector. If the persistent cache is switched on, each
+ * listing read from server is saved in the cache directory of mc too. When the directory is
+ * entered again in a new session, the saved listing is used instead of reading from server:
+ *
+ * - if the parent directory is read from server already and it reports the same modification
+ *   time of this directory as when the listing was saved, the listing is fresh and it lives as
+ *   long as a listing read from server;
+ * - otherwise the listing is shown at once, but it expires in few seconds and it is read from
+ *   server at next access.
+ *
+ * Modification time of directory is changed when files are created, removed or renamed in it,
+ * but not when they are written, so sizes and times of files may be outdated until the directory
+ * cache expires or panel is reread.
+ *
+ * The cache is private cache of one machine, so records are stored in the native byte order.
+ *
+ * Listings of directories that are not visited anymore, or were removed or renamed on server,
+ * are never read again. So once per session, before the first listing is saved, listings
+ * older than a month are removed, and then the oldest ones while the cache is too large.
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/fileloc.h"
+#include "lib/mcconfig.h"       /* mc_config_get_cache_path() */
+#include "lib/timer.h"
+
+#include "vfs.h"
+#include "path.h"               /* vfs_path_build_url_params_str() */
+#include "utilvfs.h"            /* vfs_prune_cache_dir() */
+#include "xdirentry.h"
+
+#include "dircache.h"
+
+/*** global variables ****************************************************************************/
+
+bool vfs_persistent_dircache = false;
+
+/*** file scope macro definitions ****************************************************************/
+
+#define VFS_S_DIRCACHE_SIGNATURE "MC directory listing 1\n"
+
+/* lifetime of listing that can't be checked, in seconds */
+#define VFS_S_DIRCACHE_STALE_LIFETIME 5
+
+/* saved listings older than this, in seconds, are removed */
+#define VFS_S_DIRCACHE_MAX_AGE (30 * 24 * 60 * 60)
+
+/* if saved listings take more, the oldest ones are removed */
+#define VFS_S_DIRCACHE_MAX_SIZE (32 * 1024 * 1024)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    gint64 mtime;               /* modification time of directory, 0 if unknown */
+    guint64 lifetime;           /* lifetime of listing in microseconds */
+    guint32 entries;            /* number of entries */
+    guint32 key;                /* length of key */
+} vfs_s_dircache_header_t;
+
+typedef struct
+{
+    guint64 size;
+    guint64 rdev;
+    guint64 blocks;
+    gint64 data_offset;
+    gint64 atime;
+    gint64 mtime;
+    gint64 ctime;
+    guint32 mode;
+    guint32 uid;
+    guint32 gid;
+    guint32 blksize;
+    guint32 name;               /* length of name */
+    guint32 linkname;           /* length of link name plus 1, 0 if there is no link name */
+} vfs_s_dircache_entry_t;
+
+/*** file scope variables ************************************************************************/
+
+static bool vfs_s_dircache_pruned = false;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_dircache_key (const struct vfs_s_super *super, const char *path)
+{
+    char *url, *key;
+
+    url = vfs_path_build_url_params_str (super->path_element, false);
+    key = g_strconcat (super->me->name, ":", url, ":", path, (char *) nullptr);
+    g_free (url);
+
+    return key;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_dircache_file_name (const char *key)
+{
+    char *digest, *name;
+
+    digest = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+    name = g_build_filename (mc_config_get_cache_path (), MC_DIRCACHE_DIR, digest,
+                             (char *) nullptr);
+    g_free (digest);
+
+    return name;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get modification time of directory from the listing of its parent directory.
+ *
+ * @param super superblock
+ * @param path path to directory, root directory of site is ""
+ * @param fresh_only take listing of parent only if it is read from server
+ *
+ * @return modification time, 0 if it is unknown
+ */
+
+static time_t
+vfs_s_dircache_dir_mtime (const struct vfs_s_super *super, const char *path, bool fresh_only)
+{
+    char *parent_path, *name;
+    struct vfs_s_entry *parent, *ent = nullptr;
+    time_t mtime = 0;
+
+    if (*path == '\0')
+        return 0;
+
+    parent_path = g_path_get_dirname (path);
+    name = g_path_get_basename (path);
+
+    /* linear file systems keep all directories in the root one */
+    parent = vfs_s_subdir_find (super->root, DIR_IS_DOT (parent_path) ? "" : parent_path);
+    if (parent != nullptr && !(fresh_only && parent->ino->cached))
+        ent = vfs_s_subdir_find (parent->ino, name);
+    if (ent != nullptr && S_ISDIR (ent->ino->st.st_mode))
+        mtime = ent->ino->st.st_mtime;
+
+    g_free (name);
+    g_free (parent_path);
+
+    return mtime;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+vfs_s_dircache_take (const char **p, const char *end, size_t size)
+{
+    const char *rec = *p;
+
+    if ((size_t) (end - rec) < size)
+        return nullptr;
+
+    *p = rec + size;
+    return rec;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+vfs_s_dircache_validate (const vfs_s_dircache_header_t * header, const char *p, const char *end)
+{
+    guint32 i;
+
+    for (i = 0; i < header->entries; i++)
+    {
+        vfs_s_dircache_entry_t rec;
+        const char *r;
+
+        r = vfs_s_dircache_take (&p, end, sizeof (rec));
+        if (r == nullptr)
+            return false;
+
+        memcpy (&rec, r, sizeof (rec));
+        if (rec.name == 0 || vfs_s_dircache_take (&p, end, rec.name) == nullptr
+            || vfs_s_dircache_take (&p, end, rec.linkname == 0 ? 0 : rec.linkname - 1) == nullptr)
+            return false;
+    }
+
+    return p == end;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+vfs_s_dircache_read (struct vfs_s_inode *dir, const char *path, const char *key,
+                     const char *file_name)
+{
+    struct vfs_class *me = dir->super->me;
+    char *contents;
+    gsize len;
+    const char *p, *end, *r;
+    vfs_s_dircache_header_t header;
+    guint64 now, lifetime;
+    guint32 i;
+
+    if (!g_file_get_contents (file_name, &contents, &len, nullptr))
+        return false;
+
+    p = contents;
+    end = contents + len;
+
+    r = vfs_s_dircache_take (&p, end, strlen (VFS_S_DIRCACHE_SIGNATURE) + sizeof (header));
+    if (r == nullptr
+        || strncmp (r, VFS_S_DIRCACHE_SIGNATURE, strlen (VFS_S_DIRCACHE_SIGNATURE)) != 0)
+    {
+        g_free (contents);
+        return false;
+    }
+
+    memcpy (&header, r + strlen (VFS_S_DIRCACHE_SIGNATURE), sizeof (header));
+
+    /* protection against collision of file names */
+    if (header.key != strlen (key) || (r = vfs_s_dircache_take (&p, end, header.key)) == nullptr
+        || strncmp (r, key, header.key) != 0 || !vfs_s_dircache_validate (&header, p, end))
+    {
+        g_free (contents);
+        return false;
+    }
+
+    for (i = 0; i < header.entries; i++)
+    {
+        vfs_s_dircache_entry_t rec;
+        struct stat st;
+        struct vfs_s_inode *ino;
+        struct vfs_s_entry *ent;
+        char *name;
+
+        memcpy (&rec, vfs_s_dircache_take (&p, end, sizeof (rec)), sizeof (rec));
+
+        memset (&st, 0, sizeof (st));
+        st.st_size = (off_t) rec.size;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+        st.st_rdev = (dev_t) rec.rdev;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLOCKS
+        st.st_blocks = (blkcnt_t) rec.blocks;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+        st.st_blksize = (blksize_t) rec.blksize;
+#endif
+        st.st_atime = (time_t) rec.atime;
+        st.st_mtime = (time_t) rec.mtime;
+        st.st_ctime = (time_t) rec.ctime;
+        st.st_mode = (mode_t) rec.mode;
+        st.st_uid = (uid_t) rec.uid;
+        st.st_gid = (gid_t) rec.gid;
+
+        name = g_strndup (vfs_s_dircache_take (&p, end, rec.name), rec.name);
+        ino = vfs_s_new_inode (me, dir->super, &st);
+        ino->data_offset = (off_t) rec.data_offset;
+        if (rec.linkname != 0)
+            ino->linkname =
+                g_strndup (vfs_s_dircache_take (&p, end, rec.linkname - 1), rec.linkname - 1);
+        ent = vfs_s_new_entry (me, name, ino);
+        vfs_s_insert_entry (me, dir, ent);
+        g_free (name);
+    }
+
+    g_free (contents);
+
+    /* the listing is fresh if directory isn't changed since it was saved */
+    lifetime = header.lifetime;
+    if (header.mtime == 0
+        || header.mtime != (gint64) vfs_s_dircache_dir_mtime (dir->super, path, true))
+        lifetime = MIN (lifetime, VFS_S_DIRCACHE_STALE_LIFETIME * G_USEC_PER_SEC);
+
+    now = mc_timer_elapsed (mc_global.timer);
+    dir->timestamp = now + lifetime;
+    dir->cached = true;
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+vfs_s_dircache_write (struct vfs_s_inode *dir, const char *path, const char *key,
+                      const char *file_name)
+{
+    vfs_s_dircache_header_t header;
+    GString *buf;
+    GList *iter;
+    guint64 now;
+    bool ret;
+
+    now = mc_timer_elapsed (mc_global.timer);
+
+    memset (&header, 0, sizeof (header));
+    header.mtime = (gint64) vfs_s_dircache_dir_mtime (dir->super, path, false);
+    header.lifetime = dir->timestamp > now ? dir->timestamp - now : 0;
+    header.entries = g_queue_get_length (dir->subdir);
+    header.key = strlen (key);
+
+    buf = g_string_sized_new (sizeof (header) + header.entries * 128);
+    g_string_append (buf, VFS_S_DIRCACHE_SIGNATURE);
+    g_string_append_len (buf, (const char *) &header, sizeof (header));
+    g_string_append_len (buf, key, header.key);
+
+    for (iter = g_queue_peek_head_link (dir->subdir); iter != nullptr; iter = g_list_next (iter))
+    {
+        const struct vfs_s_entry *ent = VFS_ENTRY (iter->data);
+        const struct vfs_s_inode *ino = ent->ino;
+        vfs_s_dircache_entry_t rec;
+
+        memset (&rec, 0, sizeof (rec));
+        rec.size = (guint64) ino->st.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+        rec.rdev = (guint64) ino->st.st_rdev;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLOCKS
+        rec.blocks = (guint64) ino->st.st_blocks;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+        rec.blksize = (guint32) ino->st.st_blksize;
+#endif
+        rec.data_offset = (gint64) ino->data_offset;
+        rec.atime = (gint64) ino->st.st_atime;
+        rec.mtime = (gint64) ino->st.st_mtime;
+        rec.ctime = (gint64) ino->st.st_ctime;
+        rec.mode = (guint32) ino->st.st_mode;
+        rec.uid = (guint32) ino->st.st_uid;
+        rec.gid = (guint32) ino->st.st_gid;
+        rec.name = strlen (ent->name);
+        rec.linkname = ino->linkname == nullptr ? 0 : strlen (ino->linkname) + 1;
+
+        g_string_append_len (buf, (const char *) &rec, sizeof (rec));
+        g_string_append_len (buf, ent->name, rec.name);
+        if (ino->linkname != nullptr)
+            g_string_append_len (buf, ino->linkname, rec.linkname - 1);
+    }
+
+    ret = g_file_set_contents (file_name, buf->str, buf->len, nullptr);
+    g_string_free (buf, TRUE);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fill the directory from the saved listing.
+ *
+ * @param dir empty inode of directory
+ * @param path path to directory, root directory of site is ""
+ *
+ * @return true if the directory is filled, false if there is no saved listing or the cache is
+ *         switched off
+ */
+
+bool
+vfs_s_dircache_load (struct vfs_s_inode *dir, const char *path)
+{
+    char *key, *file_name;
+    bool ret;
+
+    if (!vfs_persistent_dircache || dir->super->path_element == nullptr)
+        return false;
+
+    key = vfs_s_dircache_key (dir->super, path);
+    file_name = vfs_s_dircache_file_name (key);
+    ret = vfs_s_dircache_read (dir, path, key, file_name);
+    g_free (file_name);
+    g_free (key);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save listing of directory read from server. Errors are ignored.
+ *
+ * @param dir inode of directory
+ * @param path path to directory, root directory of site is ""
+ */
+
+void
+vfs_s_dircache_save (struct vfs_s_inode *dir, const char *path)
+{
+    char *key, *file_name, *cache_dir;
+
+    if (!vfs_persistent_dircache || dir->super->path_element == nullptr)
+        return;
+
+    key = vfs_s_dircache_key (dir->super, path);
+    file_name = vfs_s_dircache_file_name (key);
+
+    cache_dir = g_path_get_dirname (file_name);
+    if (!vfs_s_dircache_pruned)
+    {
+        vfs_s_dircache_pruned = true;
+        vfs_prune_cache_dir (cache_dir, VFS_S_DIRCACHE_MAX_AGE, VFS_S_DIRCACHE_MAX_SIZE);
+    }
+    if (g_mkdir_with_parents (cache_dir, 0700) == 0)
+        vfs_s_dircache_write (dir, path, key, file_name);
+    g_free (cache_dir);
+
+    g_free (file_name);
+    g_free (key);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove saved listings of all directories of superblock those are in memory. Used when files
+ * are changed by mc itself: one of those directories is changed. Listings of other
+ * directories of site are removed by age, see vfs_prune_cache_dir().
+ *
+ * @param super superblock of linear file system
+ */
+
+void
+vfs_s_dircache_forget (const struct vfs_s_super *super)
+{
+    GList *iter;
+
+    if (!vfs_persistent_dircache || super->path_element == nullptr || super->root == nullptr)
+        return;
+
+    for (iter = g_queue_peek_head_link (super->root->subdir); iter != nullptr;
+         iter = g_list_next (iter))
+    {
+        char *key, *file_name;
+
+        key = vfs_s_dircache_key (super, VFS_ENTRY (iter->data)->name);
+        file_name = vfs_s_dircache_file_name (key);
+        unlink (file_name);
+        g_free (file_name);
+        g_free (key);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
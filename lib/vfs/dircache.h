@@ -0,0 +1,28 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: persistent cache of directory listings
+ */
+
+#ifndef MC__VFS_DIRCACHE_H
+#define MC__VFS_DIRCACHE_H
+
+#include "xdirentry.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+extern bool vfs_persistent_dircache;
+
+/*** declarations of public functions ************************************************************/
+
+bool vfs_s_dircache_load (struct vfs_s_inode *dir, const char *path);
+void vfs_s_dircache_save (struct vfs_s_inode *dir, const char *path);
+void vfs_s_dircache_forget (const struct vfs_s_super *super);
+
+/*** inline functions ****************************************************************************/
+#endif /* MC__VFS_DIRCACHE_H */
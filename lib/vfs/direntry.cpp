@@ -79,6 +79,9 @@
 #include "utilvfs.h"
 #include "xdirentry.h"
 #include "gc.h"                 /* vfs_rmstamp */
+#ifdef ENABLE_VFS_NET
+#include "dircache.h"
+#endif
 
 /*** global variables ****************************************************************************/
 
@@ -88,6 +91,9 @@
         if (VFS_SUBCLASS (me)->x != nullptr) \
             VFS_SUBCLASS (me)->x
 
+/* Directories with at least this number of entries get a name -> entry hash index */
+#define VFS_S_SUBDIR_INDEX_MIN 64
+
 /*** file scope type declarations ****************************************************************/
 
 struct dirhandle
@@ -102,6 +108,24 @@ struct dirhandle
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+vfs_s_subdir_index_build (struct vfs_s_inode *dir)
+{
+    GList *iter;
+
+    dir->subdir_index = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (iter = g_queue_peek_head_link (dir->subdir); iter != nullptr; iter = g_list_next (iter))
+    {
+        struct vfs_s_entry *ent = VFS_ENTRY (iter->data);
+
+        /* keep the first of duplicated names like the linear search does */
+        if (g_hash_table_lookup (dir->subdir_index, ent->name) == nullptr)
+            g_hash_table_insert (dir->subdir_index, ent->name, ent);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
 /* We were asked to create entries automagically */
 
 static struct vfs_s_entry *
@@ -186,7 +210,7 @@ vfs_s_find_entry_tree (struct vfs_class *me, struct vfs_s_inode *root,
 
     while (root != nullptr)
     {
-        GList *iter;
+        char c;
 
         while (IS_PATH_SEP (*path))     /* Strip leading '/' */
             path++;
@@ -200,15 +224,10 @@ vfs_s_find_entry_tree (struct vfs_class *me, struct vfs_s_inode *root,
         for (pseg = 0; path[pseg] != '\0' && !IS_PATH_SEP (path[pseg]); pseg++)
             ;
 
-        for (iter = g_queue_peek_head_link (root->subdir); iter != nullptr; iter = g_list_next (iter))
-        {
-            ent = VFS_ENTRY (iter->data);
-            if (strlen (ent->name) == pseg && strncmp (ent->name, path, pseg) == 0)
-                /* FOUND! */
-                break;
-        }
-
-        ent = iter != nullptr ? VFS_ENTRY (iter->data) : nullptr;
+        c = path[pseg];
+        path[pseg] = '\0';
+        ent = vfs_s_subdir_find (root, path);
+        path[pseg] = c;
 
         if (ent == nullptr && (flags & (FL_MKFILE | FL_MKDIR)) != 0)
             ent = vfs_s_automake (me, root, path, flags);
@@ -240,7 +259,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
 {
     struct vfs_s_entry *ent = nullptr;
     char *const path = g_strdup (a_path);
-    GList *iter;
+    bool expired = false;
 
     if (root->super->root != root)
         vfs_die ("We have to use _real_ root. Always. Sorry.");
@@ -263,8 +282,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
         return ent;
     }
 
-    iter = g_queue_find_custom (root->subdir, path, (GCompareFunc) vfs_s_entry_compare);
-    ent = iter != nullptr ? VFS_ENTRY (iter->data) : nullptr;
+    ent = vfs_s_subdir_find (root, path);
 
     if (ent != nullptr && !VFS_SUBCLASS (me)->dir_uptodate (me, ent->ino))
     {
@@ -273,25 +291,38 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
 #endif
         vfs_s_free_entry (me, ent);
         ent = nullptr;
+        expired = true;
     }
 
     if (ent == nullptr)
     {
         struct vfs_s_inode *ino;
+        bool loaded = false;
 
         ino = vfs_s_new_inode (me, root->super, vfs_s_default_stat (me, S_IFDIR | 0755));
         ent = vfs_s_new_entry (me, path, ino);
-        if (VFS_SUBCLASS (me)->dir_load (me, ino, path) == -1)
+#ifdef ENABLE_VFS_NET
+        /* saved listing is used only if directory isn't read in this session yet */
+        if (!expired && (me->flags & VFSF_DIRCACHE) != 0)
+            loaded = vfs_s_dircache_load (ino, path);
+#endif
+        if (!loaded)
         {
-            vfs_s_free_entry (me, ent);
-            g_free (path);
-            return nullptr;
+            if (VFS_SUBCLASS (me)->dir_load (me, ino, path) == -1)
+            {
+                vfs_s_free_entry (me, ent);
+                g_free (path);
+                return nullptr;
+            }
+#ifdef ENABLE_VFS_NET
+            if ((me->flags & VFSF_DIRCACHE) != 0)
+                vfs_s_dircache_save (ino, path);
+#endif
         }
 
         vfs_s_insert_entry (me, root, ent);
 
-        iter = g_queue_find_custom (root->subdir, path, (GCompareFunc) vfs_s_entry_compare);
-        ent = iter != nullptr ? VFS_ENTRY (iter->data) : nullptr;
+        ent = vfs_s_subdir_find (root, path);
     }
     if (ent == nullptr)
         vfs_die ("find_linear: success but directory is not there\n");
@@ -821,6 +852,26 @@ vfs_s_setctl (const vfs_path_t * vpath, int ctlop, void *arg)
     case VFS_SETCTL_FLUSH:
         path_element->clazz->flush = true;
         return 1;
+    case VFS_SETCTL_BATCH:
+        {
+            struct vfs_s_subclass *sub;
+            struct vfs_s_super *super;
+            const char *dir;
+
+            /* local and some other classes use this function but aren't subclasses */
+            if ((path_element->clazz->flags & VFSF_REMOTE) == 0)
+                return 0;
+
+            sub = VFS_SUBCLASS (path_element->clazz);
+            if (sub->batch == nullptr)
+                return 0;
+
+            dir = vfs_s_get_path (vpath, &super, 0);
+            if (dir == nullptr)
+                return 0;
+
+            return sub->batch (path_element->clazz, super, dir, (GArray *) arg) == 0 ? 1 : 0;
+        }
     default:
         return 0;
     }
@@ -919,6 +970,9 @@ vfs_s_free_inode (struct vfs_class *me, struct vfs_s_inode *ino)
         return;
     }
 
+    /* entries are freed all together, don't maintain the index one by one */
+    vfs_s_subdir_index_free (ino);
+
     while (g_queue_get_length (ino->subdir) != 0)
     {
         struct vfs_s_entry *entry;
@@ -964,7 +1018,24 @@ void
 vfs_s_free_entry (struct vfs_class *me, struct vfs_s_entry *ent)
 {
     if (ent->dir != nullptr)
-        g_queue_remove (ent->dir->subdir, ent);
+    {
+        struct vfs_s_inode *dir = ent->dir;
+
+        g_queue_remove (dir->subdir, ent);
+
+        if (dir->subdir_index != nullptr
+            && g_hash_table_lookup (dir->subdir_index, ent->name) == ent)
+        {
+            GList *iter;
+
+            g_hash_table_remove (dir->subdir_index, ent->name);
+
+            /* entry with the same name, if any, becomes visible now */
+            iter = g_queue_find_custom (dir->subdir, ent->name, vfs_s_entry_compare);
+            if (iter != nullptr)
+                g_hash_table_insert (dir->subdir_index, VFS_ENTRY (iter->data)->name, iter->data);
+        }
+    }
 
     MC_PTR_FREE (ent->name);
 
@@ -987,7 +1058,7 @@ vfs_s_insert_entry (struct vfs_class *me, struct vfs_s_inode *dir, struct vfs_s_
     ent->dir = dir;
 
     ent->ino->st.st_nlink++;
-    g_queue_push_tail (dir->subdir, ent);
+    vfs_s_subdir_append (dir, ent);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1001,6 +1072,70 @@ vfs_s_entry_compare (const void *a, const void *b)
     return strcmp (e->name, name);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append entry to the directory list keeping the name index in sync.
+ * Neither ent->dir nor the link counter are touched, see vfs_s_insert_entry().
+ *
+ * @param dir directory inode
+ * @param ent entry to append
+ */
+
+void
+vfs_s_subdir_append (struct vfs_s_inode *dir, struct vfs_s_entry *ent)
+{
+    g_queue_push_tail (dir->subdir, ent);
+
+    if (dir->subdir_index != nullptr
+        && g_hash_table_lookup (dir->subdir_index, ent->name) == nullptr)
+        g_hash_table_insert (dir->subdir_index, ent->name, ent);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find entry by name in the directory.
+ * Small directories are searched linearly. Once directory becomes large enough,
+ * the name index is built and is used for all subsequent lookups.
+ *
+ * @param dir directory inode
+ * @param name entry name
+ *
+ * @return entry if found, nullptr otherwise
+ */
+
+struct vfs_s_entry *
+vfs_s_subdir_find (struct vfs_s_inode *dir, const char *name)
+{
+    GList *iter;
+
+    if (dir->subdir_index == nullptr && g_queue_get_length (dir->subdir) >= VFS_S_SUBDIR_INDEX_MIN)
+        vfs_s_subdir_index_build (dir);
+
+    if (dir->subdir_index != nullptr)
+        return VFS_ENTRY (g_hash_table_lookup (dir->subdir_index, name));
+
+    iter = g_queue_find_custom (dir->subdir, name, vfs_s_entry_compare);
+    return iter != nullptr ? VFS_ENTRY (iter->data) : nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop the name index of directory. It will be rebuilt on demand.
+ * Must be called if names of entries are changed in place.
+ *
+ * @param dir directory inode
+ */
+
+void
+vfs_s_subdir_index_free (struct vfs_s_inode *dir)
+{
+    if (dir->subdir_index != nullptr)
+    {
+        g_hash_table_destroy (dir->subdir_index);
+        dir->subdir_index = nullptr;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 struct stat *
@@ -1234,6 +1369,10 @@ vfs_s_invalidate (struct vfs_class *me, struct vfs_s_super *super)
 {
     if (!super->want_stale)
     {
+#ifdef ENABLE_VFS_NET
+        if ((me->flags & VFSF_DIRCACHE) != 0)
+            vfs_s_dircache_forget (super);
+#endif
         vfs_s_free_inode (me, super->root);
         super->root = vfs_s_new_inode (me, super, vfs_s_default_stat (me, S_IFDIR | 0755));
     }
@@ -1721,6 +1860,9 @@ vfs_s_normalize_filename_leading_spaces (struct vfs_s_inode *root_inode, size_t
 {
     GList *iter;
 
+    /* names are changed in place */
+    vfs_s_subdir_index_free (root_inode);
+
     for (iter = g_queue_peek_head_link (root_inode->subdir); iter != nullptr;
          iter = g_list_next (iter))
     {
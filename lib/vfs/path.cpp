@@ -517,6 +517,134 @@ vfs_path_from_str_uri_parser (char *path)
     return vpath;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check if token can be appended to path as is, without canonicalization and parsing:
+ * it is relative and consists of names only (no "", "." and ".." components, no VFS prefixes
+ * and encodings).
+ */
+
+static bool
+vfs_path_token_is_plain (const char *token)
+{
+    const char *p = token;
+
+    while (true)
+    {
+        const char *end;
+        size_t len;
+
+        end = strchr (p, PATH_SEP);
+        len = end == nullptr ? strlen (p) : (size_t) (end - p);
+
+        if (len == 0 || (len == 1 && p[0] == '.') || (len == 2 && p[0] == '.' && p[1] == '.'))
+            return false;
+
+        if (end == nullptr)
+            break;
+
+        p = end + 1;
+    }
+
+    return strstr (token, VFS_ENCODING_PREFIX) == nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static size_t
+vfs_path_append_token (char *buffer, size_t len, const char *token)
+{
+    size_t token_len;
+
+    if (len != 0 && !IS_PATH_SEP (buffer[len - 1]))
+        buffer[len++] = PATH_SEP;
+
+    token_len = strlen (token);
+    memcpy (buffer + len, token, token_len + 1);
+
+    return len + token_len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append plain tokens to the last element of path: elements are copied and names are added
+ * to path of the last element and to string representation, which is much cheaper than
+ * building string of whole path and parsing it again.
+ *
+ * @return newly allocated path object or nullptr if tokens should be appended by parser
+ */
+
+static vfs_path_t *
+vfs_path_append_plain (const vfs_path_t * vpath, const char *first_element, va_list args)
+{
+    const vfs_path_element_t *last;
+    vfs_path_element_t *element;
+    vfs_path_t *ret_vpath;
+    char *path, *str;
+    size_t path_len, str_len, tokens_len = 0;
+    const char *token;
+    va_list tokens;
+    int count, i;
+
+    count = vfs_path_elements_count (vpath);
+    /* string of path created with flags may differ from one of its elements */
+    if (vpath->relative || vpath->str == nullptr || !IS_PATH_SEP (*vpath->str) || count == 0)
+        return nullptr;
+
+    last = vfs_path_get_by_index (vpath, -1);
+#ifdef HAVE_CHARSET
+    /* names should be recoded */
+    if (last->encoding != nullptr)
+        return nullptr;
+#endif
+
+    va_copy (tokens, args);
+    for (token = first_element; token != nullptr; token = va_arg (tokens, const char *))
+    {
+        if (!vfs_path_token_is_plain (token))
+            break;
+        /* with separator */
+        tokens_len += strlen (token) + 1;
+    }
+    va_end (tokens);
+
+    if (token != nullptr)
+        return nullptr;
+
+    path_len = strlen (last->path);
+    path = (char *) g_malloc (path_len + tokens_len + 1);
+    memcpy (path, last->path, path_len + 1);
+    str_len = strlen (vpath->str);
+    str = (char *) g_malloc (str_len + tokens_len + 1);
+    memcpy (str, vpath->str, str_len + 1);
+
+    for (token = first_element; token != nullptr; token = va_arg (args, const char *))
+    {
+        path_len = vfs_path_append_token (path, path_len, token);
+        str_len = vfs_path_append_token (str, str_len, token);
+    }
+
+    ret_vpath = vfs_path_new ();
+    g_array_set_size (ret_vpath->path, count);
+
+    for (i = 0; i < count - 1; i++)
+        g_array_index (ret_vpath->path, vfs_path_element_t *, i) =
+            vfs_path_element_clone (vfs_path_get_by_index (vpath, i));
+
+    element = g_new (vfs_path_element_t, 1);
+    *element = *last;
+    element->user = g_strdup (last->user);
+    element->password = g_strdup (last->password);
+    element->host = g_strdup (last->host);
+    element->path = path;
+    element->vfs_prefix = g_strdup (last->vfs_prefix);
+    g_array_index (ret_vpath->path, vfs_path_element_t *, count - 1) = element;
+
+    ret_vpath->str = str;
+
+    return ret_vpath;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Add element's class info to result string (such as VFS name, host, encoding etc)
@@ -1258,6 +1386,14 @@ vfs_path_append_new (const vfs_path_t * vpath, const char *first_element, ...)
     if (vpath == nullptr || first_element == nullptr)
         return nullptr;
 
+    /* names of files are usually appended to directory in loops */
+    va_start (args, first_element);
+    ret_vpath = vfs_path_append_plain (vpath, first_element, args);
+    va_end (args);
+
+    if (ret_vpath != nullptr)
+        return ret_vpath;
+
     va_start (args, first_element);
     str_path = mc_build_filenamev (first_element, args);
     va_end (args);
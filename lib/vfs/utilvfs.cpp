@@ -37,6 +37,8 @@
 #include <grp.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "lib/global.h"
 #include "lib/unixcompat.h"
@@ -67,11 +69,27 @@
 
 /*** file scope type declarations ****************************************************************/
 
+/* file found by pruning of cache directory */
+typedef struct
+{
+    char *name;
+    time_t mtime;
+    off_t size;
+} vfs_cache_file_t;
+
 /*** file scope variables ************************************************************************/
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
+static int
+vfs_cache_file_cmp (gconstpointer a, gconstpointer b)
+{
+    const vfs_cache_file_t *fa = (const vfs_cache_file_t *) a;
+    const vfs_cache_file_t *fb = (const vfs_cache_file_t *) b;
+
+    return fa->mtime < fb->mtime ? -1 : (fa->mtime > fb->mtime ? 1 : 0);
+}
 
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
@@ -367,3 +385,73 @@ vfs_get_password (const char *msg)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Prune persistent cache directory of mc: remove files older than @max_age, then the oldest
+ * ones while total size of files is larger than @max_size.
+ *
+ * @param cache_dir cache directory
+ * @param max_age maximal age of file, in seconds
+ * @param max_size maximal total size of files, in bytes
+ */
+
+void
+vfs_prune_cache_dir (const char *cache_dir, time_t max_age, off_t max_size)
+{
+    GDir *dir;
+    const char *name;
+    GArray *files;
+    time_t now;
+    off_t total = 0;
+    guint i;
+
+    dir = g_dir_open (cache_dir, 0, nullptr);
+    if (dir == nullptr)
+        return;
+
+    files = g_array_new (FALSE, FALSE, sizeof (vfs_cache_file_t));
+    now = time (nullptr);
+
+    while ((name = g_dir_read_name (dir)) != nullptr)
+    {
+        vfs_cache_file_t file;
+        struct stat st;
+
+        file.name = g_build_filename (cache_dir, name, (char *) nullptr);
+
+        if (stat (file.name, &st) != 0 || !S_ISREG (st.st_mode))
+            g_free (file.name);
+        else if (now - st.st_mtime > max_age)
+        {
+            unlink (file.name);
+            g_free (file.name);
+        }
+        else
+        {
+            file.mtime = st.st_mtime;
+            file.size = st.st_size;
+            total += st.st_size;
+            g_array_append_val (files, file);
+        }
+    }
+
+    g_dir_close (dir);
+
+    if (total > max_size)
+        g_array_sort (files, vfs_cache_file_cmp);
+
+    for (i = 0; i < files->len; i++)
+    {
+        vfs_cache_file_t *file = &g_array_index (files, vfs_cache_file_t, i);
+
+        if (total > max_size)
+        {
+            unlink (file->name);
+            total -= file->size;
+        }
+        g_free (file->name);
+    }
+
+    g_array_free (files, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
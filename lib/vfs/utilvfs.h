@@ -48,6 +48,8 @@ char *vfs_get_password (const char *msg);
 
 char *vfs_get_local_username (void);
 
+void vfs_prune_cache_dir (const char *cache_dir, time_t max_age, off_t max_size);
+
 bool vfs_parse_filetype (const char *s, size_t * ret_skipped, mode_t * ret_type);
 bool vfs_parse_fileperms (const char *s, size_t * ret_skipped, mode_t * ret_perms);
 bool vfs_parse_filemode (const char *s, size_t * ret_skipped, mode_t * ret_mode);
@@ -44,11 +44,15 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <unistd.h>             /* copy_file_range() */
 
 #ifdef __linux__
 #ifdef HAVE_LINUX_FS_H
 #include <linux/fs.h>
 #endif /* HAVE_LINUX_FS_H */
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif /* HAVE_SYS_SENDFILE_H */
 #ifdef HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif /* HAVE_SYS_IOCTL_H */
@@ -715,3 +719,62 @@ vfs_clone_file (int dest_vfs_fd, int src_vfs_fd)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy data between local files in kernel, without passing them through user space buffer.
+ * Data are copied from the current position of source file to the current position of
+ * destination file, both positions are advanced.
+ *
+ * @param dest_vfs_fd mc VFS file handler of destination file
+ * @param src_vfs_fd mc VFS file handler of source file
+ * @param count number of bytes to copy
+ *
+ * @return number of bytes copied, 0 at end of source file, -1 on error or if the files can't be
+ *         copied in kernel. In the last case errno is EOPNOTSUPP, EXDEV, EINVAL or ENOSYS and
+ *         the file positions are unchanged.
+ */
+
+ssize_t
+vfs_copy_file_range (int dest_vfs_fd, int src_vfs_fd, size_t count)
+{
+#if defined(HAVE_COPY_FILE_RANGE) || (defined(__linux__) && defined(HAVE_SYS_SENDFILE_H))
+    void *dest_fd = nullptr;
+    void *src_fd = nullptr;
+    struct vfs_class *dest_class;
+    struct vfs_class *src_class;
+    ssize_t ret = -1;
+
+    dest_class = vfs_class_find_by_handle (dest_vfs_fd, &dest_fd);
+    src_class = vfs_class_find_by_handle (src_vfs_fd, &src_fd);
+    if (dest_class == nullptr || src_class == nullptr || (dest_class->flags & VFSF_LOCAL) == 0
+        || (src_class->flags & VFSF_LOCAL) == 0)
+    {
+        errno = EOPNOTSUPP;
+        return (-1);
+    }
+    if (dest_fd == nullptr || src_fd == nullptr)
+    {
+        errno = EBADF;
+        return (-1);
+    }
+
+#ifdef HAVE_COPY_FILE_RANGE
+    ret = copy_file_range (*(int *) src_fd, nullptr, *(int *) dest_fd, nullptr, count, 0);
+    if (ret != -1 || (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP))
+        return ret;
+#endif
+
+#if defined(__linux__) && defined(HAVE_SYS_SENDFILE_H)
+    ret = sendfile (*(int *) dest_fd, *(int *) src_fd, nullptr, count);
+#endif
+
+    return ret;
+#else
+    (void) dest_vfs_fd;
+    (void) src_vfs_fd;
+    (void) count;
+    errno = EOPNOTSUPP;
+    return (-1);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -116,6 +116,7 @@ typedef int vfs_flags_t;
 #define VFSF_REMOTE (1 << 2)
 #define VFSF_READONLY (1 << 3)
 #define VFSF_USETMP (1 << 4)
+#define VFSF_DIRCACHE (1 << 5)     /* Listings of directories can be kept in persistent cache */
 
 /* Operations for mc_ctl - on open file */
 enum
@@ -133,9 +134,25 @@ enum
 
     /* Setting this makes vfs layer give out potentially incorrect data,
        but it also makes some operations much faster. Use with caution. */
-    VFS_SETCTL_STALE_DATA
+    VFS_SETCTL_STALE_DATA,
+    /* Files of directory will be read soon. Argument is GPtrArray of names of files.
+       File system may get them all at once, which is much faster for some of them. */
+    VFS_SETCTL_PREFETCH,
+    /* Do operations on files of directory. Argument is GArray of vfs_batch_t.
+       Returns 1 if operations were done (result of each one is in its error field)
+       and 0 if file system can't do them at once. */
+    VFS_SETCTL_BATCH
 };
 
+/* Operations of VFS_SETCTL_BATCH */
+typedef enum
+{
+    VFS_BATCH_UNLINK,
+    VFS_BATCH_CHMOD,
+    VFS_BATCH_CHOWN,
+    VFS_BATCH_MKDIR
+} vfs_batch_op_t;
+
 /*** structures declarations (and typedefs of structures)*****************************************/
 
 typedef struct vfs_class
@@ -207,6 +224,17 @@ typedef struct vfs_class
     /* *INDENT-ON* */
 } vfs_class;
 
+/* One operation of VFS_SETCTL_BATCH */
+typedef struct
+{
+    vfs_batch_op_t op;
+    const char *name;           /* name of file in directory */
+    mode_t mode;                /* VFS_BATCH_CHMOD, VFS_BATCH_MKDIR */
+    uid_t uid;                  /* VFS_BATCH_CHOWN */
+    gid_t gid;                  /* VFS_BATCH_CHOWN */
+    int error;                  /* 0 on success, errno otherwise */
+} vfs_batch_t;
+
 /*
  * This union is used to ensure that there is enough space for the
  * filename (d_name) when the dirent structure is created.
@@ -296,6 +324,8 @@ int vfs_preallocate (int dest_desc, off_t src_fsize, off_t dest_fsize);
 
 int vfs_clone_file (int dest_vfs_fd, int src_vfs_fd);
 
+ssize_t vfs_copy_file_range (int dest_vfs_fd, int src_vfs_fd, size_t count);
+
 /**
  * Interface functions described in interface.c
  */
@@ -88,10 +88,13 @@ struct vfs_s_inode
                                    use only for directories because they
                                    cannot be hardlinked */
     GQueue *subdir;             /* If this is a directory, its entry. List of vfs_s_entry */
+    GHashTable *subdir_index;   /* name -> vfs_s_entry index of subdir, built lazily for
+                                   large directories by vfs_s_subdir_find() */
     struct stat st;             /* Parameters of this inode */
     char *linkname;             /* Symlink's contents */
     char *localname;            /* Filename of local file, if we have one */
     guint64 timestamp;          /* Subclass specific */
+    bool cached;                /* Directory listing is taken from persistent cache */
     off_t data_offset;          /* Subclass specific */
 };
 
@@ -145,6 +148,10 @@ struct vfs_s_subclass
     int (*linear_start) (struct vfs_class * me, vfs_file_handler_t * fh, off_t from);
     ssize_t (*linear_read) (struct vfs_class * me, vfs_file_handler_t * fh, void *buf, size_t len);
     void (*linear_close) (struct vfs_class * me, vfs_file_handler_t * fh);
+
+    /* operations on files of directory at once, see VFS_SETCTL_BATCH */
+    int (*batch) (struct vfs_class * me, struct vfs_s_super * super, const char *dir,
+                  GArray * ops);        /* optional */
     /* *INDENT-ON* */
 };
 
@@ -162,6 +169,9 @@ struct vfs_s_entry *vfs_s_new_entry (struct vfs_class *me, const char *name,
 void vfs_s_free_entry (struct vfs_class *me, struct vfs_s_entry *ent);
 void vfs_s_insert_entry (struct vfs_class *me, struct vfs_s_inode *dir, struct vfs_s_entry *ent);
 int vfs_s_entry_compare (const void *a, const void *b);
+void vfs_s_subdir_append (struct vfs_s_inode *dir, struct vfs_s_entry *ent);
+struct vfs_s_entry *vfs_s_subdir_find (struct vfs_s_inode *dir, const char *name);
+void vfs_s_subdir_index_free (struct vfs_s_inode *dir);
 struct stat *vfs_s_default_stat (struct vfs_class *me, mode_t mode);
 
 struct vfs_s_entry *vfs_s_generate_entry (struct vfs_class *me, const char *name,
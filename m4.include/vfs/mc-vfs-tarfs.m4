@@ -7,6 +7,17 @@ AC_DEFUN([mc_VFS_TARFS],
 	enable_vfs_tar="yes"
 	mc_VFS_ADDNAME([tar])
 	AC_DEFINE([ENABLE_VFS_TAR], [1], [Support for tar filesystem])
+
+	dnl zlib is used to read files from gzipped tar archives without decompression of whole archive
+	AC_CHECK_HEADER([zlib.h],
+	    [AC_CHECK_LIB([z], [inflatePrime], [found_zlib=yes])])
+	if test x"$found_zlib" = x"yes"; then
+	    AC_DEFINE([HAVE_ZLIB], [1], [Define to use zlib for random access to gzipped tar archives])
+	    ZLIB_LIBS="-lz"
+	    MCLIBS="$MCLIBS $ZLIB_LIBS"
+	fi
     fi
+    AC_SUBST(ZLIB_LIBS)
     AM_CONDITIONAL(ENABLE_VFS_TAR, [test "$enable_vfs" = "yes" -a x"$enable_vfs_tar" = x"yes"])
+    AM_CONDITIONAL(HAVE_ZLIB, [test x"$found_zlib" = x"yes"])
 ])
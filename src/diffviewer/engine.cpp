@@ -0,0 +1,1394 @@
+/*
+   File difference viewer: comparison of files
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: comparison of files for diff viewer
+ *
+ * Files are compared in memory: local files are mapped, other VFS files are read to the heap.
+ *
+ * The common head and tail of files are skipped first. Without options that make different
+ * lines equal, they are compared as bytes; otherwise line by line. For large files the tail is
+ * scanned by another thread while the head is scanned by the calling one.
+ *
+ * Lines of the rest are put to classes of equal lines by hash. Lines whose class doesn't occur
+ * in other file can't match anything and are changed for sure, so only remaining ones are
+ * compared further. These are compared by histogram diff: the region is split around the
+ * longest run of equal lines that contains the least frequent line, and both parts are
+ * compared in the same way. Regions without such line are compared by Myers' algorithm in
+ * linear space, which gives up at some cost unless the minimal difference is requested.
+ * The latter is used for the whole text in that case.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#include "lib/global.h"
+#include "lib/memscan.h"        /* mc_memcount(), mc_memrchr() */
+#include "lib/vfs/vfs.h"
+
+#include "engine.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#ifdef HAVE_MMAP
+#ifndef MAP_FILE
+#define MAP_FILE 0
+#endif
+#endif /* HAVE_MMAP */
+
+/* head and tail of files of this size are scanned in parallel */
+#define DIFF_PARALLEL_MIN (4 * 1024 * 1024)
+
+/* bytes compared at once while head and tail of files are scanned */
+#define DIFF_TRIM_CHUNK 65536
+
+/* more frequent lines are not used to split regions in histogram diff */
+#define DIFF_MAX_CHAIN 64
+
+/* minimal cost after which Myers' algorithm gives up */
+#define DIFF_COST_MIN 4096
+#define DIFF_COST_MIN_FAST 256
+
+#define DIFF_HASH_MUL G_GUINT64_CONSTANT (0x9e3779b97f4a7c15)
+#define DIFF_HASH(h, w) (((h) ^ (w)) * DIFF_HASH_MUL)
+
+/*** file scope type declarations ****************************************************************/
+
+/* iterator over bytes of line as they are compared */
+typedef struct
+{
+    const char *p;
+    const char *end;            /* end of line without newline */
+    bool newline;               /* line has newline */
+    int col;                    /* column for tab expansion */
+    int spaces;                 /* spaces of expanded tabs to return */
+} diff_line_iter_t;
+
+/* common head and tail of texts */
+typedef struct
+{
+    const diff_options_t *opt;
+    bool raw;                   /* lines are compared as bytes */
+    const diff_text_t *text[2];
+
+    /* positions reached by scans, read by the other one */
+    gpointer head[2];
+    gpointer tail[2];
+
+    int head_lines;
+    int tail_lines;
+} diff_trim_t;
+
+/* class of equal lines */
+typedef struct
+{
+    const char *line;           /* the first line of class */
+    size_t len;
+    int count[2];               /* number of lines in both texts */
+} diff_class_t;
+
+/* entry of hash table of classes */
+typedef struct
+{
+    guint32 hash;
+    int cls;                    /* -1 if entry is free */
+} diff_bucket_t;
+
+/* lines between the common head and tail of text */
+typedef struct
+{
+    int n;
+    const char **line;          /* beginnings of lines, line[n] is the end of the last one */
+    int *cls;                   /* classes of lines */
+    char *changed;
+    int len;                    /* number of lines that can match lines of other text */
+    int *seq;                   /* their classes */
+    int *idx;                   /* their numbers */
+} diff_side_t;
+
+/* region of sequences */
+typedef struct
+{
+    int off[2];
+    int lim[2];
+    bool histogram;
+} diff_region_t;
+
+typedef struct
+{
+    const diff_options_t *opt;
+    bool raw;
+    diff_side_t side[2];
+    int too_expensive;          /* cost after which Myers' algorithm gives up, 0 if never */
+
+    /* histogram diff */
+    int *count;                 /* number of lines of class in region of the 1st sequence */
+    int *first;                 /* their first occurrence */
+    int *next;                  /* next occurrence of line of the 1st sequence */
+
+    /* Myers' algorithm: the furthest points on diagonals */
+    int *fdiag;
+    int *bdiag;
+} diff_ctx_t;
+
+/*** file scope variables ************************************************************************/
+
+/* scan head and tail of large files in parallel */
+static bool diff_parallel = true;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static inline bool
+diff_options_raw (const diff_options_t * opt)
+{
+    return !(opt->strip_trailing_cr || opt->ignore_tab_expansion || opt->ignore_space_change
+             || opt->ignore_all_space || opt->ignore_case);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline const char *
+diff_line_end (const char *p, const char *end)
+{
+    const char *eol;
+
+    eol = static_cast<const char *> (memchr (p, '\n', end - p));
+    return eol == nullptr ? end : eol + 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline const char *
+diff_line_begin (const char *begin, const char *p)
+{
+    const char *eol;
+
+    /* skip newline of the line itself */
+    eol = static_cast<const char *> (mc_memrchr (begin, '\n', p - 1 - begin));
+    return eol == nullptr ? begin : eol + 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+diff_line_iter_init (diff_line_iter_t * it, const diff_options_t * opt, const char *p, size_t len)
+{
+    it->p = p;
+    it->end = p + len;
+    it->newline = len != 0 && it->end[-1] == '\n';
+    if (it->newline)
+    {
+        it->end--;
+        if (opt->strip_trailing_cr && it->end > p && it->end[-1] == '\r')
+            it->end--;
+    }
+    it->col = 0;
+    it->spaces = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get next byte of line as it is compared.
+ *
+ * @return byte, -1 at the end of line
+ */
+
+static int
+diff_line_iter_next (diff_line_iter_t * it, const diff_options_t * opt)
+{
+    while (true)
+    {
+        int c;
+
+        if (it->spaces != 0)
+        {
+            it->spaces--;
+            return ' ';
+        }
+
+        if (it->p == it->end)
+        {
+            /* trailing whitespace and missing newline don't matter if whitespace is ignored */
+            if (it->newline && !opt->ignore_space_change && !opt->ignore_all_space)
+            {
+                it->newline = false;
+                return '\n';
+            }
+            return (-1);
+        }
+
+        c = (unsigned char) *it->p;
+
+        if (opt->ignore_all_space && g_ascii_isspace (c))
+        {
+            it->p++;
+            continue;
+        }
+
+        if (opt->ignore_space_change && g_ascii_isspace (c))
+        {
+            while (it->p < it->end && g_ascii_isspace (*it->p))
+                it->p++;
+            if (it->p == it->end)
+                continue;
+            return ' ';
+        }
+
+        if (opt->ignore_tab_expansion && (c == ' ' || c == '\t'))
+        {
+            int col = it->col;
+
+            for (; it->p < it->end && (*it->p == ' ' || *it->p == '\t'); it->p++)
+                it->col = *it->p == '\t' ? (it->col / 8 + 1) * 8 : it->col + 1;
+            it->spaces = it->col - col;
+            continue;
+        }
+
+        it->p++;
+        it->col++;
+        return opt->ignore_case ? g_ascii_tolower (c) : c;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint32
+diff_line_hash (const diff_options_t * opt, bool raw, const char *p, size_t len)
+{
+    guint64 h = len;
+
+    if (raw)
+    {
+        guint64 w;
+
+        for (; len >= sizeof (w); p += sizeof (w), len -= sizeof (w))
+        {
+            memcpy (&w, p, sizeof (w));
+            h = DIFF_HASH (h, w);
+            h ^= h >> 32;
+        }
+
+        w = 0;
+        memcpy (&w, p, len);
+        h = DIFF_HASH (h, w);
+    }
+    else
+    {
+        diff_line_iter_t it;
+        int c;
+
+        diff_line_iter_init (&it, opt, p, len);
+        h = 0;
+        while ((c = diff_line_iter_next (&it, opt)) != -1)
+            h = DIFF_HASH (h, (guint64) c);
+    }
+
+    return (guint32) (h ^ (h >> 32));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+diff_line_equal (const diff_options_t * opt, bool raw, const char *p1, size_t len1,
+                 const char *p2, size_t len2)
+{
+    diff_line_iter_t it1, it2;
+    int c;
+
+    if (raw)
+        return len1 == len2 && memcmp (p1, p2, len1) == 0;
+
+    diff_line_iter_init (&it1, opt, p1, len1);
+    diff_line_iter_init (&it2, opt, p2, len2);
+
+    do
+    {
+        c = diff_line_iter_next (&it1, opt);
+        if (c != diff_line_iter_next (&it2, opt))
+            return false;
+    }
+    while (c != -1);
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Skip equal lines at the beginning of texts. Scan stops where the scan of tail has reached.
+ */
+
+static void
+diff_trim_head (diff_trim_t * t)
+{
+    const char *a = t->text[0]->data;
+    const char *b = t->text[1]->data;
+    const char *a_end = a + t->text[0]->size;
+    const char *b_end = b + t->text[1]->size;
+    const char *pa = a;
+    const char *pb = b;
+    int lines = 0;
+
+    if (t->raw)
+    {
+        while (true)
+        {
+            const char *lim_a, *lim_b;
+            size_t n;
+
+            lim_a = static_cast<const char *> (g_atomic_pointer_get (&t->tail[0]));
+            lim_b = static_cast<const char *> (g_atomic_pointer_get (&t->tail[1]));
+            if (pa >= lim_a || pb >= lim_b)
+                break;
+
+            n = MIN ((size_t) (lim_a - pa), (size_t) (lim_b - pb));
+            n = MIN (n, DIFF_TRIM_CHUNK);
+            if (memcmp (pa, pb, n) != 0)
+            {
+                while (*pa == *pb)
+                    pa++, pb++;
+                break;
+            }
+
+            pa += n;
+            pb += n;
+            g_atomic_pointer_set (&t->head[0], (gpointer) pa);
+            g_atomic_pointer_set (&t->head[1], (gpointer) pb);
+        }
+
+        if (pa == a_end && pb == b_end)
+        {
+            /* texts are equal */
+            lines = mc_memcount (a, '\n', pa - a);
+            if (pa != a && pa[-1] != '\n')
+                lines++;
+        }
+        else
+        {
+            const char *eol;
+
+            /* go back to the beginning of line */
+            eol = static_cast<const char *> (mc_memrchr (a, '\n', pa - a));
+            pa = eol == nullptr ? a : eol + 1;
+            pb = b + (pa - a);
+            lines = mc_memcount (a, '\n', pa - a);
+        }
+    }
+    else
+        while (pa < a_end && pb < b_end)
+        {
+            const char *ea, *eb;
+
+            if (pa >= static_cast<const char *> (g_atomic_pointer_get (&t->tail[0]))
+                || pb >= static_cast<const char *> (g_atomic_pointer_get (&t->tail[1])))
+                break;
+
+            ea = diff_line_end (pa, a_end);
+            eb = diff_line_end (pb, b_end);
+            if (!diff_line_equal (t->opt, false, pa, ea - pa, pb, eb - pb))
+                break;
+
+            pa = ea;
+            pb = eb;
+            lines++;
+            g_atomic_pointer_set (&t->head[0], (gpointer) pa);
+            g_atomic_pointer_set (&t->head[1], (gpointer) pb);
+        }
+
+    g_atomic_pointer_set (&t->head[0], (gpointer) pa);
+    g_atomic_pointer_set (&t->head[1], (gpointer) pb);
+    t->head_lines = lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Skip equal lines at the end of texts. Scan stops where the scan of head has reached.
+ */
+
+static void
+diff_trim_tail (diff_trim_t * t)
+{
+    const char *a = t->text[0]->data;
+    const char *b = t->text[1]->data;
+    const char *a_end = a + t->text[0]->size;
+    const char *b_end = b + t->text[1]->size;
+    const char *qa = a_end;
+    const char *qb = b_end;
+    int lines = 0;
+
+    if (t->raw)
+    {
+        while (true)
+        {
+            const char *lim_a, *lim_b;
+            size_t n;
+
+            lim_a = static_cast<const char *> (g_atomic_pointer_get (&t->head[0]));
+            lim_b = static_cast<const char *> (g_atomic_pointer_get (&t->head[1]));
+            if (qa <= lim_a || qb <= lim_b)
+                break;
+
+            n = MIN ((size_t) (qa - lim_a), (size_t) (qb - lim_b));
+            n = MIN (n, DIFF_TRIM_CHUNK);
+            if (memcmp (qa - n, qb - n, n) != 0)
+            {
+                while (qa[-1] == qb[-1])
+                    qa--, qb--;
+                break;
+            }
+
+            qa -= n;
+            qb -= n;
+            g_atomic_pointer_set (&t->tail[0], (gpointer) qa);
+            g_atomic_pointer_set (&t->tail[1], (gpointer) qb);
+        }
+
+        /* go forward to the beginning of line in both texts */
+        if ((qa != a && qa[-1] != '\n') || (qb != b && qb[-1] != '\n'))
+        {
+            const char *eol;
+
+            eol = diff_line_end (qa, a_end);
+            qb += eol - qa;
+            qa = eol;
+        }
+
+        lines = mc_memcount (qa, '\n', a_end - qa);
+        if (qa != a_end && a_end[-1] != '\n')
+            lines++;
+    }
+    else
+        while (qa > a && qb > b)
+        {
+            const char *sa, *sb;
+
+            if (qa <= static_cast<const char *> (g_atomic_pointer_get (&t->head[0]))
+                || qb <= static_cast<const char *> (g_atomic_pointer_get (&t->head[1])))
+                break;
+
+            sa = diff_line_begin (a, qa);
+            sb = diff_line_begin (b, qb);
+            if (!diff_line_equal (t->opt, false, sa, qa - sa, sb, qb - sb))
+                break;
+
+            qa = sa;
+            qb = sb;
+            lines++;
+            g_atomic_pointer_set (&t->tail[0], (gpointer) qa);
+            g_atomic_pointer_set (&t->tail[1], (gpointer) qb);
+        }
+
+    g_atomic_pointer_set (&t->tail[0], (gpointer) qa);
+    g_atomic_pointer_set (&t->tail[1], (gpointer) qb);
+    t->tail_lines = lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static gpointer
+diff_trim_tail_worker (gpointer data)
+{
+    diff_trim_tail ((diff_trim_t *) data);
+    return nullptr;
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the common head and tail of texts.
+ */
+
+static void
+diff_trim (diff_trim_t * t)
+{
+    const char *a = t->text[0]->data;
+    const char *b = t->text[1]->data;
+    const char *pa, *pb, *qa, *qb;
+    bool done = false;
+
+    t->head[0] = (gpointer) a;
+    t->head[1] = (gpointer) b;
+    t->tail[0] = (gpointer) (a + t->text[0]->size);
+    t->tail[1] = (gpointer) (b + t->text[1]->size);
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    if (diff_parallel && t->text[0]->size >= DIFF_PARALLEL_MIN
+        && t->text[1]->size >= DIFF_PARALLEL_MIN)
+    {
+        GThread *thread;
+
+        thread = g_thread_try_new ("diff", diff_trim_tail_worker, t, nullptr);
+        if (thread != nullptr)
+        {
+            diff_trim_head (t);
+            g_thread_join (thread);
+            done = true;
+        }
+    }
+#endif
+
+    if (!done)
+    {
+        diff_trim_head (t);
+        diff_trim_tail (t);
+    }
+
+    pa = static_cast<const char *> (t->head[0]);
+    pb = static_cast<const char *> (t->head[1]);
+    qa = static_cast<const char *> (t->tail[0]);
+    qb = static_cast<const char *> (t->tail[1]);
+
+    /* parallel scans could overlap */
+    while (t->tail_lines != 0 && (qa < pa || qb < pb))
+    {
+        qa = diff_line_end (qa, a + t->text[0]->size);
+        qb = diff_line_end (qb, b + t->text[1]->size);
+        t->tail_lines--;
+    }
+
+    t->tail[0] = (gpointer) qa;
+    t->tail[1] = (gpointer) qb;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+diff_side_init (diff_side_t * s, const char *begin, const char *end)
+{
+    const char *p;
+    int i;
+
+    s->n = 0;
+    for (p = begin; p < end; p = diff_line_end (p, end))
+        s->n++;
+
+    s->line = g_new (const char *, s->n + 1);
+    for (i = 0, p = begin; i < s->n; i++, p = diff_line_end (p, end))
+        s->line[i] = p;
+    s->line[s->n] = end;
+
+    s->cls = g_new (int, s->n);
+    s->changed = g_new0 (char, s->n);
+    s->len = 0;
+    s->seq = g_new (int, s->n);
+    s->idx = g_new (int, s->n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+diff_side_free (diff_side_t * s)
+{
+    g_free (s->line);
+    g_free (s->cls);
+    g_free (s->changed);
+    g_free (s->seq);
+    g_free (s->idx);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Put lines of both texts to classes of equal lines. Lines which can't match any line of other
+ * text are marked as changed, others form sequences to compare.
+ *
+ * @return number of classes
+ */
+
+static int
+diff_classify (diff_ctx_t * ctx)
+{
+    diff_class_t *classes;
+    diff_bucket_t *buckets;
+    guint32 mask;
+    int nclasses = 0;
+    int s, i, n;
+
+    n = ctx->side[0].n + ctx->side[1].n;
+    for (mask = 1; mask < (guint32) n * 2; mask <<= 1)
+        ;
+    buckets = g_new (diff_bucket_t, mask);
+    for (i = 0; i < (int) mask; i++)
+        buckets[i].cls = -1;
+    mask--;
+
+    classes = g_new (diff_class_t, n);
+
+    for (s = 0; s < 2; s++)
+    {
+        diff_side_t *side = &ctx->side[s];
+
+        for (i = 0; i < side->n; i++)
+        {
+            const char *line = side->line[i];
+            size_t len = side->line[i + 1] - line;
+            guint32 hash, b;
+
+            hash = diff_line_hash (ctx->opt, ctx->raw, line, len);
+
+            for (b = hash & mask; buckets[b].cls != -1; b = (b + 1) & mask)
+                if (buckets[b].hash == hash
+                    && diff_line_equal (ctx->opt, ctx->raw, classes[buckets[b].cls].line,
+                                        classes[buckets[b].cls].len, line, len))
+                    break;
+
+            if (buckets[b].cls == -1)
+            {
+                buckets[b].hash = hash;
+                buckets[b].cls = nclasses;
+                classes[nclasses].line = line;
+                classes[nclasses].len = len;
+                classes[nclasses].count[0] = 0;
+                classes[nclasses].count[1] = 0;
+                nclasses++;
+            }
+
+            side->cls[i] = buckets[b].cls;
+            classes[side->cls[i]].count[s]++;
+        }
+    }
+
+    for (s = 0; s < 2; s++)
+    {
+        diff_side_t *side = &ctx->side[s];
+
+        for (i = 0; i < side->n; i++)
+            if (classes[side->cls[i]].count[1 - s] == 0)
+                side->changed[i] = 1;
+            else
+            {
+                side->seq[side->len] = side->cls[i];
+                side->idx[side->len] = i;
+                side->len++;
+            }
+    }
+
+    g_free (classes);
+    g_free (buckets);
+
+    return nclasses;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline void
+diff_mark_changed (diff_ctx_t * ctx, int s, int from, int to)
+{
+    diff_side_t *side = &ctx->side[s];
+
+    for (; from < to; from++)
+        side->changed[side->idx[from]] = 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Histogram diff: find the longest run of equal elements containing the least frequent element.
+ *
+ * @return true if region was split by run of equal elements, false if there is no element
+ *         which is rare enough
+ */
+
+static bool
+diff_histogram (diff_ctx_t * ctx, const diff_region_t * r, int *as_out, int *ae_out, int *bs_out,
+                int *be_out)
+{
+    const int *xv = ctx->side[0].seq;
+    const int *yv = ctx->side[1].seq;
+    int *count = ctx->count;
+    int *first = ctx->first;
+    int *next = ctx->next;
+    int best_count = G_MAXINT;
+    int best_len = 0;
+    int i, j, j_next;
+
+    for (j = r->off[1]; j < r->lim[1]; j++)
+    {
+        count[yv[j]] = 0;
+        first[yv[j]] = -1;
+    }
+    for (i = r->off[0]; i < r->lim[0]; i++)
+    {
+        count[xv[i]] = 0;
+        first[xv[i]] = -1;
+    }
+    for (i = r->lim[0] - 1; i >= r->off[0]; i--)
+    {
+        next[i] = first[xv[i]];
+        first[xv[i]] = i;
+        count[xv[i]]++;
+    }
+
+    for (j = r->off[1]; j < r->lim[1]; j = j_next)
+    {
+        j_next = j + 1;
+
+        if (count[yv[j]] == 0 || count[yv[j]] > MIN (best_count, DIFF_MAX_CHAIN))
+            continue;
+
+        for (i = first[yv[j]]; i != -1;)
+        {
+            int as = i, ae = i + 1, bs = j, be = j + 1;
+            int rc = count[yv[j]];
+
+            while (as > r->off[0] && bs > r->off[1] && xv[as - 1] == yv[bs - 1])
+            {
+                as--;
+                bs--;
+                rc = MIN (rc, count[xv[as]]);
+            }
+            while (ae < r->lim[0] && be < r->lim[1] && xv[ae] == yv[be])
+            {
+                rc = MIN (rc, count[xv[ae]]);
+                ae++;
+                be++;
+            }
+
+            if (j_next < be)
+                j_next = be;
+
+            if (best_len < ae - as || rc < best_count)
+            {
+                *as_out = as;
+                *ae_out = ae;
+                *bs_out = bs;
+                *be_out = be;
+                best_len = ae - as;
+                best_count = rc;
+            }
+
+            /* skip occurrences inside the run */
+            for (i = next[i]; i != -1 && i < ae; i = next[i])
+                ;
+        }
+    }
+
+    return best_len != 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the middle snake of the shortest edit script by Myers' algorithm, searching forward
+ * from the beginning and backward from the end of region. If the cost exceeds the limit,
+ * return the point of the path that went further.
+ */
+
+static void
+diff_myers_split (diff_ctx_t * ctx, const diff_region_t * r, int *xmid, int *ymid)
+{
+    const int *xv = ctx->side[0].seq;
+    const int *yv = ctx->side[1].seq;
+    int *fd = ctx->fdiag;
+    int *bd = ctx->bdiag;
+    const int xoff = r->off[0], xlim = r->lim[0];
+    const int yoff = r->off[1], ylim = r->lim[1];
+    const int dmin = xoff - ylim;
+    const int dmax = xlim - yoff;
+    const int fmid = xoff - yoff;
+    const int bmid = xlim - ylim;
+    const bool odd = ((fmid - bmid) & 1) != 0;
+    int fmin = fmid, fmax = fmid;
+    int bmin = bmid, bmax = bmid;
+    int c;
+
+    fd[fmid] = xoff;
+    bd[bmid] = xlim;
+
+    for (c = 1;; c++)
+    {
+        int d;
+
+        /* extend the forward search by one edit on each diagonal */
+        if (fmin > dmin)
+            fd[--fmin - 1] = -1;
+        else
+            fmin++;
+        if (fmax < dmax)
+            fd[++fmax + 1] = -1;
+        else
+            fmax--;
+
+        for (d = fmax; d >= fmin; d -= 2)
+        {
+            int x, y;
+            int tlo = fd[d - 1], thi = fd[d + 1];
+
+            x = tlo < thi ? thi : tlo + 1;
+            for (y = x - d; x < xlim && y < ylim && xv[x] == yv[y]; x++, y++)
+                ;
+            fd[d] = x;
+            if (odd && bmin <= d && d <= bmax && bd[d] <= x)
+            {
+                *xmid = x;
+                *ymid = y;
+                return;
+            }
+        }
+
+        /* the same for the backward search */
+        if (bmin > dmin)
+            bd[--bmin - 1] = G_MAXINT;
+        else
+            bmin++;
+        if (bmax < dmax)
+            bd[++bmax + 1] = G_MAXINT;
+        else
+            bmax--;
+
+        for (d = bmax; d >= bmin; d -= 2)
+        {
+            int x, y;
+            int tlo = bd[d - 1], thi = bd[d + 1];
+
+            x = tlo < thi ? tlo : thi - 1;
+            for (y = x - d; x > xoff && y > yoff && xv[x - 1] == yv[y - 1]; x--, y--)
+                ;
+            bd[d] = x;
+            if (!odd && fmin <= d && d <= fmax && x <= fd[d])
+            {
+                *xmid = x;
+                *ymid = y;
+                return;
+            }
+        }
+
+        if (ctx->too_expensive != 0 && c >= ctx->too_expensive)
+        {
+            int fxybest = -1, fxbest = xoff;
+            int bxybest = G_MAXINT, bxbest = xlim;
+
+            for (d = fmax; d >= fmin; d -= 2)
+            {
+                int x, y;
+
+                x = MIN (fd[d], xlim);
+                y = x - d;
+                if (y > ylim)
+                {
+                    x = ylim + d;
+                    y = ylim;
+                }
+                if (fxybest < x + y)
+                {
+                    fxybest = x + y;
+                    fxbest = x;
+                }
+            }
+
+            for (d = bmax; d >= bmin; d -= 2)
+            {
+                int x, y;
+
+                x = MAX (xoff, bd[d]);
+                y = x - d;
+                if (y < yoff)
+                {
+                    x = yoff + d;
+                    y = yoff;
+                }
+                if (x + y < bxybest)
+                {
+                    bxybest = x + y;
+                    bxbest = x;
+                }
+            }
+
+            if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff))
+            {
+                *xmid = fxbest;
+                *ymid = fxybest - fxbest;
+            }
+            else
+            {
+                *xmid = bxbest;
+                *ymid = bxybest - bxbest;
+            }
+            return;
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare sequences of lines and mark changed lines.
+ */
+
+static void
+diff_compare_seq (diff_ctx_t * ctx, bool histogram)
+{
+    const int *xv = ctx->side[0].seq;
+    const int *yv = ctx->side[1].seq;
+    GArray *stack;
+    diff_region_t r;
+
+    stack = g_array_new (false, false, sizeof (diff_region_t));
+
+    r.off[0] = 0;
+    r.off[1] = 0;
+    r.lim[0] = ctx->side[0].len;
+    r.lim[1] = ctx->side[1].len;
+    r.histogram = histogram;
+    g_array_append_val (stack, r);
+
+    while (stack->len != 0)
+    {
+        diff_region_t lo, hi;
+        int xmid, ymid;
+
+        r = g_array_index (stack, diff_region_t, stack->len - 1);
+        g_array_set_size (stack, stack->len - 1);
+
+        while (r.off[0] < r.lim[0] && r.off[1] < r.lim[1] && xv[r.off[0]] == yv[r.off[1]])
+            r.off[0]++, r.off[1]++;
+        while (r.off[0] < r.lim[0] && r.off[1] < r.lim[1]
+               && xv[r.lim[0] - 1] == yv[r.lim[1] - 1])
+            r.lim[0]--, r.lim[1]--;
+
+        if (r.off[0] == r.lim[0] || r.off[1] == r.lim[1])
+        {
+            diff_mark_changed (ctx, 0, r.off[0], r.lim[0]);
+            diff_mark_changed (ctx, 1, r.off[1], r.lim[1]);
+            continue;
+        }
+
+        lo = r;
+        hi = r;
+
+        if (r.histogram && diff_histogram (ctx, &r, &lo.lim[0], &hi.off[0], &lo.lim[1], &hi.off[1]))
+        {
+            g_array_append_val (stack, hi);
+            g_array_append_val (stack, lo);
+            continue;
+        }
+
+        diff_myers_split (ctx, &r, &xmid, &ymid);
+        if ((xmid == r.off[0] && ymid == r.off[1]) || (xmid == r.lim[0] && ymid == r.lim[1]))
+        {
+            /* no progress: shouldn't happen */
+            diff_mark_changed (ctx, 0, r.off[0], r.lim[0]);
+            diff_mark_changed (ctx, 1, r.off[1], r.lim[1]);
+            continue;
+        }
+
+        lo.lim[0] = hi.off[0] = xmid;
+        lo.lim[1] = hi.off[1] = ymid;
+        lo.histogram = hi.histogram = false;
+        g_array_append_val (stack, hi);
+        g_array_append_val (stack, lo);
+    }
+
+    g_array_free (stack, true);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+diff_add_hunk (GArray * ops, int line, int a0, int a1, int b0, int b1)
+{
+    DIFFCMD op;
+
+    if (a0 == a1)
+    {
+        op.cmd = 'a';
+        op.a[0][0] = op.a[0][1] = line + a0;
+    }
+    else
+    {
+        op.cmd = b0 == b1 ? 'd' : 'c';
+        op.a[0][0] = line + a0 + 1;
+        op.a[0][1] = line + a1;
+    }
+
+    if (b0 == b1)
+        op.a[1][0] = op.a[1][1] = line + b0;
+    else
+    {
+        op.a[1][0] = line + b0 + 1;
+        op.a[1][1] = line + b1;
+    }
+
+    g_array_append_val (ops, op);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline int
+diff_op_lines (const DIFFCMD * op, int side)
+{
+    if (op->cmd == (side == 0 ? 'a' : 'd'))
+        return 0;
+    return op->a[side][1] - op->a[side][0] + 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Use data in memory as text to compare. Data are not copied.
+ */
+
+void
+diff_text_init (diff_text_t * text, const char *data, size_t size)
+{
+    text->data = data;
+    text->size = size;
+    text->map = nullptr;
+    text->buf = nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load file to compare. Local file is mapped to memory, other VFS files are read.
+ *
+ * @param text text to initialize
+ * @param filename name of file
+ *
+ * @return true on success, false on error (errno is set)
+ */
+
+bool
+diff_text_load (diff_text_t * text, const char *filename)
+{
+    vfs_path_t *vpath;
+    int fd;
+    bool ret = false;
+
+    diff_text_init (text, "", 0);
+
+    vpath = vfs_path_from_str (filename);
+
+#ifdef HAVE_MMAP
+    if (vfs_file_is_local (vpath))
+    {
+        struct stat st;
+
+        fd = open (filename, O_RDONLY);
+        if (fd == -1)
+            goto ret;
+
+        if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0
+            && (off_t) (size_t) st.st_size == st.st_size)
+        {
+            void *map;
+
+            map = mmap (0, (size_t) st.st_size, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED)
+            {
+                text->map = map;
+                text->data = static_cast<const char *> (map);
+                text->size = (size_t) st.st_size;
+                close (fd);
+                ret = true;
+                goto ret;
+            }
+        }
+
+        close (fd);
+    }
+#endif /* HAVE_MMAP */
+
+    fd = mc_open (vpath, O_RDONLY);
+    if (fd == -1)
+        goto ret;
+
+    {
+        GByteArray *buf;
+        char chunk[BUF_8K];
+        ssize_t n;
+
+        buf = g_byte_array_new ();
+        while ((n = mc_read (fd, chunk, sizeof (chunk))) > 0)
+            g_byte_array_append (buf, (const guint8 *) chunk, (guint) n);
+
+        if (n == 0)
+        {
+            text->size = buf->len;
+            text->buf = (char *) g_byte_array_free (buf, false);
+            if (text->buf != nullptr)
+                text->data = text->buf;
+            ret = true;
+        }
+        else
+        {
+            int saved_errno = errno;
+
+            g_byte_array_free (buf, true);
+            errno = saved_errno;
+        }
+    }
+
+    mc_close (fd);
+
+  ret:
+    vfs_path_free (vpath);
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+diff_text_free (diff_text_t * text)
+{
+#ifdef HAVE_MMAP
+    if (text->map != nullptr)
+        munmap (text->map, text->size);
+#endif
+    g_free (text->buf);
+    diff_text_init (text, "", 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare texts.
+ *
+ * @param text1 the 1st text
+ * @param text2 the 2nd text
+ * @param opt options of comparison
+ * @param ops list of hunks to fill
+ *
+ * @return number of hunks
+ */
+
+int
+diff_compute (const diff_text_t * text1, const diff_text_t * text2, const diff_options_t * opt,
+              GArray * ops)
+{
+    diff_trim_t trim;
+    diff_ctx_t ctx;
+    int nclasses;
+    int diags;
+    int i, j;
+
+    trim.opt = opt;
+    trim.raw = diff_options_raw (opt);
+    trim.text[0] = text1;
+    trim.text[1] = text2;
+    diff_trim (&trim);
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.opt = opt;
+    ctx.raw = trim.raw;
+    diff_side_init (&ctx.side[0], static_cast<const char *> (trim.head[0]),
+                    static_cast<const char *> (trim.tail[0]));
+    diff_side_init (&ctx.side[1], static_cast<const char *> (trim.head[1]),
+                    static_cast<const char *> (trim.tail[1]));
+
+    nclasses = diff_classify (&ctx);
+
+    if (ctx.side[0].len != 0 && ctx.side[1].len != 0)
+    {
+        diags = ctx.side[0].len + ctx.side[1].len + 3;
+
+        if (opt->quality != 2)
+        {
+            int d;
+
+            /* about square root of number of diagonals */
+            ctx.too_expensive = 1;
+            for (d = diags; d != 0; d >>= 2)
+                ctx.too_expensive <<= 1;
+            ctx.too_expensive =
+                MAX (opt->quality == 1 ? DIFF_COST_MIN_FAST : DIFF_COST_MIN, ctx.too_expensive);
+
+            ctx.count = g_new (int, nclasses);
+            ctx.first = g_new (int, nclasses);
+            ctx.next = g_new (int, ctx.side[0].len);
+        }
+
+        ctx.fdiag = g_new (int, diags * 2);
+        ctx.bdiag = ctx.fdiag + diags;
+        /* diagonals are from -len[1] to len[0] */
+        ctx.fdiag += ctx.side[1].len + 1;
+        ctx.bdiag += ctx.side[1].len + 1;
+    }
+
+    diff_compare_seq (&ctx, opt->quality != 2);
+
+    /* collect runs of changed lines */
+    for (i = 0, j = 0; i < ctx.side[0].n || j < ctx.side[1].n;)
+    {
+        if ((i < ctx.side[0].n && ctx.side[0].changed[i] != 0)
+            || (j < ctx.side[1].n && ctx.side[1].changed[j] != 0))
+        {
+            int i0 = i, j0 = j;
+
+            while (i < ctx.side[0].n && ctx.side[0].changed[i] != 0)
+                i++;
+            while (j < ctx.side[1].n && ctx.side[1].changed[j] != 0)
+                j++;
+            diff_add_hunk (ops, trim.head_lines, i0, i, j0, j);
+        }
+        else
+        {
+            i++;
+            j++;
+        }
+    }
+
+    if (ctx.fdiag != nullptr)
+        g_free (ctx.fdiag - (ctx.side[1].len + 1));
+    g_free (ctx.count);
+    g_free (ctx.first);
+    g_free (ctx.next);
+    diff_side_free (&ctx.side[0]);
+    diff_side_free (&ctx.side[1]);
+
+    return ops->len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether hunks describe the difference of texts: lines out of hunks are equal.
+ *
+ * @param text1 the 1st text
+ * @param text2 the 2nd text
+ * @param opt options of comparison
+ * @param ops list of hunks
+ *
+ * @return true if hunks are valid for texts
+ */
+
+bool
+diff_ops_check (const diff_text_t * text1, const diff_text_t * text2, const diff_options_t * opt,
+                const GArray * ops)
+{
+    const char *p[2] = { text1->data, text2->data };
+    const char *end[2] = { text1->data + text1->size, text2->data + text2->size };
+    bool raw;
+    int line[2] = { 0, 0 };
+    guint i;
+
+    raw = diff_options_raw (opt);
+
+    for (i = 0; i <= ops->len; i++)
+    {
+        const DIFFCMD *op = nullptr;
+        int before[2] = { 0, 0 };
+        int s;
+
+        if (i < ops->len)
+        {
+            op = &g_array_index (ops, DIFFCMD, i);
+            /* number of lines before hunk */
+            for (s = 0; s < 2; s++)
+                before[s] = op->a[s][0] - (diff_op_lines (op, s) == 0 ? 0 : 1);
+            if (before[0] - line[0] != before[1] - line[1] || before[0] < line[0])
+                return false;
+        }
+
+        /* unchanged lines */
+        while (op == nullptr ? (p[0] < end[0] || p[1] < end[1]) : line[0] < before[0])
+        {
+            const char *e[2];
+
+            if (p[0] == end[0] || p[1] == end[1])
+                return false;
+
+            for (s = 0; s < 2; s++)
+                e[s] = diff_line_end (p[s], end[s]);
+            if (!diff_line_equal (opt, raw, p[0], e[0] - p[0], p[1], e[1] - p[1]))
+                return false;
+
+            for (s = 0; s < 2; s++)
+            {
+                p[s] = e[s];
+                line[s]++;
+            }
+        }
+
+        if (op != nullptr)
+            for (s = 0; s < 2; s++)
+            {
+                int n;
+
+                for (n = diff_op_lines (op, s); n != 0; n--, line[s]++)
+                {
+                    if (p[s] == end[s])
+                        return false;
+                    p[s] = diff_line_end (p[s], end[s]);
+                }
+            }
+    }
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update hunks after one of them was merged: lines of hunk in one text were replaced by ones
+ * of other text.
+ *
+ * @param ops list of hunks
+ * @param hunk index of merged hunk
+ * @param from text that lines were copied from: 0 or 1
+ */
+
+void
+diff_ops_merge (GArray * ops, guint hunk, int from)
+{
+    const DIFFCMD *op;
+    int to = 1 - from;
+    int delta;
+    guint i;
+
+    if (hunk >= ops->len)
+        return;
+
+    op = &g_array_index (ops, DIFFCMD, hunk);
+    delta = diff_op_lines (op, from) - diff_op_lines (op, to);
+    g_array_remove_index (ops, hunk);
+
+    for (i = hunk; i < ops->len; i++)
+    {
+        DIFFCMD *o = &g_array_index (ops, DIFFCMD, i);
+
+        o->a[to][0] += delta;
+        o->a[to][1] += delta;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Allow or forbid scanning of head and tail of large files in parallel. Intended for tests.
+ *
+ * @param parallel true to scan them in parallel, false to scan them one after another
+ */
+
+void
+diff_set_parallel (bool parallel)
+{
+    diff_parallel = parallel;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,63 @@
+/** \file engine.h
+ *  \brief Header: comparison of files for diff viewer
+ */
+
+#ifndef MC__DIFFVIEW_ENGINE_H
+#define MC__DIFFVIEW_ENGINE_H
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/* how lines are compared */
+typedef struct
+{
+    int quality;                /* 0: normal, 1: fastest, 2: minimal */
+    bool strip_trailing_cr;
+    bool ignore_tab_expansion;
+    bool ignore_space_change;
+    bool ignore_all_space;
+    bool ignore_case;
+} diff_options_t;
+
+/*
+ * Hunk: lines a[0][0]...a[0][1] of the 1st file are replaced by lines a[1][0]...a[1][1]
+ * of the 2nd one. Lines are numbered from 1. If lines are added ('a'), a[0][0] == a[0][1] is
+ * the line of the 1st file after which they are added; if lines are deleted ('d'),
+ * a[1][0] == a[1][1] is such line of the 2nd file. Changes are 'c'.
+ */
+typedef struct
+{
+    int a[2][2];
+    int cmd;
+} DIFFCMD;
+
+/* content of compared file */
+typedef struct
+{
+    const char *data;
+    size_t size;
+    void *map;                  /* mapping of local file */
+    char *buf;                  /* content of file read to the heap */
+} diff_text_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+void diff_text_init (diff_text_t * text, const char *data, size_t size);
+bool diff_text_load (diff_text_t * text, const char *filename);
+void diff_text_free (diff_text_t * text);
+
+int diff_compute (const diff_text_t * text1, const diff_text_t * text2,
+                  const diff_options_t * opt, GArray * ops);
+bool diff_ops_check (const diff_text_t * text1, const diff_text_t * text2,
+                     const diff_options_t * opt, const GArray * ops);
+void diff_ops_merge (GArray * ops, guint hunk, int from);
+void diff_set_parallel (bool parallel);
+
+#endif /* MC__DIFFVIEW_ENGINE_H */
@@ -7,6 +7,8 @@
 #include "lib/tty/color.h"
 #include "lib/widget.h"
 
+#include "engine.h"
+
 /*** typedefs(not structures) and defined constants **********************************************/
 
 typedef int (*DFUNC) (void *ctx, int ch, int line, off_t off, size_t sz, const char *str);
@@ -48,12 +50,6 @@ typedef struct
     void *data;
 } FBUF;
 
-typedef struct
-{
-    int a[2][2];
-    int cmd;
-} DIFFCMD;
-
 
 typedef struct
 {
@@ -84,7 +80,6 @@ typedef struct WDiff
 {
     Widget widget;
 
-    const char *args;           /* Args passed to diff */
     const char *file[DIFF_COUNT];       /* filenames */
     char *label[DIFF_COUNT];
     FBUF *f[DIFF_COUNT];
@@ -92,6 +87,8 @@ typedef struct WDiff
     bool merged[DIFF_COUNT];
     GArray *a[DIFF_COUNT];
     GPtrArray *hdiff;
+    GArray *ops;                /* hunks: DIFFCMD */
+    bool ops_merged;            /* hunk was merged: the rest of ops is reusable */
     int ndiff;                  /* number of hunks */
     DSRC dsrc;                  /* data source: memory or temporary file */
 
@@ -119,15 +116,7 @@ typedef struct WDiff
     GIConv converter;
 #endif                          /* HAVE_CHARSET */
 
-    struct
-    {
-        int quality;
-        bool strip_trailing_cr;
-        bool ignore_tab_expansion;
-        bool ignore_space_change;
-        bool ignore_all_space;
-        bool ignore_case;
-    } opt;
+    diff_options_t opt;
 
     /* Search variables */
     struct
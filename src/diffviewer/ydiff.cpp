@@ -28,12 +28,10 @@
 
 
 #include <config.h>
-#include <ctype.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 
 #include "lib/global.h"
 #include "lib/tty/tty.h"
@@ -44,7 +42,6 @@
 #include "lib/util.h"
 #include "lib/widget.h"
 #include "lib/strutil.h"
-#include "lib/strescape.h"      /* strutils_glob_escape() */
 #ifdef HAVE_CHARSET
 #include "lib/charsets.h"
 #endif
@@ -489,71 +486,6 @@ f_close (FBUF * fs)
 
 /* --------------------------------------------------------------------------------------------- */
 
-/**
- * Create pipe stream to process.
- *
- * @param cmd shell command line
- * @param flags open mode, either O_RDONLY or O_WRONLY
- *
- * @return file structure
- */
-
-static FBUF *
-p_open (const char *cmd, int flags)
-{
-    FILE *f;
-    FBUF *fs;
-    const char *type = nullptr;
-
-    if (flags == O_RDONLY)
-        type = "r";
-    else if (flags == O_WRONLY)
-        type = "w";
-
-    if (type == nullptr)
-        return nullptr;
-
-    fs = f_dopen (0);
-    if (fs == nullptr)
-        return nullptr;
-
-    f = popen (cmd, type);
-    if (f == nullptr)
-    {
-        f_free (fs);
-        return nullptr;
-    }
-
-    fs->fd = fileno (f);
-    fs->data = f;
-    return fs;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-/**
- * Close pipe stream.
- *
- * @param fs structure
- * @return 0 on success, non-zero on error
- */
-
-static int
-p_close (FBUF * fs)
-{
-    int rv = -1;
-
-    if (fs != nullptr)
-    {
-        rv = pclose (static_cast<FILE *> (fs->data));
-        f_free (fs);
-    }
-
-    return rv;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
 /**
  * Get one char (byte) from string
  *
@@ -674,178 +606,42 @@ scan_deci (const char **str, int *n)
 /* --------------------------------------------------------------------------------------------- */
 
 /**
- * Parse line for diff statement.
+ * Display one line of text.
  *
- * @param p string to parse
- * @param ops list of diff statements
- * @return 0 if success, otherwise non-zero
- */
-
-static int
-scan_line (const char *p, GArray * ops)
-{
-    DIFFCMD op;
-
-    int f1, f2;
-    int t1, t2;
-    int cmd;
-    int range;
-
-    /* handle the following cases:
-     *  NUMaNUM[,NUM]
-     *  NUM[,NUM]cNUM[,NUM]
-     *  NUM[,NUM]dNUM
-     * where NUM is a positive integer
-     */
-
-    if (scan_deci (&p, &f1) != 0 || f1 < 0)
-        return -1;
-
-    f2 = f1;
-    range = 0;
-    if (*p == ',')
-    {
-        p++;
-        if (scan_deci (&p, &f2) != 0 || f2 < f1)
-            return -1;
-
-        range = 1;
-    }
-
-    cmd = *p++;
-    if (cmd == 'a')
-    {
-        if (range != 0)
-            return -1;
-    }
-    else if (cmd != 'c' && cmd != 'd')
-        return -1;
-
-    if (scan_deci (&p, &t1) != 0 || t1 < 0)
-        return -1;
-
-    t2 = t1;
-    range = 0;
-    if (*p == ',')
-    {
-        p++;
-        if (scan_deci (&p, &t2) != 0 || t2 < t1)
-            return -1;
-
-        range = 1;
-    }
-
-    if (cmd == 'd' && range != 0)
-        return -1;
-
-    op.a[0][0] = f1;
-    op.a[0][1] = f2;
-    op.cmd = cmd;
-    op.a[1][0] = t1;
-    op.a[1][1] = t2;
-    g_array_append_val (ops, op);
-    return 0;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-/**
- * Parse diff output and extract diff statements.
+ * @param printer printf-like function to be used for displaying
+ * @param ctx printer context
+ * @param ch kind of line
+ * @param line number of line
+ * @param off offset of line in text
+ * @param p beginning of line
+ * @param end end of text
  *
- * @param f stream to read from
- * @param ops list of diff statements to fill
- * @return positive number indicating number of hunks, otherwise negative
+ * @return beginning of the next line
  */
 
-static int
-scan_diff (FBUF * f, GArray * ops)
+static const char *
+dff_print_line (DFUNC printer, void *ctx, int ch, int line, off_t off, const char *p,
+                const char *end)
 {
-    int sz;
-    char buf[BUFSIZ];
-
-    while ((sz = f_gets (buf, sizeof (buf) - 1, f)) != 0)
-    {
-        if (isdigit (buf[0]))
-        {
-            if (buf[sz - 1] != '\n')
-                return -1;
-
-            buf[sz] = '\0';
-            if (scan_line (buf, ops) != 0)
-                return -1;
-
-            continue;
-        }
+    const char *nl;
+    size_t sz;
 
-        while (buf[sz - 1] != '\n' && (sz = f_gets (buf, sizeof (buf), f)) != 0)
-            ;
-    }
+    nl = static_cast<const char *> (memchr (p, '\n', end - p));
+    sz = nl == nullptr ? (size_t) (end - p) : (size_t) (nl + 1 - p);
+    printer (ctx, ch, line, off, sz, p);
+    if (nl == nullptr)
+        printer (ctx, 0, 0, 0, 1, "\n");
 
-    return ops->len;
+    return p + sz;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
 /**
- * Invoke diff and extract diff statements.
- *
- * @param args extra arguments to be passed to diff
- * @param extra more arguments to be passed to diff
- * @param file1 first file to compare
- * @param file2 second file to compare
- * @param ops list of diff statements to fill
- *
- * @return positive number indicating number of hunks, otherwise negative
- */
-
-static int
-dff_execute (const char *args, const char *extra, const char *file1, const char *file2,
-             GArray * ops)
-{
-    static const char *opt =
-        " --old-group-format='%df%(f=l?:,%dl)d%dE\n'"
-        " --new-group-format='%dea%dF%(F=L?:,%dL)\n'"
-        " --changed-group-format='%df%(f=l?:,%dl)c%dF%(F=L?:,%dL)\n'"
-        " --unchanged-group-format=''";
-
-    int rv;
-    FBUF *f;
-    char *cmd;
-    int code;
-    char *file1_esc, *file2_esc;
-
-    /* escape potential $ to avoid shell variable substitutions in popen() */
-    file1_esc = strutils_shell_escape (file1);
-    file2_esc = strutils_shell_escape (file2);
-    cmd = g_strdup_printf ("diff %s %s %s %s %s", args, extra, opt, file1_esc, file2_esc);
-    g_free (file1_esc);
-    g_free (file2_esc);
-
-    if (cmd == nullptr)
-        return -1;
-
-    f = p_open (cmd, O_RDONLY);
-    g_free (cmd);
-
-    if (f == nullptr)
-        return -1;
-
-    rv = scan_diff (f, ops);
-    code = p_close (f);
-
-    if (rv < 0 || code == -1 || !WIFEXITED (code) || WEXITSTATUS (code) == 2)
-        rv = -1;
-
-    return rv;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-/**
- * Reparse and display file according to diff statements.
+ * Reparse and display text according to diff statements.
  *
  * @param ord DIFF_LEFT if 1nd file is displayed , DIFF_RIGHT if 2nd file is displayed.
- * @param filename file name to display
+ * @param text content of file to display
  * @param ops list of diff statements
  * @param printer printf-like function to be used for displaying
  * @param ctx printer context
@@ -854,23 +650,18 @@ dff_execute (const char *args, const char *extra, const char *file1, const char
  */
 
 static int
-dff_reparse (diff_place_t ord, const char *filename, const GArray * ops, DFUNC printer, void *ctx)
+dff_reparse (diff_place_t ord, const diff_text_t * text, const GArray * ops, DFUNC printer,
+             void *ctx)
 {
+    const char *p = text->data;
+    const char *end = text->data + text->size;
     size_t i;
-    FBUF *f;
-    size_t sz;
-    char buf[BUFSIZ];
     int line = 0;
-    off_t off = 0;
     const DIFFCMD *op;
     diff_place_t eff;
     int add_cmd;
     int del_cmd;
 
-    f = f_open (filename, O_RDONLY);
-    if (f == nullptr)
-        return -1;
-
     ord = static_cast<diff_place_t> (static_cast<int> (ord) & 1);
     eff = ord;
 
@@ -892,26 +683,14 @@ dff_reparse (diff_place_t ord, const char *filename, const GArray * ops, DFUNC p
         op = &g_array_index (ops, DIFFCMD, i);
         n = op->F1 - (op->cmd != add_cmd);
 
-        while (line < n && (sz = f_gets (buf, sizeof (buf), f)) != 0)
+        while (line < n && p < end)
         {
             line++;
-            printer (ctx, EQU_CH, line, off, sz, buf);
-            off += sz;
-            while (buf[sz - 1] != '\n')
-            {
-                sz = f_gets (buf, sizeof (buf), f);
-                if (sz == 0)
-                {
-                    printer (ctx, 0, 0, 0, 1, "\n");
-                    break;
-                }
-                printer (ctx, 0, 0, 0, sz, buf);
-                off += sz;
-            }
+            p = dff_print_line (printer, ctx, EQU_CH, line, p - text->data, p, end);
         }
 
         if (line != n)
-            goto err;
+            return -1;
 
         if (op->cmd == add_cmd)
         {
@@ -926,53 +705,29 @@ dff_reparse (diff_place_t ord, const char *filename, const GArray * ops, DFUNC p
         if (op->cmd == del_cmd)
         {
             n = op->F2 - op->F1 + 1;
-            while (n != 0 && (sz = f_gets (buf, sizeof (buf), f)) != 0)
+            while (n != 0 && p < end)
             {
                 line++;
-                printer (ctx, ADD_CH, line, off, sz, buf);
-                off += sz;
-                while (buf[sz - 1] != '\n')
-                {
-                    sz = f_gets (buf, sizeof (buf), f);
-                    if (sz == 0)
-                    {
-                        printer (ctx, 0, 0, 0, 1, "\n");
-                        break;
-                    }
-                    printer (ctx, 0, 0, 0, sz, buf);
-                    off += sz;
-                }
+                p = dff_print_line (printer, ctx, ADD_CH, line, p - text->data, p, end);
                 n--;
             }
 
             if (n != 0)
-                goto err;
+                return -1;
         }
 
         if (op->cmd == 'c')
         {
             n = op->F2 - op->F1 + 1;
-            while (n != 0 && (sz = f_gets (buf, sizeof (buf), f)) != 0)
+            while (n != 0 && p < end)
             {
                 line++;
-                printer (ctx, CHG_CH, line, off, sz, buf);
-                off += sz;
-                while (buf[sz - 1] != '\n')
-                {
-                    sz = f_gets (buf, sizeof (buf), f);
-                    if (sz == 0)
-                    {
-                        printer (ctx, 0, 0, 0, 1, "\n");
-                        break;
-                    }
-                    printer (ctx, 0, 0, 0, sz, buf);
-                    off += sz;
-                }
+                p = dff_print_line (printer, ctx, CHG_CH, line, p - text->data, p, end);
                 n--;
             }
 
             if (n != 0)
-                goto err;
+                return -1;
 
             n = op->T2 - op->T1 - (op->F2 - op->F1);
             while (n > 0)
@@ -987,30 +742,13 @@ dff_reparse (diff_place_t ord, const char *filename, const GArray * ops, DFUNC p
 #undef F2
 #undef F1
 
-    while ((sz = f_gets (buf, sizeof (buf), f)) != 0)
+    while (p < end)
     {
         line++;
-        printer (ctx, EQU_CH, line, off, sz, buf);
-        off += sz;
-        while (buf[sz - 1] != '\n')
-        {
-            sz = f_gets (buf, sizeof (buf), f);
-            if (sz == 0)
-            {
-                printer (ctx, 0, 0, 0, 1, "\n");
-                break;
-            }
-            printer (ctx, 0, 0, 0, sz, buf);
-            off += sz;
-        }
+        p = dff_print_line (printer, ctx, EQU_CH, line, p - text->data, p, end);
     }
 
-    f_close (f);
     return 0;
-
-  err:
-    f_close (f);
-    return -1;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1734,26 +1472,9 @@ redo_diff (WDiff * dview)
 {
     FBUF *const *f = dview->f;
     PRINTER_CTX ctx;
-    GArray *ops;
+    diff_text_t text[DIFF_COUNT];
     int ndiff;
     int rv;
-    char extra[256];
-
-    extra[0] = '\0';
-    if (dview->opt.quality == 2)
-        strcat (extra, " -d");
-    if (dview->opt.quality == 1)
-        strcat (extra, " --speed-large-files");
-    if (dview->opt.strip_trailing_cr)
-        strcat (extra, " --strip-trailing-cr");
-    if (dview->opt.ignore_tab_expansion)
-        strcat (extra, " -E");
-    if (dview->opt.ignore_space_change)
-        strcat (extra, " -b");
-    if (dview->opt.ignore_all_space)
-        strcat (extra, " -w");
-    if (dview->opt.ignore_case)
-        strcat (extra, " -i");
 
     if (dview->dsrc != DATA_SRC_MEM)
     {
@@ -1761,28 +1482,38 @@ redo_diff (WDiff * dview)
         f_reset (f[DIFF_RIGHT]);
     }
 
-    ops = g_array_new (false, false, sizeof (DIFFCMD));
-    ndiff = dff_execute (dview->args, extra, dview->file[DIFF_LEFT], dview->file[DIFF_RIGHT], ops);
-    if (ndiff < 0)
+    if (!diff_text_load (&text[DIFF_LEFT], dview->file[DIFF_LEFT]))
+        return -1;
+    if (!diff_text_load (&text[DIFF_RIGHT], dview->file[DIFF_RIGHT]))
     {
-        if (ops != nullptr)
-            g_array_free (ops, true);
+        diff_text_free (&text[DIFF_LEFT]);
         return -1;
     }
 
+    /* after merge of hunk, the rest of hunks is still valid unless files were changed outside */
+    if (dview->ops_merged
+        && diff_ops_check (&text[DIFF_LEFT], &text[DIFF_RIGHT], &dview->opt, dview->ops))
+        ndiff = dview->ops->len;
+    else
+    {
+        g_array_set_size (dview->ops, 0);
+        ndiff = diff_compute (&text[DIFF_LEFT], &text[DIFF_RIGHT], &dview->opt, dview->ops);
+    }
+    dview->ops_merged = false;
+
     ctx.dsrc = dview->dsrc;
 
     rv = 0;
     ctx.a = dview->a[DIFF_LEFT];
     ctx.f = f[DIFF_LEFT];
-    rv |= dff_reparse (DIFF_LEFT, dview->file[DIFF_LEFT], ops, printer, &ctx);
+    rv |= dff_reparse (DIFF_LEFT, &text[DIFF_LEFT], dview->ops, printer, &ctx);
 
     ctx.a = dview->a[DIFF_RIGHT];
     ctx.f = f[DIFF_RIGHT];
-    rv |= dff_reparse (DIFF_RIGHT, dview->file[DIFF_RIGHT], ops, printer, &ctx);
+    rv |= dff_reparse (DIFF_RIGHT, &text[DIFF_RIGHT], dview->ops, printer, &ctx);
 
-    if (ops != nullptr)
-        g_array_free (ops, true);
+    diff_text_free (&text[DIFF_LEFT]);
+    diff_text_free (&text[DIFF_RIGHT]);
 
     if (rv != 0 || dview->a[DIFF_LEFT]->len != dview->a[DIFF_RIGHT]->len)
         return -1;
@@ -2243,11 +1974,22 @@ do_merge_hunk (WDiff * dview, action_direction_t merge_direction)
         }
         fflush (merge_file);
         fclose (merge_file);
+        if (rewrite_backup_content (merge_file_name_vpath, dview->file[n_merge]))
         {
-            int res;
-
-            res = rewrite_backup_content (merge_file_name_vpath, dview->file[n_merge]);
-            (void) res;
+            const GArray *a0 = dview->a[DIFF_LEFT];
+            size_t pos;
+            guint nhunks = 0;
+
+            /* hunks are separated by unchanged lines: count them up to the current one */
+            for (pos = 0; pos <= (size_t) dview->skip_rows; pos++)
+                if (((DIFFLN *) & g_array_index (a0, DIFFLN, pos))->ch != EQU_CH
+                    && (pos == 0
+                        || ((DIFFLN *) & g_array_index (a0, DIFFLN, pos - 1))->ch == EQU_CH))
+                    nhunks++;
+
+            /* the rest of hunks is reused by redo_diff() */
+            diff_ops_merge (dview->ops, nhunks - 1, n_merge ^ 1);
+            dview->ops_merged = true;
         }
         mc_unlink (merge_file_name_vpath);
         vfs_path_free (merge_file_name_vpath);
@@ -2390,8 +2132,8 @@ dview_diff_options (WDiff * dview)
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-dview_init (WDiff * dview, const char *args, const char *file1, const char *file2,
-            const char *label1, const char *label2, DSRC dsrc)
+dview_init (WDiff * dview, const char *file1, const char *file2, const char *label1,
+            const char *label2, DSRC dsrc)
 {
     int ndiff;
     FBUF *f[DIFF_COUNT];
@@ -2426,7 +2168,6 @@ dview_init (WDiff * dview, const char *args, const char *file1, const char *file
         }
     }
 
-    dview->args = args;
     dview->file[DIFF_LEFT] = file1;
     dview->file[DIFF_RIGHT] = file2;
     dview->label[DIFF_LEFT] = g_strdup (label1);
@@ -2443,6 +2184,8 @@ dview_init (WDiff * dview, const char *args, const char *file1, const char *file
 #endif
     dview->a[DIFF_LEFT] = g_array_new (false, false, sizeof (DIFFLN));
     dview->a[DIFF_RIGHT] = g_array_new (false, false, sizeof (DIFFLN));
+    dview->ops = g_array_new (false, false, sizeof (DIFFCMD));
+    dview->ops_merged = false;
 
     ndiff = redo_diff (dview);
     if (ndiff < 0)
@@ -2514,6 +2257,11 @@ dview_fini (WDiff * dview)
         g_array_free (dview->a[DIFF_RIGHT], true);
         dview->a[DIFF_RIGHT] = nullptr;
     }
+    if (dview->ops != nullptr)
+    {
+        g_array_free (dview->ops, true);
+        dview->ops = nullptr;
+    }
 
     g_free (dview->label[DIFF_LEFT]);
     g_free (dview->label[DIFF_RIGHT]);
@@ -3464,7 +3212,7 @@ diff_view (const char *file1, const char *file2, const char *label1, const char
 
     dview_dlg->get_title = dview_get_title;
 
-    error = dview_init (dview, "-a", file1, file2, label1, label2, DATA_SRC_MEM);       /* XXX binary diff? */
+    error = dview_init (dview, file1, file2, label1, label2, DATA_SRC_MEM);     /* XXX binary diff? */
 
     if (error == 0)
         dlg_run (dview_dlg);
@@ -619,8 +619,6 @@ get_prev_undo_action (WEdit * edit)
 static void
 edit_modification (WEdit * edit)
 {
-    edit->caches_valid = false;
-
     /* raise lock when file modified */
     if (!edit->modified && !edit->delete_file)
         edit->locked = lock_file (edit->filename_vpath);
@@ -680,54 +678,13 @@ is_blank (const edit_buffer_t * buf, off_t offset)
 /** returns the offset of line i */
 
 static off_t
-edit_find_line (WEdit * edit, long line)
+edit_find_line (const WEdit * edit, long line)
 {
-    long i, j = 0;
-    long m = 2000000000;        /* what is the magic number? */
-
-    if (!edit->caches_valid)
-    {
-        memset (edit->line_numbers, 0, sizeof (edit->line_numbers));
-        memset (edit->line_offsets, 0, sizeof (edit->line_offsets));
-        /* three offsets that we *know* are line 0 at 0 and these two: */
-        edit->line_numbers[1] = edit->buffer.curs_line;
-        edit->line_offsets[1] = edit_buffer_get_current_bol (&edit->buffer);
-        edit->line_numbers[2] = edit->buffer.lines;
-        edit->line_offsets[2] = edit_buffer_get_bol (&edit->buffer, edit->buffer.size);
-        edit->caches_valid = true;
-    }
-    if (line >= edit->buffer.lines)
-        return edit->line_offsets[2];
-    if (line <= 0)
-        return 0;
-    /* find the closest known point */
-    for (i = 0; i < N_LINE_CACHES; i++)
-    {
-        long n;
+    /* past the last line is the beginning of the last line */
+    if (line > edit->buffer.lines)
+        line = edit->buffer.lines;
 
-        n = labs (edit->line_numbers[i] - line);
-        if (n < m)
-        {
-            m = n;
-            j = i;
-        }
-    }
-    if (m == 0)
-        return edit->line_offsets[j];   /* know the offset exactly */
-    if (m == 1 && j >= 3)
-        i = j;                  /* one line different - caller might be looping, so stay in this cache */
-    else
-        i = 3 + (rand () % (N_LINE_CACHES - 3));
-    if (line > edit->line_numbers[j])
-        edit->line_offsets[i] =
-            edit_buffer_get_forward_offset (&edit->buffer, edit->line_offsets[j],
-                                            line - edit->line_numbers[j], 0);
-    else
-        edit->line_offsets[i] =
-            edit_buffer_get_backward_offset (&edit->buffer, edit->line_offsets[j],
-                                             edit->line_numbers[j] - line);
-    edit->line_numbers[i] = line;
-    return edit->line_offsets[i];
+    return edit_buffer_get_line_offset (&edit->buffer, line);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -37,6 +37,7 @@
 
 #include "lib/global.h"
 
+#include "lib/memscan.h"
 #include "lib/vfs/vfs.h"
 
 #include "edit-impl.h"
@@ -73,6 +74,13 @@
  * See also:
  * http://en.wikipedia.org/wiki/Gap_buffer
  * http://stackoverflow.com/questions/4199694/data-structure-for-text-editor
+ *
+ * Every buffer carries the running total of '\n' in it and all buffers of the same array
+ * before it (b1_lines and b2_lines). Since characters are inserted and deleted only in
+ * the last buffers of b1 and b2, only the last running totals are ever changed. So the
+ * text is seen as a sequence of pieces (b1[0]...b1[n1 - 1], b2[n2 - 1]...b2[0]) with known
+ * number of lines before each one, and line <-> offset conversions take a binary search
+ * over pieces plus a scan within a single piece instead of a scan of the whole text.
  */
 
 /*** global variables ****************************************************************************/
@@ -131,6 +139,218 @@ edit_buffer_get_byte_ptr (const edit_buffer_t * buf, off_t byte_index)
     return (char *) b + (byte_index & M_EDIT_BUF_SIZE);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count '\n' in memory area.
+ *
+ * @param s start of area
+ * @param len length of area
+ *
+ * @return number of '\n' in area
+ */
+
+static long
+edit_buffer_count_newlines (const char *s, off_t len)
+{
+    return (long) mc_memcount (s, '\n', (size_t) len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find last '\n' in memory area.
+ *
+ * @param s start of area
+ * @param len length of area
+ *
+ * @return pointer to last '\n' in area, nullptr if area doesn't contain it.
+ */
+
+static const char *
+edit_buffer_find_newline_backward (const char *s, off_t len)
+{
+    return (const char *) mc_memrchr (s, '\n', (size_t) len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append new line counter for just added buffer.
+ *
+ * @param lines running totals of lines of b1 or b2
+ */
+
+static void
+edit_buffer_lines_push (GArray * lines)
+{
+    long n = 0;
+
+    if (lines->len != 0)
+        n = g_array_index (lines, long, lines->len - 1);
+
+    g_array_append_val (lines, n);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of '\n' in buffers 0...i of b1 or b2.
+ *
+ * @param lines running totals of lines of b1 or b2
+ * @param i buffer index, -1 means "no buffers"
+ *
+ * @return number of '\n'
+ */
+
+static inline long
+edit_buffer_lines_upto (const GArray * lines, long i)
+{
+    return i < 0 ? 0 : g_array_index (lines, long, i);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of pieces of text. Piece is a filled part of one buffer of b1 or b2.
+ * Pieces are numbered in the text order: b1[0]...b1[n1 - 1], b2[n2 - 1]...b2[0].
+ *
+ * @param buf editor buffer
+ *
+ * @return number of pieces
+ */
+
+static inline long
+edit_buffer_get_pieces (const edit_buffer_t * buf)
+{
+    return (long) buf->b1->len + (long) buf->b2->len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get index of piece containing specified byte.
+ *
+ * @param buf editor buffer
+ * @param byte_index byte index, must be less than text size and not negative
+ *
+ * @return piece index
+ */
+
+static long
+edit_buffer_find_piece (const edit_buffer_t * buf, off_t byte_index)
+{
+    off_t p;
+
+    if (byte_index < buf->curs1)
+        return (long) (byte_index >> S_EDIT_BUF_SIZE);
+
+    p = buf->curs1 + buf->curs2 - byte_index - 1;
+
+    return edit_buffer_get_pieces (buf) - 1 - (long) (p >> S_EDIT_BUF_SIZE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get piece of text.
+ *
+ * @param buf editor buffer
+ * @param piece piece index
+ * @param start offset of first byte of piece in the text
+ * @param len length of piece
+ *
+ * @return pointer to first byte of piece.
+ */
+
+static const char *
+edit_buffer_get_piece (const edit_buffer_t * buf, long piece, off_t * start, off_t * len)
+{
+    long n1 = (long) buf->b1->len;
+    long j;
+    off_t p;
+
+    if (piece < n1)
+    {
+        *start = ((off_t) piece) << S_EDIT_BUF_SIZE;
+        *len = MIN (buf->curs1 - *start, EDIT_BUF_SIZE);
+        return (const char *) g_ptr_array_index (buf->b1, piece);
+    }
+
+    j = (long) buf->b2->len - 1 - (piece - n1);
+    /* b2 keeps text in the reverse order: p is a distance from the end of text */
+    p = ((off_t) j) << S_EDIT_BUF_SIZE;
+    *len = MIN (buf->curs2 - p, EDIT_BUF_SIZE);
+    *start = buf->curs1 + buf->curs2 - p - *len;
+    return (const char *) g_ptr_array_index (buf->b2, j) + EDIT_BUF_SIZE - *len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of '\n' in all pieces before specified one.
+ *
+ * @param buf editor buffer
+ * @param piece piece index, can be equal to number of pieces
+ *
+ * @return number of '\n'
+ */
+
+static long
+edit_buffer_lines_before_piece (const edit_buffer_t * buf, long piece)
+{
+    long n1 = (long) buf->b1->len;
+    long n2 = (long) buf->b2->len;
+    long lines;
+
+    lines = edit_buffer_lines_upto (buf->b1_lines, MIN (piece, n1) - 1);
+
+    if (piece > n1)
+        lines += edit_buffer_lines_upto (buf->b2_lines, n2 - 1)
+            - edit_buffer_lines_upto (buf->b2_lines, n2 - 1 - (piece - n1));
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether piece contains any '\n'.
+ *
+ * @param buf editor buffer
+ * @param piece piece index
+ *
+ * @return true if piece contains '\n', false otherwise
+ */
+
+static inline bool
+edit_buffer_piece_has_lines (const edit_buffer_t * buf, long piece)
+{
+    return edit_buffer_lines_before_piece (buf, piece + 1)
+        != edit_buffer_lines_before_piece (buf, piece);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of '\n' before specified byte.
+ *
+ * @param buf editor buffer
+ * @param byte_index byte index
+ *
+ * @return line number of specified byte
+ */
+
+static long
+edit_buffer_lines_before (const edit_buffer_t * buf, off_t byte_index)
+{
+    long piece;
+    const char *data;
+    off_t start, len;
+
+    if (byte_index <= 0)
+        return 0;
+
+    if (byte_index >= buf->curs1 + buf->curs2)
+        return edit_buffer_lines_before_piece (buf, edit_buffer_get_pieces (buf));
+
+    piece = edit_buffer_find_piece (buf, byte_index);
+    data = edit_buffer_get_piece (buf, piece, &start, &len);
+
+    return edit_buffer_lines_before_piece (buf, piece)
+        + edit_buffer_count_newlines (data, byte_index - start);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -145,6 +365,8 @@ edit_buffer_init (edit_buffer_t * buf, off_t size)
 {
     buf->b1 = g_ptr_array_sized_new (32);
     buf->b2 = g_ptr_array_sized_new (32);
+    buf->b1_lines = g_array_sized_new (false, false, sizeof (long), 32);
+    buf->b2_lines = g_array_sized_new (false, false, sizeof (long), 32);
 
     buf->curs1 = 0;
     buf->curs2 = 0;
@@ -174,6 +396,12 @@ edit_buffer_clean (edit_buffer_t * buf)
         g_ptr_array_foreach (buf->b2, (GFunc) g_free, nullptr);
         g_ptr_array_free (buf->b2, true);
     }
+
+    if (buf->b1_lines != nullptr)
+        g_array_free (buf->b1_lines, true);
+
+    if (buf->b2_lines != nullptr)
+        g_array_free (buf->b2_lines, true);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -218,6 +446,7 @@ edit_buffer_get_utf (const edit_buffer_t * buf, off_t byte_index, int *char_leng
     gunichar res;
     gunichar ch;
     gchar *next_ch = nullptr;
+    gssize rest;
 
     if (byte_index >= (buf->curs1 + buf->curs2) || byte_index < 0)
     {
@@ -232,7 +461,13 @@ edit_buffer_get_utf (const edit_buffer_t * buf, off_t byte_index, int *char_leng
         return 0;
     }
 
-    res = g_utf8_get_char_validated (str, -1);
+    /* don't look past the end of buffer that str points into */
+    if (byte_index >= buf->curs1)
+        rest = ((buf->curs1 + buf->curs2 - byte_index - 1) & M_EDIT_BUF_SIZE) + 1;
+    else
+        rest = EDIT_BUF_SIZE - (byte_index & M_EDIT_BUF_SIZE);
+
+    res = g_utf8_get_char_validated (str, rest);
     if (res == (gunichar) (-2) || res == (gunichar) (-1))
     {
         /* Retry with explicit bytes to make sure it's not a buffer boundary */
@@ -302,7 +537,7 @@ edit_buffer_get_prev_utf (const edit_buffer_t * buf, off_t byte_index, int *char
         return *(cursor_buf_ptr - 1);
     }
 
-    res = g_utf8_get_char_validated (str, -1);
+    res = g_utf8_get_char_validated (str, cursor_buf_ptr - str);
     if (res == (gunichar) (-2) || res == (gunichar) (-1))
     {
         *char_length = 1;
@@ -328,16 +563,72 @@ edit_buffer_get_prev_utf (const edit_buffer_t * buf, off_t byte_index, int *char
 long
 edit_buffer_count_lines (const edit_buffer_t * buf, off_t first, off_t last)
 {
-    long lines = 0;
+    long piece;
+    const char *data;
+    off_t start, len;
 
     first = MAX (first, 0);
     last = MIN (last, buf->size);
 
-    while (first < last)
-        if (edit_buffer_get_byte (buf, first++) == '\n')
-            lines++;
+    if (first >= last)
+        return 0;
 
-    return lines;
+    piece = edit_buffer_find_piece (buf, first);
+    data = edit_buffer_get_piece (buf, piece, &start, &len);
+
+    /* short distance within one piece */
+    if (last <= start + len)
+        return edit_buffer_count_newlines (data + first - start, last - first);
+
+    return edit_buffer_lines_before (buf, last) - edit_buffer_lines_before (buf, first);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get offset of the line with specified number.
+ *
+ * @param buf editor buffer
+ * @param line line number
+ *
+ * @return index of first char of line, 0 if line is negative, size of text if line is greater
+ *         than number of lines in the text.
+ */
+
+off_t
+edit_buffer_get_line_offset (const edit_buffer_t * buf, long line)
+{
+    long lo, hi;
+    const char *data, *p;
+    off_t start, len;
+
+    if (line <= 0)
+        return 0;
+
+    hi = edit_buffer_get_pieces (buf);
+
+    if (line > edit_buffer_lines_before_piece (buf, hi))
+        return buf->size;
+
+    /* find piece containing '\n' that precedes the line */
+    for (lo = 0, hi--; lo < hi;)
+    {
+        long mid = lo + (hi - lo) / 2;
+
+        if (edit_buffer_lines_before_piece (buf, mid + 1) < line)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    data = edit_buffer_get_piece (buf, lo, &start, &len);
+    line -= edit_buffer_lines_before_piece (buf, lo);
+
+    for (p = data; (p = (const char *) memchr (p, '\n', data + len - p)) != nullptr; p++)
+        if (--line == 0)
+            return start + (p - data) + 1;
+
+    /* line counters are broken */
+    return start + len;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -353,13 +644,27 @@ edit_buffer_count_lines (const edit_buffer_t * buf, off_t first, off_t last)
 off_t
 edit_buffer_get_bol (const edit_buffer_t * buf, off_t current)
 {
+    long piece;
+
     if (current <= 0)
         return 0;
 
-    for (; edit_buffer_get_byte (buf, current - 1) != '\n'; current--)
-        ;
+    if (current > buf->size)
+        return current;
+
+    for (piece = edit_buffer_find_piece (buf, current - 1); piece >= 0; piece--)
+        if (edit_buffer_piece_has_lines (buf, piece))
+        {
+            const char *data, *p;
+            off_t start, len;
+
+            data = edit_buffer_get_piece (buf, piece, &start, &len);
+            p = edit_buffer_find_newline_backward (data, MIN (current - start, len));
+            if (p != nullptr)
+                return start + (p - data) + 1;
+        }
 
-    return current;
+    return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -375,13 +680,30 @@ edit_buffer_get_bol (const edit_buffer_t * buf, off_t current)
 off_t
 edit_buffer_get_eol (const edit_buffer_t * buf, off_t current)
 {
+    long piece, pieces;
+
     if (current >= buf->size)
         return buf->size;
 
-    for (; edit_buffer_get_byte (buf, current) != '\n'; current++)
-        ;
+    if (current < 0)
+        return current;
+
+    pieces = edit_buffer_get_pieces (buf);
+
+    for (piece = edit_buffer_find_piece (buf, current); piece < pieces; piece++)
+        if (edit_buffer_piece_has_lines (buf, piece))
+        {
+            const char *data, *p;
+            off_t start, len, from;
+
+            data = edit_buffer_get_piece (buf, piece, &start, &len);
+            from = MAX (current - start, 0);
+            p = (const char *) memchr (data + from, '\n', len - from);
+            if (p != nullptr)
+                return start + (p - data);
+        }
 
-    return current;
+    return buf->size;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -449,12 +771,18 @@ edit_buffer_insert (edit_buffer_t * buf, int c)
 
     /* add a new buffer if we've reached the end of the last one */
     if (i == 0)
+    {
         g_ptr_array_add (buf->b1, g_malloc0 (EDIT_BUF_SIZE));
+        edit_buffer_lines_push (buf->b1_lines);
+    }
 
     /* perform the insertion */
     b = g_ptr_array_index (buf->b1, buf->curs1 >> S_EDIT_BUF_SIZE);
     *((unsigned char *) b + i) = (unsigned char) c;
 
+    if (c == '\n')
+        g_array_index (buf->b1_lines, long, buf->b1_lines->len - 1)++;
+
     /* update cursor position */
     buf->curs1++;
 
@@ -481,12 +809,18 @@ edit_buffer_insert_ahead (edit_buffer_t * buf, int c)
 
     /* add a new buffer if we've reached the end of the last one */
     if (i == 0)
+    {
         g_ptr_array_add (buf->b2, g_malloc0 (EDIT_BUF_SIZE));
+        edit_buffer_lines_push (buf->b2_lines);
+    }
 
     /* perform the insertion */
     b = g_ptr_array_index (buf->b2, buf->curs2 >> S_EDIT_BUF_SIZE);
     *((unsigned char *) b + EDIT_BUF_SIZE - 1 - i) = (unsigned char) c;
 
+    if (c == '\n')
+        g_array_index (buf->b2_lines, long, buf->b2_lines->len - 1)++;
+
     /* update cursor position */
     buf->curs2++;
 
@@ -517,6 +851,9 @@ edit_buffer_delete (edit_buffer_t * buf)
     i = prev & M_EDIT_BUF_SIZE;
     c = *((unsigned char *) b + EDIT_BUF_SIZE - 1 - i);
 
+    if (c == '\n')
+        g_array_index (buf->b2_lines, long, buf->b2_lines->len - 1)--;
+
     if (i == 0)
     {
         guint j;
@@ -525,6 +862,7 @@ edit_buffer_delete (edit_buffer_t * buf)
         b = g_ptr_array_index (buf->b2, j);
         g_ptr_array_remove_index (buf->b2, j);
         g_free (b);
+        g_array_set_size (buf->b2_lines, j);
     }
 
     buf->curs2 = prev;
@@ -558,6 +896,9 @@ edit_buffer_backspace (edit_buffer_t * buf)
     i = prev & M_EDIT_BUF_SIZE;
     c = *((unsigned char *) b + i);
 
+    if (c == '\n')
+        g_array_index (buf->b1_lines, long, buf->b1_lines->len - 1)--;
+
     if (i == 0)
     {
         guint j;
@@ -566,6 +907,7 @@ edit_buffer_backspace (edit_buffer_t * buf)
         b = g_ptr_array_index (buf->b1, j);
         g_ptr_array_remove_index (buf->b1, j);
         g_free (b);
+        g_array_set_size (buf->b1_lines, j);
     }
 
     buf->curs1 = prev;
@@ -593,22 +935,22 @@ edit_buffer_backspace (edit_buffer_t * buf)
 off_t
 edit_buffer_get_forward_offset (const edit_buffer_t * buf, off_t current, long lines, off_t upto)
 {
+    long line, last_line;
+
     if (upto != 0)
         return (off_t) edit_buffer_count_lines (buf, current, upto);
 
-    lines = MAX (lines, 0);
+    if (lines <= 0)
+        return current;
 
-    while (lines-- != 0)
-    {
-        long next;
+    line = edit_buffer_lines_before (buf, current);
+    last_line = edit_buffer_lines_before (buf, buf->size);
 
-        next = edit_buffer_get_eol (buf, current) + 1;
-        if (next > buf->size)
-            break;
-        current = next;
-    }
+    if (line + lines <= last_line)
+        return edit_buffer_get_line_offset (buf, line + lines);
 
-    return current;
+    /* stay in the last line */
+    return line < last_line ? edit_buffer_get_line_offset (buf, last_line) : current;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -625,13 +967,17 @@ edit_buffer_get_forward_offset (const edit_buffer_t * buf, off_t current, long l
 off_t
 edit_buffer_get_backward_offset (const edit_buffer_t * buf, off_t current, long lines)
 {
+    long line;
+
     lines = MAX (lines, 0);
     current = edit_buffer_get_bol (buf, current);
 
-    while (lines-- != 0 && current != 0)
-        current = edit_buffer_get_bol (buf, current - 1);
+    if (lines == 0 || current == 0)
+        return current;
 
-    return current;
+    line = edit_buffer_lines_before (buf, current);
+
+    return edit_buffer_get_line_offset (buf, MAX (line - lines, 0));
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -650,8 +996,9 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
                        edit_buffer_read_file_status_msg_t * sm, bool * aborted)
 {
     off_t ret = 0;
-    off_t i, j;
+    off_t i;
     off_t data_size;
+    long lines;
     void *b;
     status_msg_t *s = STATUS_MSG (sm);
     unsigned short update_cnt = 0;
@@ -672,9 +1019,9 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
         ret = mc_read (fd, b, data_size);
 
         /* count lines */
-        for (j = 0; j < ret; j++)
-            if (*((char *) b + j) == '\n')
-                buf->lines++;
+        lines = ret > 0 ? edit_buffer_count_newlines ((char *) b, ret) : 0;
+        g_array_append_val (buf->b2_lines, lines);
+        buf->lines += lines;
 
         if (ret < 0 || ret != data_size)
             return ret;
@@ -693,9 +1040,9 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
             ret += sz;
 
         /* count lines */
-        for (j = 0; j < sz; j++)
-            if (*((char *) b + j) == '\n')
-                buf->lines++;
+        lines = sz > 0 ? edit_buffer_count_newlines ((char *) b, sz) : 0;
+        g_array_append_val (buf->b2_lines, lines);
+        buf->lines += lines;
 
         if (s != nullptr && s->update != nullptr)
         {
@@ -746,6 +1093,22 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
         }
     }
 
+    /* reverse line counters as well and make running totals of them */
+    for (i = 0; i < (off_t) buf->b2_lines->len / 2; i++)
+    {
+        long *l1, *l2;
+
+        l1 = &g_array_index (buf->b2_lines, long, i);
+        l2 = &g_array_index (buf->b2_lines, long, buf->b2_lines->len - 1 - i);
+
+        lines = *l1;
+        *l1 = *l2;
+        *l2 = lines;
+    }
+
+    for (i = 1; i < (off_t) buf->b2_lines->len; i++)
+        g_array_index (buf->b2_lines, long, i) += g_array_index (buf->b2_lines, long, i - 1);
+
     return ret;
 }
 
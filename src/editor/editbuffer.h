@@ -17,6 +17,8 @@ typedef struct edit_buffer_struct
     off_t curs2;                /* position from the end of the file */
     GPtrArray *b1;              /* all data up to curs1 */
     GPtrArray *b2;              /* all data from end of file down to curs2 */
+    GArray *b1_lines;           /* number of '\n' in b1[0]...b1[i], for each i */
+    GArray *b2_lines;           /* number of '\n' in b2[0]...b2[i], for each i */
     off_t size;                 /* file size */
     long lines;                 /* total lines in the file */
     long curs_line;             /* line number of the cursor. */
@@ -44,6 +46,7 @@ int edit_buffer_get_utf (const edit_buffer_t * buf, off_t byte_index, int *char_
 int edit_buffer_get_prev_utf (const edit_buffer_t * buf, off_t byte_index, int *char_length);
 #endif
 long edit_buffer_count_lines (const edit_buffer_t * buf, off_t first, off_t last);
+off_t edit_buffer_get_line_offset (const edit_buffer_t * buf, long line);
 off_t edit_buffer_get_bol (const edit_buffer_t * buf, off_t current);
 off_t edit_buffer_get_eol (const edit_buffer_t * buf, off_t current);
 GString *edit_buffer_get_word_from_pos (const edit_buffer_t * buf, off_t start_pos, off_t * start,
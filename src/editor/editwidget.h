@@ -13,8 +13,6 @@
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
-#define N_LINE_CACHES 32
-
 /*** enums ***************************************************************************************/
 
 /**
@@ -122,11 +120,6 @@ struct WEdit
     off_t bracket;              /* position of a matching bracket */
     off_t last_bracket;         /* previous position of a matching bracket */
 
-    /* cache speedup for line lookups */
-    bool caches_valid;
-    long line_numbers[N_LINE_CACHES];
-    off_t line_offsets[N_LINE_CACHES];
-
     edit_book_mark_t *book_mark;
     GArray *serialized_bookmarks;
 
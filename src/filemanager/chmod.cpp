@@ -484,15 +484,33 @@ do_chmod (const vfs_path_t * p, struct stat *sf)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static bool
+chmod_batch_fill (const file_entry_t * fe, vfs_batch_t * op, void *data)
+{
+    (void) data;
+
+    /* panel keeps mode of link itself, but chmod changes its target: do it one by one */
+    if (S_ISLNK (fe->st.st_mode))
+        return false;
+
+    op->op = VFS_BATCH_CHMOD;
+    op->mode = (fe->st.st_mode & and_mask) | or_mask;
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static void
 apply_mask (vfs_path_t * vpath, struct stat *sf)
 {
-    bool ok;
+    bool ok = true;
 
-    if (!do_chmod (vpath, sf))
-        return;
+    /* remote file system may change all files at once, failed ones are kept marked */
+    if (panel_batch_marked (current_panel, chmod_batch_fill, nullptr) == 0
+        || current_panel->dir.list[current_file].f.marked)
+        ok = do_chmod (vpath, sf);
 
-    do
+    while (ok && current_panel->marked != 0)
     {
         const char *fname;
 
@@ -518,7 +536,6 @@ apply_mask (vfs_path_t * vpath, struct stat *sf)
 
         vfs_path_free (vpath);
     }
-    while (ok && current_panel->marked != 0);
 }
 
 /* --------------------------------------------------------------------------------------------- */
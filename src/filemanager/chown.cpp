@@ -353,15 +353,35 @@ do_chown (const vfs_path_t * p, uid_t u, gid_t g)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static bool
+chown_batch_fill (const file_entry_t * fe, vfs_batch_t * op, void *data)
+{
+    const vfs_batch_t *ids = (const vfs_batch_t *) data;
+
+    (void) fe;
+
+    op->op = VFS_BATCH_CHOWN;
+    op->uid = ids->uid;
+    op->gid = ids->gid;
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static void
 apply_chowns (vfs_path_t * vpath, uid_t u, gid_t g)
 {
-    bool ok;
+    vfs_batch_t ids;
+    bool ok = true;
 
-    if (!do_chown (vpath, u, g))
-        return;
+    /* remote file system may change all files at once, failed ones are kept marked */
+    ids.uid = u;
+    ids.gid = g;
+    if (panel_batch_marked (current_panel, chown_batch_fill, &ids) == 0
+        || current_panel->dir.list[current_file].f.marked)
+        ok = do_chown (vpath, u, g);
 
-    do
+    while (ok && current_panel->marked != 0)
     {
         const char *fname;
         struct stat sf;
@@ -384,7 +404,6 @@ apply_chowns (vfs_path_t * vpath, uid_t u, gid_t g)
 
         vfs_path_free (vpath);
     }
-    while (ok && current_panel->marked != 0);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1150,6 +1150,10 @@ compare_dirs_cmd (void)
 
     if (get_current_type () == view_listing && get_other_type () == view_listing)
     {
+        /* files that arrive later would be never marked */
+        panel_load_finish (current_panel);
+        panel_load_finish (other_panel);
+
         compare_dir (current_panel, other_panel, thorough_flag);
         compare_dir (other_panel, current_panel, thorough_flag);
     }
@@ -1447,6 +1451,8 @@ dirsizes_cmd (void)
     status_msg_init (STATUS_MSG (&dsm), _("Directory scanning"), 0, dirsize_status_init_cb,
                      dirsize_status_update_cb, dirsize_status_deinit_cb);
 
+    panel_load_finish (panel);
+
     for (i = 0; i < panel->dir.len; i++)
         if (S_ISDIR (panel->dir.list[i].st.st_mode)
             && ((panel->dirs_marked != 0 && panel->dir.list[i].f.marked)
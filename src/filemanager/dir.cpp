@@ -30,13 +30,17 @@
 
 #include <config.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "lib/global.h"
 #include "lib/tty/tty.h"
+#include "lib/tty/key.h"        /* add_select_channel() */
 #include "lib/search.h"
 #include "lib/vfs/vfs.h"
 #include "lib/fs.h"
@@ -58,8 +62,105 @@
         ? 1 \
         : ( (S_ISDIR (x->st.st_mode) || link_isdir (x)) ? 2 : 0) )
 
+#if defined(HAVE_FSTATAT) && defined(O_DIRECTORY)
+/* files of local directory are stat'ed relative to the directory by batches */
+#define DIR_STAT_AT 1
+#define DIR_STAT_BATCH_SIZE 4096
+#if GLIB_CHECK_VERSION (2, 32, 0)
+/* large batches are stat'ed in worker threads: on network file systems stat() is slow */
+#define DIR_STAT_THREADS 1
+#define DIR_STAT_MAX_THREADS 8
+/* min number of files in batch to start worker threads */
+#define DIR_STAT_PARALLEL_MIN 256
+/* number of files taken by thread at once */
+#define DIR_STAT_CHUNK 16
+/* local directories can be loaded in background */
+#define DIR_LOAD_THREADS 1
+/* files of the first batch are enough to fill panel, next batches are twice larger */
+#define DIR_LOAD_FIRST_BATCH 64
+/* loaded files are merged into the list if their number is at least 1/ratio of list */
+#define DIR_LOAD_MERGE_RATIO 8
+#endif
+#endif
+
+/* lists are sorted by insertion in pieces not longer than this */
+#define DIR_SORT_RUN 16
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+/* large lists are sorted in worker threads */
+#define DIR_SORT_THREADS 1
+#define DIR_SORT_MAX_THREADS 8
+/* min number of files in list to sort it in worker threads */
+#define DIR_SORT_PARALLEL_MIN 65536
+#endif
+
 /*** file scope type declarations ****************************************************************/
 
+/* compact record of file to be sorted */
+typedef struct
+{
+    file_entry_t *fentry;
+    guint64 key;                /* size, time or inode for orders by them */
+    int group;                  /* directories first etc, see MY_ISDIR */
+} dir_sort_item_t;
+
+#ifdef DIR_SORT_THREADS
+/* piece of list to be sorted or two sorted pieces to be merged by worker thread */
+typedef struct
+{
+    dir_sort_item_t *items;
+    dir_sort_item_t *tmp;
+    int mid;                    /* length of the first piece to be merged, 0 to sort */
+    int len;
+} dir_sort_task_t;
+#endif
+
+#ifdef DIR_STAT_AT
+typedef struct
+{
+    char *fname;
+    struct stat st;
+    bool link_to_dir;
+    bool stale_link;
+} dir_stat_t;
+
+/* files of local directory to be stat'ed */
+typedef struct
+{
+    int fd;                     /* directory */
+    dir_stat_t *files;
+    int len;
+    gint next;                  /* index of the first file not taken by any thread */
+    gint running;               /* number of worker threads that aren't finished yet */
+} dir_stat_batch_t;
+#endif
+
+#ifdef DIR_LOAD_THREADS
+/* directory loaded by worker thread */
+struct dir_list_loader_t
+{
+    gint ref;                   /* owners: main thread and worker thread */
+    gint cancel;                /* set when files aren't needed any more */
+    DIR *dirp;
+    int pipe[2];                /* wakes up main loop when files are loaded */
+    bool show_dot_files;        /* panel options when loading was started */
+    bool show_backups;
+
+    /* owned by main thread */
+    vfs_path_t *vpath;
+    dir_list_loader_fn callback;
+    void *data;
+    dir_list pending;           /* shown files those aren't merged into list yet */
+
+    /* protected by lock */
+    GMutex lock;
+    GCond cond;                 /* signaled when loading is finished */
+    GArray *ready;              /* dir_stat_t of loaded files those aren't taken yet */
+    bool notified;              /* main loop is woken up but files aren't taken yet */
+    bool finished;
+};
+#endif
+
 /*** file scope variables ************************************************************************/
 
 /* Reverse flag */
@@ -71,7 +172,24 @@ static bool case_sensitive = OS_SORT_CASE_SENSITIVE_DEFAULT;
 /* Are the exec_bit files top in list */
 static bool exec_first = true;
 
-static dir_list dir_copy = { nullptr, 0, 0, nullptr };
+/* sort routine of current dir_list_sort() */
+static GCompareFunc dir_sort_routine = nullptr;
+/* are files sorted by dir_sort_item_t::key? */
+static bool dir_sort_by_key = false;
+
+#ifdef DIR_SORT_THREADS
+static GThreadPool *dir_sort_pool = nullptr;
+static GMutex dir_sort_lock;
+static GCond dir_sort_cond;     /* signaled when worker thread finishes task */
+static int dir_sort_running = 0;        /* number of tasks not finished yet */
+#endif
+
+#ifdef DIR_STAT_THREADS
+static GThreadPool *dir_stat_pool = nullptr;
+static GMutex dir_stat_lock;
+static GCond dir_stat_cond;     /* signaled when worker thread finishes batch */
+static bool dir_stat_done = false;      /* pool was freed, batches are stat'ed by callers */
+#endif
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -138,6 +256,273 @@ clean_sort_keys (dir_list * list, int start, int count)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether file isn't shown in panel because of its name.
+ *
+ * @param fname file name
+ *
+ * @return true if file should be skipped, false otherwise
+ */
+
+static bool
+dir_name_is_hidden (const char *fname)
+{
+    return (DIR_IS_DOT (fname) || DIR_IS_DOTDOT (fname)
+            || (!panels_options.show_dot_files && fname[0] == '.')
+            || (!panels_options.show_backups && fname[strlen (fname) - 1] == '~'));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether stat'ed file is shown in panel.
+ *
+ * @return false = don't add, true = add to the list
+ */
+
+static bool
+dir_entry_is_shown (const char *fname, const struct stat *st, bool link_to_dir, const char *fltr)
+{
+    if (S_ISDIR (st->st_mode))
+        tree_store_mark_checked (fname);
+
+    return (S_ISDIR (st->st_mode) || link_to_dir || fltr == nullptr
+            || mc_search (fltr, nullptr, fname, MC_SEARCH_T_GLOB));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare two files the same way as sort routine does but without touching
+ * the file_entry_t for orders by size, time and inode.
+ * Keys of names must be created before.
+ */
+
+static inline int
+dir_sort_item_compare (const dir_sort_item_t * a, const dir_sort_item_t * b)
+{
+    if (a->group != b->group)
+        return b->group - a->group;
+
+    if (dir_sort_by_key)
+    {
+        if (a->key != b->key)
+            return (a->key < b->key ? -1 : 1) * reverse;
+        if (dir_sort_routine == (GCompareFunc) sort_inode)
+            return 0;
+        return key_collate (a->fentry->sort_key, b->fentry->sort_key);
+    }
+
+    if (dir_sort_routine == (GCompareFunc) sort_name)
+        return key_collate (a->fentry->sort_key, b->fentry->sort_key);
+
+    return dir_sort_routine (a->fentry, b->fentry);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Merge sorted pieces src[0, mid) and src[mid, len) into dst.
+ * Files from the first piece go first if they are equal, so sort is stable.
+ */
+
+static void
+dir_sort_merge (const dir_sort_item_t * src, int mid, int len, dir_sort_item_t * dst)
+{
+    int i = 0, j = mid;
+
+    while (i < mid && j < len)
+        *dst++ = dir_sort_item_compare (&src[j], &src[i]) < 0 ? src[j++] : src[i++];
+
+    memcpy (dst, src + i, (mid - i) * sizeof (*src));
+    dst += mid - i;
+    memcpy (dst, src + j, (len - j) * sizeof (*src));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stable merge sort.
+ *
+ * @param items files to be sorted
+ * @param tmp buffer of the same length as @items
+ * @param len number of files
+ */
+
+static void
+dir_sort_items (dir_sort_item_t * items, dir_sort_item_t * tmp, int len)
+{
+    int mid;
+
+    if (len <= DIR_SORT_RUN)
+    {
+        int i;
+
+        for (i = 1; i < len; i++)
+        {
+            dir_sort_item_t item = items[i];
+            int j;
+
+            for (j = i; j > 0 && dir_sort_item_compare (&item, &items[j - 1]) < 0; j--)
+                items[j] = items[j - 1];
+            items[j] = item;
+        }
+
+        return;
+    }
+
+    mid = len / 2;
+    dir_sort_items (items, tmp, mid);
+    dir_sort_items (items + mid, tmp + mid, len - mid);
+
+    /* already sorted list is sorted again after every reload */
+    if (dir_sort_item_compare (&items[mid], &items[mid - 1]) >= 0)
+        return;
+
+    memcpy (tmp, items, len * sizeof (*items));
+    dir_sort_merge (tmp, mid, len, items);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_SORT_THREADS
+static void
+dir_sort_worker (gpointer data, gpointer user_data)
+{
+    dir_sort_task_t *task = (dir_sort_task_t *) data;
+
+    (void) user_data;
+
+    if (task->mid == 0)
+        dir_sort_items (task->items, task->tmp, task->len);
+    else
+    {
+        memcpy (task->tmp, task->items, task->len * sizeof (*task->items));
+        dir_sort_merge (task->tmp, task->mid, task->len, task->items);
+    }
+
+    g_mutex_lock (&dir_sort_lock);
+    if (--dir_sort_running == 0)
+        g_cond_signal (&dir_sort_cond);
+    g_mutex_unlock (&dir_sort_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Run tasks in worker threads and wait for all of them.
+ */
+
+static void
+dir_sort_run_tasks (dir_sort_task_t * tasks, int n)
+{
+    int i;
+
+    dir_sort_running = n;
+
+    for (i = 0; i < n; i++)
+        g_thread_pool_push (dir_sort_pool, &tasks[i], nullptr);
+
+    g_mutex_lock (&dir_sort_lock);
+    while (dir_sort_running != 0)
+        g_cond_wait (&dir_sort_cond, &dir_sort_lock);
+    g_mutex_unlock (&dir_sort_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Sort pieces of list in worker threads, then merge them by pairs.
+ *
+ * @return false if threads aren't available, true if list is sorted
+ */
+
+static bool
+dir_sort_items_parallel (dir_sort_item_t * items, dir_sort_item_t * tmp, int len)
+{
+    dir_sort_task_t tasks[DIR_SORT_MAX_THREADS];
+    int bounds[DIR_SORT_MAX_THREADS + 1];
+    int n, i;
+
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+    n = CLAMP (n, 1, DIR_SORT_MAX_THREADS);
+    if (n < 2)
+        return false;
+
+    if (dir_sort_pool == nullptr)
+        dir_sort_pool =
+            g_thread_pool_new (dir_sort_worker, nullptr, DIR_SORT_MAX_THREADS, false, nullptr);
+    if (dir_sort_pool == nullptr)
+        return false;
+
+    for (i = 0; i <= n; i++)
+        bounds[i] = (int) ((gint64) len * i / n);
+
+    for (i = 0; i < n; i++)
+    {
+        tasks[i].items = items + bounds[i];
+        tasks[i].tmp = tmp + bounds[i];
+        tasks[i].mid = 0;
+        tasks[i].len = bounds[i + 1] - bounds[i];
+    }
+
+    dir_sort_run_tasks (tasks, n);
+
+    /* merge neighbour pieces until one piece is left */
+    while (n > 1)
+    {
+        int m = 0;
+
+        for (i = 0; i + 1 < n; i += 2, m++)
+        {
+            tasks[m].items = items + bounds[i];
+            tasks[m].tmp = tmp + bounds[i];
+            tasks[m].mid = bounds[i + 1] - bounds[i];
+            tasks[m].len = bounds[i + 2] - bounds[i];
+        }
+
+        dir_sort_run_tasks (tasks, m);
+
+        /* odd piece is merged at the next level */
+        for (i = 0; i < n; i += 2)
+            bounds[i / 2] = bounds[i];
+        bounds[(n + 1) / 2] = len;
+        n = (n + 1) / 2;
+    }
+
+    return true;
+}
+#endif /* DIR_SORT_THREADS */
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move entries of list in place to the order of sorted items.
+ *
+ * @param list entries to be moved
+ * @param items sorted items pointing to entries of @list, destroyed here
+ * @param len number of items
+ */
+
+static void
+dir_sort_permute (file_entry_t * list, dir_sort_item_t * items, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+    {
+        file_entry_t fentry;
+        int j, k;
+
+        if (items[i].fentry == &list[i])
+            continue;
+
+        /* follow the cycle: entry from position k goes to position j */
+        fentry = list[i];
+        for (j = i; (k = items[j].fentry - list) != i; j = k)
+        {
+            list[j] = list[k];
+            items[j].fentry = &list[j];
+        }
+        list[j] = fentry;
+        items[j].fentry = &list[j];
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * If you change handle_dirent then check also handle_path.
@@ -150,11 +535,7 @@ handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, bool * li
 {
     vfs_path_t *vpath;
 
-    if (DIR_IS_DOT (dp->d_name) || DIR_IS_DOTDOT (dp->d_name))
-        return false;
-    if (!panels_options.show_dot_files && (dp->d_name[0] == '.'))
-        return false;
-    if (!panels_options.show_backups && dp->d_name[strlen (dp->d_name) - 1] == '~')
+    if (dir_name_is_hidden (dp->d_name))
         return false;
 
     vpath = vfs_path_from_str (dp->d_name);
@@ -168,16 +549,290 @@ handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, bool * li
         memset (buf1, 0, sizeof (*buf1));
     }
 
-    if (S_ISDIR (buf1->st_mode))
-        tree_store_mark_checked (dp->d_name);
-
     /* A link to a file or a directory? */
     *link_to_dir = file_is_symlink_to_dir (vpath, buf1, stale_link);
 
     vfs_path_free (vpath);
 
-    return (S_ISDIR (buf1->st_mode) || *link_to_dir || fltr == nullptr
-            || mc_search (fltr, nullptr, dp->d_name, MC_SEARCH_T_GLOB));
+    return dir_entry_is_shown (dp->d_name, buf1, *link_to_dir, fltr);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append file info to the directory list and mark it if it was marked before reload.
+ *
+ * @param marked_files names of marked files, or nullptr
+ * @param marked_cnt number of names in @marked_files that aren't found yet
+ *
+ * @return false on failure, true on success
+ */
+
+static bool
+dir_list_append_marked (dir_list * list, const char *fname, const struct stat *st,
+                        bool link_to_dir, bool stale_link, GHashTable * marked_files,
+                        int *marked_cnt)
+{
+    file_entry_t *fentry;
+
+    if (!dir_list_append (list, fname, st, link_to_dir, stale_link))
+        return false;
+
+    if (marked_files == nullptr)
+        return true;
+
+    fentry = &list->list[list->len - 1];
+
+    /*
+     * If we have marked files in the copy, scan through the copy
+     * to find matching file.  Decrease number of remaining marks if
+     * we copied one.
+     */
+    fentry->f.marked = (*marked_cnt > 0 && g_hash_table_lookup (marked_files, fname) != nullptr);
+    if (fentry->f.marked)
+        (*marked_cnt)--;
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_STAT_AT
+/**
+ * Open local directory to stat its files relative to it.
+ *
+ * @param vpath directory
+ *
+ * @return file descriptor of directory, -1 if directory isn't local or can't be opened
+ */
+
+static int
+dir_open_local (const vfs_path_t * vpath)
+{
+    const vfs_path_element_t *element;
+
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return (-1);
+
+    element = vfs_path_get_by_index (vpath, -1);
+#ifdef HAVE_CHARSET
+    /* names are recoded by mc_readdir() */
+    if (element->encoding != nullptr)
+        return (-1);
+#endif
+
+    return open (element->path, O_RDONLY | O_DIRECTORY);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stat files of batch those aren't taken by other threads yet. Only plain system calls are
+ * used here because it is run in worker threads too.
+ */
+
+static void
+dir_stat_batch_run (dir_stat_batch_t * batch)
+{
+    while (true)
+    {
+        int i, end;
+
+#ifdef DIR_STAT_THREADS
+        i = g_atomic_int_add (&batch->next, DIR_STAT_CHUNK);
+        end = MIN (i + DIR_STAT_CHUNK, batch->len);
+#else
+        i = batch->next;
+        end = batch->next = batch->len;
+#endif
+        if (i >= batch->len)
+            break;
+
+        for (; i < end; i++)
+        {
+            dir_stat_t *f = &batch->files[i];
+            struct stat st;
+
+            /* the same as handle_dirent() does */
+            if (fstatat (batch->fd, f->fname, &f->st, AT_SYMLINK_NOFOLLOW) == -1)
+                memset (&f->st, 0, sizeof (f->st));
+
+            f->link_to_dir = false;
+            f->stale_link = false;
+            if (S_ISLNK (f->st.st_mode))
+            {
+                f->stale_link = fstatat (batch->fd, f->fname, &st, 0) != 0;
+                if (!f->stale_link)
+                    f->link_to_dir = S_ISDIR (st.st_mode) != 0;
+            }
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_STAT_THREADS
+static void
+dir_stat_worker (gpointer data, gpointer user_data)
+{
+    dir_stat_batch_t *batch = (dir_stat_batch_t *) data;
+
+    (void) user_data;
+
+    dir_stat_batch_run (batch);
+
+    g_mutex_lock (&dir_stat_lock);
+    if (g_atomic_int_dec_and_test (&batch->running))
+        g_cond_broadcast (&dir_stat_cond);
+    g_mutex_unlock (&dir_stat_lock);
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stat all files of batch, in worker threads if batch is large enough.
+ */
+
+static void
+dir_stat_batch (dir_stat_batch_t * batch)
+{
+    batch->next = 0;
+    batch->running = 0;
+
+#ifdef DIR_STAT_THREADS
+    if (batch->len >= DIR_STAT_PARALLEL_MIN)
+    {
+        /* batches are stat'ed by loaders of directories too, even after dir_list_done() */
+        g_mutex_lock (&dir_stat_lock);
+        if (dir_stat_pool == nullptr && !dir_stat_done)
+            dir_stat_pool =
+                g_thread_pool_new (dir_stat_worker, nullptr, DIR_STAT_MAX_THREADS, false, nullptr);
+
+        if (dir_stat_pool != nullptr)
+        {
+            int i, n;
+
+            n = MIN (DIR_STAT_MAX_THREADS, batch->len / DIR_STAT_PARALLEL_MIN + 1);
+            g_atomic_int_set (&batch->running, n);
+            for (i = 0; i < n; i++)
+                g_thread_pool_push (dir_stat_pool, batch, nullptr);
+        }
+        g_mutex_unlock (&dir_stat_lock);
+    }
+#endif
+
+    /* take part in work */
+    dir_stat_batch_run (batch);
+
+#ifdef DIR_STAT_THREADS
+    g_mutex_lock (&dir_stat_lock);
+    while (g_atomic_int_get (&batch->running) != 0)
+        g_cond_wait (&dir_stat_cond, &dir_stat_lock);
+    g_mutex_unlock (&dir_stat_lock);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stat files of batch and add them to the list.
+ *
+ * @return false on failure, true on success
+ */
+
+static bool
+dir_list_add_batch (dir_list * list, dir_stat_batch_t * batch, const char *fltr,
+                    GHashTable * marked_files, int *marked_cnt)
+{
+    bool ret = true;
+    int i;
+
+    dir_stat_batch (batch);
+
+    for (i = 0; i < batch->len; i++)
+    {
+        dir_stat_t *f = &batch->files[i];
+
+        if (ret && dir_entry_is_shown (f->fname, &f->st, f->link_to_dir, fltr))
+            ret = dir_list_append_marked (list, f->fname, &f->st, f->link_to_dir, f->stale_link,
+                                          marked_files, marked_cnt);
+        g_free (f->fname);
+    }
+
+    batch->len = 0;
+
+    return ret;
+}
+#endif /* DIR_STAT_AT */
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read entries of directory and add them to the list.
+ * Files of local directory are stat'ed relative to it, by batches.
+ *
+ * @param list directory list
+ * @param dirp opened directory
+ * @param vpath directory path
+ * @param fltr file name filter, nullptr to show all files
+ * @param marked_files names of files to mark, or nullptr
+ * @param marked_cnt number of names in @marked_files
+ *
+ * @return false on failure, true on success
+ */
+
+static bool
+dir_list_read (dir_list * list, DIR * dirp, const vfs_path_t * vpath, const char *fltr,
+               GHashTable * marked_files, int marked_cnt)
+{
+    struct dirent *dp;
+    bool ret = true;
+#ifdef DIR_STAT_AT
+    dir_stat_batch_t batch;
+
+    batch.fd = dir_open_local (vpath);
+    if (batch.fd != -1)
+    {
+        batch.files = g_new (dir_stat_t, DIR_STAT_BATCH_SIZE);
+        batch.len = 0;
+
+        while (ret && (dp = mc_readdir (dirp)) != nullptr)
+        {
+            if (list->callback != nullptr)
+                list->callback (DIR_READ, dp);
+
+            if (dir_name_is_hidden (dp->d_name))
+                continue;
+
+            batch.files[batch.len++].fname = g_strdup (dp->d_name);
+            if (batch.len == DIR_STAT_BATCH_SIZE)
+                ret = dir_list_add_batch (list, &batch, fltr, marked_files, &marked_cnt);
+        }
+
+        if (batch.len != 0 && !dir_list_add_batch (list, &batch, fltr, marked_files, &marked_cnt))
+            ret = false;
+
+        g_free (batch.files);
+        close (batch.fd);
+
+        return ret;
+    }
+#else
+    (void) vpath;
+#endif
+
+    while (ret && (dp = mc_readdir (dirp)) != nullptr)
+    {
+        struct stat st;
+        bool link_to_dir, stale_link;
+
+        if (list->callback != nullptr)
+            list->callback (DIR_READ, dp);
+
+        if (!handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
+            continue;
+
+        ret = dir_list_append_marked (list, dp->d_name, &st, link_to_dir, stale_link,
+                                      marked_files, &marked_cnt);
+    }
+
+    return ret;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -208,19 +863,168 @@ dir_get_dotdot_stat (const vfs_path_t * vpath, struct stat *st)
 
 /* --------------------------------------------------------------------------------------------- */
 
+#ifdef DIR_LOAD_THREADS
 static void
-alloc_dir_copy (int size)
+dir_loader_unref (dir_list_loader_t * loader)
+{
+    guint i;
+
+    if (!g_atomic_int_dec_and_test (&loader->ref))
+        return;
+
+    for (i = 0; i < loader->ready->len; i++)
+        g_free (g_array_index (loader->ready, dir_stat_t, i).fname);
+    g_array_free (loader->ready, TRUE);
+
+    close (loader->pipe[0]);
+    close (loader->pipe[1]);
+    g_mutex_clear (&loader->lock);
+    g_cond_clear (&loader->cond);
+    g_free (loader);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Pass stat'ed files to main thread. Main loop is woken up if it doesn't know about
+ * files those aren't taken yet.
+ */
+
+static void
+dir_loader_push (dir_list_loader_t * loader, dir_stat_batch_t * batch, bool finished)
+{
+    g_mutex_lock (&loader->lock);
+
+    g_array_append_vals (loader->ready, batch->files, batch->len);
+    batch->len = 0;
+
+    if (finished)
+    {
+        loader->finished = true;
+        g_cond_broadcast (&loader->cond);
+    }
+
+    if (!loader->notified)
+    {
+        loader->notified = true;
+        while (write (loader->pipe[1], "", 1) == -1 && errno == EINTR)
+            ;
+    }
+
+    g_mutex_unlock (&loader->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read local directory by batches in worker thread. Only plain system calls are used here.
+ * The first batch is small to show files in panel as soon as possible.
+ */
+
+static gpointer
+dir_loader_worker (gpointer data)
 {
-    if (dir_copy.size < size)
+    dir_list_loader_t *loader = (dir_list_loader_t *) data;
+    dir_stat_batch_t batch;
+    int size = DIR_LOAD_FIRST_BATCH;
+    struct dirent *dp;
+
+    batch.fd = dirfd (loader->dirp);
+    batch.files = g_new (dir_stat_t, DIR_STAT_BATCH_SIZE);
+    batch.len = 0;
+
+    while (g_atomic_int_get (&loader->cancel) == 0 && (dp = readdir (loader->dirp)) != nullptr)
     {
-        if (dir_copy.list != nullptr)
-            dir_list_free_list (&dir_copy);
+        const char *fname = dp->d_name;
 
-        dir_copy.list = g_new0 (file_entry_t, size);
-        dir_copy.size = size;
-        dir_copy.len = 0;
+        /* the same as dir_name_is_hidden() does but with options copied in main thread */
+        if (DIR_IS_DOT (fname) || DIR_IS_DOTDOT (fname)
+            || (!loader->show_dot_files && fname[0] == '.')
+            || (!loader->show_backups && fname[strlen (fname) - 1] == '~'))
+            continue;
+
+        batch.files[batch.len++].fname = g_strdup (fname);
+        if (batch.len == size)
+        {
+            dir_stat_batch (&batch);
+            dir_loader_push (loader, &batch, false);
+            size = MIN (size * 2, DIR_STAT_BATCH_SIZE);
+        }
+    }
+
+    if (g_atomic_int_get (&loader->cancel) == 0)
+        dir_stat_batch (&batch);
+    /* files of cancelled loading are freed with loader */
+    dir_loader_push (loader, &batch, true);
+
+    g_free (batch.files);
+    closedir (loader->dirp);
+    dir_loader_unref (loader);
+
+    return nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+dir_loader_channel (int fd, void *info)
+{
+    dir_list_loader_t *loader = (dir_list_loader_t *) info;
+    char buf[16];
+
+    g_mutex_lock (&loader->lock);
+    loader->notified = false;
+    while (read (fd, buf, sizeof (buf)) > 0)
+        ;
+    g_mutex_unlock (&loader->lock);
+
+    /* loader can be freed here */
+    loader->callback (loader->data);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Merge sorted list of files into the sorted directory list keeping the order.
+ * Entries of @add are moved to @list.
+ *
+ * @return false on failure, true on success
+ */
+
+static bool
+dir_list_merge (dir_list * list, dir_list * add, GCompareFunc sort,
+                const dir_sort_options_t * sort_op)
+{
+    int i, j, k, lo;
+
+    if (list->len + add->len > list->size && !dir_list_grow (list, list->len + add->len
+                                                             - list->size + DIR_LIST_RESIZE_STEP))
+        return false;
+
+    reverse = sort_op->reverse ? -1 : 1;
+    case_sensitive = sort_op->case_sensitive ? 1 : 0;
+    exec_first = sort_op->exec_first;
+
+    /* from the end: files of @add go after equal files of @list */
+    lo = list->len > 0 && DIR_IS_DOTDOT (list->list[0].fname) ? 1 : 0;
+    i = list->len - 1;
+    j = add->len - 1;
+    k = list->len + add->len - 1;
+    while (j >= 0)
+    {
+        if (i >= lo && sort != (GCompareFunc) unsorted
+            && sort (&list->list[i], &add->list[j]) > 0)
+            list->list[k--] = list->list[i--];
+        else
+            list->list[k--] = add->list[j--];
     }
+
+    list->len += add->len;
+    add->len = 0;
+    clean_sort_keys (list, lo, list->len - lo);
+
+    return true;
 }
+#endif /* DIR_LOAD_THREADS */
 
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
@@ -303,6 +1107,7 @@ dir_list_append (dir_list * list, const char *fname, const struct stat * st,
     fentry->st = *st;
     fentry->sort_key = nullptr;
     fentry->second_sort_key = nullptr;
+    fentry->color_stamp = 0;
 
     list->len++;
 
@@ -481,6 +1286,211 @@ sort_size (file_entry_t * a, file_entry_t * b)
     return bd - ad;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find file in the directory list.
+ *
+ * @param list directory list
+ * @param fname file name
+ *
+ * @return index of file, -1 if file is not found
+ */
+
+int
+dir_list_find (const dir_list * list, const char *fname)
+{
+    size_t len;
+    int i;
+
+    len = strlen (fname);
+
+    for (i = 0; i < list->len; i++)
+        if (list->list[i].fnamelen == len && strcmp (list->list[i].fname, fname) == 0)
+            return i;
+
+    return (-1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove file from the directory list.
+ *
+ * @param list directory list
+ * @param idx index of file
+ */
+
+void
+dir_list_remove (dir_list * list, int idx)
+{
+    g_free (list->list[idx].fname);
+    list->len--;
+    memmove (&list->list[idx], &list->list[idx + 1], (list->len - idx) * sizeof (file_entry_t));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove several files from the directory list by one pass.
+ *
+ * @param list directory list
+ * @param remove remove[i] is true if file i should be removed, list->len elements
+ */
+
+void
+dir_list_remove_files (dir_list * list, const bool * remove)
+{
+    int i, j;
+
+    for (i = 0, j = 0; i < list->len; i++)
+        if (remove[i])
+            g_free (list->list[i].fname);
+        else
+        {
+            if (j != i)
+                list->list[j] = list->list[i];
+            j++;
+        }
+
+    list->len = j;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Make index to find files of the directory list by name.
+ * The index is valid until the list is changed or sorted.
+ *
+ * @param list directory list
+ *
+ * @return hash table of file names owned by @list to indexes of files
+ */
+
+GHashTable *
+dir_list_make_index (const dir_list * list)
+{
+    GHashTable *index;
+    int i;
+
+    index = g_hash_table_new (g_str_hash, g_str_equal);
+
+    /* the first one of equal names is found, as by dir_list_find() */
+    for (i = list->len - 1; i >= 0; i--)
+        g_hash_table_insert (index, list->list[i].fname, GINT_TO_POINTER (i + 1));
+
+    return index;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find file in the index of directory list.
+ *
+ * @param index index made by dir_list_make_index()
+ * @param fname file name
+ *
+ * @return index of file, -1 if file is not found
+ */
+
+int
+dir_list_index_find (GHashTable * index, const char *fname)
+{
+    return GPOINTER_TO_INT (g_hash_table_lookup (index, fname)) - 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Insert file info to the sorted directory list keeping the order.
+ *
+ * @param list directory list sorted by @sort
+ * @param fname file name
+ * @param st file stat info
+ * @param link_to_dir is file link to directory
+ * @param stale_link is file stale elink
+ * @param sort sort routine
+ * @param sort_op sort options
+ *
+ * @return index of inserted file, -1 on failure
+ */
+
+int
+dir_list_insert (dir_list * list, const char *fname, const struct stat *st, bool link_to_dir,
+                 bool stale_link, GCompareFunc sort, const dir_sort_options_t * sort_op)
+{
+    file_entry_t fentry;
+    int lo, hi;
+
+    if (!dir_list_append (list, fname, st, link_to_dir, stale_link))
+        return (-1);
+
+    hi = list->len - 1;
+    if (sort == (GCompareFunc) unsorted)
+        return hi;
+
+    reverse = sort_op->reverse ? -1 : 1;
+    case_sensitive = sort_op->case_sensitive ? 1 : 0;
+    exec_first = sort_op->exec_first;
+
+    /* binary search of the last position to keep equal files in order */
+    fentry = list->list[hi];
+    lo = list->len > 1 && DIR_IS_DOTDOT (list->list[0].fname) ? 1 : 0;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+
+        if (sort (&list->list[mid], &fentry) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+
+        clean_sort_keys (list, mid, 1);
+    }
+
+    str_release_key (fentry.sort_key, case_sensitive);
+    str_release_key (fentry.second_sort_key, case_sensitive);
+    fentry.sort_key = nullptr;
+    fentry.second_sort_key = nullptr;
+
+    memmove (&list->list[lo + 1], &list->list[lo],
+             (list->len - 1 - lo) * sizeof (file_entry_t));
+    list->list[lo] = fentry;
+
+    return lo;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get info about file of directory if the file is shown in panel.
+ * The same as handle_dirent() but for file known by name.
+ *
+ * @param vpath directory
+ * @param fname file name
+ * @param fltr file name filter, nullptr to show all files
+ * @param st file stat info
+ * @param link_to_dir is file link to directory
+ * @param stale_link is file stale elink
+ *
+ * @return true if file exists and is shown, false otherwise
+ */
+
+bool
+dir_list_stat_file (const vfs_path_t * vpath, const char *fname, const char *fltr,
+                    struct stat *st, bool * link_to_dir, bool * stale_link)
+{
+    vfs_path_t *file_vpath;
+    bool ret;
+
+    if (dir_name_is_hidden (fname))
+        return false;
+
+    file_vpath = vfs_path_append_new (vpath, fname, (char *) nullptr);
+    ret = mc_lstat (file_vpath, st) == 0;
+    if (ret)
+    {
+        *link_to_dir = file_is_symlink_to_dir (file_vpath, st, stale_link);
+        ret = dir_entry_is_shown (fname, st, *link_to_dir, fltr);
+    }
+    vfs_path_free (file_vpath);
+
+    return ret;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -490,6 +1500,8 @@ dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * so
     {
         file_entry_t *fentry = &list->list[0];
         int dot_dot_found;
+        dir_sort_item_t *items;
+        int len, i;
 
         /* If there is an ".." entry the caller must take care to
            ensure that it occupies the first list element. */
@@ -497,10 +1509,57 @@ dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * so
         reverse = sort_op->reverse ? -1 : 1;
         case_sensitive = sort_op->case_sensitive ? 1 : 0;
         exec_first = sort_op->exec_first;
-        qsort (&(list->list)[dot_dot_found], list->len - dot_dot_found, sizeof (file_entry_t),
-               sort);
+        dir_sort_routine = sort;
+        dir_sort_by_key = (sort == (GCompareFunc) sort_size || sort == (GCompareFunc) sort_time
+                           || sort == (GCompareFunc) sort_atime
+                           || sort == (GCompareFunc) sort_ctime
+                           || sort == (GCompareFunc) sort_inode);
+
+        fentry += dot_dot_found;
+        len = list->len - dot_dot_found;
+        items = g_new (dir_sort_item_t, len * 2);
+
+        /* compare files by compact records and create all keys before sorting
+           instead of in comparison routine: it is called O(n log n) times */
+        for (i = 0; i < len; i++)
+        {
+            file_entry_t *fe = &fentry[i];
+            gint64 key = 0;
+
+            items[i].fentry = fe;
+            items[i].group = panels_options.mix_all_files ? 0 : MY_ISDIR (fe);
+
+            if (sort == (GCompareFunc) sort_size)
+                key = fe->st.st_size;
+            else if (sort == (GCompareFunc) sort_time)
+                key = fe->st.st_mtime;
+            else if (sort == (GCompareFunc) sort_atime)
+                key = fe->st.st_atime;
+            else if (sort == (GCompareFunc) sort_ctime)
+                key = fe->st.st_ctime;
+
+            if (sort == (GCompareFunc) sort_inode)
+                items[i].key = fe->st.st_ino;
+            else
+                /* keep order of signed values in unsigned key */
+                items[i].key = (guint64) key ^ G_GUINT64_CONSTANT (0x8000000000000000);
+
+            if (sort == (GCompareFunc) sort_ext)
+                fe->second_sort_key = str_create_key (extension (fe->fname), case_sensitive);
+            if (sort != (GCompareFunc) sort_inode && sort != (GCompareFunc) sort_vers)
+                fe->sort_key = str_create_key_for_filename (fe->fname, case_sensitive);
+        }
+
+#ifdef DIR_SORT_THREADS
+        if (len < DIR_SORT_PARALLEL_MIN || !dir_sort_items_parallel (items, items + len, len))
+#endif
+            dir_sort_items (items, items + len, len);
 
-        clean_sort_keys (list, dot_dot_found, list->len - dot_dot_found);
+        /* move entries once */
+        dir_sort_permute (fentry, items, len);
+        g_free (items);
+
+        clean_sort_keys (list, dot_dot_found, len);
     }
 }
 
@@ -624,7 +1683,6 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                const dir_sort_options_t * sort_op, const char *fltr)
 {
     DIR *dirp;
-    struct dirent *dp;
     struct stat st;
     file_entry_t *fentry;
     const char *vpath_str;
@@ -651,19 +1709,7 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     if (IS_PATH_SEP (vpath_str[0]) && vpath_str[1] == '\0')
         dir_list_clean (list);
 
-    while (ret && (dp = mc_readdir (dirp)) != nullptr)
-    {
-        bool link_to_dir, stale_link;
-
-        if (list->callback != nullptr)
-            list->callback (DIR_READ, dp);
-
-        if (!handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
-            continue;
-
-        if (!dir_list_append (list, dp->d_name, &st, link_to_dir, stale_link))
-            ret = false;
-    }
+    ret = dir_list_read (list, dirp, vpath, fltr, nullptr, 0);
 
     if (ret)
         dir_list_sort (list, sort, sort_op);
@@ -697,7 +1743,6 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                  const dir_sort_options_t * sort_op, const char *fltr)
 {
     DIR *dirp;
-    struct dirent *dp;
     int i;
     struct stat st;
     int marked_cnt;
@@ -717,33 +1762,26 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
 
     tree_store_start_check (vpath);
 
-    marked_files = g_hash_table_new (g_str_hash, g_str_equal);
-    alloc_dir_copy (list->len);
+    /* only names of marked files are kept to mark them again */
+    marked_files = nullptr;
     for (marked_cnt = i = 0; i < list->len; i++)
     {
-        file_entry_t *fentry, *dfentry;
+        file_entry_t *fentry;
 
         fentry = &list->list[i];
-        dfentry = &dir_copy.list[i];
-
-        dfentry->fnamelen = fentry->fnamelen;
-        dfentry->fname = g_strndup (fentry->fname, fentry->fnamelen);
-        dfentry->f.marked = fentry->f.marked;
-        dfentry->f.dir_size_computed = fentry->f.dir_size_computed;
-        dfentry->f.link_to_dir = fentry->f.link_to_dir;
-        dfentry->f.stale_link = fentry->f.stale_link;
-        dfentry->sort_key = nullptr;
-        dfentry->second_sort_key = nullptr;
         if (fentry->f.marked)
         {
-            g_hash_table_insert (marked_files, dfentry->fname, dfentry);
+            char *fname;
+
+            if (marked_files == nullptr)
+                marked_files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, nullptr);
+
+            fname = g_strndup (fentry->fname, fentry->fnamelen);
+            g_hash_table_insert (marked_files, fname, fname);
             marked_cnt++;
         }
     }
 
-    /* save len for later dir_list_clean() */
-    dir_copy.len = list->len;
-
     /* Add ".." except to the root directory. The ".." entry
        (if any) must be the first in the list. */
     tmp_path = vfs_path_get_by_index (vpath, 0)->path;
@@ -757,7 +1795,8 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
         dir_list_clean (list);
         if (!dir_list_init (list))
         {
-            dir_list_free_list (&dir_copy);
+            if (marked_files != nullptr)
+                g_hash_table_destroy (marked_files);
             return false;
         }
 
@@ -770,35 +1809,7 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
         }
     }
 
-    while (ret && (dp = mc_readdir (dirp)) != nullptr)
-    {
-        bool link_to_dir, stale_link;
-
-        if (list->callback != nullptr)
-            list->callback (DIR_READ, dp);
-
-        if (!handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
-            continue;
-
-        if (!dir_list_append (list, dp->d_name, &st, link_to_dir, stale_link))
-            ret = false;
-        else
-        {
-            file_entry_t *fentry;
-
-            fentry = &list->list[list->len - 1];
-
-            /*
-             * If we have marked files in the copy, scan through the copy
-             * to find matching file.  Decrease number of remaining marks if
-             * we copied one.
-             */
-            fentry->f.marked = (marked_cnt > 0
-                                && g_hash_table_lookup (marked_files, dp->d_name) != nullptr);
-            if (fentry->f.marked)
-                marked_cnt--;
-        }
-    }
+    ret = dir_list_read (list, dirp, vpath, fltr, marked_files, marked_cnt);
 
     if (ret)
         dir_list_sort (list, sort, sort_op);
@@ -808,10 +1819,281 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     mc_closedir (dirp);
     tree_store_end_check ();
 
-    g_hash_table_destroy (marked_files);
-    dir_list_free_list (&dir_copy);
+    if (marked_files != nullptr)
+        g_hash_table_destroy (marked_files);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start loading of directory in background. Only ".." is added to the list at once,
+ * files are added by dir_list_loader_take() while they are loaded.
+ *
+ * @param list directory list
+ * @param vpath directory
+ * @param callback function called from main loop when loaded files can be taken.
+ *                 The loader can be freed in it
+ * @param data data for @callback
+ *
+ * @return new loader, nullptr if directory can't be loaded in background:
+ *         it isn't local or can't be opened, dir_list_load() should be used then
+ */
+
+dir_list_loader_t *
+dir_list_load_start (dir_list * list, const vfs_path_t * vpath, dir_list_loader_fn callback,
+                     void *data)
+{
+#ifdef DIR_LOAD_THREADS
+    dir_list_loader_t *loader;
+    const vfs_path_element_t *element;
+    const char *vpath_str;
+    struct stat st;
+    GThread *thread;
+    DIR *dirp;
+    int fds[2];
+
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return nullptr;
+
+    element = vfs_path_get_by_index (vpath, -1);
+#ifdef HAVE_CHARSET
+    /* names are recoded by mc_readdir() */
+    if (element->encoding != nullptr)
+        return nullptr;
+#endif
+
+    dirp = opendir (element->path);
+    if (dirp == nullptr)
+        return nullptr;
+
+    if (pipe (fds) == -1)
+    {
+        closedir (dirp);
+        return nullptr;
+    }
+
+    fcntl (fds[0], F_SETFL, fcntl (fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl (fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl (fds[1], F_SETFD, FD_CLOEXEC);
+
+    loader = g_new0 (dir_list_loader_t, 1);
+    loader->ref = 2;
+    loader->dirp = dirp;
+    loader->pipe[0] = fds[0];
+    loader->pipe[1] = fds[1];
+    loader->show_dot_files = panels_options.show_dot_files;
+    loader->show_backups = panels_options.show_backups;
+    loader->callback = callback;
+    loader->data = data;
+    g_mutex_init (&loader->lock);
+    g_cond_init (&loader->cond);
+    loader->ready = g_array_new (FALSE, FALSE, sizeof (dir_stat_t));
+
+    thread = g_thread_try_new ("dir_load", dir_loader_worker, loader, nullptr);
+    if (thread == nullptr)
+    {
+        closedir (dirp);
+        loader->ref = 1;
+        dir_loader_unref (loader);
+        return nullptr;
+    }
+    g_thread_unref (thread);
+
+    loader->vpath = vfs_path_clone (vpath);
+    add_select_channel (loader->pipe[0], dir_loader_channel, loader);
+
+    /* ".." (if any) must be the first entry in the list */
+    if (dir_list_init (list))
+    {
+        if (dir_get_dotdot_stat (vpath, &st))
+            list->list[0].st = st;
+
+        vpath_str = vfs_path_as_str (vpath);
+        /* Do not add a ".." entry to the root directory */
+        if (IS_PATH_SEP (vpath_str[0]) && vpath_str[1] == '\0')
+            dir_list_clean (list);
+    }
+
+    return loader;
+#else
+    (void) list;
+    (void) vpath;
+    (void) callback;
+    (void) data;
+
+    return nullptr;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for the end of loading.
+ *
+ * @param loader loader
+ * @param timeout max time to wait in microseconds, negative to wait until loading is finished
+ *
+ * @return true if loading is finished, false otherwise
+ */
+
+bool
+dir_list_loader_wait (dir_list_loader_t * loader, gint64 timeout)
+{
+#ifdef DIR_LOAD_THREADS
+    gint64 end_time;
+    bool ret;
+
+    end_time = g_get_monotonic_time () + timeout;
+
+    g_mutex_lock (&loader->lock);
+    while (!loader->finished)
+    {
+        if (timeout < 0)
+            g_cond_wait (&loader->cond, &loader->lock);
+        else if (!g_cond_wait_until (&loader->cond, &loader->lock, end_time))
+            break;
+    }
+    ret = loader->finished;
+    g_mutex_unlock (&loader->lock);
+
+    return ret;
+#else
+    (void) loader;
+    (void) timeout;
+
+    return true;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take files loaded since the previous call. Shown files are sorted and merged into the list
+ * when their number becomes large enough against files in list, so the list is sorted
+ * O(log n) times while it is growing.
+ *
+ * @param loader loader
+ * @param list directory list sorted by @sort
+ * @param sort sort routine
+ * @param sort_op sort options
+ * @param fltr file name filter, nullptr to show all files
+ * @param finished set to true if all files are loaded and added to the list
+ *
+ * @return true if the list is changed, false otherwise
+ */
+
+bool
+dir_list_loader_take (dir_list_loader_t * loader, dir_list * list, GCompareFunc sort,
+                      const dir_sort_options_t * sort_op, const char *fltr, bool * finished)
+{
+#ifdef DIR_LOAD_THREADS
+    GArray *ready;
+    bool ret = false;
+    guint i;
+
+    g_mutex_lock (&loader->lock);
+    ready = loader->ready;
+    loader->ready = g_array_new (FALSE, FALSE, sizeof (dir_stat_t));
+    *finished = loader->finished;
+    g_mutex_unlock (&loader->lock);
+
+    for (i = 0; i < ready->len; i++)
+    {
+        dir_stat_t *f = &g_array_index (ready, dir_stat_t, i);
+
+        if (dir_entry_is_shown (f->fname, &f->st, f->link_to_dir, fltr))
+            dir_list_append (&loader->pending, f->fname, &f->st, f->link_to_dir, f->stale_link);
+        g_free (f->fname);
+    }
+    g_array_free (ready, TRUE);
+
+    if (loader->pending.len != 0
+        && (*finished || loader->pending.len >= list->len / DIR_LOAD_MERGE_RATIO))
+    {
+        dir_list_sort (&loader->pending, sort, sort_op);
+        ret = dir_list_merge (list, &loader->pending, sort, sort_op);
+    }
+
+    if (*finished)
+    {
+        /* the same check of tree store as dir_list_load() does */
+        tree_store_start_check (loader->vpath);
+        for (i = 0; i < (guint) list->len; i++)
+            if (S_ISDIR (list->list[i].st.st_mode))
+                tree_store_mark_checked (list->list[i].fname);
+        tree_store_end_check ();
+    }
 
     return ret;
+#else
+    (void) loader;
+    (void) list;
+    (void) sort;
+    (void) sort_op;
+    (void) fltr;
+
+    *finished = true;
+
+    return false;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free loader. Loading is cancelled if it isn't finished yet.
+ *
+ * @param loader loader
+ */
+
+void
+dir_list_loader_free (dir_list_loader_t * loader)
+{
+#ifdef DIR_LOAD_THREADS
+    if (loader == nullptr)
+        return;
+
+    g_atomic_int_set (&loader->cancel, 1);
+    delete_select_channel (loader->pipe[0]);
+    dir_list_free_list (&loader->pending);
+    vfs_path_free (loader->vpath);
+    /* worker thread can be blocked in slow system call: it frees loader itself when finishes */
+    dir_loader_unref (loader);
+#else
+    (void) loader;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free worker threads of sorting and stat'ing. Called once at exit.
+ */
+
+void
+dir_list_done (void)
+{
+#ifdef DIR_SORT_THREADS
+    if (dir_sort_pool != nullptr)
+    {
+        g_thread_pool_free (dir_sort_pool, false, true);
+        dir_sort_pool = nullptr;
+    }
+#endif
+
+#ifdef DIR_STAT_THREADS
+    {
+        GThreadPool *pool;
+
+        /* loader blocked in slow system call can stat a batch later */
+        g_mutex_lock (&dir_stat_lock);
+        pool = dir_stat_pool;
+        dir_stat_pool = nullptr;
+        dir_stat_done = true;
+        g_mutex_unlock (&dir_stat_lock);
+
+        /* workers take the lock, so wait for them without it */
+        if (pool != nullptr)
+            g_thread_pool_free (pool, false, true);
+    }
+#endif
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -26,6 +26,9 @@ typedef enum
 /* dir_list callback */
 typedef void (*dir_list_cb_fn) (dir_list_cb_state_t state, void *data);
 
+/* called when files of directory loaded in background can be taken */
+typedef void (*dir_list_loader_fn) (void *data);
+
 /*** enums ***************************************************************************************/
 
 /*** structures declarations (and typedefs of structures)*****************************************/
@@ -51,6 +54,8 @@ typedef struct dir_sort_options_struct
     bool exec_first;        /**< executables are at top of list */
 } dir_sort_options_t;
 
+typedef struct dir_list_loader_t dir_list_loader_t;
+
 /*** global variables defined in .c file *********************************************************/
 
 /*** declarations of public functions ************************************************************/
@@ -64,6 +69,22 @@ bool dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort
 bool dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                           const dir_sort_options_t * sort_op, const char *fltr);
 void dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * sort_op);
+int dir_list_find (const dir_list * list, const char *fname);
+void dir_list_remove (dir_list * list, int idx);
+void dir_list_remove_files (dir_list * list, const bool * remove);
+GHashTable *dir_list_make_index (const dir_list * list);
+int dir_list_index_find (GHashTable * index, const char *fname);
+int dir_list_insert (dir_list * list, const char *fname, const struct stat *st, bool link_to_dir,
+                     bool stale_link, GCompareFunc sort, const dir_sort_options_t * sort_op);
+bool dir_list_stat_file (const vfs_path_t * vpath, const char *fname, const char *fltr,
+                         struct stat *st, bool * link_to_dir, bool * stale_link);
+dir_list_loader_t *dir_list_load_start (dir_list * list, const vfs_path_t * vpath,
+                                        dir_list_loader_fn callback, void *data);
+bool dir_list_loader_wait (dir_list_loader_t * loader, gint64 timeout);
+bool dir_list_loader_take (dir_list_loader_t * loader, dir_list * list, GCompareFunc sort,
+                           const dir_sort_options_t * sort_op, const char *fltr, bool * finished);
+void dir_list_loader_free (dir_list_loader_t * loader);
+void dir_list_done (void);
 bool dir_list_init (dir_list * list);
 void dir_list_clean (dir_list * list);
 void dir_list_free_list (dir_list * list);
@@ -0,0 +1,288 @@
+/*
+   Watching of local directories for changes.
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file dirwatch.c
+ *  \brief Source: watching of local directories for changes
+ *
+ *  A panel watches its directory to apply changes of single files to its list instead of
+ *  reading the whole directory again. Events are read in the main loop of mc as soon as they
+ *  come, and names of changed files are kept until the owner of watch takes them.
+ *  If some changes are lost (event queue overflow, too many changed files, directory
+ *  is removed), the watch becomes invalid and the directory must be read again.
+ *
+ *  Only inotify on Linux is supported now.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#include "lib/global.h"
+#include "lib/tty/key.h"        /* add_select_channel() */
+#include "lib/vfs/vfs.h"
+
+#include "dirwatch.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* if more files are changed, it is faster to read directory again */
+#define DIR_WATCH_MAX_PENDING 1024
+
+#ifdef HAVE_SYS_INOTIFY_H
+#define DIR_WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB \
+                          | IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF \
+                          | IN_ONLYDIR)
+
+/* events those make watch invalid */
+#define DIR_WATCH_LOST (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)
+#endif
+
+/*** file scope type declarations ****************************************************************/
+
+struct dir_watch_t
+{
+    int fd;                     /* inotify instance, -1 if changes are lost */
+    GHashTable *pending;        /* names of changed files those aren't taken yet */
+    dir_watch_fn callback;
+    void *data;
+};
+
+/*** file scope variables ************************************************************************/
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_watch_lose (dir_watch_t * watch)
+{
+    if (watch->fd != -1)
+    {
+        delete_select_channel (watch->fd);
+        close (watch->fd);
+        watch->fd = -1;
+    }
+
+    g_hash_table_remove_all (watch->pending);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read all queued events and remember names of changed files.
+ */
+
+static void
+dir_watch_read (dir_watch_t * watch)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    /* aligned as struct inotify_event */
+    guint64 buf[4096 / sizeof (guint64)];
+
+    while (watch->fd != -1)
+    {
+        ssize_t n;
+        const char *p;
+
+        n = read (watch->fd, buf, sizeof (buf));
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1 && errno == EAGAIN)
+            break;
+        if (n <= 0)
+        {
+            dir_watch_lose (watch);
+            break;
+        }
+
+        for (p = (const char *) buf; p < (const char *) buf + n;)
+        {
+            const struct inotify_event *ev = (const struct inotify_event *) p;
+
+            p += sizeof (*ev) + ev->len;
+
+            if ((ev->mask & DIR_WATCH_LOST) != 0
+                || g_hash_table_size (watch->pending) >= DIR_WATCH_MAX_PENDING)
+            {
+                dir_watch_lose (watch);
+                break;
+            }
+
+            if (ev->len != 0 && g_hash_table_lookup (watch->pending, ev->name) == nullptr)
+            {
+                char *name;
+
+                name = g_strdup (ev->name);
+                g_hash_table_insert (watch->pending, name, name);
+            }
+        }
+    }
+#else
+    (void) watch;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+dir_watch_channel (int fd, void *info)
+{
+    dir_watch_t *watch = (dir_watch_t *) info;
+
+    (void) fd;
+
+    dir_watch_read (watch);
+    /* watch can be freed here */
+    watch->callback (watch->data);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start watching of local directory.
+ *
+ * @param vpath directory
+ * @param callback function called from main loop when files of directory are changed.
+ *                 The watch can be freed in it
+ * @param data data for @callback
+ *
+ * @return new watch, nullptr if directory can't be watched
+ */
+
+dir_watch_t *
+dir_watch_new (const vfs_path_t * vpath, dir_watch_fn callback, void *data)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    const vfs_path_element_t *element;
+    dir_watch_t *watch;
+    int fd;
+
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return nullptr;
+
+    element = vfs_path_get_by_index (vpath, -1);
+#ifdef HAVE_CHARSET
+    /* names of files are recoded */
+    if (element->encoding != nullptr)
+        return nullptr;
+#endif
+
+    fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1)
+        return nullptr;
+
+    if (inotify_add_watch (fd, element->path, DIR_WATCH_EVENTS) == -1)
+    {
+        close (fd);
+        return nullptr;
+    }
+
+    watch = g_new (dir_watch_t, 1);
+    watch->fd = fd;
+    watch->pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, nullptr);
+    watch->callback = callback;
+    watch->data = data;
+
+    add_select_channel (fd, dir_watch_channel, watch);
+
+    return watch;
+#else
+    (void) vpath;
+    (void) callback;
+    (void) data;
+
+    return nullptr;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether all changes of directory are known. Queued events are read before.
+ *
+ * @param watch watch
+ *
+ * @return true if changes of all files can be taken by dir_watch_take(),
+ *         false if directory should be read again
+ */
+
+bool
+dir_watch_is_valid (dir_watch_t * watch)
+{
+    dir_watch_read (watch);
+
+    return watch->fd != -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take names of files changed since the previous call.
+ *
+ * @param watch watch
+ *
+ * @return array of names to be freed by caller, nullptr if there are no changes
+ */
+
+GPtrArray *
+dir_watch_take (dir_watch_t * watch)
+{
+    GPtrArray *names;
+    GHashTableIter iter;
+    gpointer key;
+
+    dir_watch_read (watch);
+
+    if (g_hash_table_size (watch->pending) == 0)
+        return nullptr;
+
+    names = g_ptr_array_new_with_free_func (g_free);
+
+    g_hash_table_iter_init (&iter, watch->pending);
+    while (g_hash_table_iter_next (&iter, &key, nullptr))
+    {
+        g_hash_table_iter_steal (&iter);
+        g_ptr_array_add (names, key);
+    }
+
+    return names;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+dir_watch_free (dir_watch_t * watch)
+{
+    if (watch == nullptr)
+        return;
+
+    dir_watch_lose (watch);
+    g_hash_table_destroy (watch->pending);
+    g_free (watch);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,33 @@
+/** \file  dirwatch.h
+ *  \brief Header: watching of local directories for changes
+ */
+
+#ifndef MC__DIRWATCH_H
+#define MC__DIRWATCH_H
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* called when files of directory are changed */
+typedef void (*dir_watch_fn) (void *data);
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct dir_watch_t dir_watch_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+dir_watch_t *dir_watch_new (const vfs_path_t * vpath, dir_watch_fn callback, void *data);
+bool dir_watch_is_valid (dir_watch_t * watch);
+GPtrArray *dir_watch_take (dir_watch_t * watch);
+void dir_watch_free (dir_watch_t * watch);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__DIRWATCH_H */
@@ -83,6 +83,7 @@
 #include "midnight.h"           /* current_panel */
 #include "layout.h"             /* rotate_dash() */
 #include "ioblksize.h"          /* io_blksize() */
+#include "readahead.h"
 
 #include "file.h"
 
@@ -101,6 +102,25 @@ const char *op_names[3] = {
 
 #define FILEOP_UPDATE_INTERVAL 2
 #define FILEOP_STALLING_INTERVAL 4
+/* max amount of data copied by kernel between updates of progress */
+#define FILEOP_KERNEL_COPY_CHUNK (8 * 1024 * 1024)
+/* size of block of local file read ahead in another thread */
+#define FILEOP_READAHEAD_BUFSIZE (1024 * 1024)
+/* max number of files got by VFS at once before they are copied */
+#define FILEOP_PREFETCH_CHUNK 64
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+/* copy small local files in worker threads */
+#define FILEOP_COPY_THREADS 1
+/* copying of small files waits for disk or network rather than for CPU */
+#define FILEOP_COPY_MAX_THREADS 8
+/* max size of file to be copied in worker thread */
+#define FILEOP_COPY_MAX_SIZE (1024 * 1024)
+/* max number of files being copied in worker threads, per thread */
+#define FILEOP_COPY_QUEUE_PER_THREAD 8
+/* max time in microseconds to wait for worker thread without checking of progress buttons */
+#define FILEOP_COPY_WAIT_INTERVAL (G_USEC_PER_SEC / 10)
+#endif
 
 /*** file scope type declarations ****************************************************************/
 
@@ -135,6 +155,20 @@ typedef enum
     HARDLINK_ABORT              /**< Stop file operation after hardlink creation error */
 } hardlink_status_t;
 
+#ifdef FILEOP_COPY_THREADS
+/* small local file copied by worker thread */
+typedef struct
+{
+    char *src_path;
+    char *dst_path;
+    struct stat src_stat;
+    mode_t dst_mode;            /* mode of target file */
+    bool chown;                 /* set owner of target file */
+    int error;                  /* errno, 0 if file is copied */
+    gint done;                  /* set by worker when file is processed */
+} copy_job_t;
+#endif /* FILEOP_COPY_THREADS */
+
 /*
  * This array introduced to avoid translation problems. The former (op_names)
  * is assumed to be nouns, suitable in dialog box titles; this one should
@@ -194,6 +228,14 @@ static GSList *erase_list = nullptr;
  */
 static GSList *dest_dirs = nullptr;
 
+#ifdef FILEOP_COPY_THREADS
+static GThreadPool *copy_pool = nullptr;
+static guint copy_jobs_max = 0; /* max number of files being copied in worker threads */
+static gint copy_abort = 0;     /* skip files that aren't copied yet */
+static GMutex copy_lock;
+static GCond copy_cond;         /* signaled when file is copied */
+#endif
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -1149,6 +1191,71 @@ copy_file_file_display_progress (file_op_total_context_t * tctx, file_op_context
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy next chunk of local file in kernel. Holes of sparse file are skipped instead of being
+ * copied, so that they stay holes in the target file.
+ *
+ * @param src_desc source file handle
+ * @param dest_desc target file handle, its position should be equal to one of source file
+ * @param pos current position in source file
+ * @param file_size size of source file
+ * @param sparse whether source file has holes
+ *
+ * @return number of bytes the file positions are advanced by, 0 at end of file, -1 if data
+ *         can't be copied in kernel
+ */
+
+static ssize_t
+copy_file_file_kernel (int src_desc, int dest_desc, off_t pos, off_t file_size, bool sparse)
+{
+    size_t chunk = FILEOP_KERNEL_COPY_CHUNK;
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    if (sparse)
+    {
+        off_t data, hole;
+
+        data = mc_lseek (src_desc, pos, SEEK_DATA);
+        if (data == -1)
+        {
+            if (errno != ENXIO)
+                return (-1);
+            /* there is only a hole up to the end of file */
+            data = MAX (pos, file_size);
+        }
+
+        if (data > pos)
+        {
+            /* skip the hole */
+            data = MIN (data, pos + (off_t) chunk);
+            if (mc_lseek (src_desc, data, SEEK_SET) != data
+                || mc_lseek (dest_desc, data, SEEK_SET) != data)
+                return (-1);
+
+            /* if file ends with a hole, write its last byte to set the size of target file */
+            if (data == file_size && (mc_lseek (dest_desc, data - 1, SEEK_SET) != data - 1
+                                      || mc_write (dest_desc, "", 1) != 1))
+                return (-1);
+
+            return (ssize_t) (data - pos);
+        }
+
+        hole = mc_lseek (src_desc, pos, SEEK_HOLE);
+        if (hole == -1 || mc_lseek (src_desc, pos, SEEK_SET) != pos)
+            return (-1);
+        if (hole > pos)
+            chunk = MIN (chunk, (size_t) (hole - pos));
+    }
+#else
+    (void) pos;
+    (void) file_size;
+    (void) sparse;
+#endif
+
+    return vfs_copy_file_range (dest_desc, src_desc, chunk);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static bool
@@ -1169,6 +1276,297 @@ try_remove_file (file_op_context_t * ctx, const vfs_path_t * vpath, FileProgress
 
 /* --------------------------------------------------------------------------------------------- */
 
+/* {{{ Parallel copy routines */
+
+#ifdef FILEOP_COPY_THREADS
+/**
+ * Copy small local file. Runs in worker thread, so only plain system calls are used here
+ * instead of VFS ones.
+ *
+ * @param job file to copy
+ *
+ * @return 0 if file is copied, errno otherwise. Incomplete target file is removed.
+ */
+
+static int
+copy_job_copy (const copy_job_t * job)
+{
+    int src_fd, dst_fd;
+    char *buf;
+    int error = 0;
+    mc_timesbuf_t times;
+
+    src_fd = open (job->src_path, O_RDONLY);
+    if (src_fd == -1)
+        return errno;
+
+    /* never touch the file created by somebody else */
+    dst_fd = open (job->dst_path, O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (dst_fd == -1)
+    {
+        error = errno;
+        close (src_fd);
+        return error;
+    }
+
+    buf = static_cast<char *> (g_malloc (BUF_8K * 8));
+
+    while (error == 0)
+    {
+        ssize_t n_read;
+        const char *t = buf;
+
+        n_read = read (src_fd, buf, BUF_8K * 8);
+        if (n_read == 0)
+            break;
+        if (n_read < 0)
+        {
+            if (errno != EINTR)
+                error = errno;
+            continue;
+        }
+
+        while (n_read > 0)
+        {
+            ssize_t n_written;
+
+            n_written = write (dst_fd, t, n_read);
+            if (n_written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                error = errno;
+                break;
+            }
+            t += n_written;
+            n_read -= n_written;
+        }
+    }
+
+    g_free (buf);
+
+    if (error == 0 && job->chown
+        && fchown (dst_fd, job->src_stat.st_uid, job->src_stat.st_gid) != 0)
+        error = errno;
+    if (error == 0 && fchmod (dst_fd, job->dst_mode) != 0)
+        error = errno;
+    if (error == 0)
+    {
+        /* like mc_utime() in copy_file_file(), failure is ignored */
+        get_times (&job->src_stat, &times);
+#ifdef HAVE_UTIMENSAT
+        (void) futimens (dst_fd, times);
+#else
+        (void) utime (job->dst_path, &times);
+#endif
+    }
+
+    if (close (dst_fd) != 0 && error == 0)
+        error = errno;
+    close (src_fd);
+
+    if (error != 0)
+        unlink (job->dst_path);
+
+    return error;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+copy_job_worker (gpointer data, gpointer user_data)
+{
+    copy_job_t *job = (copy_job_t *) data;
+
+    (void) user_data;
+
+    job->error = g_atomic_int_get (&copy_abort) != 0 ? ECANCELED : copy_job_copy (job);
+
+    g_mutex_lock (&copy_lock);
+    g_atomic_int_set (&job->done, 1);
+    g_cond_broadcast (&copy_cond);
+    g_mutex_unlock (&copy_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+copy_job_free (copy_job_t * job)
+{
+    g_free (job->src_path);
+    g_free (job->dst_path);
+    g_free (job);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether file in the new target directory can be copied in worker thread.
+ * Small regular local files that are not hard links are copied so.
+ *
+ * @param ctx file operation context
+ * @param src_stat status of source file
+ *
+ * @return true if file can be copied in worker thread, false otherwise
+ */
+
+static bool
+copy_job_allowed (const file_op_context_t * ctx, const struct stat *src_stat)
+{
+    if (!S_ISREG (src_stat->st_mode) || src_stat->st_size > FILEOP_COPY_MAX_SIZE
+        || (!ctx->follow_links && src_stat->st_nlink > 1))
+        return false;
+
+    if (copy_pool == nullptr)
+    {
+        copy_pool =
+            g_thread_pool_new (copy_job_worker, nullptr, FILEOP_COPY_MAX_THREADS, false, nullptr);
+        copy_jobs_max = FILEOP_COPY_MAX_THREADS * FILEOP_COPY_QUEUE_PER_THREAD;
+        g_atomic_int_set (&copy_abort, 0);
+    }
+
+    return copy_pool != nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start copying of file in worker thread.
+ *
+ * @param ctx file operation context
+ * @param pending queue of files being copied to add file to
+ * @param src_path source file name
+ * @param dst_path target file name, the file should not exist
+ * @param src_stat status of source file
+ */
+
+static void
+copy_job_push (const file_op_context_t * ctx, GQueue * pending, const char *src_path,
+               const char *dst_path, const struct stat *src_stat)
+{
+    copy_job_t *job;
+
+    job = g_new0 (copy_job_t, 1);
+    job->src_path = g_strdup (src_path);
+    job->dst_path = g_strdup (dst_path);
+    job->src_stat = *src_stat;
+    job->chown = ctx->preserve_uidgid;
+
+    /* the same modes as copy_file_file() sets */
+    if (ctx->preserve)
+        job->dst_mode = src_stat->st_mode & ctx->umask_kill;
+    else
+    {
+        mode_t mask;
+
+        mask = umask (-1);
+        umask (mask);
+        job->dst_mode = 0100666 & ~mask & ctx->umask_kill;
+    }
+
+    g_queue_push_tail (pending, job);
+    g_thread_pool_push (copy_pool, job, nullptr);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Account files copied by worker threads in order they were queued. If worker thread has failed
+ * to copy a file, the file is copied again by copy_file_file() that reports an error and asks
+ * user what to do.
+ *
+ * @param tctx file operation total context
+ * @param ctx file operation context
+ * @param pending queue of files being copied
+ * @param max number of files that can be left in queue
+ *
+ * While waiting for worker thread, progress is shown and Abort button is checked periodically:
+ * a small file on a slow disk or network file system may be copied for a long time.
+ *
+ * @return status of file operation
+ */
+
+static FileProgressStatus
+copy_jobs_collect (file_op_total_context_t * tctx, file_op_context_t * ctx, GQueue * pending,
+                   guint max)
+{
+    FileProgressStatus status = FILE_CONT;
+    copy_job_t *job;
+
+    while ((job = (copy_job_t *) g_queue_peek_head (pending)) != nullptr)
+    {
+        if (g_atomic_int_get (&job->done) == 0)
+        {
+            if (g_queue_get_length (pending) <= max)
+                break;
+
+            g_mutex_lock (&copy_lock);
+            while (g_atomic_int_get (&job->done) == 0)
+            {
+                gint64 end_time;
+
+                end_time = g_get_monotonic_time () + FILEOP_COPY_WAIT_INTERVAL;
+                while (g_atomic_int_get (&job->done) == 0
+                       && g_cond_wait_until (&copy_cond, &copy_lock, end_time))
+                    ;
+
+                /* aborted jobs still should be waited for: worker uses them */
+                if (g_atomic_int_get (&job->done) != 0 || status == FILE_ABORT)
+                    continue;
+
+                g_mutex_unlock (&copy_lock);
+
+                if (verbose && ctx->dialog_type == FILEGUI_DIALOG_MULTI_ITEM)
+                {
+                    file_progress_show_count (ctx, tctx->progress_count, ctx->progress_count);
+                    file_progress_show_total (tctx, ctx, tctx->progress_bytes, true);
+                }
+
+                /* files that aren't copied yet are skipped by workers */
+                if (check_progress_buttons (ctx) == FILE_ABORT)
+                {
+                    status = FILE_ABORT;
+                    g_atomic_int_set (&copy_abort, 1);
+                }
+
+                mc_refresh ();
+
+                g_mutex_lock (&copy_lock);
+            }
+            g_mutex_unlock (&copy_lock);
+        }
+
+        g_queue_pop_head (pending);
+
+        if (status == FILE_ABORT || job->error == ECANCELED)
+            ;                   /* operation is aborted */
+        else if (job->error == 0)
+            status = progress_update_one (tctx, ctx, job->src_stat.st_size);
+        else
+            status = copy_file_file (tctx, ctx, job->src_path, job->dst_path);
+
+        if (status == FILE_ABORT)
+            g_atomic_int_set (&copy_abort, 1);
+
+        copy_job_free (job);
+    }
+
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+copy_jobs_done (void)
+{
+    if (copy_pool != nullptr)
+    {
+        g_thread_pool_free (copy_pool, true, true);
+        copy_pool = nullptr;
+    }
+}
+#endif /* FILEOP_COPY_THREADS */
+
+/* }}} */
+
+/* --------------------------------------------------------------------------------------------- */
 /* {{{ Move routines */
 
 /**
@@ -2131,6 +2529,75 @@ operate_one_file (const WPanel * panel, FileOperation operation, file_op_total_c
     return value;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Let VFS of the current directory of panel get marked files by large chunks
+ * before they are processed one by one. Progress is shown and abort is checked between chunks.
+ *
+ * @return FILE_ABORT if operation was aborted by user, FILE_CONT otherwise
+ */
+
+static FileProgressStatus
+panel_operate_prefetch (const WPanel * panel, file_op_context_t * ctx)
+{
+    GPtrArray *names;
+    FileProgressStatus ret = FILE_CONT;
+    guint done;
+    int i;
+
+    if (vfs_file_is_local (panel->cwd_vpath))
+        return FILE_CONT;
+
+    names = g_ptr_array_new ();
+
+    for (i = 0; i < panel->dir.len; i++)
+        if (panel->dir.list[i].f.marked && S_ISREG (panel->dir.list[i].st.st_mode))
+            g_ptr_array_add (names, panel->dir.list[i].fname);
+
+    if (names->len > 1)
+    {
+        file_progress_show_source (ctx, panel->cwd_vpath);
+        file_progress_show (ctx, 0, names->len, "", true);
+        mc_refresh ();
+
+        for (done = 0; ret == FILE_CONT && done < names->len;)
+        {
+            GPtrArray *chunk;
+
+            chunk = g_ptr_array_sized_new (FILEOP_PREFETCH_CHUNK);
+            for (; done < names->len && chunk->len < FILEOP_PREFETCH_CHUNK; done++)
+                g_ptr_array_add (chunk, g_ptr_array_index (names, done));
+
+            mc_setctl (panel->cwd_vpath, VFS_SETCTL_PREFETCH, chunk);
+            g_ptr_array_free (chunk, TRUE);
+
+            file_progress_show (ctx, done, names->len, "", true);
+            ret = check_progress_buttons (ctx);
+            mc_refresh ();
+        }
+    }
+
+    g_ptr_array_free (names, TRUE);
+
+    return ret == FILE_ABORT ? FILE_ABORT : FILE_CONT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Marked files of remote directory are removed at once, see panel_batch_marked() */
+
+static bool
+panel_operate_delete_fill (const file_entry_t * fe, vfs_batch_t * op, void *data)
+{
+    (void) data;
+
+    /* directories are removed recursively file by file */
+    if (S_ISDIR (fe->st.st_mode))
+        return false;
+
+    op->op = VFS_BATCH_UNLINK;
+    return true;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 #ifdef ENABLE_BACKGROUND
@@ -2214,6 +2681,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
     int open_flags;
     vfs_path_t *src_vpath = nullptr, *dst_vpath = nullptr;
     char *buf = nullptr;
+    file_readahead_t *ra = nullptr;
 
     /* FIXME: We should not be using global variables! */
     ctx->do_reget = 0;
@@ -2532,18 +3000,75 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
         int secs, update_secs;
         const char *stalled_msg = "";
         bool is_first_time = true;
+        bool kernel_copy, sparse, try_readahead;
+        const char *ra_data = nullptr;
 
         tv_last_update = tv_transfer_start;
 
         bufsize = io_blksize (dst_stat);
         buf = static_cast<char *> (g_malloc (bufsize));
 
+        /* copy local files in kernel if possible */
+        kernel_copy = !appending && vfs_file_is_local (src_vpath) && vfs_file_is_local (dst_vpath);
+        sparse = kernel_copy && S_ISREG (src_stat.st_mode)
+            && (off_t) ST_NBLOCKS (src_stat) * ST_NBLOCKSIZE < file_size;
+        try_readahead = vfs_file_is_local (src_vpath);
+
         while (true)
         {
             ssize_t n_read = -1, n_written;
 
+            if (kernel_copy)
+            {
+                n_read =
+                    copy_file_file_kernel (src_desc, dest_desc, n_read_total, file_size, sparse);
+                if (n_read <= 0)
+                {
+                    /* Copy the rest of file through the buffer. At the end of file, make sure
+                     * that it is really reached: some files (in /proc, for example) have zero
+                     * size and can't be copied in kernel. */
+                    kernel_copy = false;
+                    n_read = -1;
+                    if (mc_lseek (src_desc, n_read_total, SEEK_SET) != n_read_total
+                        || mc_lseek (dest_desc, n_read_total, SEEK_SET) != n_read_total)
+                    {
+                        return_status =
+                            file_error (true, _("Cannot read source file \"%s\"\n%s"), src_path);
+                        goto ret;
+                    }
+                }
+            }
+
+            if (!kernel_copy && try_readahead)
+            {
+                /* read local file ahead in another thread while target is being written */
+                try_readahead = false;
+                if (file_size - ctx->do_reget - n_read_total > FILEOP_READAHEAD_BUFSIZE)
+                    ra = file_readahead_new (src_desc, FILEOP_READAHEAD_BUFSIZE);
+            }
+
+            if (ra != nullptr)
+            {
+                n_read = file_readahead_read (ra, &ra_data);
+                if (n_read < 0)
+                {
+                    /* read the rest synchronously to handle the error */
+                    off_t offset;
+
+                    offset = file_readahead_get_offset (ra);
+                    file_readahead_free (ra);
+                    ra = nullptr;
+                    if (mc_lseek (src_desc, offset, SEEK_SET) != offset)
+                    {
+                        return_status =
+                            file_error (true, _("Cannot read source file \"%s\"\n%s"), src_path);
+                        goto ret;
+                    }
+                }
+            }
+
             /* src_read */
-            if (mc_ctl (src_desc, VFS_CTL_IS_NOTREADY, 0) == 0)
+            if (!kernel_copy && ra == nullptr && mc_ctl (src_desc, VFS_CTL_IS_NOTREADY, 0) == 0)
                 while ((n_read = mc_read (src_desc, buf, bufsize)) < 0 && !ctx->skip_all)
                 {
                     return_status =
@@ -2562,7 +3087,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
 
             if (n_read > 0)
             {
-                char *t = buf;
+                const char *t = ra != nullptr ? ra_data : buf;
 
                 n_read_total += n_read;
 
@@ -2575,7 +3100,8 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
                 gettimeofday (&tv_last_input, nullptr);
 
                 /* dst_write */
-                while ((n_written = mc_write (dest_desc, t, (size_t) n_read)) < n_read)
+                while (!kernel_copy
+                       && (n_written = mc_write (dest_desc, t, (size_t) n_read)) < n_read)
                 {
                     bool write_errno_nospace;
 
@@ -2661,6 +3187,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
 
   ret:
     g_free (buf);
+    file_readahead_free (ra);
 
     rotate_dash (false);
     while (src_desc != -1 && mc_close (src_desc) < 0 && !ctx->skip_all)
@@ -2773,6 +3300,10 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     struct link *lp;
     vfs_path_t *src_vpath, *dst_vpath;
     bool do_mkdir = true;
+#ifdef FILEOP_COPY_THREADS
+    GQueue pending = G_QUEUE_INIT;      /* files being copied in worker threads */
+    bool parallel;
+#endif
 
     src_vpath = vfs_path_from_str (s);
     dst_vpath = vfs_path_from_str (d);
@@ -2952,6 +3483,13 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     if (reading == nullptr)
         goto ret;
 
+#ifdef FILEOP_COPY_THREADS
+    /* Files of new local directory are copied in parallel: there is nothing to overwrite,
+     * and time of copying of small files is mostly spent waiting for open(), chmod(), etc. */
+    parallel = do_mkdir && !do_delete && vfs_file_is_local (src_vpath)
+        && vfs_file_is_local (dst_vpath);
+#endif
+
     while ((next = mc_readdir (reading)) && return_status != FILE_ABORT)
     {
         char *path;
@@ -2964,8 +3502,8 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
             continue;
 
         /* get the filename and add it to the src directory */
-        path = mc_build_filename (s, next->d_name, (char *) nullptr);
-        tmp_vpath = vfs_path_from_str (path);
+        tmp_vpath = vfs_path_append_new (src_vpath, next->d_name, (char *) nullptr);
+        path = g_strdup (vfs_path_as_str (tmp_vpath));
 
         (*ctx->stat_func) (tmp_vpath, &dst_stat);
         if (S_ISDIR (dst_stat.st_mode))
@@ -2988,7 +3526,15 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
             char *dest_file;
 
             dest_file = mc_build_filename (d, x_basename (path), (char *) nullptr);
-            return_status = copy_file_file (tctx, ctx, path, dest_file);
+#ifdef FILEOP_COPY_THREADS
+            if (parallel && copy_job_allowed (ctx, &dst_stat))
+            {
+                copy_job_push (ctx, &pending, path, dest_file, &dst_stat);
+                return_status = copy_jobs_collect (tctx, ctx, &pending, copy_jobs_max);
+            }
+            else
+#endif
+                return_status = copy_file_file (tctx, ctx, path, dest_file);
             g_free (dest_file);
         }
 
@@ -3013,6 +3559,20 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     }
     mc_closedir (reading);
 
+#ifdef FILEOP_COPY_THREADS
+    /* files should be created before the time and mode of directory are set */
+    if (!g_queue_is_empty (&pending))
+    {
+        FileProgressStatus status;
+
+        if (return_status == FILE_ABORT)
+            g_atomic_int_set (&copy_abort, 1);
+        status = copy_jobs_collect (tctx, ctx, &pending, 0);
+        if (return_status != FILE_ABORT)
+            return_status = status;
+    }
+#endif
+
     if (ctx->preserve)
     {
         mc_timesbuf_t times;
@@ -3033,6 +3593,10 @@ copy_dir_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const cha
     free_link (parent_dirs->data);
     g_slist_free_1 (parent_dirs);
   ret_fast:
+#ifdef FILEOP_COPY_THREADS
+    if (toplevel)
+        copy_jobs_done ();
+#endif
     vfs_path_free (src_vpath);
     vfs_path_free (dst_vpath);
     return return_status;
@@ -3380,8 +3944,20 @@ panel_operate (void *source_panel, FileOperation operation, bool force_single)
         if (panel_operate_init_totals (panel, nullptr, nullptr, ctx, file_op_compute_totals, dialog_type)
             == FILE_CONT)
         {
+            value = FILE_CONT;
+
+            if (operation != OP_DELETE)
+                value = panel_operate_prefetch (panel, ctx);
+            else
+            {
+                tctx->progress_count += panel_batch_marked (panel, panel_operate_delete_fill,
+                                                            nullptr);
+                if (verbose && ctx->dialog_type == FILEGUI_DIALOG_MULTI_ITEM)
+                    file_progress_show_count (ctx, tctx->progress_count, ctx->progress_count);
+            }
+
             /* Loop for every file, perform the actual copy operation */
-            for (i = 0; i < panel->dir.len; i++)
+            for (i = 0; value != FILE_ABORT && i < panel->dir.len; i++)
             {
                 const char *source2;
 
@@ -37,6 +37,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <unistd.h>             /* read(), sysconf() */
 
 #include "lib/global.h"
 
@@ -44,6 +45,7 @@
 #include "lib/tty/key.h"
 #include "lib/skin.h"
 #include "lib/search.h"
+#include "lib/memscan.h"
 #include "lib/mcconfig.h"
 #include "lib/vfs/vfs.h"
 #include "lib/strutil.h"
@@ -66,6 +68,16 @@
 #define MAX_REFRESH_INTERVAL (G_USEC_PER_SEC / 20)      /* 50 ms */
 #define MIN_REFRESH_FILE_SIZE (256 * 1024)      /* 256 KB */
 
+#if GLIB_CHECK_VERSION (2, 32, 0)
+/* grep files on local filesystem in worker threads */
+#define FIND_GREP_THREADS 1
+#define FIND_GREP_MAX_THREADS 16
+/* max number of files waiting to be grepped, per thread */
+#define FIND_GREP_QUEUE_PER_THREAD 64
+/* initial size of buffer to read file to */
+#define FIND_GREP_BLOCK_SIZE (256 * 1024)
+#endif
+
 /*** file scope type declarations ****************************************************************/
 
 /* A couple of extra messages we need */
@@ -115,6 +127,46 @@ typedef struct
     gsize end;
 } find_match_location_t;
 
+/* file content split to lines */
+typedef struct
+{
+    int fd;
+    char buffer[BUF_4K];        /* raw input buffer */
+    int pos;                    /* current position in buffer */
+    int n_read;                 /* amount of data in buffer */
+    char *strbuf;               /* buffer for fetched string */
+    int strbuf_size;
+} find_line_reader_t;
+
+#ifdef FIND_GREP_THREADS
+typedef struct
+{
+    int line;
+    gsize start;
+    gsize end;
+} find_grep_match_t;
+
+/* file to be grepped by worker thread */
+typedef struct
+{
+    char *directory;
+    char *filename;
+    GArray *matches;            /* find_grep_match_t, filled by worker */
+    gint done;                  /* set by worker when file is processed */
+} find_grep_job_t;
+
+/* content search in file by worker thread */
+typedef struct
+{
+    mc_search_t *handle;
+    const char *literal;        /* bytes that every found line contains, or nullptr */
+    gsize literal_len;
+    int line;                   /* number of current line */
+    bool found;                 /* current line is found already */
+    GArray *matches;            /* find_grep_match_t */
+} find_grep_state_t;
+#endif /* FIND_GREP_THREADS */
+
 /*** file scope variables ************************************************************************/
 
 /* button callbacks */
@@ -173,6 +225,16 @@ static WLabel *found_num_label; /* Number of found items */
 /* This keeps track of the directory stack */
 static GQueue dir_queue = G_QUEUE_INIT;
 
+#ifdef FIND_GREP_THREADS
+static GThreadPool *grep_pool = nullptr;
+static GAsyncQueue *grep_handles = nullptr;     /* prepared search handles, one per thread */
+static GQueue grep_jobs = G_QUEUE_INIT; /* files being grepped in order of traversal */
+static guint grep_jobs_max = 0;
+static gint grep_abort = 0;
+static GMutex grep_lock;
+static GCond grep_cond;
+#endif
+
 /* *INDENT-OFF* */
 static struct
 {
@@ -973,6 +1035,74 @@ check_find_events (WDialog * h)
     return FIND_CONT;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fetch next line of file to the reader's strbuf. The line is not null-terminated.
+ *
+ * @param r line reader
+ * @param off offset of line in file, incremented for every skipped leading zero byte
+ * @param ch where to store the character that ended the line: '\n', or '\0' for zero byte
+ *           and end of file
+ *
+ * @return length of line
+ */
+
+static int
+find_line_reader_get (find_line_reader_t * r, off_t * off, char *ch)
+{
+    int i = 0;
+
+    *ch = '\0';
+
+    /* read to buffer and get line from there */
+    while (true)
+    {
+        const char *eol;
+        int len;
+
+        if (r->pos >= r->n_read)
+        {
+            r->pos = 0;
+            r->n_read = mc_read (r->fd, r->buffer, sizeof (r->buffer));
+            if (r->n_read <= 0)
+                break;
+        }
+
+        /* take all bytes up to the end of line at once */
+        eol = (const char *) mc_memchr2 (r->buffer + r->pos, '\n', '\0', r->n_read - r->pos);
+        len = (eol == nullptr ? r->n_read : eol - r->buffer) - r->pos;
+        if (len != 0)
+        {
+            if (i + len >= r->strbuf_size - 1)
+            {
+                r->strbuf_size = i + len + 128;
+                r->strbuf = static_cast<char *> (g_realloc (r->strbuf, r->strbuf_size));
+            }
+
+            memcpy (r->strbuf + i, r->buffer + r->pos, len);
+            i += len;
+            r->pos += len;
+        }
+
+        if (eol == nullptr)
+            continue;
+
+        *ch = r->buffer[r->pos++];
+
+        /* skip possible leading zero(s) */
+        if (*ch == '\0' && i == 0)
+        {
+            (*off)++;
+            continue;
+        }
+
+        /* Strip newline */
+        break;
+    }
+
+    return i;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * search_content:
@@ -988,7 +1118,7 @@ static bool
 search_content (WDialog * h, const char *directory, const char *filename)
 {
     struct stat s;
-    char buffer[BUF_4K];        /* raw input buffer */
+    char buffer[BUF_MEDIUM];
     int file_fd;
     bool ret_val = false;
     vfs_path_t *vpath;
@@ -1039,70 +1169,37 @@ search_content (WDialog * h, const char *directory, const char *filename)
     tty_got_interrupt ();
 
     {
+        find_line_reader_t reader;
         int line = 1;
-        int pos = 0;
-        int n_read = 0;
         off_t off = 0;          /* file_fd's offset corresponding to strbuf[0] */
         bool found = false;
         gsize found_len;
         gsize found_start;
         char result[BUF_MEDIUM];
-        char *strbuf = nullptr;    /* buffer for fetched string */
-        int strbuf_size = 0;
         int i = -1;             /* compensate for a newline we'll add when we first enter the loop */
 
+        reader.fd = file_fd;
+        reader.pos = 0;
+        reader.n_read = 0;
+        reader.strbuf = nullptr;
+        reader.strbuf_size = 0;
+
         if (resuming)
         {
             /* We've been previously suspended, start from the previous position */
             resuming = false;
             line = last_line;
-            pos = last_pos;
+            reader.pos = last_pos;
             off = last_off;
             i = last_i;
         }
 
         while (!ret_val)
         {
-            char ch = '\0';
+            char ch;
 
             off += i + 1;       /* the previous line, plus a newline character */
-            i = 0;
-
-            /* read to buffer and get line from there */
-            while (true)
-            {
-                if (pos >= n_read)
-                {
-                    pos = 0;
-                    n_read = mc_read (file_fd, buffer, sizeof (buffer));
-                    if (n_read <= 0)
-                        break;
-                }
-
-                ch = buffer[pos++];
-                if (ch == '\0')
-                {
-                    /* skip possible leading zero(s) */
-                    if (i == 0)
-                    {
-                        off++;
-                        continue;
-                    }
-                    break;
-                }
-
-                if (i >= strbuf_size - 1)
-                {
-                    strbuf_size += 128;
-                    strbuf = static_cast<char *> (g_realloc (strbuf, strbuf_size));
-                }
-
-                /* Strip newline */
-                if (ch == '\n')
-                    break;
-
-                strbuf[i++] = ch;
-            }
+            i = find_line_reader_get (&reader, &off, &ch);
 
             if (i == 0)
             {
@@ -1113,10 +1210,11 @@ search_content (WDialog * h, const char *directory, const char *filename)
                 goto skip_search;
             }
 
-            strbuf[i] = '\0';
+            reader.strbuf[i] = '\0';
 
             if (!found          /* Search in binary line once */
-                && mc_search_run (search_content_handle, (const void *) strbuf, 0, i, &found_len))
+                && mc_search_run (search_content_handle, (const void *) reader.strbuf, 0, i,
+                                  &found_len))
             {
                 if (!status_updated)
                 {
@@ -1159,7 +1257,7 @@ search_content (WDialog * h, const char *directory, const char *filename)
                 case FIND_SUSPEND:
                     resuming = true;
                     last_line = line;
-                    last_pos = pos;
+                    last_pos = reader.pos;
                     last_off = off;
                     last_i = i;
                     ret_val = true;
@@ -1170,7 +1268,7 @@ search_content (WDialog * h, const char *directory, const char *filename)
             }
         }
 
-        g_free (strbuf);
+        g_free (reader.strbuf);
     }
 
     tty_disable_interrupt_key ();
@@ -1180,6 +1278,412 @@ search_content (WDialog * h, const char *directory, const char *filename)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static mc_search_t *
+find_content_handle_new (void)
+{
+    mc_search_t *handle;
+
+    handle = mc_search_new (content_pattern, nullptr);
+    if (handle != nullptr)
+    {
+        handle->search_type = options.content_regexp ? MC_SEARCH_T_REGEX : MC_SEARCH_T_NORMAL;
+        handle->is_case_sensitive = options.content_case_sens;
+        handle->whole_words = options.content_whole_words;
+#ifdef HAVE_CHARSET
+        handle->is_all_charsets = options.content_all_charsets;
+#endif
+    }
+
+    return handle;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef FIND_GREP_THREADS
+/**
+ * Get bytes that every line found by search handle contains.
+ *
+ * @param handle search handle
+ * @param len where to store length of bytes
+ *
+ * @return bytes to look for before running the search in line, nullptr if search type
+ *         doesn't allow to get them
+ */
+
+static const char *
+find_grep_literal (const mc_search_t * handle, gsize * len)
+{
+    if (handle->search_type != MC_SEARCH_T_NORMAL || !handle->is_case_sensitive
+#ifdef HAVE_CHARSET
+        || handle->is_all_charsets
+#endif
+        || handle->original_len == 0)
+        return nullptr;
+
+    *len = handle->original_len;
+    return handle->original;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Search content in memory block. Lines are split in the same way as find_line_reader_get()
+ * does: both newline and zero byte end the string to search in, but only newline ends the line.
+ *
+ * @param g search state
+ * @param data memory block that contains whole lines only (or the tail of file)
+ * @param size size of memory block
+ * @param base offset of memory block in file
+ *
+ * @return false if search in file should be stopped, true otherwise
+ */
+
+static bool
+find_grep_block (find_grep_state_t * g, const char *data, size_t size, off_t base)
+{
+    const char *p = data;
+    const char *end = data + size;
+
+    while (p < end)
+    {
+        const char *eol;
+        gsize found_len;
+
+        if (g_atomic_int_get (&grep_abort) != 0)
+            return false;
+
+        if (g->literal != nullptr)
+        {
+            const char *hit, *bol;
+            size_t lines;
+
+            /* skip lines that can't be found at once */
+            hit = (const char *) mc_memmem (p, end - p, g->literal, g->literal_len);
+            if (hit == nullptr)
+                hit = end;
+
+            bol = (const char *) mc_memrchr2 (p, '\n', '\0', hit - p);
+            if (bol != nullptr)
+            {
+                lines = mc_memcount (p, '\n', bol + 1 - p);
+                if (lines != 0)
+                {
+                    g->line += lines;
+                    g->found = false;
+                }
+                p = bol + 1;
+            }
+
+            if (hit == end)
+                break;
+        }
+
+        eol = (const char *) mc_memchr2 (p, '\n', '\0', end - p);
+        if (eol == nullptr)
+            eol = end;
+
+        if (eol != p && !g->found
+            && mc_search_run (g->handle, (const void *) data, p - data, eol - data - 1,
+                              &found_len))
+        {
+            find_grep_match_t m;
+
+            m.line = g->line;
+            m.start = base + g->handle->normal_offset + 1;      /* off by one: ticket 3280 */
+            m.end = m.start + found_len;
+            g_array_append_val (g->matches, m);
+
+            if (options.content_first_hit)
+                return false;
+
+            g->found = true;
+        }
+
+        if (eol == end)
+            break;
+
+        if (*eol == '\n')
+        {
+            g->found = false;
+            g->line++;
+        }
+
+        p = eol + 1;
+    }
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Search content in local file. Runs in worker thread, so only plain system calls are used here
+ * instead of VFS ones.
+ *
+ * File is read by large blocks and the search is run in place, so that lines aren't copied
+ * from block one by one. Only the incomplete line at the end of block is moved to the
+ * beginning of buffer to be completed by the next read.
+ *
+ * @param fd file descriptor
+ * @param handle search handle, owned by the calling thread
+ * @param matches array of find_grep_match_t to add found matches to
+ */
+
+static void
+find_grep_file (int fd, mc_search_t * handle, GArray * matches)
+{
+    find_grep_state_t g;
+    char *buf;
+    size_t buf_size = FIND_GREP_BLOCK_SIZE;
+    size_t len = 0;             /* amount of data in buffer */
+    off_t base = 0;             /* offset of buffer in file */
+    bool more = true;
+
+    g.handle = handle;
+    g.literal = find_grep_literal (handle, &g.literal_len);
+    g.line = 1;
+    g.found = false;
+    g.matches = matches;
+
+    buf = static_cast<char *> (g_malloc (buf_size));
+
+    while (more)
+    {
+        ssize_t n_read;
+        const char *eol;
+        size_t done;
+
+        if (len == buf_size)
+        {
+            /* line is longer than buffer */
+            buf_size *= 2;
+            buf = static_cast<char *> (g_realloc (buf, buf_size));
+        }
+
+        n_read = read (fd, buf + len, buf_size - len);
+        if (n_read <= 0)
+        {
+            /* search in the tail of file too */
+            more = false;
+            done = len;
+        }
+        else
+        {
+            len += n_read;
+            /* search in whole lines only */
+            eol = (const char *) mc_memrchr2 (buf, '\n', '\0', len);
+            done = eol == nullptr ? 0 : eol + 1 - buf;
+        }
+
+        if (done != 0)
+        {
+            if (!find_grep_block (&g, buf, done, base))
+                break;
+
+            len -= done;
+            memmove (buf, buf + done, len);
+            base += done;
+        }
+    }
+
+    g_free (buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_grep_worker (gpointer data, gpointer user_data)
+{
+    find_grep_job_t *job = (find_grep_job_t *) data;
+    char *path;
+    struct stat s;
+
+    (void) user_data;
+
+    path = g_build_filename (job->directory, job->filename, (char *) nullptr);
+
+    if (g_atomic_int_get (&grep_abort) == 0 && stat (path, &s) == 0 && S_ISREG (s.st_mode))
+    {
+        int fd;
+
+        fd = open (path, O_RDONLY);
+        if (fd != -1)
+        {
+            mc_search_t *handle;
+
+            handle = (mc_search_t *) g_async_queue_pop (grep_handles);
+            find_grep_file (fd, handle, job->matches);
+            g_async_queue_push (grep_handles, handle);
+            close (fd);
+        }
+    }
+
+    g_free (path);
+
+    g_mutex_lock (&grep_lock);
+    g_atomic_int_set (&job->done, 1);
+    g_cond_signal (&grep_cond);
+    g_mutex_unlock (&grep_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_grep_job_free (find_grep_job_t * job)
+{
+    g_free (job->directory);
+    g_free (job->filename);
+    g_array_free (job->matches, true);
+    g_free (job);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start worker threads to search content of files.
+ * Search handles aren't thread safe, so every thread gets its own one prepared here.
+ */
+
+static void
+find_grep_init (void)
+{
+    long n;
+    int i;
+
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+    n = CLAMP (n, 1, FIND_GREP_MAX_THREADS);
+
+    grep_handles = g_async_queue_new_full ((GDestroyNotify) mc_search_free);
+
+    for (i = 0; i < n; i++)
+    {
+        mc_search_t *handle;
+
+        handle = find_content_handle_new ();
+        if (handle == nullptr)
+            break;
+        if (!mc_search_prepare (handle))
+        {
+            mc_search_free (handle);
+            break;
+        }
+        g_async_queue_push (grep_handles, handle);
+    }
+
+    if (i != 0)
+        grep_pool = g_thread_pool_new (find_grep_worker, nullptr, i, false, nullptr);
+
+    if (grep_pool == nullptr)
+    {
+        /* search in the dialog */
+        g_async_queue_unref (grep_handles);
+        grep_handles = nullptr;
+        return;
+    }
+
+    grep_jobs_max = i * FIND_GREP_QUEUE_PER_THREAD;
+    g_atomic_int_set (&grep_abort, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Stop worker threads and drop results that weren't shown */
+
+static void
+find_grep_done (void)
+{
+    if (grep_pool == nullptr)
+        return;
+
+    g_atomic_int_set (&grep_abort, 1);
+    /* drop files not started yet and wait for the rest */
+    g_thread_pool_free (grep_pool, true, true);
+    grep_pool = nullptr;
+
+    g_queue_clear_full (&grep_jobs, (GDestroyNotify) find_grep_job_free);
+
+    g_async_queue_unref (grep_handles);
+    grep_handles = nullptr;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_grep_push (const char *directory, const char *filename)
+{
+    find_grep_job_t *job;
+
+    job = g_new0 (find_grep_job_t, 1);
+    job->directory = g_strdup (directory);
+    job->filename = g_strdup (filename);
+    job->matches = g_array_new (false, false, sizeof (find_grep_match_t));
+
+    g_queue_push_tail (&grep_jobs, job);
+    g_thread_pool_push (grep_pool, job, nullptr);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add matches found by worker threads to the list. Files are taken in order of traversal,
+ * so the list is the same as if they were grepped one by one.
+ *
+ * @param h find dialog
+ * @param wait whether to wait a bit for the next file if it is not grepped yet
+ *
+ * @return number of files not processed yet
+ */
+
+static guint
+find_grep_collect (WDialog * h, bool wait)
+{
+    find_grep_job_t *job;
+
+    while ((job = (find_grep_job_t *) g_queue_peek_head (&grep_jobs)) != nullptr)
+    {
+        guint i;
+
+        if (g_atomic_int_get (&job->done) == 0)
+        {
+            gint64 end_time;
+            char msg[BUF_MEDIUM];
+
+            if (!wait)
+                break;
+
+            /* wait not longer than the dialog may be irresponsive */
+            end_time = g_get_monotonic_time () + MAX_REFRESH_INTERVAL;
+            g_mutex_lock (&grep_lock);
+            while (g_atomic_int_get (&job->done) == 0
+                   && g_cond_wait_until (&grep_cond, &grep_lock, end_time))
+                ;
+            g_mutex_unlock (&grep_lock);
+
+            if (g_atomic_int_get (&job->done) == 0)
+            {
+                g_snprintf (msg, sizeof (msg), _("Grepping in %s"), job->filename);
+                status_update (str_trunc (msg, WIDGET (h)->cols - 8));
+                mc_refresh ();
+                break;
+            }
+        }
+
+        g_queue_pop_head (&grep_jobs);
+
+        for (i = 0; i < job->matches->len; i++)
+        {
+            const find_grep_match_t *m;
+            char result[BUF_MEDIUM];
+
+            m = &g_array_index (job->matches, find_grep_match_t, i);
+            g_snprintf (result, sizeof (result), "%d:%s", m->line, job->filename);
+            find_add_match (job->directory, result, m->start, m->end);
+        }
+
+        find_grep_job_free (job);
+    }
+
+    return g_queue_get_length (&grep_jobs);
+}
+#endif /* FIND_GREP_THREADS */
+
+/* --------------------------------------------------------------------------------------------- */
+
 /**
   If dir is absolute, this means we're within dir and searching file here.
   If dir is relative, this means we're going to add dir to the directory stack.
@@ -1281,6 +1785,15 @@ do_search (WDialog * h)
         return 1;
     }
 
+#ifdef FIND_GREP_THREADS
+    if (grep_pool != nullptr && find_grep_collect (h, false) >= grep_jobs_max)
+    {
+        /* let worker threads catch up */
+        find_grep_collect (h, true);
+        return 1;
+    }
+#endif
+
     for (count = 0; count < 32; count++)
     {
         while (dp == nullptr)
@@ -1302,6 +1815,11 @@ do_search (WDialog * h)
                     tmp_vpath = pop_directory ();
                     if (tmp_vpath == nullptr)
                     {
+#ifdef FIND_GREP_THREADS
+                        /* wait for files being grepped */
+                        if (grep_pool != nullptr && find_grep_collect (h, true) != 0)
+                            return 1;
+#endif
                         running = false;
                         if (ignore_count == 0)
                             status_update (_("Finished"));
@@ -1392,6 +1910,10 @@ do_search (WDialog * h)
             {
                 if (content_pattern == nullptr)
                     find_add_match (directory, dp->d_name, 0, 0);
+#ifdef FIND_GREP_THREADS
+                else if (grep_pool != nullptr)
+                    find_grep_push (directory, dp->d_name);
+#endif
                 else if (search_content (h, directory, dp->d_name))
                     return 1;
             }
@@ -1716,21 +2238,11 @@ setup_gui (void)
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-run_process (void)
+run_process (const char *start_dir)
 {
     int ret;
 
-    search_content_handle = mc_search_new (content_pattern, nullptr);
-    if (search_content_handle)
-    {
-        search_content_handle->search_type =
-            options.content_regexp ? MC_SEARCH_T_REGEX : MC_SEARCH_T_NORMAL;
-        search_content_handle->is_case_sensitive = options.content_case_sens;
-        search_content_handle->whole_words = options.content_whole_words;
-#ifdef HAVE_CHARSET
-        search_content_handle->is_all_charsets = options.content_all_charsets;
-#endif
-    }
+    search_content_handle = find_content_handle_new ();
     search_file_handle = mc_search_new (find_pattern, nullptr);
     search_file_handle->search_type = options.file_pattern ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
     search_file_handle->is_case_sensitive = options.file_case_sens;
@@ -1741,9 +2253,28 @@ run_process (void)
 
     resuming = false;
 
+#ifdef FIND_GREP_THREADS
+    if (search_content_handle != nullptr)
+    {
+        vfs_path_t *start_vpath;
+
+        /* VFS isn't thread safe: only local files can be grepped in parallel */
+        start_vpath = vfs_path_from_str (start_dir);
+        if (vfs_file_is_local (start_vpath))
+            find_grep_init ();
+        vfs_path_free (start_vpath);
+    }
+#else
+    (void) start_dir;
+#endif
+
     widget_idle (WIDGET (find_dlg), true);
     ret = dlg_run (find_dlg);
 
+#ifdef FIND_GREP_THREADS
+    find_grep_done ();
+#endif
+
     mc_search_free (search_file_handle);
     search_file_handle = nullptr;
     mc_search_free (search_content_handle);
@@ -1776,7 +2307,7 @@ do_find (const char *start_dir, ssize_t start_dir_len, const char *ignore_dirs,
     parse_ignore_dirs (ignore_dirs);
     push_directory (vfs_path_from_str (start_dir));
 
-    return_value = run_process ();
+    return_value = run_process (start_dir);
 
     /* Clear variables */
     init_find_vars ();
@@ -1856,6 +2387,7 @@ do_find (const char *start_dir, ssize_t start_dir_len, const char *ignore_dirs,
             list->list[list->len].st = st;
             list->list[list->len].sort_key = nullptr;
             list->list[list->len].second_sort_key = nullptr;
+            list->list[list->len].color_stamp = 0;
             list->len++;
             g_free (name);
             if ((list->len & 15) == 0)
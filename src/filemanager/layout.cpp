@@ -1262,6 +1262,10 @@ swap_panels (void)
     {
         WPanel panel;
 
+        /* loading and watching of directory are bound to panel */
+        panel_load_finish (panel1);
+        panel_load_finish (panel2);
+
 #define panelswap(x) panel.x = panel1->x; panel1->x = panel2->x; panel2->x = panel.x;
         /* Change content and related stuff */
         panelswap (dir);
@@ -1277,6 +1281,9 @@ swap_panels (void)
         panelswap (dir_stat);
 #undef panelswap
 
+        panel_watch_start (panel1);
+        panel_watch_start (panel2);
+
         panel1->searching = false;
         panel2->searching = false;
 
@@ -117,6 +117,9 @@ mc_fhl_t *mc_filehighlight = nullptr;
 #define MARKED_SELECTED 3
 #define STATUS          5
 
+/* time to wait for the end of loading of directory before the panel is shown */
+#define PANEL_LOAD_WAIT (G_USEC_PER_SEC / 10)
+
 /*** file scope type declarations ****************************************************************/
 
 typedef enum
@@ -2059,6 +2062,9 @@ panel_select_ext_cmd (void)
 
     g_free (cur_file_ext);
 
+    /* files that are still being loaded should be selected as well */
+    panel_load_finish (current_panel);
+
     search = mc_search_new (reg_exp, nullptr);
     search->search_type = MC_SEARCH_T_REGEX;
     search->is_case_sensitive = false;
@@ -2554,6 +2560,9 @@ panel_select_unselect_files (WPanel * panel, const char *title, const char *hist
         return;
     }
 
+    /* files that are still being loaded should be selected as well */
+    panel_load_finish (panel);
+
     search = mc_search_new (reg_exp, nullptr);
     search->search_type = shell_patterns ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
     search->is_entire_line = true;
@@ -2606,6 +2615,8 @@ panel_select_invert_files (WPanel * panel)
 {
     int i;
 
+    panel_load_finish (panel);
+
     for (i = 0; i < panel->dir.len; i++)
     {
         file_entry_t *file = &panel->dir.list[i];
@@ -3239,6 +3250,264 @@ subshell_chdir (const vfs_path_t * vpath)
 #endif /* ENABLE_SUBSHELL */
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether files of panel can be changed in place now: the list isn't used by
+ * file operation or other dialog.
+ */
+
+static bool
+panel_list_is_changeable (const WPanel * panel)
+{
+    return (top_dlg != nullptr && DIALOG (top_dlg->data) == midnight_dlg && !panel->is_panelized);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Select the file at the same line of panel after the directory list is changed.
+ *
+ * @param panel panel
+ * @param fname name of file selected before change, nullptr if list was empty
+ * @param offset line of selected file before change, relative to the top file
+ */
+
+static void
+panel_keep_selection (WPanel * panel, const char *fname, int offset)
+{
+    int i;
+
+    i = fname == nullptr ? -1 : dir_list_find (&panel->dir, fname);
+    if (i != -1)
+    {
+        panel->selected = i;
+        panel->top_file = MAX (i - offset, 0);
+    }
+    else if (panel->selected >= panel->dir.len)
+        panel->selected = MAX (panel->dir.len - 1, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Apply changes of files known from watch to the directory list. Marks of files and
+ * selection are kept. If watch has lost some changes, the directory is read again.
+ */
+
+static void
+panel_watch_apply (WPanel * panel)
+{
+    GPtrArray *names;
+    GHashTable *index;
+    file_entry_t *old;
+    bool *found, *remove;
+    char *current_file = nullptr;
+    int offset, i;
+    guint n;
+
+    if (!dir_watch_is_valid (panel->watch))
+    {
+        if (panel->dir.len != 0)
+            current_file = g_strdup (selection (panel)->fname);
+        memset (&(panel->dir_stat), 0, sizeof (panel->dir_stat));
+        /* watch is started again */
+        panel_reload (panel);
+        try_to_select (panel, current_file);
+        g_free (current_file);
+        return;
+    }
+
+    names = dir_watch_take (panel->watch);
+    if (names == nullptr)
+        return;
+
+    if (panel->dir.len != 0)
+        current_file = g_strdup (selection (panel)->fname);
+    offset = panel->selected - panel->top_file;
+
+    /* find old entries of all changed files by index and remove them by one pass */
+    old = g_new (file_entry_t, names->len);
+    found = g_new0 (bool, names->len);
+    remove = g_new0 (bool, panel->dir.len);
+    index = dir_list_make_index (&panel->dir);
+
+    for (n = 0; n < names->len; n++)
+    {
+        i = dir_list_index_find (index, (const char *) g_ptr_array_index (names, n));
+        if (i != -1)
+        {
+            old[n] = panel->dir.list[i];
+            found[n] = true;
+            remove[i] = true;
+            do_file_mark (panel, i, 0);
+        }
+    }
+
+    g_hash_table_destroy (index);
+    dir_list_remove_files (&panel->dir, remove);
+    g_free (remove);
+
+    for (n = 0; n < names->len; n++)
+    {
+        const char *fname = (const char *) g_ptr_array_index (names, n);
+        struct stat st;
+        bool link_to_dir, stale_link;
+
+        if (dir_list_stat_file (panel->cwd_vpath, fname, panel->filter, &st, &link_to_dir,
+                                &stale_link))
+        {
+            i = dir_list_insert (&panel->dir, fname, &st, link_to_dir, stale_link,
+                                 panel->sort_field->sort_routine, &panel->sort_info);
+            if (i != -1 && found[n])
+            {
+                file_entry_t *fe = &panel->dir.list[i];
+
+                /* keep computed size of directory */
+                if (old[n].f.dir_size_computed && S_ISDIR (fe->st.st_mode)
+                    && fe->st.st_ino == old[n].st.st_ino)
+                {
+                    fe->st.st_size = old[n].st.st_size;
+                    fe->f.dir_size_computed = 1;
+                }
+
+                do_file_mark (panel, i, old[n].f.marked);
+            }
+        }
+    }
+
+    g_free (found);
+    g_free (old);
+    g_ptr_array_free (names, TRUE);
+
+    panel_keep_selection (panel, current_file, offset);
+    g_free (current_file);
+
+    select_item (panel);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_watch_callback (void *data)
+{
+    WPanel *panel = PANEL (data);
+
+    /* changes are applied when all files are loaded */
+    if (!panel_list_is_changeable (panel) || panel->loader != nullptr)
+        return;
+
+    panel_watch_apply (panel);
+
+    if (panel->dirty)
+    {
+        widget_draw (WIDGET (panel));
+        mc_refresh ();
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add files loaded in background to the list of panel. The selected file is kept at
+ * the same line. The file selected before the change of directory is selected as soon as
+ * it is loaded if the user hasn't moved the cursor yet.
+ */
+
+static void
+panel_load_take (WPanel * panel)
+{
+    char *current_file = nullptr;
+    bool finished;
+    int offset;
+
+    if (panel->dir.len != 0)
+        current_file = g_strdup (selection (panel)->fname);
+    offset = panel->selected - panel->top_file;
+
+    if (dir_list_loader_take (panel->loader, &panel->dir, panel->sort_field->sort_routine,
+                              &panel->sort_info, panel->filter, &finished))
+    {
+        panel->dirty = 1;
+
+        if (panel->load_select != nullptr && panel->selected == 0)
+            try_to_select (panel, panel->load_select);
+        else
+        {
+            panel_keep_selection (panel, current_file, offset);
+            select_item (panel);
+        }
+    }
+
+    g_free (current_file);
+
+    if (finished)
+    {
+        dir_list_loader_free (panel->loader);
+        panel->loader = nullptr;
+        MC_PTR_FREE (panel->load_select);
+
+        /* files changed while directory was loaded */
+        if (panel->watch != nullptr)
+            panel_watch_apply (panel);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_load_continue (WPanel * panel)
+{
+    panel_load_take (panel);
+
+    if (panel->dirty)
+    {
+        widget_draw (WIDGET (panel));
+        mc_refresh ();
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take files those were loaded while panels couldn't be changed.
+ */
+
+static void
+panel_load_idle (void *data)
+{
+    int i;
+
+    (void) data;
+
+    if (top_dlg == nullptr || DIALOG (top_dlg->data) != midnight_dlg)
+        return;
+
+    delete_hook (&idle_hook, panel_load_idle);
+
+    for (i = 0; i < 2; i++)
+        if (get_panel_type (i) == view_listing)
+        {
+            WPanel *panel = PANEL (get_panel_widget (i));
+
+            if (panel->loader != nullptr && !panel->is_panelized)
+                panel_load_continue (panel);
+        }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_load_callback (void *data)
+{
+    WPanel *panel = PANEL (data);
+
+    if (!panel_list_is_changeable (panel))
+    {
+        /* loaded files aren't lost: they are taken when the main dialog is on top again */
+        if (!hook_present (idle_hook, panel_load_idle))
+            add_hook (&idle_hook, panel_load_idle, nullptr);
+        return;
+    }
+
+    panel_load_continue (panel);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Changes the current directory of the panel.
@@ -3278,12 +3547,25 @@ _do_panel_cd (WPanel * panel, const vfs_path_t * new_dir_vpath, enum cd_enum cd_
 
     /* Reload current panel */
     panel_clean_dir (panel);
+    panel_watch_start (panel);
 
-    if (!dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
-                        &panel->sort_info, panel->filter))
-        message (D_ERROR, MSG_ERROR, _("Cannot read directory contents"));
+    /* local directory is loaded in background, the first files are shown as soon as possible */
+    panel->loader = dir_list_load_start (&panel->dir, panel->cwd_vpath, panel_load_callback, panel);
+    if (panel->loader != nullptr)
+    {
+        panel->load_select = g_strdup (get_parent_dir_name (panel->cwd_vpath, olddir_vpath));
+        /* don't blink if directory is read fast */
+        dir_list_loader_wait (panel->loader, PANEL_LOAD_WAIT);
+        panel_load_take (panel);
+    }
+    else
+    {
+        if (!dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
+                            &panel->sort_info, panel->filter))
+            message (D_ERROR, MSG_ERROR, _("Cannot read directory contents"));
 
-    try_to_select (panel, get_parent_dir_name (panel->cwd_vpath, olddir_vpath));
+        try_to_select (panel, get_parent_dir_name (panel->cwd_vpath, olddir_vpath));
+    }
 
     load_hint (false);
     panel->dirty = 1;
@@ -4239,6 +4521,12 @@ panel_clean_dir (WPanel * panel)
     panel->content_shift = -1;
     panel->max_shift = -1;
 
+    dir_watch_free (panel->watch);
+    panel->watch = nullptr;
+    dir_list_loader_free (panel->loader);
+    panel->loader = nullptr;
+    MC_PTR_FREE (panel->load_select);
+
     dir_list_free_list (&panel->dir);
 }
 
@@ -4401,6 +4689,7 @@ panel_sized_with_dir_new (const char *panel_name, int y, int x, int lines, int c
     }
 
     /* Load the default format */
+    panel_watch_start (panel);
     if (!dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
                         &panel->sort_info, panel->filter))
         message (D_ERROR, MSG_ERROR, _("Cannot read directory contents"));
@@ -4434,6 +4723,19 @@ panel_reload (WPanel * panel)
         && current_stat.st_mtime == panel->dir_stat.st_mtime)
         return;
 
+    /* changes of files are known from watch */
+    if (panels_options.fast_reload && panel->dir_stat.st_mtime != 0 && panel->watch != nullptr
+        && panel->loader == nullptr && !panel->is_panelized && dir_watch_is_valid (panel->watch))
+    {
+        panel_watch_apply (panel);
+        return;
+    }
+
+    /* directory is read again at once */
+    dir_list_loader_free (panel->loader);
+    panel->loader = nullptr;
+    MC_PTR_FREE (panel->load_select);
+
     cwd_vpath = panel_recursive_cd_to_parent (panel->cwd_vpath);
     vfs_path_free (panel->cwd_vpath);
 
@@ -4449,6 +4751,8 @@ panel_reload (WPanel * panel)
     memset (&(panel->dir_stat), 0, sizeof (panel->dir_stat));
     show_dir (panel);
 
+    panel_watch_start (panel);
+
     if (!dir_list_reload (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
                           &panel->sort_info, panel->filter))
         message (D_ERROR, MSG_ERROR, _("Cannot read directory contents"));
@@ -4460,6 +4764,39 @@ panel_reload (WPanel * panel)
     recalculate_panel_summary (panel);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait until the current directory of panel is loaded in background and add all its files
+ * to the list.
+ *
+ * @param panel panel
+ */
+
+void
+panel_load_finish (WPanel * panel)
+{
+    if (panel->loader != nullptr)
+    {
+        dir_list_loader_wait (panel->loader, -1);
+        panel_load_take (panel);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start watching of the current directory of panel.
+ * Should be called before reading of directory to don't lose changes.
+ *
+ * @param panel panel
+ */
+
+void
+panel_watch_start (WPanel * panel)
+{
+    dir_watch_free (panel->watch);
+    panel->watch = dir_watch_new (panel->cwd_vpath, panel_watch_callback, panel);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* Switches the panel to the mode specified in the format           */
 /* Seting up both format and status string. Return: 0 - on success; */
@@ -4619,6 +4956,67 @@ do_file_mark (WPanel * panel, int idx, int mark)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Do operation on all marked files of remote panel at once if file system supports it.
+ * Files are unmarked if operation on them succeeded, failed ones are kept marked
+ * to be processed one by one by caller which reports errors.
+ *
+ * @param panel panel
+ * @param fill callback to fill operation on file
+ * @param data data of callback
+ *
+ * @return number of files processed successfully
+ */
+
+int
+panel_batch_marked (WPanel * panel, panel_batch_fill_fn fill, void *data)
+{
+    GArray *ops;
+    GArray *idx;
+    int i, done = 0;
+
+    if (panel->marked < 2 || panel->is_panelized || vfs_file_is_local (panel->cwd_vpath))
+        return 0;
+
+    ops = g_array_sized_new (FALSE, TRUE, sizeof (vfs_batch_t), panel->marked);
+    idx = g_array_sized_new (FALSE, FALSE, sizeof (int), panel->marked);
+
+    for (i = 0; i < panel->dir.len; i++)
+    {
+        file_entry_t *fe = &panel->dir.list[i];
+        vfs_batch_t op;
+
+        if (!fe->f.marked)
+            continue;
+
+        memset (&op, 0, sizeof (op));
+        op.name = fe->fname;
+        if (fill (fe, &op, data))
+        {
+            g_array_append_val (ops, op);
+            g_array_append_val (idx, i);
+        }
+    }
+
+    if (ops->len > 1 && mc_setctl (panel->cwd_vpath, VFS_SETCTL_BATCH, ops) == 1)
+    {
+        guint j;
+
+        for (j = 0; j < ops->len; j++)
+            if (g_array_index (ops, vfs_batch_t, j).error == 0)
+            {
+                do_file_mark (panel, g_array_index (idx, int, j), 0);
+                done++;
+            }
+    }
+
+    g_array_free (idx, TRUE);
+    g_array_free (ops, TRUE);
+
+    return done;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Changes the current directory of the panel.
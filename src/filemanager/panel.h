@@ -15,6 +15,7 @@
 #include "lib/filehighlight.h"
 
 #include "dir.h"                /* dir_list */
+#include "dirwatch.h"
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
@@ -26,6 +27,9 @@
 
 #define UP_KEEPSEL ((char *) -1)
 
+/* fill operation on marked file for panel_batch_marked(). Return false to skip file */
+typedef bool (*panel_batch_fill_fn) (const file_entry_t * fe, vfs_batch_t * op, void *data);
+
 /*** enums ***************************************************************************************/
 
 typedef enum
@@ -121,6 +125,9 @@ typedef struct
 
     char *panel_name;           /* The panel name */
     struct stat dir_stat;       /* Stat of current dir: used by execute () */
+    dir_watch_t *watch;         /* Watch of current dir for changes, nullptr if not watched */
+    dir_list_loader_t *loader;  /* Loader of current dir in background, nullptr if it is loaded */
+    char *load_select;          /* File to be selected as soon as it is loaded */
 
 #ifdef HAVE_CHARSET
     int codepage;               /* panel codepage */
@@ -152,6 +159,8 @@ WPanel *panel_sized_with_dir_new (const char *panel_name, int y, int x, int line
 void panel_clean_dir (WPanel * panel);
 
 void panel_reload (WPanel * panel);
+void panel_load_finish (WPanel * panel);
+void panel_watch_start (WPanel * panel);
 void panel_set_sort_order (WPanel * panel, const panel_field_t * sort_order);
 void panel_re_sort (WPanel * panel);
 
@@ -171,6 +180,7 @@ void select_item (WPanel * panel);
 void recalculate_panel_summary (WPanel * panel);
 void file_mark (WPanel * panel, int idx, int val);
 void do_file_mark (WPanel * panel, int idx, int val);
+int panel_batch_marked (WPanel * panel, panel_batch_fill_fn fill, void *data);
 
 bool do_panel_cd (WPanel * panel, const vfs_path_t * new_dir_vpath, enum cd_enum cd_type);
 
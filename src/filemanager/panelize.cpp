@@ -378,6 +378,9 @@ do_panelize_cd (WPanel * panel)
     dir_list *list;
     bool panelized_same;
 
+    /* files of directory that arrive later would be mixed with panelized ones */
+    panel_load_finish (panel);
+
     dir_list_clean (&panel->dir);
     if (panelized_panel.root_vpath == nullptr)
         panelize_change_root (current_panel->cwd_vpath);
@@ -420,6 +423,7 @@ do_panelize_cd (WPanel * panel)
         list->list[i].st = panelized_panel.list.list[i].st;
         list->list[i].sort_key = panelized_panel.list.list[i].sort_key;
         list->list[i].second_sort_key = panelized_panel.list.list[i].second_sort_key;
+        list->list[i].color_stamp = 0;
     }
 
     panel->is_panelized = true;
@@ -451,6 +455,9 @@ panelize_save_panel (WPanel * panel)
     int i;
     dir_list *list = &panel->dir;
 
+    /* save the whole list, not a part of it loaded so far */
+    panel_load_finish (panel);
+
     panelize_change_root (current_panel->cwd_vpath);
 
     if (panelized_panel.list.len > 0)
@@ -474,6 +481,7 @@ panelize_save_panel (WPanel * panel)
         panelized_panel.list.list[i].st = list->list[i].st;
         panelized_panel.list.list[i].sort_key = list->list[i].sort_key;
         panelized_panel.list.list[i].second_sort_key = list->list[i].second_sort_key;
+        panelized_panel.list.list[i].color_stamp = 0;
     }
 }
 
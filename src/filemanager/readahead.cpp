@@ -0,0 +1,312 @@
+/*
+   Read-ahead of local files in another thread.
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file readahead.c
+ *  \brief Source: read-ahead of local files in another thread
+ *
+ *  When a file is copied, the next blocks of source file are read by a worker thread while
+ *  the current one is written to target, so that the copying takes as long as the slower of
+ *  reading and writing instead of their sum.
+ *
+ *  VFS is not thread safe, so only local files are read ahead, and the worker thread uses plain
+ *  pread() on the file descriptor of local file. The position of file isn't changed.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+
+#include "readahead.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* number of buffers: one is being written, others are being read or wait for writing */
+#define FILE_READAHEAD_BUFFERS 4
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    char *data;
+    ssize_t len;                /* bytes read, 0 at the end of file, -1 on error */
+    int error;                  /* errno if len == -1 */
+} file_readahead_buffer_t;
+
+struct file_readahead_t
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    int fd;
+    size_t bufsize;
+    file_readahead_buffer_t buffers[FILE_READAHEAD_BUFFERS];
+
+    /* only the worker thread uses this */
+    off_t read_offset;
+
+    /* only the calling thread uses this */
+    off_t offset;               /* offset of data returned by file_readahead_read() */
+
+    /* protected by lock */
+    GMutex lock;
+    GCond cond;
+    int first;                  /* index of the oldest filled buffer */
+    int n_full;                 /* number of filled buffers including one owned by caller */
+    bool busy;                  /* the oldest filled buffer is owned by caller */
+    bool stop;                  /* worker thread should exit */
+
+    GThread *thread;
+#else
+    int dummy;
+#endif
+};
+
+/*** file scope variables ************************************************************************/
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static gpointer
+file_readahead_worker (gpointer data)
+{
+    file_readahead_t *ra = (file_readahead_t *) data;
+    bool done = false;
+
+    g_mutex_lock (&ra->lock);
+
+    while (!ra->stop && !done)
+    {
+        file_readahead_buffer_t *b;
+        ssize_t n;
+
+        if (ra->n_full == FILE_READAHEAD_BUFFERS)
+        {
+            g_cond_wait (&ra->cond, &ra->lock);
+            continue;
+        }
+
+        /* nobody else touches the free buffer */
+        b = &ra->buffers[(ra->first + ra->n_full) % FILE_READAHEAD_BUFFERS];
+        g_mutex_unlock (&ra->lock);
+
+        while ((n = pread (ra->fd, b->data, ra->bufsize, ra->read_offset)) == -1 && errno == EINTR)
+            ;
+        b->len = n;
+        b->error = n == -1 ? errno : 0;
+        if (n > 0)
+            ra->read_offset += n;
+        else
+            done = true;        /* end of file or error */
+
+        g_mutex_lock (&ra->lock);
+        ra->n_full++;
+        g_cond_broadcast (&ra->cond);
+    }
+
+    g_mutex_unlock (&ra->lock);
+
+    return nullptr;
+}
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start reading of file ahead from its current position.
+ *
+ * @param vfs_fd mc VFS file handler
+ * @param bufsize size of block to read at once
+ *
+ * @return read-ahead handle, nullptr if file isn't local or thread can't be created. The file
+ *         should not be read or closed until the handle is freed.
+ */
+
+file_readahead_t *
+file_readahead_new (int vfs_fd, size_t bufsize)
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    struct vfs_class *vclass;
+    void *fsinfo = nullptr;
+    file_readahead_t *ra;
+    off_t offset;
+    int i;
+
+    vclass = vfs_class_find_by_handle (vfs_fd, &fsinfo);
+    if (vclass == nullptr || (vclass->flags & VFSF_LOCAL) == 0 || fsinfo == nullptr)
+        return nullptr;
+
+    offset = mc_lseek (vfs_fd, 0, SEEK_CUR);
+    if (offset == -1)
+        return nullptr;
+
+    ra = g_new0 (file_readahead_t, 1);
+    ra->fd = *(int *) fsinfo;
+    ra->bufsize = bufsize;
+    ra->read_offset = offset;
+    ra->offset = offset;
+    for (i = 0; i < FILE_READAHEAD_BUFFERS; i++)
+        ra->buffers[i].data = static_cast<char *> (g_malloc (bufsize));
+    g_mutex_init (&ra->lock);
+    g_cond_init (&ra->cond);
+
+    ra->thread = g_thread_try_new ("readahead", file_readahead_worker, ra, nullptr);
+    if (ra->thread == nullptr)
+    {
+        file_readahead_free (ra);
+        ra = nullptr;
+    }
+
+    return ra;
+#else
+    (void) vfs_fd;
+    (void) bufsize;
+
+    return nullptr;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get next block of file. Wait for it if it hasn't been read yet.
+ *
+ * @param ra read-ahead handle
+ * @param data where to store pointer to data; it is valid until the next call
+ *
+ * @return number of bytes read, 0 at the end of file, -1 on error with errno set. After the
+ *         end of file or error nothing is read anymore.
+ */
+
+ssize_t
+file_readahead_read (file_readahead_t * ra, const char **data)
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    const file_readahead_buffer_t *b;
+
+    g_mutex_lock (&ra->lock);
+
+    if (ra->busy)
+    {
+        const file_readahead_buffer_t *prev = &ra->buffers[ra->first];
+
+        if (prev->len <= 0)
+        {
+            /* worker is done: return the same result again */
+            g_mutex_unlock (&ra->lock);
+            *data = prev->data;
+            errno = prev->error;
+            return prev->len;
+        }
+
+        /* give the buffer back to worker */
+        ra->first = (ra->first + 1) % FILE_READAHEAD_BUFFERS;
+        ra->n_full--;
+        ra->busy = false;
+        g_cond_broadcast (&ra->cond);
+    }
+
+    while (ra->n_full == 0)
+        g_cond_wait (&ra->cond, &ra->lock);
+
+    b = &ra->buffers[ra->first];
+    ra->busy = true;
+
+    g_mutex_unlock (&ra->lock);
+
+    if (b->len > 0)
+        ra->offset += b->len;
+
+    *data = b->data;
+    errno = b->error;
+    return b->len;
+#else
+    (void) ra;
+    (void) data;
+
+    errno = ENOSYS;
+    return (-1);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get offset of file up to which data were returned by file_readahead_read().
+ * This is where synchronous reading should be continued from after read-ahead is stopped.
+ *
+ * @param ra read-ahead handle
+ *
+ * @return offset in file
+ */
+
+off_t
+file_readahead_get_offset (const file_readahead_t * ra)
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    return ra->offset;
+#else
+    (void) ra;
+
+    return (-1);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop reading ahead and free resources. Position of file is not changed.
+ *
+ * @param ra read-ahead handle
+ */
+
+void
+file_readahead_free (file_readahead_t * ra)
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    int i;
+
+    if (ra == nullptr)
+        return;
+
+    if (ra->thread != nullptr)
+    {
+        g_mutex_lock (&ra->lock);
+        ra->stop = true;
+        g_cond_broadcast (&ra->cond);
+        g_mutex_unlock (&ra->lock);
+        g_thread_join (ra->thread);
+    }
+
+    for (i = 0; i < FILE_READAHEAD_BUFFERS; i++)
+        g_free (ra->buffers[i].data);
+    g_mutex_clear (&ra->lock);
+    g_cond_clear (&ra->cond);
+    g_free (ra);
+#else
+    (void) ra;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
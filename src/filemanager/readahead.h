@@ -0,0 +1,29 @@
+/** \file  readahead.h
+ *  \brief Header: read-ahead of local files in another thread
+ */
+
+#ifndef MC__READAHEAD_H
+#define MC__READAHEAD_H
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct file_readahead_t file_readahead_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+file_readahead_t *file_readahead_new (int vfs_fd, size_t bufsize);
+ssize_t file_readahead_read (file_readahead_t * ra, const char **data);
+off_t file_readahead_get_offset (const file_readahead_t * ra);
+void file_readahead_free (file_readahead_t * ra);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__READAHEAD_H */
@@ -54,7 +54,6 @@
 #include "lib/mcconfig.h"
 #include "lib/vfs/vfs.h"
 #include "lib/fileloc.h"
-#include "lib/strescape.h"
 #include "lib/hook.h"
 #include "lib/util.h"
 
@@ -66,7 +65,12 @@
 
 /*** file scope macro definitions ****************************************************************/
 
-#define TREE_SIGNATURE "Midnight Commander TreeStore v 2.0"
+#define TREE_SIGNATURE "Midnight Commander TreeStore v 3.0"
+
+/* text format of previous versions, it is still read */
+#define TREE_SIGNATURE_TEXT "Midnight Commander TreeStore v 2.0"
+
+#define TREE_FLAG_SCANNED 1
 
 /*** file scope type declarations ****************************************************************/
 
@@ -132,6 +136,9 @@ str_common (const vfs_path_t * s1_vpath, const vfs_path_t * s2_vpath)
   * of pathcmp and strcmp are the same (an integer less than, equal to, or 
   * greater than zero if p1 is found to be less than, to match, or be greater 
   * than p2.
+ *
+ * The same order is kept by the index of entries to find the place of a new entry without
+ * walking the list. Entries are found by their names in the hash table of paths.
  */
 
 static int
@@ -163,6 +170,16 @@ pathcmp (const vfs_path_t * p1_vpath, const vfs_path_t * p2_vpath)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static int
+tree_entry_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    (void) user_data;
+
+    return pathcmp (((const tree_entry *) a)->name, ((const tree_entry *) b)->name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static char *
 decode (char *buffer)
 {
@@ -205,98 +222,182 @@ decode (char *buffer)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** Loads the tree store from the specified filename */
+/** Reads records of the text format of previous versions */
 
-static int
-tree_store_load_from (const char *name)
+static void
+tree_store_load_text (FILE * file)
 {
-    FILE *file;
     char buffer[MC_MAXPATHLEN + 20];
+    char oldname[MC_MAXPATHLEN] = "\0";
 
-    g_return_val_if_fail (name != nullptr, 0);
+    while (fgets (buffer, MC_MAXPATHLEN, file))
+    {
+        tree_entry *e;
+        bool scanned;
+        char *lc_name;
 
-    if (ts.loaded)
-        return 1;
+        /* Skip invalid records */
+        if ((buffer[0] != '0' && buffer[0] != '1'))
+            continue;
 
-    file = fopen (name, "r");
+        if (buffer[1] != ':')
+            continue;
+
+        scanned = buffer[0] == '1';
+
+        lc_name = decode (buffer + 2);
+        if (!IS_PATH_SEP (lc_name[0]))
+        {
+            /* Clear-text decompression */
+            char *s;
+
+            s = strtok (lc_name, " ");
+            if (s != nullptr)
+            {
+                char *different;
+                int common;
+
+                common = atoi (s);
+                different = strtok (nullptr, "");
+                if (different != nullptr)
+                {
+                    vfs_path_t *vpath;
+
+                    vpath = vfs_path_from_str (oldname);
+                    strcpy (oldname + common, different);
+                    if (vfs_file_is_local (vpath))
+                    {
+                        vfs_path_t *tmp_vpath;
+
+                        tmp_vpath = vfs_path_from_str (oldname);
+                        e = tree_store_add_entry (tmp_vpath);
+                        vfs_path_free (tmp_vpath);
+                        e->scanned = scanned;
+                    }
+                    vfs_path_free (vpath);
+                }
+            }
+        }
+        else
+        {
+            vfs_path_t *vpath;
+
+            vpath = vfs_path_from_str (lc_name);
+            if (vfs_file_is_local (vpath))
+            {
+                e = tree_store_add_entry (vpath);
+                e->scanned = scanned;
+            }
+            vfs_path_free (vpath);
+            strcpy (oldname, lc_name);
+        }
+        g_free (lc_name);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read the number written by tree_store_put_number().
+ *
+ * @return true on success, false if file is truncated or corrupted
+ */
+
+static bool
+tree_store_get_number (FILE * file, size_t * number)
+{
+    unsigned int shift = 0;
+    int c;
+
+    *number = 0;
 
-    if (file != nullptr
-        && (fgets (buffer, sizeof (buffer), file) == nullptr
-            || strncmp (buffer, TREE_SIGNATURE, strlen (TREE_SIGNATURE)) != 0))
+    do
     {
-        fclose (file);
-        file = nullptr;
+        c = getc (file);
+        if (c == EOF || shift > 28)
+            return false;
+
+        *number |= (size_t) (c & 0x7f) << shift;
+        shift += 7;
     }
+    while ((c & 0x80) != 0);
 
-    if (file != nullptr)
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Reads records of the binary format. Each record is a byte of flags, the length of the prefix
+ * which is common with the previous name, the length of the rest of name and the rest of name
+ * itself. Records are stored in the order of the list, so entries are appended while loading.
+ */
+
+static void
+tree_store_load_binary (FILE * file)
+{
+    char name[MC_MAXPATHLEN];
+    size_t len = 0;
+    int flags;
+
+    while ((flags = getc (file)) != EOF)
     {
-        char oldname[MC_MAXPATHLEN] = "\0";
+        size_t common, rest;
+        vfs_path_t *vpath;
 
-        ts.loaded = true;
+        /* Stop on truncated or corrupted record, entries read before are kept */
+        if (!tree_store_get_number (file, &common) || !tree_store_get_number (file, &rest)
+            || common > len || rest >= sizeof (name) - common
+            || fread (name + common, 1, rest, file) != rest)
+            break;
 
-        /* File open -> read contents */
-        while (fgets (buffer, MC_MAXPATHLEN, file))
+        len = common + rest;
+        name[len] = '\0';
+
+        if (!IS_PATH_SEP (name[0]))
+            continue;
+
+        vpath = vfs_path_from_str (name);
+        if (vfs_file_is_local (vpath))
         {
             tree_entry *e;
-            bool scanned;
-            char *lc_name;
 
-            /* Skip invalid records */
-            if ((buffer[0] != '0' && buffer[0] != '1'))
-                continue;
+            e = tree_store_add_entry (vpath);
+            e->scanned = (flags & TREE_FLAG_SCANNED) != 0;
+        }
+        vfs_path_free (vpath);
+    }
+}
 
-            if (buffer[1] != ':')
-                continue;
+/* --------------------------------------------------------------------------------------------- */
+/** Loads the tree store from the specified filename */
 
-            scanned = buffer[0] == '1';
+static int
+tree_store_load_from (const char *name)
+{
+    FILE *file;
 
-            lc_name = decode (buffer + 2);
-            if (!IS_PATH_SEP (lc_name[0]))
-            {
-                /* Clear-text decompression */
-                char *s;
+    g_return_val_if_fail (name != nullptr, 0);
 
-                s = strtok (lc_name, " ");
-                if (s != nullptr)
-                {
-                    char *different;
-                    int common;
+    if (ts.loaded)
+        return 1;
 
-                    common = atoi (s);
-                    different = strtok (nullptr, "");
-                    if (different != nullptr)
-                    {
-                        vfs_path_t *vpath;
-
-                        vpath = vfs_path_from_str (oldname);
-                        strcpy (oldname + common, different);
-                        if (vfs_file_is_local (vpath))
-                        {
-                            vfs_path_t *tmp_vpath;
-
-                            tmp_vpath = vfs_path_from_str (oldname);
-                            e = tree_store_add_entry (tmp_vpath);
-                            vfs_path_free (tmp_vpath);
-                            e->scanned = scanned;
-                        }
-                        vfs_path_free (vpath);
-                    }
-                }
-            }
-            else
-            {
-                vfs_path_t *vpath;
+    file = fopen (name, "r");
 
-                vpath = vfs_path_from_str (lc_name);
-                if (vfs_file_is_local (vpath))
-                {
-                    e = tree_store_add_entry (vpath);
-                    e->scanned = scanned;
-                }
-                vfs_path_free (vpath);
-                strcpy (oldname, lc_name);
-            }
-            g_free (lc_name);
+    if (file != nullptr)
+    {
+        char buffer[MC_MAXPATHLEN + 20];
+
+        /* File open -> read contents */
+        if (fgets (buffer, sizeof (buffer), file) == nullptr)
+            ;
+        else if (strcmp (buffer, TREE_SIGNATURE "\n") == 0)
+        {
+            ts.loaded = true;
+            tree_store_load_binary (file);
+        }
+        else if (strncmp (buffer, TREE_SIGNATURE_TEXT, strlen (TREE_SIGNATURE_TEXT)) == 0)
+        {
+            ts.loaded = true;
+            tree_store_load_text (file);
         }
 
         fclose (file);
@@ -318,11 +419,15 @@ tree_store_load_from (const char *name)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/** Writes the number by 7 bits per byte, least significant bits first */
 
-static char *
-encode (const vfs_path_t * vpath, size_t offset)
+static void
+tree_store_put_number (FILE * file, size_t number)
 {
-    return strutils_escape (vfs_path_as_str (vpath) + offset, -1, "\n\\", false);
+    for (; number >= 0x80; number >>= 7)
+        putc ((int) (number & 0x7f) | 0x80, file);
+
+    putc ((int) number, file);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -332,7 +437,9 @@ static int
 tree_store_save_to (char *name)
 {
     tree_entry *current;
+    const vfs_path_t *prev = nullptr;
     FILE *file;
+    bool error;
 
     file = fopen (name, "w");
     if (file == nullptr)
@@ -343,37 +450,32 @@ tree_store_save_to (char *name)
     for (current = ts.tree_first; current != nullptr; current = current->next)
         if (vfs_file_is_local (current->name))
         {
-            int i, common;
-
-            /* Clear-text compression */
-            if (current->prev != nullptr
-                && (common = str_common (current->prev->name, current->name)) > 2)
-            {
-                char *encoded;
+            const char *cname;
+            size_t len, common;
 
-                encoded = encode (current->name, common);
-                i = fprintf (file, "%d:%d %s\n", current->scanned ? 1 : 0, common, encoded);
-                g_free (encoded);
-            }
-            else
-            {
-                char *encoded;
+            /* Prefix compression */
+            cname = vfs_path_as_str (current->name);
+            len = strlen (cname);
+            common = prev == nullptr ? 0 : str_common (prev, current->name);
 
-                encoded = encode (current->name, 0);
-                i = fprintf (file, "%d:%s\n", current->scanned ? 1 : 0, encoded);
-                g_free (encoded);
-            }
+            putc (current->scanned ? TREE_FLAG_SCANNED : 0, file);
+            tree_store_put_number (file, common);
+            tree_store_put_number (file, len - common);
+            fwrite (cname + common, 1, len - common, file);
 
-            if (i == EOF)
-            {
-                fprintf (stderr, _("Cannot write to the %s file:\n%s\n"),
-                         name, unix_error_string (errno));
-                break;
-            }
+            prev = current->name;
         }
 
+    error = ferror (file) != 0;
+    if (fclose (file) != 0 || error)
+    {
+        int err = errno != 0 ? errno : EIO;
+
+        fprintf (stderr, _("Cannot write to the %s file:\n%s\n"), name, unix_error_string (err));
+        return err;
+    }
+
     tree_store_dirty (false);
-    fclose (file);
 
     return 0;
 }
@@ -383,7 +485,6 @@ tree_store_save_to (char *name)
 static tree_entry *
 tree_store_add_entry (const vfs_path_t * name)
 {
-    int flag = -1;
     tree_entry *current;
     tree_entry *old = nullptr;
     tree_entry *new_;
@@ -392,55 +493,55 @@ tree_store_add_entry (const vfs_path_t * name)
     if (ts.tree_last != nullptr && ts.tree_last->next != nullptr)
         abort ();
 
-    /* Search for the correct place */
-    for (current = ts.tree_first;
-         current != nullptr && (flag = pathcmp (current->name, name)) < 0; current = current->next)
-        old = current;
-
-    if (flag == 0)
+    current = tree_store_whereis (name);
+    if (current != nullptr)
         return current;         /* Already in the list */
 
+    if (ts.paths == nullptr)
+    {
+        ts.paths = g_hash_table_new (g_str_hash, g_str_equal);
+        ts.order = g_sequence_new (nullptr);
+    }
+
     /* Not in the list -> add it */
     new_ = g_new0 (tree_entry, 1);
-    if (current == nullptr)
+    new_->name = vfs_path_clone (name);
+
+    /* Search for the correct place */
+    if (ts.tree_last == nullptr || pathcmp (ts.tree_last->name, name) < 0)
     {
-        /* Append to the end of the list */
-        if (ts.tree_first == nullptr)
-        {
-            /* Empty list */
-            ts.tree_first = new_;
-            new_->prev = nullptr;
-        }
-        else
-        {
-            if (old != nullptr)
-                old->next = new_;
-            new_->prev = old;
-        }
-        new_->next = nullptr;
-        ts.tree_last = new_;
+        /* Append to the end of the list, trees are loaded in this way */
+        new_->position = g_sequence_append (ts.order, new_);
+        old = ts.tree_last;
     }
     else
     {
-        /* Insert in to the middle of the list */
-        new_->prev = old;
-        if (old != nullptr)
-        {
-            /* Yes, in the middle */
-            new_->next = old->next;
-            old->next = new_;
-        }
-        else
-        {
-            /* Nope, in the beginning of the list */
-            new_->next = ts.tree_first;
-            ts.tree_first = new_;
-        }
-        new_->next->prev = new_;
+        new_->position = g_sequence_insert_sorted (ts.order, new_, tree_entry_cmp, nullptr);
+        if (!g_sequence_iter_is_begin (new_->position))
+            old = (tree_entry *) g_sequence_get (g_sequence_iter_prev (new_->position));
     }
 
+    g_hash_table_insert (ts.paths, (gpointer) vfs_path_as_str (new_->name), new_);
+
+    /* Insert after the previous entry */
+    new_->prev = old;
+    if (old != nullptr)
+    {
+        new_->next = old->next;
+        old->next = new_;
+    }
+    else
+    {
+        new_->next = ts.tree_first;
+        ts.tree_first = new_;
+    }
+
+    if (new_->next != nullptr)
+        new_->next->prev = new_;
+    else
+        ts.tree_last = new_;
+
     /* Calculate attributes */
-    new_->name = vfs_path_clone (name);
     new_->sublevel = vfs_path_tokens_count (new_->name);
 
     {
@@ -519,6 +620,9 @@ remove_entry (tree_entry * entry)
     else
         ts.tree_last = entry->prev;
 
+    g_hash_table_remove (ts.paths, vfs_path_as_str (entry->name));
+    g_sequence_remove (entry->position);
+
     /* Free the memory used by the entry */
     vfs_path_free (entry->name);
     g_free (entry);
@@ -595,14 +699,10 @@ should_skip_directory (const vfs_path_t * vpath)
 tree_entry *
 tree_store_whereis (const vfs_path_t * name)
 {
-    tree_entry *current;
-    int flag = -1;
-
-    for (current = ts.tree_first;
-         current != nullptr && (flag = pathcmp (current->name, name)) < 0; current = current->next)
-        ;
+    if (ts.paths == nullptr)
+        return nullptr;
 
-    return flag == 0 ? current : nullptr;
+    return (tree_entry *) g_hash_table_lookup (ts.paths, vfs_path_as_str (name));
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -730,7 +830,6 @@ tree_store_mark_checked (const char *subname)
 {
     vfs_path_t *name;
     tree_entry *current, *base;
-    int flag = 1;
     const char *cname;
 
     if (!ts.loaded)
@@ -750,11 +849,8 @@ tree_store_mark_checked (const char *subname)
         name = vfs_path_append_new (ts.check_name, subname, (char *) nullptr);
 
     /* Search for the subdirectory */
-    for (current = ts.check_start;
-         current != nullptr && (flag = pathcmp (current->name, name)) < 0; current = current->next)
-        ;
-
-    if (flag != 0)
+    current = tree_store_whereis (name);
+    if (current == nullptr)
     {
         /* Doesn't exist -> add it */
         current = tree_store_add_entry (name);
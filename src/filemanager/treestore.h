@@ -29,6 +29,7 @@ typedef struct tree_entry
     bool scanned;           /* Flag: childs scanned or not */
     struct tree_entry *next;    /* Next item in the list */
     struct tree_entry *prev;    /* Previous item in the list */
+    GSequenceIter *position;    /* Position in the ordered index */
 } tree_entry;
 
 struct TreeStore
@@ -36,6 +37,8 @@ struct TreeStore
     tree_entry *tree_first;     /* First entry in the list */
     tree_entry *tree_last;      /* Last entry in the list */
     tree_entry *check_start;    /* Start of checked subdirectories */
+    GSequence *order;           /* Entries sorted in the same order as the list */
+    GHashTable *paths;          /* Entries by full paths of directories */
     vfs_path_t *check_name;
     GList *add_queue_vpath;     /* List of vfs_path_t objects of added directories */
     bool loaded;
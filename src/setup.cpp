@@ -42,12 +42,18 @@
 #include "lib/util.h"
 #include "lib/widget.h"
 
+#ifdef ENABLE_VFS_NET
+#include "lib/vfs/dircache.h"
+#endif
 #ifdef ENABLE_VFS_FTP
 #include "src/vfs/ftpfs/ftpfs.h"
 #endif
 #ifdef ENABLE_VFS_FISH
 #include "src/vfs/fish/fish.h"
 #endif
+#ifdef ENABLE_VFS_SFTP
+#include "src/vfs/sftpfs/init.h"
+#endif
 
 #ifdef HAVE_CHARSET
 #include "lib/charsets.h"
@@ -325,6 +331,9 @@ static const struct
     { "file_op_compute_totals", &file_op_compute_totals },
     { "classic_progressbar", &classic_progressbar },
 #ifdef ENABLE_VFS
+#ifdef ENABLE_VFS_NET
+    { "vfs_persistent_dircache", &vfs_persistent_dircache },
+#endif /* ENABLE_VFS_NET */
 #ifdef ENABLE_VFS_FTP
     { "use_netrc", &ftpfs_use_netrc },
     { "ftpfs_always_use_proxy", &ftpfs_always_use_proxy },
@@ -332,6 +341,7 @@ static const struct
     { "ftpfs_use_passive_connections_over_proxy", &ftpfs_use_passive_connections_over_proxy },
     { "ftpfs_use_unix_list_options", &ftpfs_use_unix_list_options },
     { "ftpfs_first_cd_then_ls", &ftpfs_first_cd_then_ls },
+    { "ftpfs_use_mlsd", &ftpfs_use_mlsd },
     { "ignore_ftp_chattr_errors", & ftpfs_ignore_chattr_errors} ,
 #endif /* ENABLE_VFS_FTP */
 #endif /* ENABLE_VFS */
@@ -387,6 +397,9 @@ static const struct
 #ifdef ENABLE_VFS_FISH
     { "fish_directory_timeout", &fish_directory_timeout },
 #endif /* ENABLE_VFS_FISH */
+#ifdef ENABLE_VFS_SFTP
+    { "sftpfs_window_size", &sftpfs_window_size },
+#endif /* ENABLE_VFS_SFTP */
 #endif /* ENABLE_VFS */
     /* option_tab_spacing is used in internal viewer */
     { "editor_tab_spacing", &option_tab_spacing },
@@ -1267,6 +1280,7 @@ done_setup (void)
 
     done_hotlist ();
     done_panelize ();
+    dir_list_done ();
     /*    directory_history_free (); */
 
 #ifdef HAVE_CHARSET
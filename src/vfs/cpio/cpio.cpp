@@ -45,6 +45,7 @@
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_rmstamp */
+#include "lib/vfs/arcindex.h"
 
 #include "cpio.h"
 
@@ -224,12 +225,9 @@ cpio_free_archive (struct vfs_class *me, struct vfs_s_super *super)
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_path_t * vpath)
+cpio_open_cpio_file (struct vfs_s_super *super, const vfs_path_t * vpath)
 {
     int fd, type;
-    cpio_super_t *arch;
-    mode_t mode;
-    struct vfs_s_inode *root;
 
     fd = mc_open (vpath, O_RDONLY);
     if (fd == -1)
@@ -238,10 +236,6 @@ cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_
         return -1;
     }
 
-    super->name = g_strdup (vfs_path_as_str (vpath));
-    arch = CPIO_SUPER (super);
-    mc_stat (vpath, &arch->st);
-
     type = get_compression_type (fd, super->name);
     if (type == COMPRESSION_NONE)
         mc_lseek (fd, 0, SEEK_SET);
@@ -259,13 +253,27 @@ cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_
         {
             message (D_ERROR, MSG_ERROR, _("Cannot open cpio archive\n%s"), s);
             g_free (s);
-            MC_PTR_FREE (super->name);
             return -1;
         }
         g_free (s);
     }
 
-    arch->fd = fd;
+    CPIO_SUPER (super)->fd = fd;
+
+    CPIO_SEEK_SET (super, 0);
+
+    return fd;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+cpio_new_root (struct vfs_class *me, struct vfs_s_super *super)
+{
+    cpio_super_t *arch = CPIO_SUPER (super);
+    mode_t mode;
+    struct vfs_s_inode *root;
+
     mode = arch->st.st_mode & 07777;
     mode |= (mode & 0444) >> 2; /* set eXec where Read is */
     mode |= S_IFDIR;
@@ -277,10 +285,6 @@ cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_
     root->st.st_dev = VFS_SUBCLASS (me)->rdev++;
 
     super->root = root;
-
-    CPIO_SEEK_SET (super, 0);
-
-    return fd;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -769,9 +773,18 @@ static int
 cpio_open_archive (struct vfs_s_super *super, const vfs_path_t * vpath,
                    const vfs_path_element_t * vpath_element)
 {
-    (void) vpath_element;
+    cpio_super_t *arch = CPIO_SUPER (super);
+    int result;
 
-    if (cpio_open_cpio_file (vpath_element->clazz, super, vpath) == -1)
+    super->name = g_strdup (vfs_path_as_str (vpath));
+    result = mc_stat (vpath, &arch->st);
+    cpio_new_root (vpath_element->clazz, super);
+
+    /* If the tree is taken from the index, archive is opened when some file is read from it */
+    if (result == 0 && vfs_s_index_load (super, nullptr, &arch->st, nullptr))
+        return 0;
+
+    if (cpio_open_cpio_file (super, vpath) == -1)
         return -1;
 
     while (true)
@@ -800,6 +813,9 @@ cpio_open_archive (struct vfs_s_super *super, const vfs_path_t * vpath,
         break;
     }
 
+    /* The whole archive is read */
+    vfs_s_index_save (super, nullptr, &arch->st, nullptr);
+
     return 0;
 }
 
@@ -871,11 +887,27 @@ cpio_read (void *fh, char *buffer, size_t count)
 static int
 cpio_fh_open (struct vfs_class *me, vfs_file_handler_t * fh, int flags, mode_t mode)
 {
-    (void) fh;
+    struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
+
     (void) mode;
 
     if ((flags & O_ACCMODE) != O_RDONLY)
         ERRNOR (EROFS, -1);
+
+    /* The tree was taken from the index, open archive now */
+    if (CPIO_SUPER (super)->fd == -1)
+    {
+        vfs_path_t *vpath;
+        int fd;
+
+        vpath = vfs_path_from_str (super->name);
+        fd = cpio_open_cpio_file (super, vpath);
+        vfs_path_free (vpath);
+
+        if (fd == -1)
+            return -1;
+    }
+
     return 0;
 }
 
@@ -62,6 +62,7 @@
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_rmstamp */
+#include "lib/vfs/arcindex.h"
 
 #include "extfs.h"
 
@@ -85,7 +86,7 @@ struct extfs_super_t
     int fstype;
     char *local_name;
     struct stat local_stat;
-    dev_t rdev;
+    struct stat st;             /* stat of archive file */
 };
 
 typedef struct
@@ -200,8 +201,7 @@ extfs_generate_entry (struct extfs_super_t *archive, const char *name, struct vf
     struct vfs_s_inode *inode;
     struct vfs_s_entry *entry;
 
-    st.st_ino = VFS_SUPER (archive)->ino_usage++;
-    st.st_dev = archive->rdev;
+    /* st_ino and st_dev are assigned by vfs_s_new_inode() like for inodes of cached index */
     myumask = umask (022);
     umask (myumask);
     st.st_mode = mode & ~myumask;
@@ -257,8 +257,6 @@ extfs_find_entry_int (struct vfs_s_inode *dir, char *name, GSList * list, int fl
             pent = pent->dir->ent;
         else
         {
-            GList *pl;
-
             pent = extfs_resolve_symlinks_int (pent, list);
             if (pent == nullptr)
             {
@@ -274,8 +272,7 @@ extfs_find_entry_int (struct vfs_s_inode *dir, char *name, GSList * list, int fl
             }
 
             pdir = pent;
-            pl = g_queue_find_custom (pent->ino->subdir, p, vfs_s_entry_compare);
-            pent = pl != nullptr ? VFS_ENTRY (pl->data) : nullptr;
+            pent = vfs_s_subdir_find (pent->ino, p);
             if (pent != nullptr && q + 1 > name_end)
             {
                 /* Hack: I keep the original semanthic unless q+1 would break in the strchr */
@@ -372,11 +369,18 @@ extfs_free_archive (struct vfs_class *me, struct vfs_s_super *psup)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Create superblock of archive and start the helper to list the archive.
+ * The helper isn't started if the tree of archive is loaded from the cache of indexes.
+ *
+ * @return output of helper, nullptr if the tree is loaded from the cache or on error.
+ *         In the last case, *pparc isn't changed.
+ */
+
 static FILE *
 extfs_open_archive (int fstype, const char *name, struct extfs_super_t **pparc)
 {
     const extfs_plugin_info_t *info;
-    static dev_t archive_counter = 0;
     FILE *result = nullptr;
     mode_t mode;
     char *cmd;
@@ -410,26 +414,8 @@ extfs_open_archive (int fstype, const char *name, struct extfs_super_t **pparc)
                        vfs_path_get_last_path_str (local_name_vpath) : tmp, (char *) nullptr);
     g_free (tmp);
 
-    open_error_pipe ();
-    result = popen (cmd, "r");
-    g_free (cmd);
-    if (result == nullptr)
-    {
-        close_error_pipe (D_ERROR, nullptr);
-        if (local_name_vpath != nullptr)
-        {
-            mc_ungetlocalcopy (name_vpath, local_name_vpath, false);
-            vfs_path_free (local_name_vpath);
-        }
-        goto ret;
-    }
-
-#ifdef ___QNXNTO__
-    setvbuf (result, nullptr, _IONBF, 0);
-#endif
-
     current_archive = extfs_super_new (vfs_extfs_ops, name, local_name_vpath, fstype);
-    current_archive->rdev = archive_counter++;
+    current_archive->st = mystat;
     vfs_path_free (local_name_vpath);
 
     mode = mystat.st_mode & 07777;
@@ -450,6 +436,31 @@ extfs_open_archive (int fstype, const char *name, struct extfs_super_t **pparc)
     root_entry->ino->ent = root_entry;
     VFS_SUPER (current_archive)->root = root_entry->ino;
 
+    /* listing of archive may take a long time: helpers usually run an archiver for it */
+    if (info->need_archive
+        && vfs_s_index_load (VFS_SUPER (current_archive), info->prefix, &current_archive->st,
+                             nullptr))
+    {
+        g_free (cmd);
+        *pparc = current_archive;
+        goto ret;
+    }
+
+    open_error_pipe ();
+    result = popen (cmd, "r");
+    g_free (cmd);
+    if (result == nullptr)
+    {
+        close_error_pipe (D_ERROR, nullptr);
+        /* local copy of archive is released too */
+        VFS_SUPER (current_archive)->me->free (VFS_SUPER (current_archive));
+        goto ret;
+    }
+
+#ifdef ___QNXNTO__
+    setvbuf (result, nullptr, _IONBF, 0);
+#endif
+
     *pparc = current_archive;
 
   ret:
@@ -515,13 +526,13 @@ extfs_read_archive (FILE * extfsd, struct extfs_super_t *current_archive)
                 {
                     entry = extfs_entry_new (super->me, p, pent->ino);
                     entry->dir = pent->ino;
-                    g_queue_push_tail (pent->ino->subdir, entry);
+                    vfs_s_subdir_append (pent->ino, entry);
                 }
                 else
                 {
                     entry = extfs_entry_new (super->me, p, super->root);
                     entry->dir = super->root;
-                    g_queue_push_tail (super->root->subdir, entry);
+                    vfs_s_subdir_append (super->root, entry);
                 }
 
                 if (!S_ISLNK (hstat.st_mode) && (current_link_name != nullptr))
@@ -540,9 +551,8 @@ extfs_read_archive (FILE * extfsd, struct extfs_super_t *current_archive)
                 {
                     struct stat st;
 
-                    st.st_ino = super->ino_usage++;
+                    /* st_ino and st_dev are assigned by vfs_s_new_inode() */
                     st.st_nlink = 1;
-                    st.st_dev = current_archive->rdev;
                     st.st_mode = hstat.st_mode;
 #ifdef HAVE_STRUCT_STAT_ST_RDEV
                     st.st_rdev = hstat.st_rdev;
@@ -618,7 +628,12 @@ extfs_open_and_read_archive (int fstype, const char *name, struct extfs_super_t
     extfsd = extfs_open_archive (fstype, name, archive);
     a = *archive;
 
-    if (extfsd == nullptr)
+    if (extfsd == nullptr && a != nullptr)
+    {
+        /* the tree is loaded from the cache */
+        result = 0;
+    }
+    else if (extfsd == nullptr)
     {
         const extfs_plugin_info_t *info;
 
@@ -637,8 +652,14 @@ extfs_open_and_read_archive (int fstype, const char *name, struct extfs_super_t
     }
     else
     {
+        const extfs_plugin_info_t *info;
+
         close_error_pipe (D_ERROR, nullptr);
         result = 0;
+
+        info = &g_array_index (extfs_plugins, extfs_plugin_info_t, fstype);
+        if (info->need_archive)
+            vfs_s_index_save (VFS_SUPER (a), info->prefix, &a->st, nullptr);
     }
 
     return result;
@@ -792,13 +813,16 @@ extfs_get_archive_name (const struct extfs_super_t *archive)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** Don't pass localname as nullptr */
+/**
+ * Run command of helper. Don't pass file and localname as nullptr.
+ *
+ * @param error how to show error output of helper, see close_error_pipe()
+ */
 
 static int
-extfs_cmd (const char *str_extfs_cmd, const struct extfs_super_t *archive,
-           const struct vfs_s_entry *entry, const char *localname)
+extfs_cmd_run (const char *str_extfs_cmd, const struct extfs_super_t *archive, const char *file,
+               const char *localname, int error)
 {
-    char *file;
     char *quoted_file;
     char *quoted_localname;
     char *archive_name, *quoted_archive_name;
@@ -806,9 +830,7 @@ extfs_cmd (const char *str_extfs_cmd, const struct extfs_super_t *archive,
     char *cmd;
     int retval;
 
-    file = extfs_get_path_from_entry (entry);
     quoted_file = name_quote (file, false);
-    g_free (file);
 
     archive_name = extfs_get_archive_name (archive);
     quoted_archive_name = name_quote (archive_name, false);
@@ -824,7 +846,33 @@ extfs_cmd (const char *str_extfs_cmd, const struct extfs_super_t *archive,
     open_error_pipe ();
     retval = my_system (EXECUTE_AS_SHELL, mc_global.shell->path, cmd);
     g_free (cmd);
-    close_error_pipe (D_ERROR, nullptr);
+    close_error_pipe (error, nullptr);
+    return retval;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Don't pass localname as nullptr */
+
+static int
+extfs_cmd (const char *str_extfs_cmd, const struct extfs_super_t *archive,
+           const struct vfs_s_entry *entry, const char *localname)
+{
+    char *file;
+    int retval;
+
+    file = extfs_get_path_from_entry (entry);
+    retval = extfs_cmd_run (str_extfs_cmd, archive, file, localname, D_ERROR);
+    g_free (file);
+
+    /* all commands except copyout change the archive */
+    if (strcmp (str_extfs_cmd, " copyout ") != 0)
+    {
+        const extfs_plugin_info_t *info;
+
+        info = &g_array_index (extfs_plugins, extfs_plugin_info_t, archive->fstype);
+        vfs_s_index_forget (VFS_SUPER (archive), info->prefix);
+    }
+
     return retval;
 }
 
@@ -856,6 +904,251 @@ extfs_run (const vfs_path_t * vpath)
     g_free (cmd);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Remove file or directory with all its contents, errors are ignored */
+
+static void
+extfs_remove_tree (const char *path)
+{
+    struct stat st;
+
+    if (lstat (path, &st) == 0 && S_ISDIR (st.st_mode))
+    {
+        GDir *dir;
+
+        dir = g_dir_open (path, 0, nullptr);
+        if (dir != nullptr)
+        {
+            const char *name;
+
+            while ((name = g_dir_read_name (dir)) != nullptr)
+            {
+                char *child;
+
+                child = g_build_filename (path, name, (char *) nullptr);
+                extfs_remove_tree (child);
+                g_free (child);
+            }
+
+            g_dir_close (dir);
+        }
+
+        rmdir (path);
+    }
+    else
+        unlink (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check that path inside archive can be used as relative path of extracted file:
+ * it doesn't contain ".." and other special components.
+ */
+
+static bool
+extfs_is_plain_path (const char *path)
+{
+    char **parts;
+    bool ret = (strchr (path, '\n') == nullptr);
+    int i;
+
+    parts = g_strsplit (path, PATH_SEP_STR, -1);
+    for (i = 0; ret && parts[i] != nullptr; i++)
+        ret = !DIR_IS_DOT (parts[i]) && !DIR_IS_DOTDOT (parts[i]) && parts[i][0] != '\0';
+    g_strfreev (parts);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether file extracted by helper is a regular file inside the directory of extraction.
+ * Every component of the path is checked by lstat(): symbolic link to a directory created
+ * by helper must not redirect the access outside the directory.
+ *
+ * @param dir_name directory of extraction
+ * @param path path of file relative to dir_name, without special components
+ *
+ * @return full name of extracted file, or nullptr. Should be freed by g_free()
+ */
+
+static char *
+extfs_get_extracted (const char *dir_name, const char *path)
+{
+    char **parts;
+    char *name;
+    int i;
+
+    parts = g_strsplit (path, PATH_SEP_STR, -1);
+    name = g_strdup (dir_name);
+
+    for (i = 0; name != nullptr && parts[i] != nullptr; i++)
+    {
+        struct stat st;
+        char *next;
+
+        next = g_build_filename (name, parts[i], (char *) nullptr);
+        g_free (name);
+        name = next;
+
+        if (lstat (name, &st) != 0
+            || (parts[i + 1] != nullptr ? !S_ISDIR (st.st_mode) : !S_ISREG (st.st_mode)))
+            MC_PTR_FREE (name);
+    }
+
+    g_strfreev (parts);
+
+    return name;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Extract several files of archive by one run of helper: "copyoutlist archive listfile dir".
+ * Paths of files are written to listfile, one per line. Helper extracts them into the
+ * directory dir keeping the paths. Extracted files become local copies of entries,
+ * so files aren't extracted again by copyout when they are opened.
+ *
+ * The command is optional: if the helper doesn't support it, files are extracted one by one
+ * as usual.
+ */
+
+static void
+extfs_copyout_list (struct extfs_super_t *archive, GPtrArray * entries, const GString * list)
+{
+    char *dir_name, *list_name;
+    vfs_path_t *list_vpath;
+    int fd;
+    ssize_t written;
+    guint i;
+
+    dir_name = g_build_filename (mc_tmpdir (), "extfs-XXXXXX", (char *) nullptr);
+    if (g_mkdtemp (dir_name) == nullptr)
+    {
+        g_free (dir_name);
+        return;
+    }
+
+    fd = vfs_mkstemps (&list_vpath, "extfs", "list");
+    if (fd == -1)
+    {
+        rmdir (dir_name);
+        g_free (dir_name);
+        return;
+    }
+
+    list_name = g_strdup (vfs_path_get_last_path_str (list_vpath));
+    vfs_path_free (list_vpath);
+
+    written = write (fd, list->str, list->len);
+    close (fd);
+
+    /* helper may not support the command: then files are extracted by copyout silently */
+    if (written == (ssize_t) list->len
+        && extfs_cmd_run (" copyoutlist ", archive, list_name, dir_name, -1) == 0)
+    {
+        for (i = 0; i < entries->len; i++)
+        {
+            struct vfs_s_entry *entry = VFS_ENTRY (g_ptr_array_index (entries, i));
+            char *path, *extracted = nullptr;
+
+            /* the same file may be listed twice via symlinks */
+            if (entry->ino->localname == nullptr)
+            {
+                path = extfs_get_path_from_entry (entry);
+                extracted = extfs_get_extracted (dir_name, path);
+                g_free (path);
+            }
+
+            if (extracted != nullptr)
+            {
+                vfs_path_t *local_vpath;
+                int local_handle;
+
+                local_handle = vfs_mkstemps (&local_vpath, "extfs", entry->name);
+                if (local_handle != -1)
+                {
+                    const char *local_name;
+
+                    close (local_handle);
+                    local_name = vfs_path_get_last_path_str (local_vpath);
+
+                    /* local copies are private like ones created by copyout */
+                    if (rename (extracted, local_name) == 0 && chmod (local_name, 0600) == 0)
+                        entry->ino->localname = g_strdup (local_name);
+                    else
+                        unlink (local_name);
+
+                    vfs_path_free (local_vpath);
+                }
+            }
+
+            g_free (extracted);
+        }
+    }
+
+    unlink (list_name);
+    g_free (list_name);
+    extfs_remove_tree (dir_name);
+    g_free (dir_name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Extract files of directory by one run of helper before they are read one by one */
+
+static void
+extfs_prefetch (const vfs_path_t * vpath, const GPtrArray * names)
+{
+    struct extfs_super_t *archive = nullptr;
+    char *q;
+    struct vfs_s_entry *dir;
+    GPtrArray *entries;
+    GString *list;
+    guint i;
+
+    q = extfs_get_path (vpath, &archive, FL_NONE);
+    if (q == nullptr)
+        return;
+    dir = extfs_find_entry (VFS_SUPER (archive)->root, q, FL_NONE);
+    if (dir != nullptr)
+        dir = extfs_resolve_symlinks (dir);
+    if (dir == nullptr || !S_ISDIR (dir->ino->st.st_mode))
+        return;
+
+    entries = g_ptr_array_new ();
+    list = g_string_new ("");
+
+    for (i = 0; i < names->len; i++)
+    {
+        struct vfs_s_entry *entry;
+        char *name, *path;
+
+        name = g_strdup ((const char *) g_ptr_array_index (names, i));
+        entry = extfs_find_entry (dir->ino, name, FL_NONE);
+        g_free (name);
+        if (entry != nullptr)
+            entry = extfs_resolve_symlinks (entry);
+        if (entry == nullptr || !S_ISREG (entry->ino->st.st_mode)
+            || entry->ino->localname != nullptr)
+            continue;
+
+        path = extfs_get_path_from_entry (entry);
+        if (extfs_is_plain_path (path))
+        {
+            g_ptr_array_add (entries, entry);
+            g_string_append (list, path);
+            g_string_append_c (list, '\n');
+        }
+        g_free (path);
+    }
+
+    /* one file is extracted by copyout as fast as by copyoutlist */
+    if (entries->len > 1)
+        extfs_copyout_list (archive, entries, list);
+
+    g_string_free (list, TRUE);
+    g_ptr_array_free (entries, TRUE);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void *
@@ -1536,14 +1829,17 @@ extfs_done (struct vfs_class *me)
 static int
 extfs_setctl (const vfs_path_t * vpath, int ctlop, void *arg)
 {
-    (void) arg;
-
-    if (ctlop == VFS_SETCTL_RUN)
+    switch (ctlop)
     {
+    case VFS_SETCTL_RUN:
         extfs_run (vpath);
         return 1;
+    case VFS_SETCTL_PREFETCH:
+        extfs_prefetch (vpath, (const GPtrArray *) arg);
+        return 1;
+    default:
+        return 0;
     }
-    return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
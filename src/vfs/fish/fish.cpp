@@ -117,6 +117,9 @@ int fish_directory_timeout = 900;
 #define FISH_HAVE_DATE_MDYT   32
 #define FISH_HAVE_TAIL        64
 
+/* number of operations sent at once by fish_batch() */
+#define FISH_BATCH_SIZE 256
+
 #define FISH_SUPER(super) ((fish_super_t *) (super))
 #define FISH_FILE_HANDLER(fh) ((fish_file_handler_t *) fh)
 
@@ -1630,6 +1633,142 @@ fish_rmdir (const vfs_path_t * vpath)
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append script of one operation of batch to command.
+ *
+ * @return false if operation should not be sent
+ */
+
+static bool
+fish_batch_append (struct vfs_s_super *super, GString * command, const char *dir,
+                   const vfs_batch_t * op)
+{
+    fish_super_t *fish_super = FISH_SUPER (super);
+    char *path, *rpath;
+
+    if (*dir == '\0')
+        path = g_strdup (op->name);
+    else
+        path = g_strconcat (dir, PATH_SEP_STR, op->name, (char *) nullptr);
+    rpath = strutils_shell_escape (path);
+    g_free (path);
+
+    g_string_append (command, fish_super->scr_env);
+
+    switch (op->op)
+    {
+    case VFS_BATCH_UNLINK:
+        g_string_append_printf (command, "FISH_FILENAME=%s;\n", rpath);
+        g_string_append (command, fish_super->scr_unlink);
+        break;
+
+    case VFS_BATCH_CHMOD:
+        g_string_append_printf (command, "FISH_FILENAME=%s FISH_FILEMODE=%4.4o;\n", rpath,
+                                (unsigned int) (op->mode & 07777));
+        g_string_append (command, fish_super->scr_chmod);
+        break;
+
+    case VFS_BATCH_CHOWN:
+        {
+            struct passwd *pw;
+            struct group *gr;
+
+            /* like fish_chown(): ignore unknown user and group */
+            pw = getpwuid (op->uid);
+            gr = pw == nullptr ? nullptr : getgrgid (op->gid);
+            if (gr == nullptr)
+            {
+                g_free (rpath);
+                return false;
+            }
+
+            g_string_append_printf (command,
+                                    "FISH_FILENAME=%s FISH_FILEOWNER=%s FISH_FILEGROUP=%s;\n",
+                                    rpath, pw->pw_name, gr->gr_name);
+            g_string_append (command, fish_super->scr_chown);
+            break;
+        }
+
+    case VFS_BATCH_MKDIR:
+        g_string_append_printf (command, "FISH_FILENAME=%s;\n", rpath);
+        g_string_append (command, fish_super->scr_mkdir);
+        break;
+
+    default:
+        g_free (rpath);
+        return false;
+    }
+
+    g_free (rpath);
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Do operations on files of directory by scripts sent at once. Each script prints
+ * its own reply, so replies are read in order of operations after whole chunk is sent.
+ */
+
+static int
+fish_batch (struct vfs_class *me, struct vfs_s_super *super, const char *dir, GArray * ops)
+{
+    int r = COMPLETE;
+    guint first, i;
+
+    for (first = 0; first < ops->len; first = i)
+    {
+        GString *command;
+        guint sent = 0;
+
+        command = g_string_sized_new (BUF_8K);
+
+        for (i = first; i < ops->len && sent < FISH_BATCH_SIZE; i++)
+        {
+            vfs_batch_t *op = &g_array_index (ops, vfs_batch_t, i);
+
+            /* -1 means reply is expected */
+            op->error = 0;
+            if (r != COMPLETE)
+                op->error = E_REMOTE;
+            else if (fish_batch_append (super, command, dir, op))
+            {
+                op->error = -1;
+                sent++;
+            }
+        }
+
+        if (sent != 0)
+            r = fish_command (me, super, NONE, command->str, command->len);
+
+        g_string_free (command, true);
+
+        for (; first < i; first++)
+        {
+            vfs_batch_t *op = &g_array_index (ops, vfs_batch_t, first);
+            int reply = r;
+
+            if (op->error != -1)
+                continue;
+
+            if (r == COMPLETE)
+            {
+                reply = fish_get_reply (me, FISH_SUPER (super)->sockr, nullptr, 0);
+                /* connection is lost: don't wait for the rest of replies */
+                if (reply != COMPLETE && reply != ERROR)
+                    r = reply;
+            }
+
+            op->error = reply == COMPLETE ? 0 : E_REMOTE;
+        }
+    }
+
+    vfs_stamp_create (vfs_fish_ops, super);
+    vfs_s_invalidate (me, super);
+
+    return 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static vfs_file_handler_t *
@@ -1749,7 +1888,7 @@ vfs_init_fish (void)
 {
     tcp_init ();
 
-    vfs_init_subclass (&fish_subclass, "fish", VFSF_REMOTE | VFSF_USETMP, "sh");
+    vfs_init_subclass (&fish_subclass, "fish", VFSF_REMOTE | VFSF_USETMP | VFSF_DIRCACHE, "sh");
     vfs_fish_ops->fill_names = fish_fill_names;
     vfs_fish_ops->stat = fish_stat;
     vfs_fish_ops->lstat = fish_lstat;
@@ -1776,6 +1915,7 @@ vfs_init_fish (void)
     fish_subclass.linear_start = fish_linear_start;
     fish_subclass.linear_read = fish_linear_read;
     fish_subclass.linear_close = fish_linear_close;
+    fish_subclass.batch = fish_batch;
     vfs_register_class (vfs_fish_ops);
 }
 
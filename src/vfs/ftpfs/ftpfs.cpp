@@ -133,6 +133,9 @@ bool ftpfs_use_unix_list_options = true;
 /* First "CWD <path>", then "LIST -la ." */
 bool ftpfs_first_cd_then_ls = true;
 
+/* Use "MLSD <path>" to get directory listings if server supports it */
+bool ftpfs_use_mlsd = true;
+
 /* Use the ~/.netrc */
 bool ftpfs_use_netrc = true;
 
@@ -183,6 +186,9 @@ bool ftpfs_ignore_chattr_errors = true;
 #define TYPE_UNKNOWN -1
 
 #define ABORT_TIMEOUT (5 * G_USEC_PER_SEC)
+
+/* how many times broken download is resumed without any progress */
+#define RESUME_ATTEMPTS 3
 /*** file scope type declarations ****************************************************************/
 
 #ifndef HAVE_SOCKLEN_T
@@ -222,6 +228,7 @@ typedef struct
                                  */
     bool ctl_connection_busy;
     char *current_dir;
+    bool use_mlsd;              /* server supports MLSD command */
 } ftp_super_t;
 
 typedef struct
@@ -230,6 +237,7 @@ typedef struct
 
     int sock;
     bool append;
+    int resume_attempts;        /* attempts to resume download since the last received data */
 } ftp_file_handler_t;
 
 /*** file scope variables ************************************************************************/
@@ -951,6 +959,34 @@ ftpfs_open_socket (struct vfs_class *me, struct vfs_s_super *super)
     return my_socket;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Ask server about supported extensions of protocol (RFC 2389) */
+
+static void
+ftpfs_get_features (struct vfs_class *me, struct vfs_s_super *super)
+{
+    ftp_super_t *ftp_super = FTP_SUPER (super);
+    char answer[BUF_1K];
+
+    if (ftpfs_command (me, super, NONE, "%s", "FEAT") != COMPLETE)
+        return;
+
+    /* 211-Features:
+        MLST type*;size*;modify*;
+       211 End */
+    while (vfs_s_get_line (me, ftp_super->sock, answer, sizeof (answer), '\n') != 0)
+    {
+        if (g_ascii_isdigit (answer[0]))
+        {
+            /* the last line of reply or error */
+            if (answer[3] != '-')
+                break;
+        }
+        else if (g_ascii_strncasecmp (answer, " MLST", 5) == 0)
+            ftp_super->use_mlsd = true;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static int
@@ -1005,6 +1041,9 @@ ftpfs_open_archive_int (struct vfs_class *me, struct vfs_s_super *super)
     }
     while (retry_seconds != 0);
 
+    if (ftpfs_use_mlsd)
+        ftpfs_get_features (me, super);
+
     ftp_super->current_dir = ftpfs_get_current_directory (me, super);
     if (ftp_super->current_dir == nullptr)
         ftp_super->current_dir = g_strdup (PATH_SEP_STR);
@@ -1383,7 +1422,7 @@ ftpfs_initconn (struct vfs_class *me, struct vfs_s_super *super)
 
 static int
 ftpfs_open_data_connection (struct vfs_class *me, struct vfs_s_super *super, const char *cmd,
-                            const char *remote, int isbinary, int reget)
+                            const char *remote, int isbinary, off_t reget)
 {
     ftp_super_t *ftp_super = FTP_SUPER (super);
     int s, j, data;
@@ -1404,7 +1443,7 @@ ftpfs_open_data_connection (struct vfs_class *me, struct vfs_s_super *super, con
 
     if (reget > 0)
     {
-        j = ftpfs_command (me, super, WAIT_REPLY, "REST %d", reget);
+        j = ftpfs_command (me, super, WAIT_REPLY, "REST %" PRIuMAX, (uintmax_t) reget);
         if (j != CONTINUE)
         {
             close (s);
@@ -1721,6 +1760,85 @@ resolve_symlink (struct vfs_class *me, struct vfs_s_super *super, struct vfs_s_i
 }
 #endif
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read directory by MLSD command. Unlike LIST, its output has the same format on all servers.
+ *
+ * @return 0 on success, -1 on error, 1 if directory should be read by LIST
+ */
+
+static int
+ftpfs_dir_load_mlsd (struct vfs_class *me, struct vfs_s_inode *dir, const char *remote_path)
+{
+    struct vfs_s_super *super = dir->super;
+    ftp_super_t *ftp_super = FTP_SUPER (super);
+    int sock;
+
+    vfs_print_message (_("ftpfs: Reading FTP directory %s..."), remote_path);
+
+    sock = ftpfs_open_data_connection (me, super, "MLSD", remote_path, TYPE_ASCII, 0);
+    if (sock == -1)
+    {
+        if (code == 550)
+            ERRNOR (ENOENT, -1);
+
+        /* command is announced but isn't implemented really */
+        if (code / 100 == ERROR)
+            ftp_super->use_mlsd = false;
+
+        return 1;
+    }
+
+    dir->timestamp = mc_timer_elapsed (mc_global.timer) + ftpfs_directory_timeout * G_USEC_PER_SEC;
+
+    while (true)
+    {
+        struct vfs_s_entry *ent;
+        int i, res;
+        char lc_buffer[BUF_8K] = "\0";
+
+        res = vfs_s_get_line_interruptible (me, lc_buffer, sizeof (lc_buffer), sock);
+        if (res == 0)
+            break;
+
+        if (res == EINTR)
+        {
+            me->verrno = ECONNRESET;
+            close (sock);
+            ftp_super->ctl_connection_busy = false;
+            ftpfs_get_reply (me, ftp_super->sock, nullptr, 0);
+            vfs_print_message (_("%s: failure"), me->name);
+            return (-1);
+        }
+
+        if (me->logfile != nullptr)
+        {
+            fputs (lc_buffer, me->logfile);
+            fputs ("\n", me->logfile);
+            fflush (me->logfile);
+        }
+
+        ent = vfs_s_generate_entry (me, nullptr, dir, 0);
+        i = ent->ino->st.st_nlink;
+
+        if (!ftpfs_parse_mlsd_line (lc_buffer, &ent->ino->st, &ent->name, &ent->ino->linkname))
+            vfs_s_free_entry (me, ent);
+        else
+        {
+            ent->ino->st.st_nlink = i;  /* Ouch, we need to preserve our counts :-( */
+            vfs_s_insert_entry (me, dir, ent);
+        }
+    }
+
+    close (sock);
+    ftp_super->ctl_connection_busy = false;
+    if (ftpfs_get_reply (me, ftp_super->sock, nullptr, 0) != COMPLETE)
+        ERRNOR (E_REMOTE, -1);
+
+    vfs_print_message (_("%s: done."), me->name);
+    return 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static int
@@ -1732,6 +1850,15 @@ ftpfs_dir_load (struct vfs_class *me, struct vfs_s_inode *dir, char *remote_path
     int sock, num_entries = 0;
     bool cd_first;
 
+    if (ftp_super->use_mlsd)
+    {
+        int res;
+
+        res = ftpfs_dir_load_mlsd (me, dir, remote_path);
+        if (res != 1)
+            return res;
+    }
+
     cd_first = ftpfs_first_cd_then_ls || (ftp_super->strict == RFC_STRICT)
         || (strchr (remote_path, ' ') != nullptr);
 
@@ -1986,10 +2113,37 @@ ftpfs_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
         ERRNOR (EACCES, 0);
 
     fh->linear = LS_LINEAR_OPEN;
+    fh->pos = offset;
     FTP_FILE_HANDLER (fh)->append = false;
     return 1;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Continue broken download from the current position of file by REST command.
+ *
+ * @return true if data connection is opened again
+ */
+
+static bool
+ftpfs_linear_resume (struct vfs_class *me, vfs_file_handler_t * fh)
+{
+    ftp_file_handler_t *ftp = FTP_FILE_HANDLER (fh);
+
+    if (ftp->resume_attempts >= RESUME_ATTEMPTS)
+        return false;
+
+    ftp->resume_attempts++;
+    vfs_print_message (_("ftpfs: resuming transfer from %" PRIuMAX), (uintmax_t) fh->pos);
+
+    if (ftpfs_linear_start (me, fh, fh->pos) != 0)
+        return true;
+
+    /* control connection may be lost as well */
+    return ftpfs_reconnect (me, VFS_FILE_HANDLER_SUPER (fh))
+        && ftpfs_linear_start (me, fh, fh->pos) != 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static ssize_t
@@ -1998,6 +2152,7 @@ ftpfs_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, siz
     ssize_t n;
     struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
 
+  again:
     while ((n = read (FH_SOCK, buf, len)) < 0)
     {
         if ((errno == EINTR) && !tty_got_interrupt ())
@@ -2005,16 +2160,39 @@ ftpfs_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, siz
         break;
     }
 
-    if (n < 0)
+    if (n > 0)
+    {
+        fh->pos += n;
+        FTP_FILE_HANDLER (fh)->resume_attempts = 0;
+    }
+    else if (n < 0)
+    {
+        int err = errno;
+
         ftpfs_linear_abort (me, fh);
-    else if (n == 0)
+
+        /* connection is broken: continue from the current position unless user interrupted it */
+        if (err != EINTR && ftpfs_linear_resume (me, fh))
+            goto again;
+
+        errno = err;
+    }
+    else
     {
+        int reply;
+
         FTP_SUPER (super)->ctl_connection_busy = false;
         close (FH_SOCK);
         FH_SOCK = -1;
-        if ((ftpfs_get_reply (me, FTP_SUPER (super)->sock, nullptr, 0) != COMPLETE))
-            ERRNOR (E_REMOTE, -1);
-        return 0;
+        reply = ftpfs_get_reply (me, FTP_SUPER (super)->sock, nullptr, 0);
+        if (reply == COMPLETE)
+            return 0;
+
+        /* transfer is aborted by server (426 and other transient errors) */
+        if (reply == TRANSIENT && ftpfs_linear_resume (me, fh))
+            goto again;
+
+        ERRNOR (E_REMOTE, -1);
     }
 
     ERRNOR (errno, n);
@@ -2700,7 +2878,8 @@ vfs_init_ftpfs (void)
 {
     tcp_init ();
 
-    vfs_init_subclass (&ftpfs_subclass, "ftpfs", VFSF_NOLINKS | VFSF_REMOTE | VFSF_USETMP, "ftp");
+    vfs_init_subclass (&ftpfs_subclass, "ftpfs",
+                       VFSF_NOLINKS | VFSF_REMOTE | VFSF_USETMP | VFSF_DIRCACHE, "ftp");
     vfs_ftpfs_ops->done = ftpfs_done;
     vfs_ftpfs_ops->fill_names = ftpfs_fill_names;
     vfs_ftpfs_ops->stat = ftpfs_stat;
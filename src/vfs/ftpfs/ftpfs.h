@@ -32,11 +32,14 @@ extern bool ftpfs_use_passive_connections;
 extern bool ftpfs_use_passive_connections_over_proxy;
 extern bool ftpfs_use_unix_list_options;
 extern bool ftpfs_first_cd_then_ls;
+extern bool ftpfs_use_mlsd;
 
 /*** declarations of public functions ************************************************************/
 
 void ftpfs_init_passwd (void);
 void vfs_init_ftpfs (void);
 
+bool ftpfs_parse_mlsd_line (const char *line, struct stat *s, char **filename, char **linkname);
+
 /*** inline functions ****************************************************************************/
 #endif
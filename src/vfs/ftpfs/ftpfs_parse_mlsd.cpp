@@ -0,0 +1,274 @@
+/*
+   Virtual File System: FTP file system: parser of MLSD listings
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: FTP file system: parser of MLSD listings
+ *
+ * Unlike output of LIST command, format of MLSD listing is defined by RFC 3659:
+ *
+ *     fact=value;fact=value; name
+ *
+ * Names of facts are case insensitive. Time of modification is in UTC, so listing
+ * doesn't depend on locale and time zone of server.
+ */
+
+#include <config.h>
+
+#include <stdio.h>              /* sscanf() */
+#include <stdlib.h>             /* strtoul() */
+#include <string.h>
+
+#include "lib/global.h"
+
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/utilvfs.h"    /* vfs_finduid(), vfs_findgid() */
+
+#include "ftpfs.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* symbolic link and its target in proftpd and some other servers */
+#define MLSD_TYPE_SLINK "os.unix=slink:"
+
+/*** file scope type declarations ****************************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+ftpfs_mlsd_fact_is (const char *fact, size_t len, const char *name)
+{
+    return strlen (name) == len && g_ascii_strncasecmp (fact, name, len) == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Parse time in the YYYYMMDDHHMMSS[.sss] format */
+
+static bool
+ftpfs_mlsd_parse_time (const char *value, time_t * t)
+{
+    int year, month, day, hour, minute, second;
+    GDateTime *dt;
+
+    /* cppcheck-suppress invalidscanf */
+    if (sscanf (value, "%4d%2d%2d%2d%2d%2d", &year, &month, &day, &hour, &minute, &second) != 6)
+        return false;
+
+    dt = g_date_time_new_utc (year, month, day, hour, minute, (gdouble) second);
+    if (dt == nullptr)
+        return false;
+
+    *t = (time_t) g_date_time_to_unix (dt);
+    g_date_time_unref (dt);
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Permissions from the "perm" fact if server doesn't tell the UNIX mode */
+
+static mode_t
+ftpfs_mlsd_perm_to_mode (const char *perm, mode_t type)
+{
+    mode_t mode = 0;
+
+    if (perm == nullptr)
+        return S_ISDIR (type) ? 0755 : S_ISLNK (type) ? 0777 : 0644;
+
+    if (S_ISDIR (type))
+    {
+        if (strpbrk (perm, "eElL") != nullptr)
+            mode |= 0555;
+        if (strpbrk (perm, "cCmMpP") != nullptr)
+            mode |= 0200;
+    }
+    else
+    {
+        if (strpbrk (perm, "rR") != nullptr)
+            mode |= 0444;
+        if (strpbrk (perm, "wWaA") != nullptr)
+            mode |= 0200;
+    }
+
+    return mode;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Parse one line of MLSD listing.
+ *
+ * @param line line of listing without the end-of-line characters
+ * @param s stat to fill. Fields those aren't reported by server are not changed
+ * @param filename name of file, should be freed by caller
+ * @param linkname target of symbolic link if server reports it, should be freed by caller
+ *
+ * @return true on success, false if line is invalid or it describes the listed directory itself
+ *         or its parent
+ */
+
+bool
+ftpfs_parse_mlsd_line (const char *line, struct stat *s, char **filename, char **linkname)
+{
+    const char *p = line;
+    const char *type = nullptr, *perm = nullptr, *target = nullptr;
+    size_t type_len = 0, perm_len = 0, target_len = 0;
+    mode_t file_type = S_IFREG;
+    char *name;
+    size_t name_len;
+    bool have_mode = false;
+
+    *filename = nullptr;
+    if (linkname != nullptr)
+        *linkname = nullptr;
+
+    /* facts are finished by space */
+    while (*p != ' ')
+    {
+        const char *semicolon, *eq, *value;
+        size_t len;
+
+        semicolon = strchr (p, ';');
+        if (semicolon == nullptr)
+            return false;
+
+        eq = (const char *) memchr (p, '=', semicolon - p);
+        if (eq == nullptr)
+            return false;
+
+        len = eq - p;
+        value = eq + 1;
+
+        if (ftpfs_mlsd_fact_is (p, len, "type"))
+        {
+            type = value;
+            type_len = semicolon - value;
+        }
+        else if (ftpfs_mlsd_fact_is (p, len, "perm"))
+        {
+            perm = value;
+            perm_len = semicolon - value;
+        }
+        else if (ftpfs_mlsd_fact_is (p, len, "size") || ftpfs_mlsd_fact_is (p, len, "sizd"))
+            s->st_size = (off_t) g_ascii_strtoull (value, nullptr, 10);
+        else if (ftpfs_mlsd_fact_is (p, len, "modify"))
+        {
+            if (ftpfs_mlsd_parse_time (value, &s->st_mtime))
+            {
+                s->st_atime = s->st_ctime = s->st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+                s->st_atim.tv_nsec = s->st_mtim.tv_nsec = s->st_ctim.tv_nsec = 0;
+#endif
+            }
+        }
+        else if (ftpfs_mlsd_fact_is (p, len, "unix.mode"))
+        {
+            s->st_mode = (mode_t) strtoul (value, nullptr, 8) & 07777;
+            have_mode = true;
+        }
+        else if (ftpfs_mlsd_fact_is (p, len, "unix.uid"))
+            s->st_uid = (uid_t) strtoul (value, nullptr, 10);
+        else if (ftpfs_mlsd_fact_is (p, len, "unix.gid"))
+            s->st_gid = (gid_t) strtoul (value, nullptr, 10);
+        else if (ftpfs_mlsd_fact_is (p, len, "unix.owner")
+                 || ftpfs_mlsd_fact_is (p, len, "unix.group"))
+        {
+            char *id;
+
+            id = g_strndup (value, semicolon - value);
+            if (g_ascii_tolower (p[5]) == 'o')
+                s->st_uid = g_ascii_isdigit (*id) ? (uid_t) atol (id) : vfs_finduid (id);
+            else
+                s->st_gid = g_ascii_isdigit (*id) ? (gid_t) atol (id) : vfs_findgid (id);
+            g_free (id);
+        }
+
+        p = semicolon + 1;
+    }
+
+    /* skip the space */
+    p++;
+    name_len = strlen (p);
+    if (name_len != 0 && p[name_len - 1] == '\r')
+        name_len--;
+    if (name_len == 0)
+        return false;
+
+    if (type != nullptr)
+    {
+        if (ftpfs_mlsd_fact_is (type, type_len, "cdir")
+            || ftpfs_mlsd_fact_is (type, type_len, "pdir"))
+            return false;
+
+        if (ftpfs_mlsd_fact_is (type, type_len, "dir"))
+            file_type = S_IFDIR;
+        /* symbolic link without target can't be followed: it is shown as file */
+        else if (type_len > strlen (MLSD_TYPE_SLINK)
+                 && g_ascii_strncasecmp (type, MLSD_TYPE_SLINK, strlen (MLSD_TYPE_SLINK)) == 0)
+        {
+            file_type = S_IFLNK;
+            target = type + strlen (MLSD_TYPE_SLINK);
+            target_len = type_len - strlen (MLSD_TYPE_SLINK);
+        }
+    }
+
+    name = g_strndup (p, name_len);
+    /* names of files of the listed directory only */
+    if (strchr (name, PATH_SEP) != nullptr || DIR_IS_DOT (name) || DIR_IS_DOTDOT (name))
+    {
+        g_free (name);
+        return false;
+    }
+
+    if (!have_mode)
+    {
+        char *perms;
+
+        perms = perm != nullptr ? g_strndup (perm, perm_len) : nullptr;
+        s->st_mode = ftpfs_mlsd_perm_to_mode (perms, file_type);
+        g_free (perms);
+    }
+
+    s->st_mode = (s->st_mode & 07777) | file_type;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    s->st_rdev = 0;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+    s->st_blksize = 512;
+#endif
+    vfs_adjust_stat (s);
+
+    *filename = name;
+    if (linkname != nullptr && target != nullptr)
+        *linkname = g_strndup (target, target_len);
+
+    return true;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -27,6 +27,7 @@
 #include <config.h>
 
 #include <errno.h>
+#include <string.h>             /* memcpy() */
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
@@ -34,13 +35,19 @@
 #include "lib/util.h"
 
 #include "internal.h"
+#include "init.h"
 
 /*** global variables ****************************************************************************/
 
+int sftpfs_window_size = SFTP_DEFAULT_WINDOW_SIZE;
+
 /*** file scope macro definitions ****************************************************************/
 
 #define SFTP_FILE_HANDLER(a) ((sftpfs_file_handler_t *) a)
 
+/* libssh2 splits requests to packets of 30000 bytes: smaller window is useless */
+#define SFTP_MIN_WINDOW_SIZE 32
+
 /*** file scope type declarations ****************************************************************/
 
 typedef struct
@@ -50,6 +57,15 @@ typedef struct
     LIBSSH2_SFTP_HANDLE *handle;
     int flags;
     mode_t mode;
+
+    /* Window of data. libssh2 keeps in flight as many read or write requests as fit
+       in buffer it is given, so small reads and writes of callers are collected here */
+    char *window;
+    size_t window_size;
+    off_t window_offset;        /* offset of window[0] in file */
+    size_t window_len;          /* length of data read ahead or not written yet */
+    size_t window_pos;          /* position of reader in window */
+    bool window_dirty;          /* window contains data to write */
 } sftpfs_file_handler_t;
 
 /*** file scope variables ************************************************************************/
@@ -96,6 +112,117 @@ sftpfs_file__handle_error (sftpfs_super_t * super, int sftp_res, GError ** mcerr
     return 0;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+sftpfs_file__read (vfs_file_handler_t * fh, char *buffer, size_t count, GError ** mcerror)
+{
+    ssize_t rc;
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+    sftpfs_super_t *super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+
+    do
+    {
+        int err;
+
+        rc = libssh2_sftp_read (file->handle, buffer, count);
+        if (rc >= 0)
+            break;
+
+        err = sftpfs_file__handle_error (super, (int) rc, mcerror);
+        if (err < 0)
+            return err;
+    }
+    while (rc == LIBSSH2_ERROR_EAGAIN);
+
+    return rc;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+sftpfs_file__write (vfs_file_handler_t * fh, const char *buffer, size_t count,
+                    GError ** mcerror)
+{
+    ssize_t rc;
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+    sftpfs_super_t *super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+
+    do
+    {
+        int err;
+
+        rc = libssh2_sftp_write (file->handle, buffer, count);
+        if (rc >= 0)
+            break;
+
+        err = sftpfs_file__handle_error (super, (int) rc, mcerror);
+        if (err < 0)
+            return err;
+    }
+    while (rc == LIBSSH2_ERROR_EAGAIN);
+
+    return rc;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Write data collected in the window.
+ *
+ * @param fh      file handler
+ * @param mcerror pointer to the error handler
+ *
+ * @return 0 on success, negative value otherwise. Data are dropped in case of error, and
+ *         file position is moved back to the beginning of them
+ */
+
+static int
+sftpfs_file__flush (vfs_file_handler_t * fh, GError ** mcerror)
+{
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+    size_t written = 0;
+    int ret = 0;
+
+    while (written < file->window_len)
+    {
+        ssize_t rc;
+
+        rc = sftpfs_file__write (fh, file->window + written, file->window_len - written, mcerror);
+        if (rc < 0)
+        {
+            ret = (int) rc;
+            break;
+        }
+
+        written += (size_t) rc;
+    }
+
+    if (ret != 0)
+    {
+        fh->pos = file->window_offset;
+        libssh2_sftp_seek64 (file->handle, fh->pos);
+    }
+
+    file->window_len = 0;
+    file->window_pos = 0;
+    file->window_dirty = false;
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+sftpfs_file__window_init (sftpfs_file_handler_t * file)
+{
+    file->window_size =
+        sftpfs_window_size > 0 ? (size_t) MAX (sftpfs_window_size, SFTP_MIN_WINDOW_SIZE) * 1024 : 0;
+    file->window_offset = 0;
+    file->window_len = 0;
+    file->window_pos = 0;
+    file->window_dirty = false;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -184,6 +311,7 @@ sftpfs_open_file (vfs_file_handler_t * fh, int flags, mode_t mode, GError ** mce
 
     file->flags = flags;
     file->mode = mode;
+    sftpfs_file__window_init (file);
 
     if (do_append)
     {
@@ -233,6 +361,10 @@ sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror)
     if (sftpfs_fh->handle == nullptr)
         return -1;
 
+    /* size of file should include the data not written yet */
+    if (sftpfs_fh->window_dirty && sftpfs_file__flush (fh, mcerror) != 0)
+        return -1;
+
     do
     {
         int err;
@@ -267,9 +399,7 @@ sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror)
 ssize_t
 sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError ** mcerror)
 {
-    ssize_t rc;
     sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
-    sftpfs_super_t *super;
 
     mc_return_val_if_error (mcerror, -1);
 
@@ -280,25 +410,43 @@ sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError **
         return -1;
     }
 
-    super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+    if (file->window_dirty && sftpfs_file__flush (fh, mcerror) != 0)
+        return -1;
 
-    do
+    if (file->window_pos >= file->window_len)
     {
-        int err;
+        ssize_t rc;
 
-        rc = libssh2_sftp_read (file->handle, buffer, count);
-        if (rc >= 0)
-            break;
+        /* large buffer of caller is filled directly */
+        if (count >= file->window_size)
+        {
+            file->window_len = 0;
+            file->window_pos = 0;
 
-        err = sftpfs_file__handle_error (super, (int) rc, mcerror);
-        if (err < 0)
-            return err;
+            rc = sftpfs_file__read (fh, buffer, count, mcerror);
+            if (rc > 0)
+                fh->pos += rc;
+            return rc;
+        }
+
+        if (file->window == nullptr)
+            file->window = (char *) g_malloc (file->window_size);
+
+        rc = sftpfs_file__read (fh, file->window, file->window_size, mcerror);
+        if (rc <= 0)
+            return rc;
+
+        file->window_offset = fh->pos;
+        file->window_len = (size_t) rc;
+        file->window_pos = 0;
     }
-    while (rc == LIBSSH2_ERROR_EAGAIN);
 
-    fh->pos = (off_t) libssh2_sftp_tell64 (file->handle);
+    count = MIN (count, file->window_len - file->window_pos);
+    memcpy (buffer, file->window + file->window_pos, count);
+    file->window_pos += count;
+    fh->pos += count;
 
-    return rc;
+    return (ssize_t) count;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -317,29 +465,57 @@ sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError **
 ssize_t
 sftpfs_write_file (vfs_file_handler_t * fh, const char *buffer, size_t count, GError ** mcerror)
 {
-    ssize_t rc;
     sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
-    sftpfs_super_t *super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+    size_t done = 0;
 
     mc_return_val_if_error (mcerror, -1);
 
-    fh->pos = (off_t) libssh2_sftp_tell64 (file->handle);
+    /* drop data read ahead */
+    if (!file->window_dirty && file->window_len != 0)
+    {
+        file->window_len = 0;
+        file->window_pos = 0;
+        libssh2_sftp_seek64 (file->handle, fh->pos);
+    }
 
-    do
+    /* callers treat short write as error: consume the whole buffer, flushing the window
+       as many times as needed */
+    while (done < count)
     {
-        int err;
+        size_t n;
 
-        rc = libssh2_sftp_write (file->handle, buffer, count);
-        if (rc >= 0)
-            break;
+        /* large rest of buffer of caller is written directly */
+        if (file->window_len == 0 && count - done >= file->window_size)
+        {
+            ssize_t rc;
 
-        err = sftpfs_file__handle_error (super, (int) rc, mcerror);
-        if (err < 0)
-            return err;
+            rc = sftpfs_file__write (fh, buffer + done, count - done, mcerror);
+            if (rc <= 0)
+                return done != 0 ? (ssize_t) done : rc;
+
+            fh->pos += rc;
+            done += (size_t) rc;
+            continue;
+        }
+
+        if (file->window == nullptr)
+            file->window = (char *) g_malloc (file->window_size);
+
+        if (file->window_len == 0)
+            file->window_offset = fh->pos;
+
+        n = MIN (count - done, file->window_size - file->window_len);
+        memcpy (file->window + file->window_len, buffer + done, n);
+        file->window_len += n;
+        file->window_dirty = true;
+        fh->pos += n;
+        done += n;
+
+        if (file->window_len == file->window_size && sftpfs_file__flush (fh, mcerror) != 0)
+            return -1;
     }
-    while (rc == LIBSSH2_ERROR_EAGAIN);
 
-    return rc;
+    return (ssize_t) done;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -356,11 +532,20 @@ sftpfs_write_file (vfs_file_handler_t * fh, const char *buffer, size_t count, GE
 int
 sftpfs_close_file (vfs_file_handler_t * fh, GError ** mcerror)
 {
-    int ret;
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+    int ret = 0;
 
     mc_return_val_if_error (mcerror, -1);
 
-    ret = libssh2_sftp_close (SFTP_FILE_HANDLER (fh)->handle);
+    if (file->window_dirty)
+        ret = sftpfs_file__flush (fh, mcerror);
+
+    MC_PTR_FREE (file->window);
+    file->window_len = 0;
+    file->window_pos = 0;
+
+    if (libssh2_sftp_close (file->handle) != 0)
+        ret = -1;
 
     return ret == 0 ? 0 : -1;
 }
@@ -385,36 +570,48 @@ sftpfs_lseek (vfs_file_handler_t * fh, off_t offset, int whence, GError ** mcerr
 
     mc_return_val_if_error (mcerror, 0);
 
+    if (file->window_dirty && sftpfs_file__flush (fh, mcerror) != 0)
+        return -1;
+
     switch (whence)
     {
     case SEEK_SET:
-        /* Need reopen file because:
-           "You MUST NOT seek during writing or reading a file with SFTP, as the internals use
-           outstanding packets and changing the "file position" during transit will results in
-           badness." */
-        if (fh->pos > offset || offset == 0)
-        {
-            sftpfs_reopen (fh, mcerror);
-            mc_return_val_if_error (mcerror, 0);
-        }
-        fh->pos = offset;
         break;
     case SEEK_CUR:
-        fh->pos += offset;
+        offset += fh->pos;
         break;
     case SEEK_END:
-        if (fh->pos > fh->ino->st.st_size - offset)
-        {
-            sftpfs_reopen (fh, mcerror);
-            mc_return_val_if_error (mcerror, 0);
-        }
-        fh->pos = fh->ino->st.st_size - offset;
+        offset = fh->ino->st.st_size - offset;
         break;
     default:
-        break;
+        return fh->pos;
+    }
+
+    /* viewer reads file by small blocks back and forth: serve them from the window */
+    if (file->window_len != 0 && offset >= file->window_offset
+        && offset <= file->window_offset + (off_t) file->window_len)
+    {
+        file->window_pos = (size_t) (offset - file->window_offset);
+        fh->pos = offset;
+        return fh->pos;
+    }
+
+    /* position of file on server */
+    fh->pos += file->window_len - file->window_pos;
+    file->window_len = 0;
+    file->window_pos = 0;
+
+    /* Need reopen file because:
+       "You MUST NOT seek during writing or reading a file with SFTP, as the internals use
+       outstanding packets and changing the "file position" during transit will results in
+       badness." */
+    if (fh->pos > offset || offset == 0)
+    {
+        sftpfs_reopen (fh, mcerror);
+        mc_return_val_if_error (mcerror, 0);
     }
 
-    libssh2_sftp_seek64 (file->handle, fh->pos);
+    libssh2_sftp_seek64 (file->handle, offset);
     fh->pos = (off_t) libssh2_sftp_tell64 (file->handle);
 
     return fh->pos;
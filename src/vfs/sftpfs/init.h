@@ -8,12 +8,17 @@
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
+/* size of window of pipelined reads and writes, in kilobytes */
+#define SFTP_DEFAULT_WINDOW_SIZE 256
+
 /*** enums ***************************************************************************************/
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
 /*** global variables defined in .c file *********************************************************/
 
+extern int sftpfs_window_size;
+
 /*** declarations of public functions ************************************************************/
 
 void vfs_init_sftpfs (void);
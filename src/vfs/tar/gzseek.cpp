@@ -0,0 +1,572 @@
+/*
+   Virtual File System: random access to gzip-compressed files
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: random access to gzip-compressed files
+ *
+ * Deflate stream can be decompressed only from the beginning. To seek in it fast, checkpoints
+ * are remembered while data are decompressed: position of deflate block in compressed file
+ * and last 32 KiB of decompressed data which the block can refer to. Decompression is resumed
+ * from the nearest checkpoint before the requested offset, so reading of some data costs
+ * decompression of at most GZSEEK_SPAN bytes before them.
+ *
+ * Checkpoints are made in the data decompressed for the first time, so tarfs gets them
+ * for the whole archive while it reads headers. Windows of checkpoints are kept compressed:
+ * uncompressed ones would take 160 MiB for a 20 GiB archive. Checkpoints can be saved and loaded
+ * again for the next opening of the same file, tarfs keeps them in the index of archive.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"        /* mc_read(), mc_lseek() */
+
+#include "gzseek.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* maximal distance of deflate back references */
+#define GZSEEK_WINSIZE 32768
+
+/* distance between checkpoints in decompressed data */
+#define GZSEEK_SPAN (4 * 1024 * 1024)
+
+/* windowBits of inflateInit2() for gzip stream and for raw deflate one */
+#define GZSEEK_GZIP 31
+#define GZSEEK_RAW (-15)
+
+/* size of gzip trailer: CRC32 and length */
+#define GZSEEK_TRAILER 8
+
+#define GZSEEK_SIGNATURE "gzseek checkpoints 1\n"
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    off_t out;                  /* offset in decompressed data */
+    off_t in;                   /* offset of the first whole byte of deflate block */
+    int bits;                   /* number of bits of block in the byte before @in */
+    size_t size;                /* size of compressed window */
+    unsigned char *window;      /* decompressed data before @out compressed by zlib */
+} gzseek_point_t;
+
+/* checkpoint in saved data, followed by compressed window */
+typedef struct
+{
+    gint64 out;
+    gint64 in;
+    guint32 bits;
+    guint32 size;
+} gzseek_record_t;
+
+struct gzseek_t
+{
+    int fd;                     /* compressed file */
+    z_stream strm;
+    bool raw;                   /* decompression is resumed from checkpoint */
+    bool eof;                   /* end of gzip stream is reached */
+    off_t in;                   /* offset in compressed file after read input */
+    off_t out;                  /* offset of the next byte in decompressed data */
+    GPtrArray *points;          /* checkpoints sorted by offset in decompressed data */
+    size_t wpos;                /* position of the next decompressed byte in @window */
+    unsigned char window[GZSEEK_WINSIZE];       /* circular buffer of decompressed data */
+    unsigned char input[16384];
+};
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+gzseek_point_free (gpointer data)
+{
+    gzseek_point_t *point = (gzseek_point_t *) data;
+
+    g_free (point->window);
+    g_free (point);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read next part of compressed file if all input is consumed.
+ *
+ * @return -1 on error, 0 on end of file, size of available input otherwise
+ */
+
+static ssize_t
+gzseek_fill (gzseek_t * gz)
+{
+    ssize_t n;
+
+    if (gz->strm.avail_in != 0)
+        return gz->strm.avail_in;
+
+    n = mc_read (gz->fd, (char *) gz->input, sizeof (gz->input));
+    if (n <= 0)
+        return n;
+
+    gz->in += n;
+    gz->strm.next_in = gz->input;
+    gz->strm.avail_in = n;
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remember the current state of decompression. Must be called at the beginning of deflate block.
+ */
+
+static void
+gzseek_add_point (gzseek_t * gz)
+{
+    gzseek_point_t *point;
+    unsigned char *window;
+    uLong len;
+    uLongf size;
+
+    window = (unsigned char *) g_malloc (GZSEEK_WINSIZE);
+
+    if (gz->out < GZSEEK_WINSIZE)
+    {
+        len = gz->wpos;
+        memcpy (window, gz->window, len);
+    }
+    else
+    {
+        size_t tail = GZSEEK_WINSIZE - gz->wpos;
+
+        len = GZSEEK_WINSIZE;
+        memcpy (window, gz->window + gz->wpos, tail);
+        memcpy (window + tail, gz->window, gz->wpos);
+    }
+
+    point = g_new (gzseek_point_t, 1);
+    point->out = gz->out;
+    point->in = gz->in - gz->strm.avail_in;
+    point->bits = gz->strm.data_type & 7;
+
+    size = compressBound (len);
+    point->window = (unsigned char *) g_malloc (size);
+
+    /* without checkpoint, data after it are decompressed from the previous one */
+    if (compress (point->window, &size, window, len) != Z_OK)
+        gzseek_point_free (point);
+    else
+    {
+        point->size = size;
+        point->window = (unsigned char *) g_realloc (point->window, size);
+        g_ptr_array_add (gz->points, point);
+    }
+
+    g_free (window);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get offset in decompressed data from which the next checkpoint can be made.
+ */
+
+static off_t
+gzseek_next_point (const gzseek_t * gz)
+{
+    const gzseek_point_t *last;
+
+    if (gz->points->len == 0)
+        return GZSEEK_SPAN;
+
+    last = (const gzseek_point_t *) g_ptr_array_index (gz->points, gz->points->len - 1);
+    return last->out + GZSEEK_SPAN;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get the last checkpoint at or before offset.
+ *
+ * @return checkpoint, nullptr if data should be decompressed from the beginning of file
+ */
+
+static const gzseek_point_t *
+gzseek_find_point (const gzseek_t * gz, off_t offset)
+{
+    guint lo = 0, hi = gz->points->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (((const gzseek_point_t *) g_ptr_array_index (gz->points, mid))->out <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo == 0 ? nullptr : (const gzseek_point_t *) g_ptr_array_index (gz->points, lo - 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Resume decompression from checkpoint.
+ *
+ * @param point checkpoint, nullptr to start from the beginning of file
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int
+gzseek_restore (gzseek_t * gz, const gzseek_point_t * point)
+{
+    off_t in = 0;
+    uLongf size;
+
+    if (point != nullptr)
+        in = point->in - (point->bits != 0 ? 1 : 0);
+
+    if (mc_lseek (gz->fd, in, SEEK_SET) != in)
+        return -1;
+
+    gz->in = in;
+    gz->strm.avail_in = 0;
+    gz->eof = false;
+
+    if (point == nullptr)
+    {
+        gz->raw = false;
+        gz->out = 0;
+        gz->wpos = 0;
+        return inflateReset2 (&gz->strm, GZSEEK_GZIP) == Z_OK ? 0 : -1;
+    }
+
+    gz->raw = true;
+    if (inflateReset2 (&gz->strm, GZSEEK_RAW) != Z_OK)
+        return -1;
+
+    if (point->bits != 0)
+    {
+        if (gzseek_fill (gz) <= 0)
+            return -1;
+
+        inflatePrime (&gz->strm, point->bits, gz->strm.next_in[0] >> (8 - point->bits));
+        gz->strm.next_in++;
+        gz->strm.avail_in--;
+    }
+
+    size = MIN (point->out, GZSEEK_WINSIZE);
+    if (uncompress (gz->window, &size, point->window, point->size) != Z_OK
+        || size != (uLongf) MIN (point->out, GZSEEK_WINSIZE)
+        || inflateSetDictionary (&gz->strm, gz->window, size) != Z_OK)
+        return -1;
+
+    gz->wpos = size;
+    gz->out = point->out;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Go to the next member of gzip file after the end of deflate stream.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int
+gzseek_next_member (gzseek_t * gz)
+{
+    ssize_t n;
+
+    /* inflate() consumes gzip trailer only if it has read gzip header */
+    if (gz->raw)
+    {
+        size_t skip = GZSEEK_TRAILER;
+
+        while (skip > 0)
+        {
+            n = gzseek_fill (gz);
+            if (n <= 0)
+            {
+                gz->eof = true;
+                return n;
+            }
+
+            n = MIN ((size_t) n, skip);
+            gz->strm.next_in += n;
+            gz->strm.avail_in -= n;
+            skip -= n;
+        }
+    }
+
+    /* like gzip, ignore anything except gzip members after the first one */
+    n = gzseek_fill (gz);
+    if (n <= 0 || gz->strm.next_in[0] != 037)
+    {
+        gz->eof = true;
+        return n < 0 ? -1 : 0;
+    }
+
+    gz->raw = false;
+    return inflateReset2 (&gz->strm, GZSEEK_GZIP) == Z_OK ? 0 : -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Decompress data from the current offset.
+ *
+ * @param buffer buffer for data, nullptr to skip them
+ * @param count size of data
+ *
+ * @return number of decompressed bytes, less than @count at the end of file, -1 on error
+ */
+
+static ssize_t
+gzseek_inflate (gzseek_t * gz, unsigned char *buffer, size_t count)
+{
+    size_t done = 0;
+
+    while (done < count && !gz->eof)
+    {
+        ssize_t n;
+        int ret;
+
+        n = gzseek_fill (gz);
+        if (n == -1)
+            return -1;
+        if (n == 0)
+        {
+            /* truncated file */
+            gz->eof = true;
+            break;
+        }
+
+        if (gz->wpos == GZSEEK_WINSIZE)
+            gz->wpos = 0;
+
+        gz->strm.next_out = gz->window + gz->wpos;
+        gz->strm.avail_out = MIN (GZSEEK_WINSIZE - gz->wpos, count - done);
+
+        ret = inflate (&gz->strm, Z_BLOCK);
+
+        n = gz->strm.next_out - (gz->window + gz->wpos);
+        if (buffer != nullptr)
+            memcpy (buffer + done, gz->window + gz->wpos, n);
+        gz->wpos += n;
+        gz->out += n;
+        done += n;
+
+        if (ret == Z_STREAM_END)
+        {
+            if (gzseek_next_member (gz) == -1)
+                return -1;
+        }
+        else if (ret != Z_OK)
+        {
+            errno = EIO;
+            return -1;
+        }
+        /* at the beginning of block, except the last block of stream */
+        else if ((gz->strm.data_type & (128 | 64)) == 128 && gz->out >= gzseek_next_point (gz))
+            gzseek_add_point (gz);
+    }
+
+    return done;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start reading of gzip-compressed file.
+ *
+ * @param fd file opened by mc_open(). It isn't closed by gzseek_close()
+ *
+ * @return new stream, nullptr if file isn't in gzip format
+ */
+
+gzseek_t *
+gzseek_open (int fd)
+{
+    unsigned char magic[2];
+    gzseek_t *gz;
+
+    if (mc_lseek (fd, 0, SEEK_SET) != 0 || mc_read (fd, (char *) magic, sizeof (magic)) != 2
+        || magic[0] != 037 || magic[1] != 0213 || mc_lseek (fd, 0, SEEK_SET) != 0)
+        return nullptr;
+
+    gz = g_new0 (gzseek_t, 1);
+    gz->fd = fd;
+
+    if (inflateInit2 (&gz->strm, GZSEEK_GZIP) != Z_OK)
+    {
+        g_free (gz);
+        return nullptr;
+    }
+
+    gz->points = g_ptr_array_new_with_free_func (gzseek_point_free);
+
+    return gz;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+ssize_t
+gzseek_read (gzseek_t * gz, void *buffer, size_t count)
+{
+    return gzseek_inflate (gz, (unsigned char *) buffer, count);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Set offset in decompressed data.
+ *
+ * @return new offset, it is less than @offset if file is shorter; -1 on error
+ */
+
+off_t
+gzseek_lseek (gzseek_t * gz, off_t offset)
+{
+    const gzseek_point_t *point;
+
+    point = gzseek_find_point (gz, offset);
+
+    if ((offset < gz->out || (point != nullptr && point->out > gz->out))
+        && gzseek_restore (gz, point) == -1)
+    {
+        /* state of stream is unknown, restore it at the next seek */
+        gz->out = G_MAXINT64;
+        gz->eof = true;
+        errno = EIO;
+        return -1;
+    }
+
+    while (gz->out < offset && !gz->eof)
+        if (gzseek_inflate (gz, nullptr, MIN (offset - gz->out, GZSEEK_WINSIZE)) == -1)
+            return -1;
+
+    return gz->out;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save checkpoints to load them when the same file is opened next time.
+ *
+ * @param buf buffer to append checkpoints to. Records are in the native byte order
+ */
+
+void
+gzseek_save (const gzseek_t * gz, GString * buf)
+{
+    guint i;
+
+    g_string_append (buf, GZSEEK_SIGNATURE);
+
+    for (i = 0; i < gz->points->len; i++)
+    {
+        const gzseek_point_t *point = (const gzseek_point_t *) g_ptr_array_index (gz->points, i);
+        gzseek_record_t rec;
+
+        rec.out = (gint64) point->out;
+        rec.in = (gint64) point->in;
+        rec.bits = (guint32) point->bits;
+        rec.size = (guint32) point->size;
+
+        g_string_append_len (buf, (const char *) &rec, sizeof (rec));
+        g_string_append_len (buf, (const char *) point->window, point->size);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load checkpoints saved by gzseek_save() for the same file. Should be called before
+ * the first read.
+ *
+ * @return true on success, false if data are corrupted
+ */
+
+bool
+gzseek_load (gzseek_t * gz, const char *data, size_t len)
+{
+    const size_t sig_len = strlen (GZSEEK_SIGNATURE);
+    const char *p, *end = data + len;
+    off_t out = 0;
+
+    g_ptr_array_set_size (gz->points, 0);
+
+    if (len < sig_len || strncmp (data, GZSEEK_SIGNATURE, sig_len) != 0)
+        return false;
+
+    for (p = data + sig_len; p != end;)
+    {
+        gzseek_record_t rec;
+        gzseek_point_t *point;
+
+        if ((size_t) (end - p) < sizeof (rec))
+            break;
+
+        memcpy (&rec, p, sizeof (rec));
+        p += sizeof (rec);
+
+        if (rec.out <= out || rec.in <= 0 || rec.bits > 7 || rec.size == 0
+            || rec.size > compressBound (GZSEEK_WINSIZE) || (size_t) (end - p) < rec.size)
+            break;
+
+        point = g_new (gzseek_point_t, 1);
+        point->out = out = (off_t) rec.out;
+        point->in = (off_t) rec.in;
+        point->bits = (int) rec.bits;
+        point->size = rec.size;
+        point->window = (unsigned char *) g_memdup (p, rec.size);
+        g_ptr_array_add (gz->points, point);
+
+        p += rec.size;
+    }
+
+    if (p == end)
+        return true;
+
+    g_ptr_array_set_size (gz->points, 0);
+    return false;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+gzseek_close (gzseek_t * gz)
+{
+    if (gz == nullptr)
+        return;
+
+    inflateEnd (&gz->strm);
+    g_ptr_array_free (gz->points, TRUE);
+    g_free (gz);
+}
+
+/* --------------------------------------------------------------------------------------------- */
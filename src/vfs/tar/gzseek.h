@@ -0,0 +1,32 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: random access to gzip-compressed files
+ */
+
+#ifndef MC__VFS_TAR_GZSEEK_H
+#define MC__VFS_TAR_GZSEEK_H
+
+#include <sys/types.h>
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct gzseek_t gzseek_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+gzseek_t *gzseek_open (int fd);
+ssize_t gzseek_read (gzseek_t * gz, void *buffer, size_t count);
+off_t gzseek_lseek (gzseek_t * gz, off_t offset);
+void gzseek_save (const gzseek_t * gz, GString * buf);
+bool gzseek_load (gzseek_t * gz, const char *data, size_t len);
+void gzseek_close (gzseek_t * gz);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__VFS_TAR_GZSEEK_H */
@@ -54,8 +54,12 @@
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_rmstamp */
+#include "lib/vfs/arcindex.h"
 
 #include "tar.h"
+#ifdef HAVE_ZLIB
+#include "gzseek.h"
+#endif
 
 /*** global variables ****************************************************************************/
 
@@ -256,6 +260,10 @@ typedef struct
     struct vfs_s_super base;    /* base class */
 
     int fd;
+#ifdef HAVE_ZLIB
+    gzseek_t *gz;               /* decompressor of gzipped archive opened as fd */
+    GString *gz_points;         /* checkpoints of decompressor taken from the index */
+#endif
     struct stat st;
     enum archive_format type;   /* Type of the archive */
 } tar_super_t;
@@ -326,6 +334,16 @@ tar_free_archive (struct vfs_class *me, struct vfs_s_super *archive)
 
     (void) me;
 
+#ifdef HAVE_ZLIB
+    gzseek_close (arch->gz);
+    arch->gz = nullptr;
+    if (arch->gz_points != nullptr)
+    {
+        g_string_free (arch->gz_points, TRUE);
+        arch->gz_points = nullptr;
+    }
+#endif
+
     if (arch->fd != -1)
     {
         mc_close (arch->fd);
@@ -337,26 +355,45 @@ tar_free_archive (struct vfs_class *me, struct vfs_s_super *archive)
 
 /* Returns fd of the open tar file */
 static int
-tar_open_archive_int (struct vfs_class *me, const vfs_path_t * vpath, struct vfs_s_super *archive)
+tar_open_archive_int (struct vfs_class *me, struct vfs_s_super *archive, const vfs_path_t * vpath)
 {
     int result, type;
-    tar_super_t *arch;
-    mode_t mode;
-    struct vfs_s_inode *root;
+    const char *name;
+
+    name = vfs_path_as_str (vpath);
 
     result = mc_open (vpath, O_RDONLY);
     if (result == -1)
     {
-        message (D_ERROR, MSG_ERROR, _("Cannot open tar archive\n%s"), vfs_path_as_str (vpath));
+        message (D_ERROR, MSG_ERROR, _("Cannot open tar archive\n%s"), name);
         ERRNOR (ENOENT, -1);
     }
 
-    archive->name = g_strdup (vfs_path_as_str (vpath));
-    arch = TAR_SUPER (archive);
-    mc_stat (vpath, &arch->st);
-
     /* Find out the method to handle this tar file */
-    type = get_compression_type (result, archive->name);
+    type = get_compression_type (result, name);
+#ifdef HAVE_ZLIB
+    /* Decompress gzip here to seek to files without decompression of all data before them */
+    if (type == COMPRESSION_GZIP)
+    {
+        tar_super_t *arch = TAR_SUPER (archive);
+
+        arch->gz = gzseek_open (result);
+        if (arch->gz != nullptr)
+        {
+            /* the tree was taken from the index: don't decompress from the beginning again */
+            if (arch->gz_points != nullptr)
+            {
+                gzseek_load (arch->gz, arch->gz_points->str, arch->gz_points->len);
+                g_string_free (arch->gz_points, TRUE);
+                arch->gz_points = nullptr;
+            }
+
+            return result;
+        }
+    }
+#else
+    (void) archive;
+#endif
     if (type == COMPRESSION_NONE)
         mc_lseek (result, 0, SEEK_SET);
     else
@@ -365,7 +402,7 @@ tar_open_archive_int (struct vfs_class *me, const vfs_path_t * vpath, struct vfs
         vfs_path_t *tmp_vpath;
 
         mc_close (result);
-        s = g_strconcat (archive->name, decompress_extension (type), (char *) nullptr);
+        s = g_strconcat (name, decompress_extension (type), (char *) nullptr);
         tmp_vpath = vfs_path_from_str_flags (s, VPF_NO_CANON);
         result = mc_open (tmp_vpath, O_RDONLY);
         vfs_path_free (tmp_vpath);
@@ -373,13 +410,21 @@ tar_open_archive_int (struct vfs_class *me, const vfs_path_t * vpath, struct vfs
             message (D_ERROR, MSG_ERROR, _("Cannot open tar archive\n%s"), s);
         g_free (s);
         if (result == -1)
-        {
-            MC_PTR_FREE (archive->name);
             ERRNOR (ENOENT, -1);
-        }
     }
 
-    arch->fd = result;
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+tar_new_root (struct vfs_class *me, struct vfs_s_super *archive)
+{
+    tar_super_t *arch = TAR_SUPER (archive);
+    mode_t mode;
+    struct vfs_s_inode *root;
+
     mode = arch->st.st_mode & 07777;
     if (mode & 0400)
         mode |= 0100;
@@ -396,20 +441,46 @@ tar_open_archive_int (struct vfs_class *me, const vfs_path_t * vpath, struct vfs
     root->st.st_dev = VFS_SUBCLASS (me)->rdev++;
 
     archive->root = root;
+}
 
-    return result;
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+tar_archive_read (struct vfs_s_super *archive, char *buffer, size_t count)
+{
+    tar_super_t *arch = TAR_SUPER (archive);
+
+#ifdef HAVE_ZLIB
+    if (arch->gz != nullptr)
+        return gzseek_read (arch->gz, buffer, count);
+#endif
+
+    return mc_read (arch->fd, buffer, count);
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
-static union block *
-tar_get_next_block (struct vfs_s_super *archive, int tard)
+static off_t
+tar_archive_seek (struct vfs_s_super *archive, off_t offset)
 {
-    int n;
+    tar_super_t *arch = TAR_SUPER (archive);
 
-    (void) archive;
+#ifdef HAVE_ZLIB
+    if (arch->gz != nullptr)
+        return gzseek_lseek (arch->gz, offset);
+#endif
+
+    return mc_lseek (arch->fd, offset, SEEK_SET);
+}
+
+/* --------------------------------------------------------------------------------------------- */
 
-    n = mc_read (tard, block_buf.buffer, sizeof (block_buf.buffer));
+static union block *
+tar_get_next_block (struct vfs_s_super *archive)
+{
+    ssize_t n;
+
+    n = tar_archive_read (archive, block_buf.buffer, sizeof (block_buf.buffer));
     if (n != sizeof (block_buf.buffer))
         return nullptr;            /* An error has occurred */
     current_tar_position += sizeof (block_buf.buffer);
@@ -419,12 +490,10 @@ tar_get_next_block (struct vfs_s_super *archive, int tard)
 /* --------------------------------------------------------------------------------------------- */
 
 static void
-tar_skip_n_records (struct vfs_s_super *archive, int tard, size_t n)
+tar_skip_n_records (struct vfs_s_super *archive, size_t n)
 {
-    (void) archive;
-
-    mc_lseek (tard, n * sizeof (block_buf.buffer), SEEK_CUR);
     current_tar_position += n * sizeof (block_buf.buffer);
+    tar_archive_seek (archive, current_tar_position);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -620,7 +689,7 @@ tar_fill_stat (struct vfs_s_super *archive, struct stat *st, union block *header
  *
  */
 static ReadStatus
-tar_read_header (struct vfs_class *me, struct vfs_s_super *archive, int tard, size_t * h_size)
+tar_read_header (struct vfs_class *me, struct vfs_s_super *archive, size_t * h_size)
 {
     tar_super_t *arch = TAR_SUPER (archive);
     ReadStatus checksum_status;
@@ -629,7 +698,7 @@ tar_read_header (struct vfs_class *me, struct vfs_s_super *archive, int tard, si
 
     while (true)
     {
-        header = tar_get_next_block (archive, tard);
+        header = tar_get_next_block (archive);
         if (header == nullptr)
             return STATUS_EOF;
 
@@ -670,7 +739,7 @@ tar_read_header (struct vfs_class *me, struct vfs_s_super *archive, int tard, si
 
             for (size = *h_size; size > 0; size -= written)
             {
-                char *data = tar_get_next_block (archive, tard)->buffer;
+                char *data = tar_get_next_block (archive)->buffer;
                 if (data == nullptr)
                 {
                     MC_PTR_FREE (*longp);
@@ -820,7 +889,7 @@ tar_read_header (struct vfs_class *me, struct vfs_s_super *archive, int tard, si
 
         if (arch->type == TAR_GNU && header->oldgnu_header.isextended)
         {
-            while (tar_get_next_block (archive, tard)->sparse_header.isextended != 0)
+            while (tar_get_next_block (archive)->sparse_header.isextended != 0)
                 ;
 
             if (inode != nullptr)
@@ -836,30 +905,24 @@ tar_read_header (struct vfs_class *me, struct vfs_s_super *archive, int tard, si
  * Returns 0 on success, -1 on error.
  */
 static int
-tar_open_archive (struct vfs_s_super *archive, const vfs_path_t * vpath,
-                  const vfs_path_element_t * vpath_element)
+tar_read_archive (struct vfs_class *me, struct vfs_s_super *archive, const vfs_path_t * vpath)
 {
     /* Initial status at start of archive */
     ReadStatus status = STATUS_EOFMARK;
-    int tard;
 
     current_tar_position = 0;
-    /* Open for reading */
-    tard = tar_open_archive_int (vpath_element->clazz, vpath, archive);
-    if (tard == -1)
-        return -1;
 
     while (true)
     {
         size_t h_size = 0;
         ReadStatus prev_status = status;
 
-        status = tar_read_header (vpath_element->clazz, archive, tard, &h_size);
+        status = tar_read_header (me, archive, &h_size);
 
         switch (status)
         {
         case STATUS_SUCCESS:
-            tar_skip_n_records (archive, tard, (h_size + BLOCKSIZE - 1) / BLOCKSIZE);
+            tar_skip_n_records (archive, (h_size + BLOCKSIZE - 1) / BLOCKSIZE);
             continue;
 
             /*
@@ -908,6 +971,79 @@ tar_open_archive (struct vfs_s_super *archive, const vfs_path_t * vpath,
     return 0;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take the tree of archive from the index. Checkpoints of decompressor of gzipped archive
+ * are taken too, they are given to decompressor when archive is opened.
+ */
+
+static bool
+tar_index_load (struct vfs_s_super *archive)
+{
+    tar_super_t *arch = TAR_SUPER (archive);
+
+#ifdef HAVE_ZLIB
+    return vfs_s_index_load (archive, nullptr, &arch->st, &arch->gz_points);
+#else
+    return vfs_s_index_load (archive, nullptr, &arch->st, nullptr);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save the tree of archive and checkpoints of decompressor of gzipped archive to the index.
+ */
+
+static void
+tar_index_save (struct vfs_s_super *archive)
+{
+    tar_super_t *arch = TAR_SUPER (archive);
+    GString *data = nullptr;
+
+#ifdef HAVE_ZLIB
+    if (arch->gz != nullptr)
+    {
+        data = g_string_new ("");
+        gzseek_save (arch->gz, data);
+    }
+#endif
+
+    vfs_s_index_save (archive, nullptr, &arch->st, data);
+
+    if (data != nullptr)
+        g_string_free (data, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+tar_open_archive (struct vfs_s_super *archive, const vfs_path_t * vpath,
+                  const vfs_path_element_t * vpath_element)
+{
+    struct vfs_class *me = vpath_element->clazz;
+    tar_super_t *arch = TAR_SUPER (archive);
+    int result;
+
+    archive->name = g_strdup (vfs_path_as_str (vpath));
+    result = mc_stat (vpath, &arch->st);
+    tar_new_root (me, archive);
+
+    /* If the tree is taken from the index, archive is opened when some file is read from it */
+    if (result == 0 && tar_index_load (archive))
+        return 0;
+
+    /* Open for reading */
+    arch->fd = tar_open_archive_int (me, archive, vpath);
+    if (arch->fd == -1)
+        return -1;
+
+    result = tar_read_archive (me, archive, vpath);
+    if (result == 0)
+        tar_index_save (archive);
+
+    return result;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void *
@@ -952,18 +1088,18 @@ tar_super_same (const vfs_path_element_t * vpath_element, struct vfs_s_super *pa
 static ssize_t
 tar_read (void *fh, char *buffer, size_t count)
 {
-    struct vfs_class *me = VFS_FILE_HANDLER_SUPER (fh)->me;
+    struct vfs_s_super *archive = VFS_FILE_HANDLER_SUPER (fh);
+    struct vfs_class *me = archive->me;
     vfs_file_handler_t *file = VFS_FILE_HANDLER (fh);
     off_t begin = file->ino->data_offset;
-    int fd = TAR_SUPER (VFS_FILE_HANDLER_SUPER (fh))->fd;
     ssize_t res;
 
-    if (mc_lseek (fd, begin + file->pos, SEEK_SET) != begin + file->pos)
+    if (tar_archive_seek (archive, begin + file->pos) != begin + file->pos)
         ERRNOR (EIO, -1);
 
     count = MIN (count, (size_t) (file->ino->st.st_size - file->pos));
 
-    res = mc_read (fd, buffer, count);
+    res = tar_archive_read (archive, buffer, count);
     if (res == -1)
         ERRNOR (errno, -1);
 
@@ -976,11 +1112,27 @@ tar_read (void *fh, char *buffer, size_t count)
 static int
 tar_fh_open (struct vfs_class *me, vfs_file_handler_t * fh, int flags, mode_t mode)
 {
-    (void) fh;
+    struct vfs_s_super *archive = VFS_FILE_HANDLER_SUPER (fh);
+    tar_super_t *arch = TAR_SUPER (archive);
+
     (void) mode;
 
     if ((flags & O_ACCMODE) != O_RDONLY)
         ERRNOR (EROFS, -1);
+
+    /* The tree was taken from the index, open archive now */
+    if (arch->fd == -1)
+    {
+        vfs_path_t *vpath;
+
+        vpath = vfs_path_from_str (archive->name);
+        arch->fd = tar_open_archive_int (me, archive, vpath);
+        vfs_path_free (vpath);
+
+        if (arch->fd == -1)
+            return -1;
+    }
+
     return 0;
 }
 
@@ -228,6 +228,58 @@ mcview_get_ptr_string (WView * view, off_t byte_index)
     return nullptr;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get pointer to byte and the size of data around it, that can be accessed directly.
+ *
+ * @param view viewer object
+ * @param byte_index byte index
+ * @param before number of bytes available before returned pointer
+ * @param after number of bytes available starting at returned pointer
+ *
+ * @return pointer to byte, nullptr if byte is not available
+ */
+
+char *
+mcview_get_span (WView * view, off_t byte_index, size_t * before, size_t * after)
+{
+    char *p = nullptr;
+    size_t b = 0, a = 0;
+
+    switch (view->datasource)
+    {
+    case DS_STDIO_PIPE:
+    case DS_VFS_PIPE:
+        p = mcview_get_span_growing_buffer (view, byte_index, &b, &a);
+        break;
+    case DS_FILE:
+        p = mcview_get_ptr_file (view, byte_index);
+        if (p != nullptr)
+        {
+            b = (size_t) (byte_index - view->ds_file_offset);
+            a = view->ds_file_datalen - b;
+        }
+        break;
+    case DS_STRING:
+        p = mcview_get_ptr_string (view, byte_index);
+        if (p != nullptr)
+        {
+            b = (size_t) byte_index;
+            a = view->ds_string_len - b;
+        }
+        break;
+    case DS_NONE:
+    default:
+        break;
+    }
+
+    if (before != nullptr)
+        *before = b;
+    if (after != nullptr)
+        *after = a;
+
+    return p;
+}
 /* --------------------------------------------------------------------------------------------- */
 
 bool
@@ -290,3 +290,38 @@ mcview_get_ptr_growing_buffer (WView * view, off_t byte_index)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Get pointer to byte in growing buffer and the size of contiguous data around it.
+ *
+ * @param view viewer object
+ * @param byte_index byte index
+ * @param before number of bytes before returned pointer in the same page
+ * @param after number of bytes starting at returned pointer in the same page
+ *
+ * @return pointer to byte, nullptr if byte is not available
+ */
+
+char *
+mcview_get_span_growing_buffer (WView * view, off_t byte_index, size_t * before, size_t * after)
+{
+    char *p;
+    off_t pageno;
+    size_t pageindex;
+
+    p = mcview_get_ptr_growing_buffer (view, byte_index);
+    if (p == nullptr)
+        return nullptr;
+
+    pageno = byte_index / VIEW_PAGE_SIZE;
+    pageindex = byte_index % VIEW_PAGE_SIZE;
+
+    *before = pageindex;
+    if (pageno < (off_t) view->growbuf_blockptr->len - 1)
+        *after = VIEW_PAGE_SIZE - pageindex;
+    else
+        *after = view->growbuf_lastindex - pageindex;
+
+    return p;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -255,6 +255,7 @@ off_t mcview_get_filesize (WView *);
 void mcview_update_filesize (WView * view);
 char *mcview_get_ptr_file (WView *, off_t);
 char *mcview_get_ptr_string (WView *, off_t);
+char *mcview_get_span (WView * view, off_t byte_index, size_t * before, size_t * after);
 bool mcview_get_utf (WView * view, off_t byte_index, int *ch, int *ch_len);
 bool mcview_get_byte_string (WView *, off_t, int *);
 bool mcview_get_byte_none (WView *, off_t, int *);
@@ -287,6 +288,7 @@ off_t mcview_growbuf_filesize (WView * view);
 void mcview_growbuf_read_until (WView * view, off_t p);
 bool mcview_get_byte_growing_buffer (WView * view, off_t p, int *);
 char *mcview_get_ptr_growing_buffer (WView * view, off_t p);
+char *mcview_get_span_growing_buffer (WView * view, off_t p, size_t * before, size_t * after);
 
 /* hex.c: */
 void mcview_display_hex (WView * view);
@@ -39,6 +39,7 @@
 #include <sys/types.h>
 
 #include "lib/global.h"
+#include "lib/memscan.h"
 #include "lib/vfs/vfs.h"
 #include "lib/strutil.h"
 #include "lib/util.h"           /* save_file_position() */
@@ -329,11 +330,20 @@ mcview_bol (WView * view, off_t current, off_t limit)
     }
     while (current > 0 && current > limit)
     {
-        if (!mcview_get_byte (view, current - 1, &c))
-            break;
-        if (c == '\r' || c == '\n')
+        const char *p, *eol;
+        size_t before;
+        off_t start;
+
+        /* search the whole contiguous data before current position at once */
+        p = mcview_get_span (view, current - 1, &before, nullptr);
+        if (p == nullptr)
             break;
-        current--;
+        start = MAX (current - 1 - (off_t) before, MAX (limit, 0));
+        p -= current - 1 - start;
+        eol = (const char *) mc_memrchr2 (p, '\r', '\n', (size_t) (current - start));
+        if (eol != nullptr)
+            return start + (eol - p) + 1;
+        current = start;
     }
     return current;
 }
@@ -346,27 +356,35 @@ mcview_bol (WView * view, off_t current, off_t limit)
 off_t
 mcview_eol (WView * view, off_t current)
 {
-    int c, prev_ch = 0;
+    int c;
 
     if (current < 0)
         return 0;
 
     while (true)
     {
-        if (!mcview_get_byte (view, current, &c))
-            break;
-        if (c == '\n')
-        {
-            current++;
-            break;
-        }
-        else if (prev_ch == '\r')
+        const char *p, *eol;
+        size_t after;
+
+        /* search the whole contiguous data from current position at once */
+        p = mcview_get_span (view, current, nullptr, &after);
+        if (p == nullptr)
+            return current;
+        eol = (const char *) mc_memchr2 (p, '\r', '\n', after);
+        if (eol == nullptr)
+            current += after;
+        else
         {
+            current += eol - p + 1;
+            if (*eol == '\n')
+                return current;
             break;
         }
-        current++;
-        prev_ch = c;
     }
+
+    /* CR LF is single line end */
+    if (mcview_get_byte (view, current, &c) && c == '\n')
+        current++;
     return current;
 }
 
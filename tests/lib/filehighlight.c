@@ -0,0 +1,239 @@
+/*
+   lib - tests for colors of files found by file highlight filters
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/strutil.h"
+#include "lib/skin.h"
+#include "lib/skin/internal.h"  /* mc_skin_color_t */
+#include "lib/filehighlight.h"
+
+/* groups of filters, color pair index of group is its index plus 1; "nocolor" has no color */
+static const char *test_groups[] = {
+    "executable", "directory", "core", "temp", "archive", "source", "big", NULL
+};
+
+static const char *test_ini =
+    "[executable]\n"
+    "    type=FILE_EXE\n"
+    "[directory]\n"
+    "    type=DIR\n"
+    "[core]\n"
+    "    regexp=^core\\\\.*\\\\d*$\n"
+    "[temp]\n"
+    "    extensions=~;bak\n"
+    "    regexp=(^#.*|.*~$)\n"
+    "[archive]\n"
+    "    extensions=tar;gz;tar.gz\n"
+    "[nocolor]\n"
+    "    extensions=c;py\n"
+    "[source]\n"
+    "    extensions=c;h;gz\n"
+    "[big]\n"
+    "    extensions=Z\n"
+    "    extensions_case=true\n";
+
+static char *ini_name = NULL;
+static mc_fhl_t *fhl = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int fd, i;
+
+    str_init_strings (NULL);
+
+    mc_skin__default.colors = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    for (i = 0; test_groups[i] != NULL; i++)
+    {
+        mc_skin_color_t *color;
+
+        color = g_new0 (mc_skin_color_t, 1);
+        color->pair_index = i + 1;
+        g_hash_table_insert (mc_skin__default.colors,
+                             g_strconcat ("filehighlight.", test_groups[i], (char *) NULL), color);
+    }
+
+    fd = g_file_open_tmp ("filehighlightXXXXXX.ini", &ini_name, NULL);
+    close (fd);
+    g_file_set_contents (ini_name, test_ini, -1, NULL);
+
+    fhl = mc_fhl_new (false);
+    mc_fhl_read_ini_file (fhl, ini_name);
+    mc_fhl_parse_ini_file (fhl);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    mc_fhl_free (&fhl);
+    unlink (ini_name);
+    g_free (ini_name);
+    g_hash_table_destroy (mc_skin__default.colors);
+    mc_skin__default.colors = NULL;
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+expected_color (const char *group)
+{
+    int i;
+
+    if (group == NULL)
+        return NORMAL_COLOR;
+
+    for (i = 0; strcmp (test_groups[i], group) != 0; i++)
+        ;
+
+    return -(i + 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+fill_entry (file_entry_t * fe, const char *fname, mode_t mode)
+{
+    memset (fe, 0, sizeof (*fe));
+    fe->fname = (char *) fname;
+    fe->fnamelen = strlen (fname);
+    fe->st.st_mode = mode;
+    fe->st.st_nlink = 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_mc_fhl_get_color_ds") */
+/* *INDENT-OFF* */
+static const struct test_mc_fhl_get_color_ds
+{
+    const char *fname;
+    mode_t mode;
+    const char *expected_group;
+} test_mc_fhl_get_color_ds[] =
+{
+    { "main.c", S_IFREG | 0644, "source" },
+    { "MAIN.C", S_IFREG | 0644, "source" },
+    { ".h", S_IFREG | 0644, "source" },
+    { "run.sh", S_IFREG | 0755, "executable" },
+    { "src.c", S_IFDIR | 0755, "directory" },
+    { "core", S_IFREG | 0644, "core" },
+    { "core.12", S_IFREG | 0644, "core" },
+    { "notes.txt~", S_IFREG | 0644, "temp" },
+    { "x.bak", S_IFREG | 0644, "temp" },
+    { "a.tar.gz", S_IFREG | 0644, "archive" },
+    { "a.gz", S_IFREG | 0644, "archive" },
+    { "b.Z", S_IFREG | 0644, "big" },
+    { "b.z", S_IFREG | 0644, NULL },
+    { "noext", S_IFREG | 0644, NULL },
+    { "file.", S_IFREG | 0644, NULL },
+    { "a.c.txt", S_IFREG | 0644, NULL },
+    { "main.py", S_IFREG | 0644, NULL },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_mc_fhl_get_color_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_mc_fhl_get_color, test_mc_fhl_get_color_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    file_entry_t fe;
+    int actual;
+
+    fill_entry (&fe, data->fname, data->mode);
+
+    /* when */
+    actual = mc_fhl_get_color (fhl, &fe);
+
+    /* then */
+    mctest_assert_int_eq (actual, expected_color (data->expected_group));
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_mc_fhl_get_color_cache)
+/* *INDENT-ON* */
+{
+    /* given */
+    file_entry_t fe;
+
+    fill_entry (&fe, "main.c", S_IFREG | 0644);
+    mctest_assert_int_eq (mc_fhl_get_color (fhl, &fe), expected_color ("source"));
+
+    /* when */
+    fe.color = 1000;
+
+    /* then: color is taken from entry while filters are the same */
+    mctest_assert_int_eq (mc_fhl_get_color (fhl, &fe), 1000);
+    mc_fhl_parse_ini_file (fhl);
+    mctest_assert_int_eq (mc_fhl_get_color (fhl, &fe), expected_color ("source"));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_mc_fhl_get_color, test_mc_fhl_get_color_ds);
+    tcase_add_test (tc_core, test_mc_fhl_get_color_cache);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "filehighlight.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,229 @@
+/*
+   lib - tests for byte scanning functions
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+
+#include "lib/memscan.h"
+
+/* long enough to cover several rounds of byte counters in vectorized counting */
+#define TEST_BUF_SIZE (32 * 1024 + 77)
+
+static char *test_buf;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    size_t i;
+
+    test_buf = g_malloc (TEST_BUF_SIZE);
+
+    for (i = 0; i < TEST_BUF_SIZE; i++)
+        test_buf[i] = (i * 7 + i / 13) % 61 == 0 ? '\n' : (i % 97 == 0 ? '\r' : 'a' + i % 26);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    g_free (test_buf);
+    mc_memscan_set_impl (MEMSCAN_AUTO);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static size_t
+count_slow (const char *s, char c, size_t n)
+{
+    size_t ret = 0;
+
+    for (; n != 0; n--)
+        if (*s++ == c)
+            ret++;
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+chr2_slow (const char *s, char c1, char c2, size_t n)
+{
+    for (; n != 0; n--, s++)
+        if (*s == c1 || *s == c2)
+            return s;
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+rchr2_slow (const char *s, char c1, char c2, size_t n)
+{
+    while (n-- != 0)
+        if (s[n] == c1 || s[n] == c2)
+            return s + n;
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_memscan_ds") */
+/* *INDENT-OFF* */
+static const struct test_memscan_ds
+{
+    memscan_impl_t impl;
+} test_memscan_ds[] =
+{
+    { MEMSCAN_SCALAR },
+    { MEMSCAN_SSE2 },
+    { MEMSCAN_AVX2 },
+    { MEMSCAN_AUTO }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_memscan_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_memscan, test_memscan_ds)
+/* *INDENT-ON* */
+{
+    size_t start, len;
+
+    /* given */
+    if (!mc_memscan_set_impl (data->impl))
+        return;                 /* not supported by this CPU or build */
+
+    /* when, then: all alignments and short lengths... */
+    for (start = 0; start < 64; start++)
+        for (len = 0; len < 200; len++)
+        {
+            const char *s = test_buf + start;
+
+            mctest_assert_int_eq (mc_memcount (s, '\n', len), count_slow (s, '\n', len));
+            mctest_assert_ptr_eq (mc_memchr2 (s, '\r', '\n', len), chr2_slow (s, '\r', '\n', len));
+            mctest_assert_ptr_eq (mc_memrchr2 (s, '\r', '\n', len),
+                                  rchr2_slow (s, '\r', '\n', len));
+            mctest_assert_ptr_eq (mc_memrchr (s, '\n', len), rchr2_slow (s, '\n', '\n', len));
+        }
+
+    /* ...and long blocks with no matches in the middle */
+    memset (test_buf + 100, 'x', TEST_BUF_SIZE - 200);
+    for (start = 0; start < 3; start++)
+    {
+        const char *s = test_buf + start;
+
+        len = TEST_BUF_SIZE - start;
+        mctest_assert_int_eq (mc_memcount (s, '\n', len), count_slow (s, '\n', len));
+        mctest_assert_int_eq (mc_memcount (s, 'x', len), count_slow (s, 'x', len));
+        mctest_assert_ptr_eq (mc_memchr2 (s + 100, '\r', '\n', len - 100),
+                              chr2_slow (s + 100, '\r', '\n', len - 100));
+        mctest_assert_ptr_eq (mc_memrchr2 (s, '\r', '\n', len - 100),
+                              rchr2_slow (s, '\r', '\n', len - 100));
+    }
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_memmem_ds") */
+/* *INDENT-OFF* */
+static const struct test_memmem_ds
+{
+    const char *haystack;
+    const char *needle;
+    int expected;               /* offset of needle or -1 */
+} test_memmem_ds[] =
+{
+    { "", "", 0 },
+    { "abc", "", 0 },
+    { "", "a", -1 },
+    { "abc", "abc", 0 },
+    { "abc", "abcd", -1 },
+    { "aaab", "aab", 1 },
+    { "abcabd", "abd", 3 },
+    { "abcab", "abd", -1 },
+    { "xyz\nfoo", "\nf", 3 }
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_memmem_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_memmem, test_memmem_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    const char *actual;
+
+    /* when */
+    actual = (const char *) mc_memmem (data->haystack, strlen (data->haystack), data->needle,
+                                       strlen (data->needle));
+
+    /* then */
+    if (data->expected < 0)
+        mctest_assert_null (actual);
+    else
+        mctest_assert_ptr_eq (actual, data->haystack + data->expected);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_memscan, test_memscan_ds);
+    mctest_add_parameterized_test (tc_core, test_memmem, test_memmem_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "memscan.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,116 @@
+/*
+   lib - throughput of byte scanning functions
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This is not a unit test: it is built by 'make check' but not run.
+ * Run ./memscan_bench [size in MiB] to see how fast every implementation scans
+ * a text with lines of typical length.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib/global.h"
+#include "lib/memscan.h"
+
+/*** file scope macro definitions ****************************************************************/
+
+#define BENCH_ROUNDS 8
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static double
+bench_gbps (size_t size, gint64 usec)
+{
+    return usec <= 0 ? 0.0 : (double) size * BENCH_ROUNDS / (double) usec / 1000.0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench (const char *buf, size_t size)
+{
+    gint64 t;
+    size_t lines = 0;
+    int i;
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+        lines += mc_memcount (buf, '\n', size);
+    t = g_get_monotonic_time () - t;
+    printf ("%-8s count  %6.2f GB/s (%zu lines)\n", mc_memscan_get_impl_name (),
+            bench_gbps (size, t), lines / BENCH_ROUNDS);
+
+    /* line by line as editor and viewer do */
+    t = g_get_monotonic_time ();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        const char *p = buf, *end = buf + size;
+
+        while (p < end && (p = (const char *) mc_memchr2 (p, '\r', '\n', end - p)) != NULL)
+            p++;
+    }
+    t = g_get_monotonic_time () - t;
+    printf ("%-8s chr2   %6.2f GB/s\n", mc_memscan_get_impl_name (), bench_gbps (size, t));
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        const char *p = buf + size;
+
+        while (p > buf && (p = (const char *) mc_memrchr2 (buf, '\r', '\n', p - buf)) != NULL)
+            ;
+    }
+    t = g_get_monotonic_time () - t;
+    printf ("%-8s rchr2  %6.2f GB/s\n", mc_memscan_get_impl_name (), bench_gbps (size, t));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (int argc, char **argv)
+{
+    static const memscan_impl_t impls[] = { MEMSCAN_SCALAR, MEMSCAN_SSE2, MEMSCAN_AVX2 };
+    size_t size, i;
+    char *buf;
+
+    size = (argc > 1 ? (size_t) atoi (argv[1]) : 64) * 1024 * 1024;
+    buf = g_malloc (size);
+
+    /* lines of 60 bytes on average */
+    srand (1);
+    for (i = 0; i < size; i++)
+        buf[i] = rand () % 60 == 0 ? '\n' : 'a' + i % 26;
+
+    for (i = 0; i < G_N_ELEMENTS (impls); i++)
+        if (mc_memscan_set_impl (impls[i]))
+            bench (buf, size);
+
+    g_free (buf);
+    return EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------- */
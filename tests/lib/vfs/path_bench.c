@@ -0,0 +1,143 @@
+/*
+   lib/vfs - throughput of vfs_path_t functions
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This is not a unit test: it is built by 'make check' but not run.
+ * Run ./path_bench [number of rounds] to see how fast paths are parsed, built from
+ * directory and name, cloned and freed.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lib/strutil.h"
+#include "lib/vfs/xdirentry.h"
+#include "lib/vfs/path.h"
+
+#include "src/vfs/local/local.cpp"
+
+/*** file scope macro definitions ****************************************************************/
+
+#define BENCH_NAME "filemanager.c"
+
+/*** file scope variables ************************************************************************/
+
+static struct vfs_class vfs_test_ops;
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench_report (const char *title, const char *dir, int rounds, gint64 usec)
+{
+    printf ("%-8s %8.0f ns  %s\n", title, (double) usec * 1000.0 / rounds, dir);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench (const char *dir, int rounds)
+{
+    vfs_path_t *vpath;
+    vfs_path_t **paths;
+    gint64 t;
+    int i;
+
+    paths = g_new (vfs_path_t *, rounds);
+    vpath = vfs_path_from_str (dir);
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < rounds; i++)
+        paths[i] = vfs_path_from_str (dir);
+    t = g_get_monotonic_time () - t;
+    bench_report ("parse", dir, rounds, t);
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < rounds; i++)
+        vfs_path_free (paths[i]);
+    t = g_get_monotonic_time () - t;
+    bench_report ("free", dir, rounds, t);
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < rounds; i++)
+        paths[i] = vfs_path_clone (vpath);
+    t = g_get_monotonic_time () - t;
+    bench_report ("clone", dir, rounds, t);
+
+    for (i = 0; i < rounds; i++)
+        vfs_path_free (paths[i]);
+
+    /* how vfs_path_append_new() worked before: string of directory is parsed again */
+    t = g_get_monotonic_time ();
+    for (i = 0; i < rounds; i++)
+        paths[i] =
+            vfs_path_build_filename (vfs_path_as_str (vpath), BENCH_NAME, (char *) NULL);
+    t = g_get_monotonic_time () - t;
+    bench_report ("build", dir, rounds, t);
+
+    for (i = 0; i < rounds; i++)
+        vfs_path_free (paths[i]);
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < rounds; i++)
+        paths[i] = vfs_path_append_new (vpath, BENCH_NAME, (char *) NULL);
+    t = g_get_monotonic_time () - t;
+    bench_report ("append", dir, rounds, t);
+
+    for (i = 0; i < rounds; i++)
+        vfs_path_free (paths[i]);
+
+    vfs_path_free (vpath);
+    g_free (paths);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (int argc, char **argv)
+{
+    int rounds;
+
+    rounds = argc > 1 ? atoi (argv[1]) : 1000000;
+
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    vfs_init_class (&vfs_test_ops, "testfs", VFSF_NOLINKS | VFSF_REMOTE, "test");
+    vfs_register_class (&vfs_test_ops);
+
+    bench ("/home/user/src/mc/src/filemanager", rounds);
+    bench ("/test://user@host:1234/home/user/src/mc/src/filemanager", rounds);
+
+    vfs_shut ();
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+
+    return EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,201 @@
+/*
+   lib/vfs - tests for pruning of cache directories
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "lib/util.h"
+#include "lib/vfs/utilvfs.h"
+
+#define DAY (24 * 60 * 60)
+
+static char *cache_dir = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    cache_dir = g_dir_make_tmp ("mc-prune-XXXXXX", NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    GDir *dir;
+    const char *name;
+
+    dir = g_dir_open (cache_dir, 0, NULL);
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+        char *file_name;
+
+        file_name = g_build_filename (cache_dir, name, (char *) NULL);
+        unlink (file_name);
+        g_free (file_name);
+    }
+    g_dir_close (dir);
+
+    rmdir (cache_dir);
+    MC_PTR_FREE (cache_dir);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+create_file (const char *name, size_t size, int days)
+{
+    char *file_name, *contents;
+    struct utimbuf times;
+
+    file_name = g_build_filename (cache_dir, name, (char *) NULL);
+    contents = g_strnfill (size, 'x');
+    g_file_set_contents (file_name, contents, size, NULL);
+    times.actime = times.modtime = time (NULL) - days * DAY;
+    utime (file_name, &times);
+    g_free (contents);
+    g_free (file_name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static bool
+file_exists (const char *name)
+{
+    char *file_name;
+    bool ret;
+
+    file_name = g_build_filename (cache_dir, name, (char *) NULL);
+    ret = g_file_test (file_name, G_FILE_TEST_EXISTS);
+    g_free (file_name);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_vfs_prune_cache_dir_age)
+/* *INDENT-ON* */
+{
+    /* given */
+    create_file ("new", 100, 0);
+    create_file ("old", 100, 40);
+    create_file ("older", 100, 400);
+
+    /* when */
+    vfs_prune_cache_dir (cache_dir, 30 * DAY, 1000);
+
+    /* then */
+    mctest_assert_true (file_exists ("new"));
+    mctest_assert_false (file_exists ("old"));
+    mctest_assert_false (file_exists ("older"));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_vfs_prune_cache_dir_size)
+/* *INDENT-ON* */
+{
+    /* given */
+    create_file ("a", 400, 3);
+    create_file ("b", 400, 1);
+    create_file ("c", 400, 2);
+    create_file ("d", 400, 0);
+
+    /* when */
+    vfs_prune_cache_dir (cache_dir, 30 * DAY, 1000);
+
+    /* then: the oldest ones are removed */
+    mctest_assert_false (file_exists ("a"));
+    mctest_assert_false (file_exists ("c"));
+    mctest_assert_true (file_exists ("b"));
+    mctest_assert_true (file_exists ("d"));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_vfs_prune_cache_dir_missing)
+/* *INDENT-ON* */
+{
+    char *missing;
+
+    missing = g_build_filename (cache_dir, "missing", (char *) NULL);
+
+    /* when */
+    vfs_prune_cache_dir (missing, 30 * DAY, 1000);
+
+    /* then */
+    mctest_assert_false (file_exists ("missing"));
+
+    g_free (missing);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_vfs_prune_cache_dir_age);
+    tcase_add_test (tc_core, test_vfs_prune_cache_dir_size);
+    tcase_add_test (tc_core, test_vfs_prune_cache_dir_missing);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_prune_cache_dir.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
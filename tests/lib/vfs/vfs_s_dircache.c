@@ -0,0 +1,293 @@
+/*
+   lib/vfs - tests for persistent cache of directory listings
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <unistd.h>
+
+#include "lib/strutil.h"
+#include "lib/vfs/direntry.cpp"   /* for testing static methods  */
+#include "lib/vfs/dircache.cpp"
+
+#include "src/vfs/local/local.cpp"
+
+#define TEST_KEY "testfs:user@host:pub"
+
+struct vfs_s_subclass test_subclass;
+static struct vfs_class *vfs_test_ops = VFS_CLASS (&test_subclass);
+
+static struct vfs_s_super *test_super = NULL;
+static struct vfs_s_inode *test_top = NULL;
+static char *listing_name = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_entry *
+test_add_entry (struct vfs_s_inode *dir, const char *name, mode_t mode, time_t mtime)
+{
+    struct vfs_s_entry *ent;
+
+    ent = vfs_s_generate_entry (vfs_test_ops, name, dir, mode);
+    ent->ino->st.st_mode = mode;
+    ent->ino->st.st_mtime = mtime;
+    vfs_s_insert_entry (vfs_test_ops, dir, ent);
+    return ent;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_inode *
+test_new_dir (void)
+{
+    struct vfs_s_inode *dir;
+
+    dir = vfs_s_new_inode (vfs_test_ops, test_super, NULL);
+    dir->st.st_mode = S_IFDIR | 0755;
+
+    return dir;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Linear file system: root directory of site "" contains directory "pub",
+ * "pub" contains file "f" and symlink "l".
+ */
+
+static struct vfs_s_inode *
+test_fill_pub (void)
+{
+    struct vfs_s_inode *pub;
+    struct vfs_s_entry *ent;
+
+    pub = test_new_dir ();
+    ent = test_add_entry (pub, "f", S_IFREG | 0644, 3072);
+    ent->ino->st.st_size = 102;
+    ent->ino->data_offset = 7;
+    ent = test_add_entry (pub, "l", S_IFLNK | 0777, 0);
+    ent->ino->linkname = g_strdup ("f");
+    pub->timestamp = mc_timer_elapsed (mc_global.timer) + 900 * G_USEC_PER_SEC;
+
+    return pub;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    struct vfs_s_entry *ent;
+    int fd;
+
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    vfs_init_subclass (&test_subclass, "testfs", VFSF_REMOTE | VFSF_DIRCACHE, "test");
+    vfs_register_class (vfs_test_ops);
+
+    test_super = vfs_s_new_super (vfs_test_ops);
+    test_super->root = vfs_s_new_inode (vfs_test_ops, test_super, NULL);
+    test_super->root->st.st_mode = S_IFDIR | 0755;
+
+    test_top = test_new_dir ();
+    ent = vfs_s_new_entry (vfs_test_ops, "", test_top);
+    vfs_s_insert_entry (vfs_test_ops, test_super->root, ent);
+    test_add_entry (test_top, "pub", S_IFDIR | 0755, 100);
+
+    fd = g_file_open_tmp ("vfs_s_dircacheXXXXXX", &listing_name, NULL);
+    close (fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    unlink (listing_name);
+    g_free (listing_name);
+
+    vfs_s_free_inode (vfs_test_ops, test_super->root);
+    g_free (test_super);
+
+    vfs_shut ();
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_die (const char *m)
+{
+    printf ("VFS_DIE: '%s'\n", m);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_dircache_read)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_inode *pub, *loaded;
+    struct vfs_s_entry *f, *l;
+    guint64 now;
+
+    pub = test_fill_pub ();
+    mctest_assert_true (vfs_s_dircache_write (pub, "pub", TEST_KEY, listing_name));
+    vfs_s_free_inode (vfs_test_ops, pub);
+
+    /* when */
+    loaded = test_new_dir ();
+    mctest_assert_true (vfs_s_dircache_read (loaded, "pub", TEST_KEY, listing_name));
+    now = mc_timer_elapsed (mc_global.timer);
+
+    /* then */
+    mctest_assert_int_eq (g_queue_get_length (loaded->subdir), 2);
+    f = vfs_s_subdir_find (loaded, "f");
+    l = vfs_s_subdir_find (loaded, "l");
+    mctest_assert_not_null (f);
+    mctest_assert_not_null (l);
+    mctest_assert_int_eq (f->ino->st.st_mode, S_IFREG | 0644);
+    mctest_assert_int_eq (f->ino->st.st_size, 102);
+    mctest_assert_int_eq (f->ino->st.st_mtime, 3072);
+    mctest_assert_int_eq (f->ino->data_offset, 7);
+    mctest_assert_null (f->ino->linkname);
+    mctest_assert_str_eq (l->ino->linkname, "f");
+
+    /* directory is not changed: listing lives as long as one read from server */
+    mctest_assert_true (loaded->cached);
+    ck_assert (loaded->timestamp > now + 800 * G_USEC_PER_SEC);
+
+    vfs_s_free_inode (vfs_test_ops, loaded);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_dircache_read_stale)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_inode *pub, *loaded;
+    guint64 now;
+
+    pub = test_fill_pub ();
+    mctest_assert_true (vfs_s_dircache_write (pub, "pub", TEST_KEY, listing_name));
+    vfs_s_free_inode (vfs_test_ops, pub);
+
+    /* when: parent directory is taken from cache too */
+    test_top->cached = true;
+    loaded = test_new_dir ();
+    mctest_assert_true (vfs_s_dircache_read (loaded, "pub", TEST_KEY, listing_name));
+    now = mc_timer_elapsed (mc_global.timer);
+
+    /* then */
+    ck_assert (loaded->timestamp <= now + VFS_S_DIRCACHE_STALE_LIFETIME * G_USEC_PER_SEC);
+    vfs_s_free_inode (vfs_test_ops, loaded);
+
+    /* when: directory is changed */
+    test_top->cached = false;
+    vfs_s_subdir_find (test_top, "pub")->ino->st.st_mtime = 101;
+    loaded = test_new_dir ();
+    mctest_assert_true (vfs_s_dircache_read (loaded, "pub", TEST_KEY, listing_name));
+    now = mc_timer_elapsed (mc_global.timer);
+
+    /* then */
+    ck_assert (loaded->timestamp <= now + VFS_S_DIRCACHE_STALE_LIFETIME * G_USEC_PER_SEC);
+    vfs_s_free_inode (vfs_test_ops, loaded);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_dircache_read_invalid)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_inode *pub, *loaded;
+
+    pub = test_fill_pub ();
+    mctest_assert_true (vfs_s_dircache_write (pub, "pub", TEST_KEY, listing_name));
+    vfs_s_free_inode (vfs_test_ops, pub);
+
+    loaded = test_new_dir ();
+
+    /* then: other directory, corrupted listing */
+    mctest_assert_false (vfs_s_dircache_read (loaded, "pub", "testfs:user@host:other",
+                                              listing_name));
+    mctest_assert_int_eq (truncate (listing_name, 100), 0);
+    mctest_assert_false (vfs_s_dircache_read (loaded, "pub", TEST_KEY, listing_name));
+    mctest_assert_int_eq (g_queue_get_length (loaded->subdir), 0);
+
+    vfs_s_free_inode (vfs_test_ops, loaded);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_vfs_s_dircache_read);
+    tcase_add_test (tc_core, test_vfs_s_dircache_read_stale);
+    tcase_add_test (tc_core, test_vfs_s_dircache_read_invalid);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_s_dircache.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,278 @@
+/*
+   lib/vfs - tests for cache of indexes of archives
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/strutil.h"
+#include "lib/vfs/direntry.cpp"   /* for testing static methods  */
+#include "lib/vfs/arcindex.cpp"
+
+#include "src/vfs/local/local.cpp"
+
+#define TEST_KEY "testfs:/tmp/test.tar"
+
+struct vfs_s_subclass test_subclass;
+static struct vfs_class *vfs_test_ops = VFS_CLASS (&test_subclass);
+
+static struct stat test_st;
+static char *index_name = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_super *
+test_new_super (void)
+{
+    struct vfs_s_super *super;
+
+    super = vfs_s_new_super (vfs_test_ops);
+    super->name = g_strdup ("/tmp/test.tar");
+    super->root = vfs_s_new_inode (vfs_test_ops, super, NULL);
+    super->root->st.st_mode = S_IFDIR | 0755;
+
+    return super;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+test_free_super (struct vfs_s_super *super)
+{
+    vfs_s_free_inode (vfs_test_ops, super->root);
+    g_free (super->name);
+    g_free (super);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_entry *
+test_add_entry (struct vfs_s_inode *dir, const char *name, mode_t mode, off_t offset)
+{
+    struct vfs_s_entry *ent;
+
+    ent = vfs_s_generate_entry (vfs_test_ops, name, dir, mode);
+    ent->ino->st.st_mode = mode;
+    ent->ino->data_offset = offset;
+    ent->ino->st.st_size = offset / 10;
+    ent->ino->st.st_mtime = offset * 3;
+    vfs_s_insert_entry (vfs_test_ops, dir, ent);
+    return ent;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * /d
+ * /d/f
+ * /d/e
+ * /h   hard link to /d/f
+ * /l   symlink to d/f
+ */
+
+static void
+test_fill_super (struct vfs_s_super *super)
+{
+    struct vfs_s_entry *d, *f, *l;
+
+    d = test_add_entry (super->root, "d", S_IFDIR | 0755, 0);
+    f = test_add_entry (d->ino, "f", S_IFREG | 0644, 1024);
+    test_add_entry (d->ino, "e", S_IFREG | 0600, 2048);
+    vfs_s_insert_entry (vfs_test_ops, super->root, vfs_s_new_entry (vfs_test_ops, "h", f->ino));
+    l = test_add_entry (super->root, "l", S_IFLNK | 0777, 4096);
+    l->ino->linkname = g_strdup ("d/f");
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int fd;
+
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    vfs_init_subclass (&test_subclass, "testfs", VFSF_READONLY, "test");
+    vfs_register_class (vfs_test_ops);
+
+    memset (&test_st, 0, sizeof (test_st));
+    test_st.st_size = 12345;
+    test_st.st_mtime = 67890;
+
+    fd = g_file_open_tmp ("vfs_s_indexXXXXXX", &index_name, NULL);
+    close (fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    unlink (index_name);
+    g_free (index_name);
+
+    vfs_shut ();
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_die (const char *m)
+{
+    printf ("VFS_DIE: '%s'\n", m);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_index_read)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_super *super, *loaded;
+    struct vfs_s_entry *f, *h, *l;
+    GList *iter;
+    const char *names[] = { "d", "h", "l" };
+    GString *data, *loaded_data = NULL;
+    int i;
+
+    super = test_new_super ();
+    test_fill_super (super);
+    data = g_string_new_len ("private\0data", 12);
+    mctest_assert_true (vfs_s_index_write (super, &test_st, TEST_KEY, data, index_name));
+    test_free_super (super);
+
+    /* when */
+    loaded = test_new_super ();
+    mctest_assert_true (vfs_s_index_read (loaded, &test_st, TEST_KEY, &loaded_data, index_name));
+
+    /* then */
+    for (i = 0, iter = g_queue_peek_head_link (loaded->root->subdir); iter != NULL;
+         i++, iter = g_list_next (iter))
+        mctest_assert_str_eq (VFS_ENTRY (iter->data)->name, names[i]);
+    mctest_assert_int_eq (i, G_N_ELEMENTS (names));
+
+    f = vfs_s_find_entry_tree (vfs_test_ops, loaded->root, "/d/f", LINK_NO_FOLLOW, FL_NONE);
+    h = vfs_s_find_entry_tree (vfs_test_ops, loaded->root, "/h", LINK_NO_FOLLOW, FL_NONE);
+    l = vfs_s_find_entry_tree (vfs_test_ops, loaded->root, "/l", LINK_NO_FOLLOW, FL_NONE);
+    mctest_assert_not_null (f);
+    mctest_assert_not_null (h);
+    mctest_assert_not_null (l);
+
+    mctest_assert_ptr_eq (f->ino, h->ino);
+    mctest_assert_int_eq (f->ino->st.st_nlink, 2);
+    mctest_assert_int_eq (f->ino->data_offset, 1024);
+    mctest_assert_int_eq (f->ino->st.st_size, 102);
+    mctest_assert_int_eq (f->ino->st.st_mtime, 3072);
+    mctest_assert_int_eq (f->ino->st.st_mode, S_IFREG | 0644);
+    mctest_assert_null (f->ino->linkname);
+    mctest_assert_str_eq (l->ino->linkname, "d/f");
+    ck_assert (S_ISDIR (f->dir->st.st_mode));
+
+    mctest_assert_not_null (loaded_data);
+    mctest_assert_int_eq (loaded_data->len, data->len);
+    ck_assert (memcmp (loaded_data->str, data->str, data->len) == 0);
+
+    g_string_free (loaded_data, TRUE);
+    g_string_free (data, TRUE);
+    test_free_super (loaded);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_index_read_changed)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_super *super;
+    struct stat st = test_st;
+
+    super = test_new_super ();
+    test_fill_super (super);
+    mctest_assert_true (vfs_s_index_write (super, &test_st, TEST_KEY, NULL, index_name));
+    test_free_super (super);
+
+    super = test_new_super ();
+
+    /* when */
+    st.st_mtime++;
+
+    /* then: archive was changed, other archive, corrupted index */
+    mctest_assert_false (vfs_s_index_read (super, &st, TEST_KEY, NULL, index_name));
+    mctest_assert_false (vfs_s_index_read (super, &test_st, "testfs:/tmp/other.tar", NULL,
+                                           index_name));
+    mctest_assert_int_eq (truncate (index_name, 200), 0);
+    mctest_assert_false (vfs_s_index_read (super, &test_st, TEST_KEY, NULL, index_name));
+    mctest_assert_int_eq (g_queue_get_length (super->root->subdir), 0);
+
+    test_free_super (super);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_vfs_s_index_read);
+    tcase_add_test (tc_core, test_vfs_s_index_read_changed);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_s_index.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
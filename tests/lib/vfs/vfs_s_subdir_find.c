@@ -0,0 +1,193 @@
+/*
+   lib/vfs - test vfs_s_subdir_find() function
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+#include "lib/vfs/direntry.cpp"   /* for testing static methods  */
+
+#include "src/vfs/local/local.cpp"
+
+struct vfs_s_subclass test_subclass;
+static struct vfs_class *vfs_test_ops = VFS_CLASS (&test_subclass);
+
+static struct vfs_s_super *test_super;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_entry *
+test_add_entry (struct vfs_s_inode *dir, const char *name)
+{
+    struct vfs_s_entry *ent;
+
+    ent = vfs_s_generate_entry (vfs_test_ops, name, dir, 0644 | S_IFREG);
+    vfs_s_insert_entry (vfs_test_ops, dir, ent);
+    return ent;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    vfs_init_subclass (&test_subclass, "testfs", VFSF_NOLINKS, "test");
+    vfs_register_class (vfs_test_ops);
+
+    test_super = vfs_s_new_super (vfs_test_ops);
+    test_super->root = vfs_s_new_inode (vfs_test_ops, test_super, NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    vfs_s_free_inode (vfs_test_ops, test_super->root);
+    g_free (test_super);
+
+    vfs_shut ();
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_die (const char *m)
+{
+    printf ("VFS_DIE: '%s'\n", m);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_subdir_find_small)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_inode *root = test_super->root;
+    struct vfs_s_entry *ent1, *ent2;
+
+    ent1 = test_add_entry (root, "file1");
+    ent2 = test_add_entry (root, "file2");
+
+    /* when */
+    /* then */
+    mctest_assert_ptr_eq (vfs_s_subdir_find (root, "file1"), ent1);
+    mctest_assert_ptr_eq (vfs_s_subdir_find (root, "file2"), ent2);
+    mctest_assert_null (vfs_s_subdir_find (root, "file3"));
+    mctest_assert_null (root->subdir_index);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_subdir_find_indexed)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_inode *root = test_super->root;
+    struct vfs_s_entry *ents[VFS_S_SUBDIR_INDEX_MIN * 2];
+    struct vfs_s_entry *dup, *late;
+    char name[32];
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS (ents); i++)
+    {
+        g_snprintf (name, sizeof (name), "file%zu", i);
+        ents[i] = test_add_entry (root, name);
+    }
+    dup = test_add_entry (root, "file1");
+
+    /* when */
+    /* then */
+    for (i = 0; i < G_N_ELEMENTS (ents); i++)
+    {
+        g_snprintf (name, sizeof (name), "file%zu", i);
+        mctest_assert_ptr_eq (vfs_s_subdir_find (root, name), ents[i]);
+    }
+    mctest_assert_not_null (root->subdir_index);
+
+    /* entries added after index build are found */
+    late = test_add_entry (root, "late");
+    mctest_assert_ptr_eq (vfs_s_subdir_find (root, "late"), late);
+
+    /* removed entries are not found */
+    vfs_s_free_entry (vfs_test_ops, late);
+    mctest_assert_null (vfs_s_subdir_find (root, "late"));
+
+    /* removal of the first of duplicated names uncovers the second one */
+    vfs_s_free_entry (vfs_test_ops, ents[1]);
+    mctest_assert_ptr_eq (vfs_s_subdir_find (root, "file1"), dup);
+
+    /* tree lookup uses the index too */
+    mctest_assert_ptr_eq (vfs_s_find_entry_tree (vfs_test_ops, root, "/file2", LINK_NO_FOLLOW,
+                                                 FL_NONE), ents[2]);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_vfs_s_subdir_find_small);
+    tcase_add_test (tc_core, test_vfs_s_subdir_find_indexed);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_s_subdir_find.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,453 @@
+/*
+   src/diffviewer - tests for comparison of texts
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/diffviewer"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+
+#include "src/diffviewer/engine.h"
+
+/* number of lines of large texts: head and tail of texts longer than 4 MiB are scanned
+   in parallel */
+#define TEST_LARGE_LINES 300000
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* hunks in format of normal output of diff(1), separated by spaces */
+static char *
+ops_to_string (const GArray * ops)
+{
+    GString *s;
+    guint i;
+
+    s = g_string_new ("");
+
+    for (i = 0; i < ops->len; i++)
+    {
+        const DIFFCMD *op = &g_array_index (ops, DIFFCMD, i);
+        int k;
+
+        if (i != 0)
+            g_string_append_c (s, ' ');
+
+        for (k = 0; k < 2; k++)
+        {
+            if (op->a[k][0] == op->a[k][1] || (op->cmd == 'a' && k == 0)
+                || (op->cmd == 'd' && k == 1))
+                g_string_append_printf (s, "%d", op->a[k][0]);
+            else
+                g_string_append_printf (s, "%d,%d", op->a[k][0], op->a[k][1]);
+
+            if (k == 0)
+                g_string_append_c (s, op->cmd);
+        }
+    }
+
+    return g_string_free (s, false);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_diff_compute_ds") */
+/* *INDENT-OFF* */
+static const struct test_diff_compute_ds
+{
+    const char *text1;
+    const char *text2;
+    diff_options_t opt;
+    const char *expected_ops;
+} test_diff_compute_ds[] =
+{
+    { /* 0. */
+        "a\nb\nc\n", "a\nb\nc\n",
+        { 0, false, false, false, false, false },
+        ""
+    },
+    { /* 1. */
+        "a\nb\nc\nd\ne", "a\nB\nc\ne\nf\ng",
+        { 0, false, false, false, false, false },
+        "2c2 4,5c4,6"
+    },
+    { /* 2. */
+        "", "a\nb\n",
+        { 0, false, false, false, false, false },
+        "0a1,2"
+    },
+    { /* 3. */
+        "a\nb\n", "",
+        { 0, false, false, false, false, false },
+        "1,2d0"
+    },
+    { /* 4. */
+        "a\nb\nc\n", "a\nc\n",
+        { 0, false, false, false, false, false },
+        "2d1"
+    },
+    { /* 5. */
+        "a\nc\n", "a\nb\nc\n",
+        { 2, false, false, false, false, false },
+        "1a2"
+    },
+    { /* 6. last line without newline */
+        "a\nb", "a\nb\n",
+        { 0, false, false, false, false, false },
+        "2c2"
+    },
+    { /* 7. */
+        "A\nb\n", "a\nb\n",
+        { 0, false, false, false, false, false },
+        "1c1"
+    },
+    { /* 8. */
+        "A\nb\n", "a\nb\n",
+        { 0, false, false, false, false, true },
+        ""
+    },
+    { /* 9. */
+        "a  b \nc\n", "a b\nc\n",
+        { 0, false, false, true, false, false },
+        ""
+    },
+    { /* 10. */
+        "a b\nc\n", "ab\nc\n",
+        { 0, false, false, true, false, false },
+        "1c1"
+    },
+    { /* 11. */
+        "a b\nc\n", "ab\nc\n",
+        { 1, false, false, false, true, false },
+        ""
+    },
+    { /* 12. */
+        "a\r\nb\r\n", "a\nb\n",
+        { 0, true, false, false, false, false },
+        ""
+    },
+    { /* 13. */
+        "\ta\n", "        a\n",
+        { 0, false, true, false, false, false },
+        ""
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_diff_compute_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_diff_compute, test_diff_compute_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    diff_text_t text1, text2;
+    GArray *ops;
+    char *actual_ops;
+    int actual_result;
+
+    diff_text_init (&text1, data->text1, strlen (data->text1));
+    diff_text_init (&text2, data->text2, strlen (data->text2));
+    ops = g_array_new (false, false, sizeof (DIFFCMD));
+
+    /* when */
+    actual_result = diff_compute (&text1, &text2, &data->opt, ops);
+    actual_ops = ops_to_string (ops);
+
+    /* then */
+    mctest_assert_int_eq (actual_result, (int) ops->len);
+    mctest_assert_str_eq (actual_ops, data->expected_ops);
+    mctest_assert_true (diff_ops_check (&text1, &text2, &data->opt, ops));
+
+    g_free (actual_ops);
+    g_array_free (ops, true);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_diff_ops_merge)
+/* *INDENT-ON* */
+{
+    /* given */
+    static const diff_options_t opt = { 0, false, false, false, false, false };
+    static const char *data1 = "a\nb\nc\nd\ne\nf\n";
+    static const char *data2 = "a\nB\nc\nD\nD\ne\nF\n";
+    static const char *merged2 = "a\nB\nc\nd\ne\nF\n";
+    diff_text_t text1, text2;
+    GArray *ops;
+    char *actual_ops;
+
+    diff_text_init (&text1, data1, strlen (data1));
+    diff_text_init (&text2, data2, strlen (data2));
+    ops = g_array_new (false, false, sizeof (DIFFCMD));
+    diff_compute (&text1, &text2, &opt, ops);
+    actual_ops = ops_to_string (ops);
+    mctest_assert_str_eq (actual_ops, "2c2 4c4,5 6c7");
+    g_free (actual_ops);
+
+    /* when */
+    diff_ops_merge (ops, 1, 0);
+    diff_text_init (&text2, merged2, strlen (merged2));
+
+    /* then */
+    actual_ops = ops_to_string (ops);
+    mctest_assert_str_eq (actual_ops, "2c2 6c6");
+    mctest_assert_true (diff_ops_check (&text1, &text2, &opt, ops));
+
+    /* the 2nd text was changed by somebody else */
+    diff_text_init (&text2, data2, strlen (data2));
+    mctest_assert_false (diff_ops_check (&text1, &text2, &opt, ops));
+
+    g_free (actual_ops);
+    g_array_free (ops, true);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Make large text of different lines.
+ *
+ * @param edits pairs of line number and edit of line: 'c' to change, 'd' to delete, 'a' to add
+ *        a line after it; terminated by 0
+ * @param newline the last line has newline
+ */
+
+static GString *
+make_large_text (const int (*edits)[2], bool newline)
+{
+    GString *s;
+    int i;
+
+    s = g_string_sized_new (TEST_LARGE_LINES * 16);
+
+    for (i = 1; i <= TEST_LARGE_LINES; i++)
+    {
+        int k;
+        char edit = '\0';
+
+        for (k = 0; edits != NULL && edits[k][0] != 0; k++)
+            if (edits[k][0] == i)
+                edit = (char) edits[k][1];
+
+        if (edit == 'c')
+            g_string_append_printf (s, "changed %d\n", i);
+        else if (edit != 'd')
+            g_string_append_printf (s, "%d %x\n", i, i * 2654435761U);
+        if (edit == 'a')
+            g_string_append_printf (s, "added %d\n", i);
+    }
+
+    if (!newline)
+        g_string_truncate (s, s->len - 1);
+
+    ck_assert_int_gt (s->len, 4 * 1024 * 1024);
+
+    return s;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_diff_compute_large_ds") */
+/* *INDENT-OFF* */
+static const struct test_diff_compute_large_ds
+{
+    int edits[4][2];
+    bool newline1;
+    bool newline2;
+    diff_options_t opt;
+} test_diff_compute_large_ds[] =
+{
+    { /* 0. near both ends and near the middle */
+        { { 2, 'c' }, { TEST_LARGE_LINES / 2, 'd' }, { TEST_LARGE_LINES - 2, 'a' }, { 0, 0 } },
+        false, false,
+        { 0, false, false, false, false, false }
+    },
+    { /* 1. the same, lines are compared one by one */
+        { { 2, 'c' }, { TEST_LARGE_LINES / 2, 'd' }, { TEST_LARGE_LINES - 2, 'a' }, { 0, 0 } },
+        false, false,
+        { 0, false, false, false, false, true }
+    },
+    { /* 2. the last line without newline is changed */
+        { { TEST_LARGE_LINES, 'c' }, { 0, 0 } },
+        false, false,
+        { 0, false, false, false, false, false }
+    },
+    { /* 3. newline is added to the last line */
+        { { 0, 0 } },
+        false, true,
+        { 0, false, false, false, false, false }
+    },
+    { /* 4. the middle line only */
+        { { TEST_LARGE_LINES / 2 + 1, 'c' }, { 0, 0 } },
+        false, false,
+        { 0, false, false, false, false, false }
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_diff_compute_large_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_diff_compute_large, test_diff_compute_large_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    GString *data1, *data2;
+    diff_text_t text1, text2;
+    GArray *ops, *expected_ops;
+    char *actual, *expected;
+
+    data1 = make_large_text (NULL, data->newline1);
+    data2 = make_large_text (data->edits, data->newline2);
+    diff_text_init (&text1, data1->str, data1->len);
+    diff_text_init (&text2, data2->str, data2->len);
+    ops = g_array_new (false, false, sizeof (DIFFCMD));
+    expected_ops = g_array_new (false, false, sizeof (DIFFCMD));
+
+    diff_set_parallel (false);
+    diff_compute (&text1, &text2, &data->opt, expected_ops);
+    expected = ops_to_string (expected_ops);
+
+    /* when */
+    diff_set_parallel (true);
+    diff_compute (&text1, &text2, &data->opt, ops);
+    actual = ops_to_string (ops);
+
+    /* then */
+    mctest_assert_str_eq (actual, expected);
+    mctest_assert_int_ne (ops->len, 0);
+    mctest_assert_true (diff_ops_check (&text1, &text2, &data->opt, ops));
+
+    g_free (expected);
+    g_free (actual);
+    g_array_free (expected_ops, true);
+    g_array_free (ops, true);
+    g_string_free (data2, true);
+    g_string_free (data1, true);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_diff_compute_overlap_ds") */
+/* *INDENT-OFF* */
+static const struct test_diff_compute_overlap_ds
+{
+    diff_options_t opt;
+} test_diff_compute_overlap_ds[] =
+{
+    { { 0, false, false, false, false, false } },
+    { { 0, false, false, false, false, true } },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_diff_compute_overlap_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_diff_compute_overlap, test_diff_compute_overlap_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    char *data1, *data2;
+    diff_text_t text1, text2;
+    size_t i;
+    int k;
+
+    /* lines are equal: scans of head and tail can pass each other, the place of added lines
+       is arbitrary */
+    data1 = g_strnfill (2 * TEST_LARGE_LINES * 8, 'x');
+    data2 = g_strnfill (2 * TEST_LARGE_LINES * 8 + 10 * 8, 'x');
+    for (i = 7; data2[i] != '\0'; i += 8)
+    {
+        data2[i] = '\n';
+        if (data1[i] != '\0')
+            data1[i] = '\n';
+    }
+    diff_text_init (&text1, data1, strlen (data1));
+    diff_text_init (&text2, data2, strlen (data2));
+    diff_set_parallel (true);
+
+    /* scans meet at different moments */
+    for (k = 0; k < 20; k++)
+    {
+        GArray *ops;
+        const DIFFCMD *op;
+
+        ops = g_array_new (false, false, sizeof (DIFFCMD));
+
+        /* when */
+        diff_compute (&text1, &text2, &data->opt, ops);
+
+        /* then */
+        mctest_assert_int_eq (ops->len, 1);
+        op = &g_array_index (ops, DIFFCMD, 0);
+        mctest_assert_int_eq (op->cmd, 'a');
+        mctest_assert_int_eq (op->a[1][1] - op->a[1][0] + 1, 10);
+        mctest_assert_int_eq (op->a[1][0], op->a[0][0] + 1);
+        mctest_assert_true (diff_ops_check (&text1, &text2, &data->opt, ops));
+
+        g_array_free (ops, true);
+    }
+
+    g_free (data2);
+    g_free (data1);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_set_timeout (tc_core, 60);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_diff_compute, test_diff_compute_ds);
+    tcase_add_test (tc_core, test_diff_ops_merge);
+    mctest_add_parameterized_test (tc_core, test_diff_compute_large, test_diff_compute_large_ds);
+    mctest_add_parameterized_test (tc_core, test_diff_compute_overlap,
+                                   test_diff_compute_overlap_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "engine__diff_compute.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,367 @@
+/*
+   src/editor - tests for line counters of editor buffer
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "src/editor/editbuffer.cpp"
+
+static edit_buffer_t test_buf;
+
+/* the same text kept as a plain string */
+static GString *test_text = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    srand (EDIT_BUF_SIZE);
+    edit_buffer_init (&test_buf, 0);
+    test_text = g_string_new ("");
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    edit_buffer_clean (&test_buf);
+    g_string_free (test_text, true);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Move cursor the same way as editor does it.
+ */
+
+static void
+move_cursor (off_t pos)
+{
+    while (test_buf.curs1 > pos)
+        edit_buffer_insert_ahead (&test_buf, edit_buffer_backspace (&test_buf));
+
+    while (test_buf.curs1 < pos)
+        edit_buffer_insert (&test_buf, edit_buffer_delete (&test_buf));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Insert random text both before and after the cursor.
+ *
+ * @param pos insert position
+ * @param len length of text
+ * @param rate average distance between newlines, 0 means no newlines
+ */
+
+static void
+insert_text (off_t pos, size_t len, int rate)
+{
+    GString *before, *after;
+    size_t i;
+
+    move_cursor (pos);
+
+    before = g_string_sized_new (len);
+    after = g_string_sized_new (len);
+
+    for (i = 0; i < len; i++)
+    {
+        char c;
+
+        c = (rate != 0 && rand () % rate == 0) ? '\n' : 'a' + rand () % 26;
+
+        if (rand () % 2 == 0)
+        {
+            edit_buffer_insert (&test_buf, c);
+            g_string_append_c (before, c);
+        }
+        else
+        {
+            edit_buffer_insert_ahead (&test_buf, c);
+            g_string_prepend_c (after, c);
+        }
+    }
+
+    g_string_append_len (before, after->str, after->len);
+    g_string_insert_len (test_text, pos, before->str, before->len);
+
+    g_string_free (before, true);
+    g_string_free (after, true);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Delete text around the cursor.
+ *
+ * @param pos cursor position
+ * @param back number of bytes to delete before the cursor
+ * @param forward number of bytes to delete after the cursor
+ */
+
+static void
+delete_text (off_t pos, off_t back, off_t forward)
+{
+    off_t i;
+
+    move_cursor (pos);
+
+    for (i = 0; i < back; i++)
+        edit_buffer_backspace (&test_buf);
+    for (i = 0; i < forward; i++)
+        edit_buffer_delete (&test_buf);
+
+    g_string_erase (test_text, pos - back, back + forward);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_position (off_t pos, const long *before, const off_t * offsets)
+{
+    const off_t size = (off_t) test_text->len;
+    const long lines = before[size];
+    const long line = before[pos];
+    off_t eol;
+    long k;
+
+    mctest_assert_int_eq (edit_buffer_count_lines (&test_buf, 0, pos), line);
+    mctest_assert_int_eq (edit_buffer_count_lines (&test_buf, pos, size), lines - line);
+    mctest_assert_int_eq (edit_buffer_count_lines (&test_buf, pos, pos + EDIT_BUF_SIZE + 1),
+                          before[MIN (pos + EDIT_BUF_SIZE + 1, size)] - line);
+
+    mctest_assert_int_eq (edit_buffer_get_bol (&test_buf, pos), offsets[line]);
+
+    eol = line < lines ? offsets[line + 1] - 1 : size;
+    mctest_assert_int_eq (edit_buffer_get_eol (&test_buf, pos), eol);
+
+    for (k = 0; k <= 1000; k = k * 5 + 1)
+    {
+        off_t forward, backward;
+
+        if (line + k <= lines)
+            forward = offsets[line + k];
+        else
+            forward = line < lines ? offsets[lines] : pos;
+        if (k == 0)
+            forward = pos;
+
+        backward = offsets[MAX (line - k, 0)];
+
+        mctest_assert_int_eq (edit_buffer_get_forward_offset (&test_buf, pos, k, 0), forward);
+        mctest_assert_int_eq (edit_buffer_get_backward_offset (&test_buf, pos, k), backward);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Compare results of line functions with the brute-force count of newlines in the plain text.
+ * Positions around all buffer boundaries of b1 and b2 are checked, and every 997th one.
+ */
+
+static void
+check_lines (void)
+{
+    const off_t size = (off_t) test_text->len;
+    long *before;
+    off_t *offsets;
+    long line;
+    off_t pos;
+
+    mctest_assert_int_eq (test_buf.size, size);
+    mctest_assert_int_eq (test_buf.curs1 + test_buf.curs2, size);
+
+    /* before[i] is number of '\n' in text[0]...text[i - 1],
+       offsets[n] is offset of the line n */
+    before = g_new (long, size + 1);
+    offsets = g_new (off_t, size + 2);
+
+    before[0] = 0;
+    offsets[0] = 0;
+    for (pos = 0; pos < size; pos++)
+    {
+        before[pos + 1] = before[pos];
+        if (test_text->str[pos] == '\n')
+            offsets[++before[pos + 1]] = pos + 1;
+    }
+
+    for (line = -1; line <= before[size] + 1; line++)
+    {
+        off_t expected;
+
+        if (line <= 0)
+            expected = 0;
+        else if (line > before[size])
+            expected = size;
+        else
+            expected = offsets[line];
+
+        mctest_assert_int_eq (edit_buffer_get_line_offset (&test_buf, line), expected);
+    }
+
+    for (pos = 0; pos < size; pos += 997)
+        check_position (pos, before, offsets);
+
+    for (pos = 0; pos <= size + 1; pos += EDIT_BUF_SIZE)
+    {
+        off_t d;
+
+        for (d = -1; d <= 1; d++)
+        {
+            /* boundaries of b1 and b2 buffers */
+            if (pos + d >= 0 && pos + d <= size)
+                check_position (pos + d, before, offsets);
+            if (size - pos + d >= 0 && size - pos + d <= size)
+                check_position (size - pos + d, before, offsets);
+        }
+    }
+
+    check_position (size, before, offsets);
+
+    g_free (offsets);
+    g_free (before);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_lines_insert)
+/* *INDENT-ON* */
+{
+    int i;
+
+    /* when */
+    insert_text (0, 2 * EDIT_BUF_SIZE + 100, 50);
+    /* then */
+    check_lines ();
+
+    /* when: long line over several buffers */
+    insert_text (EDIT_BUF_SIZE - 10, EDIT_BUF_SIZE + 5000, 0);
+    /* then */
+    check_lines ();
+
+    /* when: newlines right at boundaries */
+    insert_text (EDIT_BUF_SIZE, 1, 1);
+    insert_text (test_text->len - EDIT_BUF_SIZE, 1, 1);
+    insert_text (test_text->len, 3, 1);
+    move_cursor (EDIT_BUF_SIZE);
+    /* then */
+    check_lines ();
+
+    for (i = 0; i < 10; i++)
+    {
+        /* when */
+        insert_text (rand () % (test_text->len + 1), 1 + rand () % 20000, 1 + rand () % 100);
+        /* then */
+        check_lines ();
+
+        /* when: only the cursor is moved */
+        move_cursor (rand () % (test_text->len + 1));
+        /* then */
+        check_lines ();
+    }
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_lines_delete)
+/* *INDENT-ON* */
+{
+    int i;
+
+    /* given */
+    insert_text (0, 4 * EDIT_BUF_SIZE + 333, 40);
+    insert_text (EDIT_BUF_SIZE / 2, EDIT_BUF_SIZE, 0);
+
+    /* when: across boundary of buffers */
+    delete_text (EDIT_BUF_SIZE + 5, 20, 20);
+    /* then */
+    check_lines ();
+
+    /* when: more than one buffer on both sides of the cursor */
+    delete_text (2 * EDIT_BUF_SIZE, EDIT_BUF_SIZE + 7, EDIT_BUF_SIZE + 9);
+    /* then */
+    check_lines ();
+
+    for (i = 0; i < 10; i++)
+    {
+        off_t pos, back, forward;
+
+        /* when */
+        pos = rand () % (test_text->len + 1);
+        back = MIN (pos, rand () % 10000);
+        forward = MIN ((off_t) test_text->len - pos, rand () % 10000);
+        delete_text (pos, back, forward);
+        /* then */
+        check_lines ();
+    }
+
+    /* when: all text */
+    delete_text (test_text->len / 2, test_text->len / 2, test_text->len - test_text->len / 2);
+    /* then */
+    check_lines ();
+    mctest_assert_int_eq (test_buf.b1->len, 0);
+    mctest_assert_int_eq (test_buf.b2->len, 0);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_edit_buffer_lines_insert);
+    tcase_add_test (tc_core, test_edit_buffer_lines_delete);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editbuffer__line_counters.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
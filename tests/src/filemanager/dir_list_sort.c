@@ -0,0 +1,286 @@
+/*
+   src/filemanager - tests for sorting of directory list
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+
+#include "src/filemanager/dir.cpp"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    str_uninit_strings ();
+    panels_options.mix_all_files = false;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Fill list with files of random type, size and times. Names contain index of file.
+ */
+
+static void
+fill_list (dir_list * list, int len)
+{
+    static const char *ext[] = { "c", "h", "", "tar.gz" };
+    int i;
+
+    dir_list_init (list);
+
+    srand (len);
+    for (i = 0; i < len; i++)
+    {
+        char name[32];
+        struct stat st;
+
+        g_snprintf (name, sizeof (name), "%s%c%07d.%s", i % 9 == 0 ? "." : "", 'a' + rand () % 26,
+                    i, ext[rand () % G_N_ELEMENTS (ext)]);
+
+        memset (&st, 0, sizeof (st));
+        st.st_mode = rand () % 3 == 0 ? S_IFDIR | 0755 : S_IFREG | (rand () % 2 ? 0755 : 0644);
+        st.st_size = rand () % 100;
+        st.st_mtime = rand () % 100 - 50;
+        st.st_atime = rand () % 100;
+        st.st_ctime = rand () % 3;
+        st.st_ino = rand () % 100000;
+
+        dir_list_append (list, name, &st, false, false);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_dir_list_sort_ds") */
+/* *INDENT-OFF* */
+static const struct test_dir_list_sort_ds
+{
+    GCompareFunc sort;
+    bool reverse;
+    bool mix_all_files;
+    int len;
+} test_dir_list_sort_ds[] =
+{
+    { (GCompareFunc) sort_name, false, false, 1 },
+    { (GCompareFunc) sort_name, false, false, 1000 },
+    { (GCompareFunc) sort_name, true, false, 1000 },
+    { (GCompareFunc) sort_name, false, true, 1000 },
+    { (GCompareFunc) sort_vers, false, false, 1000 },
+    { (GCompareFunc) sort_ext, true, false, 1000 },
+    { (GCompareFunc) sort_time, false, false, 1000 },
+    { (GCompareFunc) sort_atime, true, true, 1000 },
+    { (GCompareFunc) sort_ctime, false, false, 1000 },
+    { (GCompareFunc) sort_size, true, false, 1000 },
+    { (GCompareFunc) sort_inode, false, true, 1000 },
+#ifdef DIR_SORT_THREADS
+    { (GCompareFunc) sort_name, false, false, DIR_SORT_PARALLEL_MIN + 3 },
+    { (GCompareFunc) sort_size, true, false, DIR_SORT_PARALLEL_MIN + 3 },
+#endif
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_dir_list_sort_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_dir_list_sort, test_dir_list_sort_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_sort_options_t sort_op = { false, true, true };
+    bool *found;
+    int i;
+
+    sort_op.reverse = data->reverse;
+    panels_options.mix_all_files = data->mix_all_files;
+    fill_list (&list, data->len);
+
+    /* when */
+    dir_list_sort (&list, data->sort, &sort_op);
+
+    /* then */
+    mctest_assert_str_eq (list.list[0].fname, "..");
+    mctest_assert_int_eq (list.len, data->len + 1);
+
+    found = g_new0 (bool, data->len);
+    for (i = 1; i < list.len; i++)
+    {
+        const char *digits;
+        int index;
+
+        mctest_assert_null (list.list[i].sort_key);
+        mctest_assert_null (list.list[i].second_sort_key);
+
+        digits = strpbrk (list.list[i].fname, "0123456789");
+        index = atoi (digits);
+        ck_assert (!found[index]);
+        found[index] = true;
+
+        /* the same order as sort routine gives */
+        if (i > 1)
+            ck_assert_int_le (data->sort (&list.list[i - 1], &list.list[i]), 0);
+    }
+    g_free (found);
+
+    clean_sort_keys (&list, 1, list.len - 1);
+    dir_list_free_list (&list);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_dir_list_insert)
+/* *INDENT-ON* */
+{
+    /* given */
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_sort_options_t sort_op = { false, true, true };
+    dir_list sorted = { NULL, 0, 0, NULL };
+    int i;
+
+    fill_list (&sorted, 300);
+    dir_list_sort (&sorted, (GCompareFunc) sort_time, &sort_op);
+    dir_list_init (&list);
+
+    /* when */
+    for (i = sorted.len - 1; i > 0; i--)
+    {
+        int idx;
+
+        idx = dir_list_insert (&list, sorted.list[i].fname, &sorted.list[i].st, false, false,
+                               (GCompareFunc) sort_time, &sort_op);
+        mctest_assert_str_eq (list.list[idx].fname, sorted.list[i].fname);
+    }
+    for (i = 1; i < sorted.len; i += 3)
+        dir_list_remove (&list, dir_list_find (&list, sorted.list[i].fname));
+
+    /* then */
+    mctest_assert_str_eq (list.list[0].fname, "..");
+    mctest_assert_int_eq (list.len, 1 + (sorted.len - 1) * 2 / 3);
+    for (i = 1; i < sorted.len; i++)
+        mctest_assert_int_eq (dir_list_find (&list, sorted.list[i].fname) == -1, i % 3 == 1);
+    for (i = 2; i < list.len; i++)
+        ck_assert_int_le (sort_time (&list.list[i - 1], &list.list[i]), 0);
+
+    clean_sort_keys (&list, 1, list.len - 1);
+    dir_list_free_list (&list);
+    dir_list_free_list (&sorted);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_dir_list_index)
+/* *INDENT-ON* */
+{
+    /* given */
+    dir_list list = { NULL, 0, 0, NULL };
+    dir_list sorted = { NULL, 0, 0, NULL };
+    dir_sort_options_t sort_op = { false, true, true };
+    GHashTable *index;
+    bool *remove;
+    int i;
+
+    fill_list (&list, 300);
+    dir_list_sort (&list, (GCompareFunc) sort_size, &sort_op);
+    fill_list (&sorted, 300);
+    dir_list_sort (&sorted, (GCompareFunc) sort_size, &sort_op);
+
+    /* when */
+    index = dir_list_make_index (&list);
+
+    /* then */
+    for (i = 0; i < list.len; i++)
+        mctest_assert_int_eq (dir_list_index_find (index, list.list[i].fname), i);
+    mctest_assert_int_eq (dir_list_index_find (index, "missing"), -1);
+
+    g_hash_table_destroy (index);
+
+    /* when */
+    remove = g_new0 (bool, list.len);
+    for (i = 1; i < list.len; i += 3)
+        remove[i] = true;
+    dir_list_remove_files (&list, remove);
+    g_free (remove);
+
+    /* then: the order of other files is kept */
+    mctest_assert_int_eq (list.len, 1 + (sorted.len - 1) * 2 / 3);
+    for (i = 0; i < list.len; i++)
+        mctest_assert_str_eq (list.list[i].fname, sorted.list[i + (i + 1) / 2].fname);
+
+    clean_sort_keys (&list, 1, list.len - 1);
+    clean_sort_keys (&sorted, 1, sorted.len - 1);
+    dir_list_free_list (&list);
+    dir_list_free_list (&sorted);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_dir_list_sort, test_dir_list_sort_ds);
+    tcase_add_test (tc_core, test_dir_list_insert);
+    tcase_add_test (tc_core, test_dir_list_index);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "dir_list_sort.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
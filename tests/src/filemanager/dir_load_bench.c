@@ -0,0 +1,167 @@
+/*
+   src/filemanager - time of loading of large directories
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This is not a unit test: it is built by 'make check' but not run.
+ * Run ./dir_load_bench [number of files] [directory] to compare loading of directory
+ * with files stat'ed one by one through VFS and with files stat'ed by batches.
+ * Pass a directory on network file system to see the effect of parallel stat.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "src/vfs/local/local.cpp"
+
+#include "src/filemanager/dir.cpp"
+
+/*** file scope macro definitions ****************************************************************/
+
+#define BENCH_ROUNDS 3
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+/* load directory as it was done before files were stat'ed by batches */
+static bool
+load_by_entries (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
+                 const dir_sort_options_t * sort_op, const char *fltr)
+{
+    DIR *dirp;
+    struct dirent *dp;
+    bool ret = true;
+
+    if (!dir_list_init (list))
+        return false;
+
+    dirp = mc_opendir (vpath);
+    if (dirp == NULL)
+        return false;
+
+    while (ret && (dp = mc_readdir (dirp)) != NULL)
+    {
+        struct stat st;
+        bool link_to_dir, stale_link;
+
+        if (handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
+            ret = dir_list_append (list, dp->d_name, &st, link_to_dir, stale_link);
+    }
+
+    if (ret)
+        dir_list_sort (list, sort, sort_op);
+
+    mc_closedir (dirp);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench (const char *title, const vfs_path_t * vpath,
+       bool (*load) (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
+                     const dir_sort_options_t * sort_op, const char *fltr))
+{
+    dir_sort_options_t sort_op = { false, true, true };
+    dir_list list = { NULL, 0, 0, NULL };
+    gint64 t;
+    int i;
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        dir_list_free_list (&list);
+        load (&list, vpath, (GCompareFunc) unsorted, &sort_op, NULL);
+    }
+    t = g_get_monotonic_time () - t;
+
+    printf ("%-8s %10.1f ms (%d entries)\n", title, (double) t / BENCH_ROUNDS / 1000.0,
+            list.len);
+
+    dir_list_free_list (&list);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (int argc, char **argv)
+{
+    int count, i;
+    char *dir;
+    vfs_path_t *vpath;
+
+    count = argc > 1 ? atoi (argv[1]) : 100000;
+    dir = g_build_filename (argc > 2 ? argv[2] : g_get_tmp_dir (), "dir_load_bench.XXXXXX", NULL);
+    if (g_mkdtemp (dir) == NULL)
+        return EXIT_FAILURE;
+
+    /* regular files mostly, some directories and symlinks */
+    for (i = 0; i < count; i++)
+    {
+        char name[MC_MAXPATHLEN];
+
+        g_snprintf (name, sizeof (name), "%s/%07d", dir, i);
+        if (i % 50 == 0)
+            mkdir (name, 0700);
+        else if (i % 50 == 1)
+            symlink ("0000000", name);
+        else
+            close (open (name, O_WRONLY | O_CREAT, 0600));
+    }
+
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    vpath = vfs_path_from_str (dir);
+    mc_chdir (vpath);
+
+    bench ("entries", vpath, load_by_entries);
+    bench ("batches", vpath, dir_list_load);
+
+    vfs_path_free (vpath);
+    vfs_shut ();
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+
+    for (i = 0; i < count; i++)
+    {
+        char name[MC_MAXPATHLEN];
+
+        g_snprintf (name, sizeof (name), "%s/%07d", dir, i);
+        if (i % 50 == 0)
+            rmdir (name);
+        else
+            unlink (name);
+    }
+    rmdir (dir);
+    g_free (dir);
+
+    return EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------- */
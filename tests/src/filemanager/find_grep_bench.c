@@ -0,0 +1,196 @@
+/*
+   src/filemanager - throughput of content search of Find File
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This is not a unit test: it is built by 'make check' but not run.
+ * Run ./find_grep_bench [size in MiB] to compare content search in whole blocks of file
+ * with search in lines fetched one by one from small buffer.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "src/filemanager/find.cpp"
+
+/*** file scope macro definitions ****************************************************************/
+
+#define BENCH_ROUNDS 4
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef FIND_GREP_THREADS
+/* search in lines fetched one by one, as it was done before file was searched in blocks */
+static void
+grep_by_lines (int fd, mc_search_t * handle, GArray * matches)
+{
+    find_line_reader_t reader;
+    int line = 1;
+    off_t off = 0;
+    gboolean found = FALSE;
+    int i = -1;
+
+    reader.fd = fd;
+    reader.read = read;
+    reader.pos = 0;
+    reader.n_read = 0;
+    reader.strbuf = NULL;
+    reader.strbuf_size = 0;
+
+    while (TRUE)
+    {
+        char ch;
+        gsize found_len;
+
+        off += i + 1;
+        i = find_line_reader_get (&reader, &off, &ch);
+
+        if (i == 0 && ch == '\0')
+            break;
+
+        if (i != 0)
+        {
+            reader.strbuf[i] = '\0';
+
+            if (!found && mc_search_run (handle, reader.strbuf, 0, i, &found_len))
+            {
+                find_grep_match_t m;
+
+                m.line = line;
+                m.start = off + handle->normal_offset + 1;
+                m.end = m.start + found_len;
+                g_array_append_val (matches, m);
+                found = TRUE;
+            }
+        }
+
+        if (ch == '\n')
+        {
+            found = FALSE;
+            line++;
+        }
+    }
+
+    g_free (reader.strbuf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+bench (const char *title, int fd, size_t size, mc_search_t * handle,
+       void (*grep) (int fd, mc_search_t * handle, GArray * matches))
+{
+    GArray *matches;
+    gint64 t;
+    int i;
+
+    matches = g_array_new (FALSE, FALSE, sizeof (find_grep_match_t));
+
+    t = g_get_monotonic_time ();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        g_array_set_size (matches, 0);
+        lseek (fd, 0, SEEK_SET);
+        grep (fd, handle, matches);
+    }
+    t = g_get_monotonic_time () - t;
+
+    printf ("%-8s %-8s %8.1f MB/s (%u matches)\n", handle->original, title,
+            t <= 0 ? 0.0 : (double) size * BENCH_ROUNDS / (double) t, matches->len);
+
+    g_array_free (matches, TRUE);
+}
+#endif /* FIND_GREP_THREADS */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (int argc, char **argv)
+{
+#ifdef FIND_GREP_THREADS
+    static const struct
+    {
+        const char *pattern;
+        gboolean regexp;
+        gboolean case_sens;
+    } searches[] =
+    {
+        /* *INDENT-OFF* */
+        { "needle", FALSE, TRUE },
+        { "needle", FALSE, FALSE },
+        { "ne+dle", TRUE, TRUE }
+        /* *INDENT-ON* */
+    };
+
+    size_t size, i;
+    char *buf, *name;
+    int fd;
+
+    size = (argc > 1 ? (size_t) atoi (argv[1]) : 64) * 1024 * 1024;
+    buf = g_malloc (size);
+
+    /* lines of 60 bytes on average, one of thousand lines has a match */
+    srand (1);
+    for (i = 0; i < size; i++)
+        buf[i] = rand () % 60 == 0 ? '\n' : 'a' + i % 26;
+    for (i = 0; i + 6 < size; i += 60 * 1000)
+        memcpy (buf + i, "needle", 6);
+
+    fd = g_file_open_tmp ("find_grep_bench.XXXXXX", &name, NULL);
+    if (fd == -1 || write (fd, buf, size) != (ssize_t) size)
+        return EXIT_FAILURE;
+    g_free (buf);
+
+    str_init_strings (NULL);
+
+    for (i = 0; i < G_N_ELEMENTS (searches); i++)
+    {
+        mc_search_t *handle;
+
+        handle = mc_search_new (searches[i].pattern, NULL);
+        handle->search_type = searches[i].regexp ? MC_SEARCH_T_REGEX : MC_SEARCH_T_NORMAL;
+        handle->is_case_sensitive = searches[i].case_sens;
+        if (mc_search_prepare (handle))
+        {
+            bench ("lines", fd, size, handle, grep_by_lines);
+            bench ("blocks", fd, size, handle, find_grep_file);
+        }
+        mc_search_free (handle);
+    }
+
+    str_uninit_strings ();
+
+    close (fd);
+    unlink (name);
+    g_free (name);
+#else
+    (void) argc;
+    (void) argv;
+#endif /* FIND_GREP_THREADS */
+
+    return EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,257 @@
+/*
+   src/filemanager - tests for content search in worker threads of Find File
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+
+#include <unistd.h>
+
+#include "src/filemanager/find.cpp"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef FIND_GREP_THREADS
+/**
+ * Search in content written to temporary file.
+ *
+ * @return found matches as "line:start-end" separated by spaces
+ */
+
+static char *
+grep_content (const char *content, size_t len)
+{
+    char *name;
+    int fd;
+    mc_search_t *handle;
+    GArray *matches;
+    GString *ret;
+    guint i;
+
+    fd = g_file_open_tmp ("find_grep_file.XXXXXX", &name, NULL);
+    ck_assert_int_ne (fd, -1);
+    ck_assert_int_eq (write (fd, content, len), (ssize_t) len);
+    lseek (fd, 0, SEEK_SET);
+
+    handle = find_content_handle_new ();
+    ck_assert (mc_search_prepare (handle));
+
+    matches = g_array_new (FALSE, FALSE, sizeof (find_grep_match_t));
+    find_grep_file (fd, handle, matches);
+
+    ret = g_string_new ("");
+    for (i = 0; i < matches->len; i++)
+    {
+        const find_grep_match_t *m = &g_array_index (matches, find_grep_match_t, i);
+
+        g_string_append_printf (ret, "%s%d:%" G_GSIZE_FORMAT "-%" G_GSIZE_FORMAT,
+                                i == 0 ? "" : " ", m->line, m->start, m->end);
+    }
+
+    g_array_free (matches, TRUE);
+    mc_search_free (handle);
+    close (fd);
+    unlink (name);
+    g_free (name);
+
+    return g_string_free (ret, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_find_grep_file_ds") */
+/* *INDENT-OFF* */
+static const struct test_find_grep_file_ds
+{
+    const char *content;
+    size_t len;
+    const char *pattern;
+    gboolean regexp;
+    gboolean case_sens;
+    gboolean first_hit;
+    const char *expected;
+} test_find_grep_file_ds[] =
+{
+    { /* 0. */
+        "foo\nbar foo\n\nfoo", 16,
+        "foo", FALSE, TRUE, FALSE,
+        "1:1-4 2:9-12 4:14-17"
+    },
+    { /* 1. */
+        "foo\nbar foo\n\nfoo", 16,
+        "foo", FALSE, TRUE, TRUE,
+        "1:1-4"
+    },
+    { /* 2. line is found once */
+        "foo foo\nfoo", 11,
+        "foo", FALSE, TRUE, FALSE,
+        "1:1-4 2:9-12"
+    },
+    { /* 3. zero byte ends the string but not the line */
+        "ab\0foo\0foo\nfoo", 14,
+        "foo", FALSE, TRUE, FALSE,
+        "1:4-7 2:12-15"
+    },
+    { /* 4. */
+        "\0\0foo\n\0", 7,
+        "foo", FALSE, TRUE, FALSE,
+        "1:3-6"
+    },
+    { /* 5. */
+        "foo\nbar FOO\n\nfoo", 16,
+        "FOO", FALSE, FALSE, FALSE,
+        "1:1-4 2:9-12 4:14-17"
+    },
+    { /* 6. */
+        "foo\nbar foo\n\nfoo", 16,
+        "f.o", TRUE, TRUE, FALSE,
+        "1:1-4 2:9-12 4:14-17"
+    },
+    { /* 7. */
+        "foo\nbar foo\n\nfoo", 16,
+        "xyz", FALSE, TRUE, FALSE,
+        ""
+    },
+    { /* 8. */
+        "", 0,
+        "foo", FALSE, TRUE, FALSE,
+        ""
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_find_grep_file_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_find_grep_file, test_find_grep_file_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    char *actual;
+
+    content_pattern = g_strdup (data->pattern);
+    options.content_regexp = data->regexp;
+    options.content_case_sens = data->case_sens;
+    options.content_first_hit = data->first_hit;
+    options.content_whole_words = FALSE;
+    options.content_all_charsets = FALSE;
+
+    /* when */
+    actual = grep_content (data->content, data->len);
+
+    /* then */
+    mctest_assert_str_eq (actual, data->expected);
+
+    g_free (actual);
+    MC_PTR_FREE (content_pattern);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_find_grep_file_long_line)
+/* *INDENT-ON* */
+{
+    /* given */
+    const size_t len = FIND_GREP_BLOCK_SIZE * 3 / 2;
+    char *content;
+    char *actual, *expected;
+
+    content = g_malloc (len + 8);
+    memset (content, 'x', len);
+    memcpy (content + len, "foo\nfoo", 8);
+
+    content_pattern = g_strdup ("foo");
+    options.content_regexp = FALSE;
+    options.content_case_sens = TRUE;
+    options.content_first_hit = FALSE;
+    options.content_whole_words = FALSE;
+    options.content_all_charsets = FALSE;
+
+    /* when */
+    actual = grep_content (content, len + 7);
+
+    /* then */
+    expected = g_strdup_printf ("1:%zu-%zu 2:%zu-%zu", len + 1, len + 4, len + 5, len + 8);
+    mctest_assert_str_eq (actual, expected);
+
+    g_free (expected);
+    g_free (actual);
+    g_free (content);
+    MC_PTR_FREE (content_pattern);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+#endif /* FIND_GREP_THREADS */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+#ifdef FIND_GREP_THREADS
+    mctest_add_parameterized_test (tc_core, test_find_grep_file, test_find_grep_file_ds);
+    tcase_add_test (tc_core, test_find_grep_file_long_line);
+#endif
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "find_grep_file.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
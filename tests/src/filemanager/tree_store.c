@@ -0,0 +1,285 @@
+/*
+   src/filemanager - tests for storage of directory tree
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "src/vfs/local/local.cpp"
+
+#include "src/filemanager/treestore.cpp"
+
+/* in the order of tree */
+static const char *test_dirs[] = {
+    "/",
+    "/bin",
+    "/etc",
+    "/etc/X11",
+    "/etc/rc.d",
+    "/etc/rc.d/init.d",
+    "/etc.old/X11",
+    "/etc.old/rc.d",
+    "/usr",
+    "/usr/lib",
+    "/usr/local",
+    NULL
+};
+
+static char *tree_name = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int fd;
+
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    fd = g_file_open_tmp ("treestoreXXXXXX", &tree_name, NULL);
+    close (fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    while (ts.tree_first != NULL)
+        remove_entry (ts.tree_first);
+    ts.loaded = false;
+
+    unlink (tree_name);
+    g_free (tree_name);
+
+    vfs_shut ();
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* add test directories in the mixed order, the scanned ones are on odd positions of tree */
+static void
+add_dirs (void)
+{
+    int i, n;
+
+    n = G_N_ELEMENTS (test_dirs) - 1;
+
+    for (i = 0; i < n; i++)
+    {
+        int k;
+        vfs_path_t *vpath;
+        tree_entry *e;
+
+        k = (i * 7) % n;
+        vpath = vfs_path_from_str (test_dirs[k]);
+        e = tree_store_add_entry (vpath);
+        e->scanned = k % 2 != 0;
+        vfs_path_free (vpath);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_dirs (void)
+{
+    tree_entry *e;
+    int i;
+
+    for (i = 0, e = ts.tree_first; test_dirs[i] != NULL; i++, e = e->next)
+    {
+        vfs_path_t *vpath;
+
+        mctest_assert_not_null (e);
+        mctest_assert_str_eq (vfs_path_as_str (e->name), test_dirs[i]);
+        mctest_assert_int_eq (e->scanned, i % 2 != 0);
+        ck_assert (e->next == NULL || e->next->prev == e);
+
+        vpath = vfs_path_from_str (test_dirs[i]);
+        ck_assert (tree_store_whereis (vpath) == e);
+        vfs_path_free (vpath);
+    }
+
+    mctest_assert_null (e);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_tree_store_add_entry)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_path_t *vpath;
+
+    /* when */
+    add_dirs ();
+
+    /* then */
+    check_dirs ();
+    mctest_assert_str_eq (vfs_path_as_str (ts.tree_last->name), "/usr/local");
+
+    vpath = vfs_path_from_str ("/etc/rc");
+    mctest_assert_null (tree_store_whereis (vpath));
+    vfs_path_free (vpath);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_tree_store_remove_entry)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_path_t *vpath;
+    tree_entry *e;
+
+    add_dirs ();
+
+    /* when */
+    vpath = vfs_path_from_str ("/etc");
+    tree_store_remove_entry (vpath);
+
+    /* then */
+    mctest_assert_null (tree_store_whereis (vpath));
+    vfs_path_free (vpath);
+
+    vpath = vfs_path_from_str ("/etc/rc.d/init.d");
+    mctest_assert_null (tree_store_whereis (vpath));
+    vfs_path_free (vpath);
+
+    vpath = vfs_path_from_str ("/etc.old/X11");
+    e = tree_store_whereis (vpath);
+    vfs_path_free (vpath);
+    mctest_assert_not_null (e);
+    mctest_assert_str_eq (vfs_path_as_str (e->prev->name), "/bin");
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_tree_store_save_load)
+/* *INDENT-ON* */
+{
+    /* given */
+    add_dirs ();
+
+    /* when */
+    mctest_assert_int_eq (tree_store_save_to (tree_name), 0);
+    while (ts.tree_first != NULL)
+        remove_entry (ts.tree_first);
+    ts.loaded = false;
+    tree_store_load_from (tree_name);
+
+    /* then */
+    check_dirs ();
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_tree_store_load_text)
+/* *INDENT-ON* */
+{
+    /* given */
+    static const char *text =
+        TREE_SIGNATURE_TEXT "\n"
+        "0:/\n"
+        "1:/bin\n"
+        "0:/etc\n"
+        "1:4 /X11\n"
+        "0:5 rc.d\n"
+        "1:9 /init.d\n"
+        "0:4 .old/X11\n"
+        "1:9 rc.d\n"
+        "0:/usr\n"
+        "1:4 /lib\n"
+        "0:6 ocal\n";
+
+    g_file_set_contents (tree_name, text, -1, NULL);
+
+    /* when */
+    tree_store_load_from (tree_name);
+
+    /* then */
+    check_dirs ();
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_tree_store_add_entry);
+    tcase_add_test (tc_core, test_tree_store_remove_entry);
+    tcase_add_test (tc_core, test_tree_store_save_load);
+    tcase_add_test (tc_core, test_tree_store_load_text);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "tree_store.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
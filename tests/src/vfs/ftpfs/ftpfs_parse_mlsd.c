@@ -0,0 +1,150 @@
+/*
+   src/vfs/ftpfs - tests for parser of MLSD listings
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/ftpfs"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+
+#include "src/vfs/ftpfs/ftpfs.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_ftpfs_parse_mlsd_line_ds") */
+/* *INDENT-OFF* */
+static const struct test_ftpfs_parse_mlsd_line_ds
+{
+    const char *line;
+    bool expected_result;
+    mode_t expected_mode;
+    off_t expected_size;
+    time_t expected_mtime;
+    const char *expected_filename;
+    const char *expected_linkname;
+} test_ftpfs_parse_mlsd_line_ds[] =
+{
+    { /* 0. */
+        "type=file;size=1024;modify=20200115103000;UNIX.mode=0640; file name.txt",
+        true, S_IFREG | 0640, 1024, 1579084200, "file name.txt", NULL
+    },
+    { /* 1. */
+        "Type=dir;Modify=20200115103000.123;Perm=flcdmpe; dir\r",
+        true, S_IFDIR | 0755, 0, 1579084200, "dir", NULL
+    },
+    { /* 2. */
+        "type=file;perm=r;size=3; name;with;semicolons",
+        true, S_IFREG | 0444, 3, 0, "name;with;semicolons", NULL
+    },
+    { /* 3. */
+        "type=OS.unix=slink:/tmp/a b;UNIX.mode=0777; link",
+        true, S_IFLNK | 0777, 0, 0, "link", "/tmp/a b"
+    },
+    { /* 4. symbolic link without target */
+        "type=OS.unix=symlink;size=5; link",
+        true, S_IFREG | 0644, 5, 0, "link", NULL
+    },
+    { /* 5. */
+        "type=cdir;perm=el; .",
+        false, 0, 0, 0, NULL, NULL
+    },
+    { /* 6. */
+        "type=pdir;perm=el; ..",
+        false, 0, 0, 0, NULL, NULL
+    },
+    { /* 7. */
+        "-rw-r--r--    1 0        0            1024 Jan 15 10:30 file",
+        false, 0, 0, 0, NULL, NULL
+    },
+    { /* 8. */
+        "type=file;size=1",
+        false, 0, 0, 0, NULL, NULL
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_ftpfs_parse_mlsd_line_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_ftpfs_parse_mlsd_line, test_ftpfs_parse_mlsd_line_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct stat st;
+    char *filename, *linkname;
+    bool actual_result;
+
+    memset (&st, 0, sizeof (st));
+
+    /* when */
+    actual_result = ftpfs_parse_mlsd_line (data->line, &st, &filename, &linkname);
+
+    /* then */
+    mctest_assert_int_eq (actual_result, data->expected_result);
+    if (actual_result)
+    {
+        mctest_assert_int_eq (st.st_mode, data->expected_mode);
+        mctest_assert_int_eq (st.st_size, data->expected_size);
+        mctest_assert_int_eq (st.st_mtime, data->expected_mtime);
+        mctest_assert_str_eq (filename, data->expected_filename);
+        if (data->expected_linkname == NULL)
+        {
+            mctest_assert_null (linkname);
+        }
+        else
+        {
+            mctest_assert_str_eq (linkname, data->expected_linkname);
+        }
+    }
+
+    g_free (filename);
+    g_free (linkname);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_ftpfs_parse_mlsd_line,
+                                   test_ftpfs_parse_mlsd_line_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "ftpfs_parse_mlsd.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
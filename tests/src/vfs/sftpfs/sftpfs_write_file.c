@@ -0,0 +1,291 @@
+/*
+   src/vfs/sftpfs - tests for window of pipelined writes
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/sftpfs"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+
+#include "src/vfs/sftpfs/file.cpp"
+
+/* libssh2 sends at most 30000 bytes by one packet */
+#define TEST_SERVER_CHUNK 30000
+#define TEST_DATA_SIZE (600 * 1024 + 13)
+
+static char *test_data = NULL;
+
+/* file on server */
+static char *server_data = NULL;
+static size_t server_pos;
+static size_t server_len;
+static int server_writes;
+static size_t server_fail_at;
+
+static sftpfs_super_t test_super;
+static struct vfs_s_inode test_ino;
+static sftpfs_file_handler_t *test_file = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+ssize_t
+libssh2_sftp_write (LIBSSH2_SFTP_HANDLE * handle, const char *buffer, size_t count)
+{
+    (void) handle;
+
+    if (server_pos >= server_fail_at)
+        return LIBSSH2_ERROR_SOCKET_SEND;
+
+    count = MIN (count, TEST_SERVER_CHUNK);
+    count = MIN (count, server_fail_at - server_pos);
+    memcpy (server_data + server_pos, buffer, count);
+    server_pos += count;
+    server_len = MAX (server_len, server_pos);
+    server_writes++;
+
+    return (ssize_t) count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+void
+libssh2_sftp_seek64 (LIBSSH2_SFTP_HANDLE * handle, libssh2_uint64_t offset)
+{
+    (void) handle;
+
+    server_pos = (size_t) offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+int
+libssh2_session_last_error (LIBSSH2_SESSION * session, char **errmsg, int *errmsg_len,
+                            int want_buf)
+{
+    (void) session;
+    (void) want_buf;
+
+    *errmsg = g_strdup ("send failed");
+    if (errmsg_len != NULL)
+        *errmsg_len = (int) strlen (*errmsg);
+
+    return LIBSSH2_ERROR_SOCKET_SEND;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    size_t i;
+
+    test_data = (char *) g_malloc (TEST_DATA_SIZE);
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+        test_data[i] = (char) (i * 7 + i / 251);
+
+    server_data = (char *) g_malloc0 (TEST_DATA_SIZE);
+    server_pos = 0;
+    server_len = 0;
+    server_writes = 0;
+    server_fail_at = (size_t) (-1);
+
+    test_ino.super = VFS_SUPER (&test_super);
+    test_file = g_new0 (sftpfs_file_handler_t, 1);
+    VFS_FILE_HANDLER (test_file)->ino = &test_ino;
+    test_file->handle = (LIBSSH2_SFTP_HANDLE *) & test_super;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    g_free (test_file->window);
+    MC_PTR_FREE (test_file);
+    MC_PTR_FREE (server_data);
+    MC_PTR_FREE (test_data);
+    sftpfs_window_size = SFTP_DEFAULT_WINDOW_SIZE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_sftpfs_write_file_ds") */
+/* *INDENT-OFF* */
+static const struct test_sftpfs_write_file_ds
+{
+    int window_size;            /* in kilobytes */
+    size_t first_block;         /* size of the 1st write */
+    size_t block;               /* size of other writes */
+} test_sftpfs_write_file_ds[] =
+{
+    { /* 0. editor: window is a multiple of blocks, but the 1st block is short */
+        256, 1000, 64 * 1024
+    },
+    { /* 1. editor: window is not a multiple of blocks */
+        100, 64 * 1024, 64 * 1024
+    },
+    { /* 2. blocks cross the window boundary */
+        32, 20000, 20000
+    },
+    { /* 3. blocks larger than window after partially filled window */
+        32, 100, 100000
+    },
+    { /* 4. small blocks */
+        32, 4096, 4096
+    },
+    { /* 5. no window */
+        0, 1000, 64 * 1024
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_sftpfs_write_file_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_sftpfs_write_file, test_sftpfs_write_file_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    GError *mcerror = NULL;
+    size_t offset = 0;
+
+    sftpfs_window_size = data->window_size;
+    sftpfs_file__window_init (test_file);
+
+    /* when */
+    while (offset < TEST_DATA_SIZE)
+    {
+        size_t count;
+        ssize_t actual_result;
+
+        count = offset == 0 ? data->first_block : data->block;
+        count = MIN (count, TEST_DATA_SIZE - offset);
+
+        actual_result = sftpfs_write_file (VFS_FILE_HANDLER (test_file), test_data + offset,
+                                           count, &mcerror);
+
+        /* then: the whole block is consumed */
+        mctest_assert_int_eq (actual_result, (ssize_t) count);
+        offset += count;
+        mctest_assert_int_eq (VFS_FILE_HANDLER (test_file)->pos, (off_t) offset);
+    }
+
+    mctest_assert_int_eq (sftpfs_file__flush (VFS_FILE_HANDLER (test_file), &mcerror), 0);
+
+    /* then */
+    mctest_assert_null (mcerror);
+    mctest_assert_int_eq (server_len, TEST_DATA_SIZE);
+    mctest_assert_int_eq (server_pos, TEST_DATA_SIZE);
+    mctest_assert_true (memcmp (server_data, test_data, TEST_DATA_SIZE) == 0);
+    mctest_assert_int_eq (VFS_FILE_HANDLER (test_file)->pos, TEST_DATA_SIZE);
+    /* small writes are sent to server in large portions */
+    if (data->window_size != 0)
+        mctest_assert_true (server_writes <= TEST_DATA_SIZE / TEST_SERVER_CHUNK + 1
+                            + TEST_DATA_SIZE / (data->window_size * 1024) + 1);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* *INDENT-OFF* */
+START_TEST (test_sftpfs_write_file_flush_error)
+/* *INDENT-ON* */
+{
+    /* given */
+    GError *mcerror = NULL;
+    const size_t window = 32 * 1024;
+    ssize_t actual_result;
+
+    sftpfs_window_size = 32;
+    sftpfs_file__window_init (test_file);
+    /* the 1st window is written, the 2nd one fails in the middle */
+    server_fail_at = window + window / 2;
+
+    /* when */
+    actual_result = sftpfs_write_file (VFS_FILE_HANDLER (test_file), test_data, 1000, &mcerror);
+
+    /* then */
+    mctest_assert_int_eq (actual_result, 1000);
+
+    /* when */
+    actual_result =
+        sftpfs_write_file (VFS_FILE_HANDLER (test_file), test_data + 1000, window, &mcerror);
+
+    /* then */
+    mctest_assert_int_eq (actual_result, (ssize_t) window);
+    mctest_assert_null (mcerror);
+    mctest_assert_int_eq (server_pos, window);
+
+    /* when */
+    actual_result =
+        sftpfs_write_file (VFS_FILE_HANDLER (test_file), test_data + window + 1000, window,
+                           &mcerror);
+
+    /* then: position is moved back to the dropped data */
+    mctest_assert_int_eq (actual_result, -1);
+    mctest_assert_not_null (mcerror);
+    mctest_assert_int_eq (VFS_FILE_HANDLER (test_file)->pos, (off_t) window);
+    mctest_assert_int_eq (server_pos, window);
+    mctest_assert_int_eq (test_file->window_len, 0);
+    mctest_assert_false (test_file->window_dirty);
+    mctest_assert_true (memcmp (server_data, test_data, window) == 0);
+
+    g_error_free (mcerror);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_sftpfs_write_file, test_sftpfs_write_file_ds);
+    tcase_add_test (tc_core, test_sftpfs_write_file_flush_error);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "sftpfs_write_file.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
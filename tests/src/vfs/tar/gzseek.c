@@ -0,0 +1,377 @@
+/*
+   src/vfs/tar - tests for random access to gzip-compressed files
+
+   Copyright (C) 2020
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/tar"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "lib/strutil.h"
+#include "lib/vfs/vfs.h"
+#include "src/vfs/local/local.h"
+
+#include "src/vfs/tar/gzseek.h"
+
+/* several distances between checkpoints */
+#define TEST_DATA_SIZE (13 * 1024 * 1024 + 17)
+
+static unsigned char *test_data = NULL;
+static char *gz_name = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Compressible data with back references of different lengths.
+ */
+
+static void
+fill_data (void)
+{
+    size_t i;
+
+    test_data = (unsigned char *) g_malloc (TEST_DATA_SIZE);
+
+    srand (TEST_DATA_SIZE);
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+    {
+        if (i > 40000 && rand () % 64 == 0)
+        {
+            size_t len, from;
+
+            len = 1 + rand () % 200;
+            len = MIN (len, TEST_DATA_SIZE - i);
+            from = i - 1 - rand () % 32000;
+            for (; len > 1; len--)
+                test_data[i++] = test_data[from++];
+            test_data[i] = test_data[from];
+        }
+        else
+            test_data[i] = 'a' + rand () % 16;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Write data as gzip file of several members.
+ *
+ * @param members number of gzip members
+ * @param tail number of zero bytes after the last member
+ */
+
+static void
+write_gzip (int members, size_t tail)
+{
+    GByteArray *gz;
+    size_t begin = 0;
+    int i;
+
+    gz = g_byte_array_new ();
+
+    for (i = 0; i < members; i++)
+    {
+        z_stream strm;
+        size_t end;
+        guint len;
+
+        end = (i == members - 1) ? TEST_DATA_SIZE : TEST_DATA_SIZE / members * (i + 1);
+
+        memset (&strm, 0, sizeof (strm));
+        ck_assert_int_eq (deflateInit2 (&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8,
+                                        Z_DEFAULT_STRATEGY), Z_OK);
+        len = gz->len;
+        g_byte_array_set_size (gz, len + deflateBound (&strm, end - begin));
+        strm.next_in = test_data + begin;
+        strm.avail_in = end - begin;
+        strm.next_out = gz->data + len;
+        strm.avail_out = gz->len - len;
+        ck_assert_int_eq (deflate (&strm, Z_FINISH), Z_STREAM_END);
+        g_byte_array_set_size (gz, gz->len - strm.avail_out);
+        deflateEnd (&strm);
+
+        begin = end;
+    }
+
+    g_byte_array_set_size (gz, gz->len + tail);
+    memset (gz->data + gz->len - tail, 0, tail);
+
+    ck_assert (g_file_set_contents (gz_name, (const char *) gz->data, gz->len, NULL));
+    g_byte_array_free (gz, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int fd;
+
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    fd = g_file_open_tmp ("gzseekXXXXXX.gz", &gz_name, NULL);
+    close (fd);
+
+    if (test_data == NULL)
+        fill_data ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    unlink (gz_name);
+    g_free (gz_name);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+open_gz_file (void)
+{
+    vfs_path_t *vpath;
+    int fd;
+
+    vpath = vfs_path_from_str (gz_name);
+    fd = mc_open (vpath, O_RDONLY);
+    vfs_path_free (vpath);
+    ck_assert_int_ne (fd, -1);
+
+    return fd;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_gzseek_ds") */
+/* *INDENT-OFF* */
+static const struct test_gzseek_ds
+{
+    int members;
+    size_t tail;
+} test_gzseek_ds[] =
+{
+    { 1, 0 },
+    { 3, 0 },
+    { 2, 10240 },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_gzseek_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_gzseek, test_gzseek_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    unsigned char *buf;
+    gzseek_t *gz;
+    off_t pos;
+    int fd, i;
+
+    write_gzip (data->members, data->tail);
+    fd = open_gz_file ();
+    gz = gzseek_open (fd);
+    mctest_assert_not_null (gz);
+    buf = (unsigned char *) g_malloc (65536);
+
+    /* when: the whole file is read */
+    for (pos = 0; pos < TEST_DATA_SIZE;)
+    {
+        ssize_t n;
+
+        n = gzseek_read (gz, buf, 65536);
+        ck_assert_int_gt (n, 0);
+        ck_assert (memcmp (buf, test_data + pos, n) == 0);
+        pos += n;
+    }
+
+    /* then */
+    mctest_assert_int_eq (pos, TEST_DATA_SIZE);
+    mctest_assert_int_eq (gzseek_read (gz, buf, 65536), 0);
+
+    /* when: data are read at random offsets */
+    srand (data->members);
+    for (i = 0; i < 200; i++)
+    {
+        size_t len;
+
+        pos = rand () % TEST_DATA_SIZE;
+        len = rand () % 65536;
+        len = MIN (len, (size_t) (TEST_DATA_SIZE - pos));
+
+        /* then */
+        mctest_assert_int_eq (gzseek_lseek (gz, pos), pos);
+        mctest_assert_int_eq (gzseek_read (gz, buf, len), len);
+        ck_assert (memcmp (buf, test_data + pos, len) == 0);
+    }
+
+    /* then: offset after the end of file */
+    mctest_assert_int_eq (gzseek_lseek (gz, TEST_DATA_SIZE + 100), TEST_DATA_SIZE);
+
+    g_free (buf);
+    gzseek_close (gz);
+    mc_close (fd);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_gzseek_load)
+/* *INDENT-ON* */
+{
+    /* given */
+    unsigned char *buf;
+    GString *points;
+    gzseek_t *gz;
+    off_t pos;
+    int fd;
+
+    write_gzip (1, 0);
+    fd = open_gz_file ();
+    gz = gzseek_open (fd);
+    mctest_assert_not_null (gz);
+    buf = (unsigned char *) g_malloc (65536);
+    mctest_assert_int_eq (gzseek_lseek (gz, TEST_DATA_SIZE), TEST_DATA_SIZE);
+    points = g_string_new ("");
+    gzseek_save (gz, points);
+    gzseek_close (gz);
+    mc_close (fd);
+
+    /* the beginning of deflate stream is damaged, the rest can be read from checkpoints only */
+    {
+        char *contents;
+        gsize len;
+
+        ck_assert (g_file_get_contents (gz_name, &contents, &len, NULL));
+        memset (contents + 1000, 0xff, 1000);
+        ck_assert (g_file_set_contents (gz_name, contents, len, NULL));
+        g_free (contents);
+    }
+
+    fd = open_gz_file ();
+    gz = gzseek_open (fd);
+    mctest_assert_not_null (gz);
+
+    /* when */
+    mctest_assert_true (gzseek_load (gz, points->str, points->len));
+
+    /* then */
+    for (pos = 5 * 1024 * 1024; pos < TEST_DATA_SIZE; pos += 1024 * 1024 + 333)
+    {
+        size_t len;
+
+        len = MIN (65536, (size_t) (TEST_DATA_SIZE - pos));
+        mctest_assert_int_eq (gzseek_lseek (gz, pos), pos);
+        mctest_assert_int_eq (gzseek_read (gz, buf, len), len);
+        ck_assert (memcmp (buf, test_data + pos, len) == 0);
+    }
+
+    /* when: saved data are corrupted */
+    /* then */
+    mctest_assert_false (gzseek_load (gz, points->str, points->len - 1));
+    mctest_assert_false (gzseek_load (gz, points->str + 1, points->len - 1));
+    mctest_assert_true (gzseek_load (gz, points->str, points->len));
+    mctest_assert_int_eq (gzseek_lseek (gz, TEST_DATA_SIZE - 100), TEST_DATA_SIZE - 100);
+    mctest_assert_int_eq (gzseek_read (gz, buf, 100), 100);
+    ck_assert (memcmp (buf, test_data + TEST_DATA_SIZE - 100, 100) == 0);
+
+    g_string_free (points, TRUE);
+    g_free (buf);
+    gzseek_close (gz);
+    mc_close (fd);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_gzseek_not_gzip)
+/* *INDENT-ON* */
+{
+    /* given */
+    gzseek_t *gz;
+    int fd;
+
+    g_file_set_contents (gz_name, "\037\235 compressed by compress(1)", -1, NULL);
+    fd = open_gz_file ();
+
+    /* when */
+    gz = gzseek_open (fd);
+
+    /* then */
+    mctest_assert_null (gz);
+
+    mc_close (fd);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+    tcase_set_timeout (tc_core, 60);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_gzseek, test_gzseek_ds);
+    tcase_add_test (tc_core, test_gzseek_load);
+    tcase_add_test (tc_core, test_gzseek_not_gzip);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "gzseek.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    g_free (test_data);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */